@@ -17,13 +17,120 @@ extern "C" {
 #define CHIP8_NUM_REGISTERS  16
 #define CHIP8_NUM_KEYS       16
 #define CHIP8_DISASM_BUFSIZE 64
+#define CHIP8_DECODE_SIZE    (CHIP8_MEMORY_SIZE / 2)
+#define CHIP8_PAGE_SIZE      256
+#define CHIP8_PAGE_COUNT     (CHIP8_MEMORY_SIZE / CHIP8_PAGE_SIZE)
+
+// Pixel (x, y) of a packed display, see chip8_get_display_rows
+#define CHIP8_PIXEL(rows, x, y) ((bool)(((rows)[(y)] >> (63 - (x))) & 1))
+
+/*
+    Pre-decoded instruction, one slot per even address of memory.
+    op is a handler id private to chip8.c; 0 means "not decoded yet".
+    Slots are invalidated whenever the bytes they cover are written.
+*/
+typedef struct {
+    uint16_t opcode; // raw opcode, kept for diagnostics
+    uint16_t nnn;
+    uint8_t op;
+    uint8_t x;
+    uint8_t y;
+    uint8_t nn; // n is the low nibble of nn
+} Chip8Instr;
+
+/*
+    Interpreter backends that chip8_step_n can dispatch through.
+    The default is picked at build time with CHIP8_DEFAULT_BACKEND.
+*/
+typedef enum {
+    CHIP8_BACKEND_SWITCH = 0, // portable switch over decoded instructions
+    CHIP8_BACKEND_THREADED,   // computed-goto dispatch (GCC/Clang builds only)
+    CHIP8_BACKEND_JIT,        // hot basic blocks translated to native x86-64 code
+    CHIP8_BACKEND_AOT,        // blocks from a chip8aotc module, see chip8_load_aot
+    CHIP8_BACKEND_COUNT
+} Chip8Backend;
+
+// translated block table owned by an instance using the JIT or AOT backend (opaque, see chip8_jit.c)
+typedef struct Chip8Jit Chip8Jit;
+
+// loaded ahead-of-time module (opaque, see chip8_aot.c)
+typedef struct Chip8Aot Chip8Aot;
+
+// input recording (opaque, see chip8_movie.h)
+typedef struct Chip8Movie Chip8Movie;
+
+// refcounted state with copy-on-write memory pages (opaque, see chip8_snapshot.h)
+typedef struct Chip8Snapshot Chip8Snapshot;
+
+// per-instruction undo records (opaque, see chip8_undo.h)
+typedef struct Chip8Undo Chip8Undo;
+
+// binary instruction trace being written (opaque, see chip8_trace.h)
+typedef struct Chip8Trace Chip8Trace;
+
+// per-address execution, read and write counters (see chip8_profile.h)
+typedef struct Chip8Profile Chip8Profile;
+
+// signal-driven PC sampler (opaque, see chip8_sampler.h)
+typedef struct Chip8Sampler Chip8Sampler;
+
+// breakpoints and the run-to target (see chip8_break.h)
+typedef struct Chip8Breakpoints Chip8Breakpoints;
+
+// memory and register watchpoints (see chip8_watch.h)
+typedef struct Chip8Watches Chip8Watches;
+
+// Why chip8_run_until returned
+typedef enum {
+    CHIP8_STOP_BUDGET = 0,  // ran max_cycles
+    CHIP8_STOP_BREAKPOINT,  // PC is at a breakpoint whose condition holds
+    CHIP8_STOP_TARGET,      // reached the run-to target (run to cursor, step over, step out)
+    CHIP8_STOP_HALTED,
+    CHIP8_STOP_WATCHPOINT,  // the last instruction touched a watched range or register
+} Chip8StopReason;
+
+/*
+    What the thread running an instance is doing, kept in Chip8.phase for the sampler.
+*/
+typedef enum {
+    CHIP8_PHASE_HOST = 0,   // outside chip8_step_n
+    CHIP8_PHASE_INTERPRET,  // interpreting guest instructions
+    CHIP8_PHASE_TRANSLATED, // running JIT or AOT code
+    CHIP8_PHASE_COMPILE,    // JIT translating a block
+    CHIP8_PHASE_COUNT
+} Chip8Phase;
+
+/*
+    Conditions the core reports through the diagnostic ring instead of printing them,
+    see chip8_drain_diagnostics.
+*/
+typedef enum {
+    CHIP8_DIAG_SYS = 0,         // 0NNN machine code call, ignored
+    CHIP8_DIAG_INVALID_OPCODE,  // unassigned opcode (5XY1, 8XY8, EX00...), skipped
+    CHIP8_DIAG_STACK_UNDERFLOW, // RET with an empty stack, halts
+    CHIP8_DIAG_STACK_OVERFLOW,  // CALL with a full stack, halts
+    CHIP8_DIAG_COUNT
+} Chip8DiagCode;
+
+typedef struct {
+    uint64_t cycle;  // cycle_count when it happened (start of the block under JIT/AOT)
+    uint16_t pc;     // address of the instruction
+    uint16_t opcode;
+    uint8_t code;    // Chip8DiagCode
+} Chip8Diag;
+
+// Entries of one code that may wait in the ring; later ones are only counted
+#define CHIP8_DIAG_BURST     8
+#define CHIP8_DIAG_RING_SIZE (CHIP8_DIAG_BURST * CHIP8_DIAG_COUNT)
+
 /*
     CHIP-8 struct that emulates the state of original inteprreter
 */
 typedef struct {
     uint8_t memory[CHIP8_MEMORY_SIZE];
-    bool display[CHIP8_DISPLAY_SIZE];
+    uint64_t display[CHIP8_DISPLAY_HEIGHT]; // one word per row, bit 63 is the leftmost pixel
     bool draw_flag; // whether should the screen be updated
+    uint32_t dirty_rows; // bit y set once row y changed, see chip8_take_dirty_rows
 
     uint16_t stack[CHIP8_STACK_SIZE]; // a stack that used to call subroutines/functions and return from them
     uint16_t V[CHIP8_NUM_REGISTERS]; // general purpose variable registers for holding values at the memory; VF is a flag register
@@ -43,11 +150,58 @@ typedef struct {
     bool running; // is emulation running?
     bool halted; // does emulation encountered an error? unknown opcode?
     uint64_t cycle_count; // the number of CPU cycles executed 
+    uint64_t idle_cycles; // part of cycle_count spent in provably idle loops (see chip8_get_idle_cycles)
+    uint8_t backend; // Chip8Backend used by chip8_step_n
+    uint64_t rand_seed; // seed the CXNN generator restarts from on reset, see chip8_set_seed
+    uint64_t rand_state; // CXNN generator, per instance so instances can run on different threads
+
+    // diagnostics, filled by the core and drained by the host (see chip8_drain_diagnostics)
+    Chip8Diag diag_ring[CHIP8_DIAG_RING_SIZE];
+    uint8_t diag_head; // oldest entry
+    uint8_t diag_used; // entries waiting
+    uint8_t diag_queued[CHIP8_DIAG_COUNT]; // entries waiting per code, at most CHIP8_DIAG_BURST
+    uint64_t diag_counts[CHIP8_DIAG_COUNT]; // every occurrence, queued or not
 
     // rom info
     char rom_path[256];
     size_t rom_size; 
 
+    // decode cache, indexed by address / 2
+    Chip8Instr decoded[CHIP8_DECODE_SIZE];
+
+    // translated blocks, NULL unless the JIT or AOT backend is selected
+    Chip8Jit* jit;
+    Chip8Aot* aot;
+
+    // movie being recorded, NULL unless chip8_movie_record was called
+    Chip8Movie* movie;
+
+    // undo log, NULL unless chip8_undo_enable was called
+    Chip8Undo* undo;
+
+    // instruction trace, NULL unless chip8_trace_start was called
+    Chip8Trace* trace;
+
+    // counters parallel to memory, NULL unless chip8_profile_enable was called
+    Chip8Profile* profile;
+
+    // sampling profiler, NULL unless chip8_sampler_start was called
+    Chip8Sampler* sampler;
+    volatile uint8_t phase; // Chip8Phase, read from the sampler's signal handler
+
+    // checked by chip8_run_until, NULL until chip8_break_set or a run-to target
+    Chip8Breakpoints* breakpoints;
+
+    // NULL until chip8_watch_memory or chip8_watch_register; one bit per page holding a
+    // watched range, tested by every guest load and store
+    Chip8Watches* watches;
+    uint16_t watch_read_pages;
+    uint16_t watch_write_pages;
+
+    // memory equals the pages of snapshot except for pages with their bit set in dirty_pages
+    Chip8Snapshot* snapshot; // last snapshot taken or restored, NULL before the first
+    uint16_t dirty_pages;
+
 } Chip8;
 
 // === INTERFACE ===
@@ -115,6 +269,52 @@ bool chip8_step(Chip8* chip);
 */
 int chip8_step_n(Chip8* chip, int n);
 
+/*
+    Runs up to max_cycles, stopping before an instruction with a breakpoint whose
+    condition holds or at the run-to target (see chip8_break.h), and after one that
+    touches a watchpoint (see chip8_watch.h). A run that starts where the last one
+    stopped at a breakpoint or the target, with nothing run in between, runs that
+    instruction first so it can resume; any other run checks its first instruction
+    too, so budgets may end anywhere without missing a stop. With nothing armed it runs on
+    the selected backend like chip8_step_n; otherwise one instruction at a time on the
+    switch interpreter.
+*/
+Chip8StopReason chip8_run_until(Chip8* chip, uint64_t max_cycles);
+
+const char* chip8_stop_reason_name(Chip8StopReason reason);
+
+/*
+    Selects the interpreter backend used by chip8_step_n.
+    Returns false and keeps the current backend if it is not available in this build.
+    The choice survives chip8_reset.
+*/
+bool chip8_set_backend(Chip8* chip, Chip8Backend backend);
+
+Chip8Backend chip8_get_backend(Chip8* chip);
+
+/*
+    Whether the backend was compiled into this build.
+    CHIP8_BACKEND_AOT additionally needs a module loaded with chip8_load_aot.
+*/
+bool chip8_backend_available(Chip8Backend backend);
+
+/*
+    Short display name, e.g. "switch" or "threaded".
+*/
+const char* chip8_backend_name(Chip8Backend backend);
+
+/*
+    Loads a shared object built by chip8aotc and switches to the AOT backend.
+    Blocks whose code differs from memory (another ROM, self-modified code) are
+    interpreted instead, and so is every address the module did not translate.
+*/
+bool chip8_load_aot(Chip8* chip, const char* path);
+
+/*
+    Unloads the AOT module. An instance on the AOT backend falls back to the switch backend.
+*/
+void chip8_unload_aot(Chip8* chip);
+
 /*
     Starts executing cycles indefinitely until halt or error.
 */
@@ -135,6 +335,38 @@ bool chip8_is_running(Chip8* chip);
 */
 bool chip8_is_halted(Chip8* chip);
 
+/*
+    Restarts the CXNN random generator from seed. The seed is kept across chip8_reset and
+    ROM loads, so the same seed and the same input always replay the same run.
+    New instances use a fixed default seed.
+*/
+void chip8_set_seed(Chip8* chip, uint64_t seed);
+
+uint64_t chip8_get_seed(Chip8* chip);
+
+// DIAGNOSTICS
+
+/*
+    Moves up to max of the oldest waiting diagnostics into out and returns how many.
+    Executing never prints or makes any other syscall: 0NNN, unassigned opcodes and stack
+    errors are written to a small per-instance ring, which the host drains whenever it
+    likes, e.g. once per frame. At most CHIP8_DIAG_BURST entries of each code wait at a
+    time, so a ROM looping over a bad opcode costs one counter increment per pass.
+    Ring and counters are cleared by chip8_reset.
+*/
+size_t chip8_drain_diagnostics(Chip8* chip, Chip8Diag* out, size_t max);
+
+/*
+    How often code happened since the last reset, including occurrences that were
+    rate-limited out of the ring.
+*/
+uint64_t chip8_get_diag_count(Chip8* chip, Chip8DiagCode code);
+
+/*
+    Short display name, e.g. "stack underflow".
+*/
+const char* chip8_diag_name(Chip8DiagCode code);
+
 // INPUT MANAGEMENT
 
 // shall include key pressed, key released, is key pressed
@@ -163,16 +395,30 @@ uint8_t chip8_get_sound_timer(Chip8* chip);
 
 uint64_t chip8_get_cycle_count(Chip8* chip);
 
+/*
+    Cycles spent in loops that cannot make progress before the next timer tick or key change:
+    a jump to itself, a delay-timer poll (FX07; 3XNN; 1NNN back to FX07) or FX0A with no key held.
+    chip8_step_n skips such loops to the end of its budget; the skipped cycles still count in
+    both cycle_count and here. Compare the two over a frame to see how busy the ROM is.
+*/
+uint64_t chip8_get_idle_cycles(Chip8* chip);
+
 /*
     Get the pointer to memory (read-only). Shall not modify.
 */
 const uint8_t* chip8_get_memory(Chip8* chip);
 
 /*
-    Get the pointer to display (read-only). Shall not modify, only read.
-    Gets an array.
+    Unpacks the display into pixels, one bool per pixel, row by row; pixels must hold
+    CHIP8_DISPLAY_SIZE. Only reads the instance.
 */
-const bool* chip8_get_display(Chip8* chip);
+void chip8_get_display(Chip8* chip, bool* pixels);
+
+/*
+    Get the packed display (read-only): CHIP8_DISPLAY_HEIGHT words, one per row,
+    with bit 63 being x = 0. Read pixels with CHIP8_PIXEL.
+*/
+const uint64_t* chip8_get_display_rows(Chip8* chip);
 
 /*
     Check if display needs redraw.
@@ -180,6 +426,13 @@ const bool* chip8_get_display(Chip8* chip);
 */
 bool chip8_should_draw(Chip8* chip);
 
+/*
+    Returns the rows of the display that changed since the last call, as a bitmask with
+    bit y for row y, and clears it. DXYN marks the rows it drew to, 00E0 the rows it
+    blanked; ROM load and reset mark every row. Independent of chip8_should_draw.
+*/
+uint32_t chip8_take_dirty_rows(Chip8* chip);
+
 // MEMORY ACCESS
 
 // shall read byte, write byte, read opcode
@@ -208,6 +461,11 @@ uint16_t chip8_read_opcode(Chip8* chip, uint16_t address);
 */
 void chip8_disassemble(Chip8* chip, uint16_t address, char* buffer, size_t bufsize);
 
+/*
+    Same for an opcode that is not in memory, e.g. one from a trace.
+*/
+void chip8_disassemble_opcode(uint16_t opcode, char* buffer, size_t bufsize);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,48 @@
+#ifndef CHIP8_AOT_H
+#define CHIP8_AOT_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    ABI between the chip8aotc static recompiler and the core.
+
+    A module is a shared object exporting one Chip8AotModule named chip8_aot_module.
+    Its blocks are plain C functions on a Chip8*, so the module must be rebuilt whenever
+    the Chip8 struct changes; the loader refuses modules built against another layout.
+*/
+
+#define CHIP8_AOT_ABI_VERSION 1
+#define CHIP8_AOT_SYMBOL      "chip8_aot_module"
+#define CHIP8_AOT_MAX_BLOCK   64 // instructions per block, same limit as the JIT
+
+// runs all instructions of a block and leaves PC at the next one
+typedef void (*Chip8AotBlockFn)(Chip8* chip);
+
+// executes one opcode through the interpreter (DXYN, FX55, ...), including its effect on PC
+typedef void (*Chip8AotExecFn)(Chip8* chip, uint16_t opcode);
+
+typedef struct {
+    uint16_t start;  // guest address of the first instruction
+    uint8_t length;  // number of guest instructions
+    Chip8AotBlockFn fn;
+} Chip8AotBlock;
+
+typedef struct {
+    uint32_t abi_version;         // CHIP8_AOT_ABI_VERSION
+    uint32_t chip8_size;          // sizeof(Chip8) the module was compiled against
+    uint32_t block_count;
+    const Chip8AotBlock* blocks;
+    const uint8_t* image;         // ROM bytes the blocks were translated from, loaded at 0x200
+    uint32_t image_size;
+    Chip8AotExecFn* exec_opcode;  // filled in by the loader before any block runs
+} Chip8AotModule;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef CHIP8_BREAK_H
+#define CHIP8_BREAK_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Breakpoints and the run-to target, checked by chip8_run_until.
+
+    Breakpoints are kept as one bit per address, so chip8_run_until pays a single bit
+    test per instruction; instances without any breakpoint or target never leave their
+    backend. A breakpoint may carry a condition, compiled when it is set and evaluated
+    only when its address comes up. Conditions are C-like expressions over
+    V0-VF, I, PC, SP, DT, ST, [address] (a byte of memory) and decimal or 0x numbers,
+    with + - & == != < <= > >= ! && || and parentheses, e.g. "V3 == 0x10 && I > 0x300".
+
+    The run-to target is a one-shot stop behind run to cursor, step over and step out.
+    It is dropped when reached, when a breakpoint stops the run first, and when the host
+    replaces the state. Breakpoints survive resets and ROM loads.
+*/
+
+// Target address matching any PC, see chip8_break_set_target
+#define CHIP8_BREAK_ANY 0xFFFF
+
+// BREAKPOINTS
+
+/*
+    Sets a breakpoint at address, replacing the one there. condition may be NULL or
+    empty for a breakpoint that always stops. returns false at failure or if condition
+    does not compile; the breakpoint at address is left as it was then.
+*/
+bool chip8_break_set(Chip8* chip, uint16_t address, const char* condition);
+
+void chip8_break_clear(Chip8* chip, uint16_t address);
+
+/*
+    Removes every breakpoint and the target.
+*/
+void chip8_break_clear_all(Chip8* chip);
+
+bool chip8_break_is_set(Chip8* chip, uint16_t address);
+
+/*
+    The condition of the breakpoint at address as it was set, or NULL if it has none.
+*/
+const char* chip8_break_condition(Chip8* chip, uint16_t address);
+
+/*
+    Times the breakpoint at address stopped a run since it was set.
+*/
+uint64_t chip8_break_hits(Chip8* chip, uint16_t address);
+
+/*
+    Fills addresses with up to max breakpoint addresses, lowest first. returns the
+    number filled.
+*/
+int chip8_break_list(Chip8* chip, uint16_t* addresses, int max);
+
+/*
+    Whether there is a breakpoint at PC whose condition holds now. Does not count a
+    hit; for hosts that move the state themselves, e.g. stepping back. If there is, a
+    chip8_run_until started right here resumes past it, as after a breakpoint stop.
+*/
+bool chip8_break_at_pc(Chip8* chip);
+
+/*
+    Checks that condition compiles without setting anything. returns false and writes
+    the reason into error (if not NULL) if it does not.
+*/
+bool chip8_break_check_condition(const char* condition, char* error, size_t error_size);
+
+// RUN-TO TARGET
+
+/*
+    Stops chip8_run_until the next time PC is address (or at any address, with
+    CHIP8_BREAK_ANY) while SP is at most max_sp. Replaces the previous target. The
+    instruction at PC now runs first, so address may be the current one.
+*/
+bool chip8_break_set_target(Chip8* chip, uint16_t address, uint8_t max_sp);
+
+void chip8_break_clear_target(Chip8* chip);
+
+bool chip8_break_has_target(Chip8* chip);
+
+/*
+    Targets the instruction after a CALL at PC, back at the current depth. returns false,
+    setting nothing, if the instruction at PC is not a CALL; a single step then steps
+    over it.
+*/
+bool chip8_break_step_over(Chip8* chip);
+
+/*
+    Targets the first instruction after the current subroutine returns. returns false
+    at the top level.
+*/
+bool chip8_break_step_out(Chip8* chip);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef CHIP8_LANES_H
+#define CHIP8_LANES_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Lockstep interpreter for many instances of the same ROM.
+
+    Every lane is a complete CHIP-8 machine. Registers, I, PC and timers are kept as
+    vectors with one element per lane, so the register work of an instruction is done
+    for all lanes with a few SIMD operations. Each dispatch executes the instruction at the lowest
+    PC among the lanes that still have cycles left, for every lane sitting at that PC with
+    the same opcode; lanes that branched elsewhere wait and rejoin once the others reach
+    their PC, like the threads of a GPU warp.
+
+    Lanes only diverge through their own input, RNG seed and the memory they write, so
+    ROMs that mostly wait on the same code paths keep most lanes active per dispatch.
+*/
+
+#define CHIP8_LANES_MAX 32
+
+typedef struct Chip8Lanes Chip8Lanes;
+
+/*
+    Creates lanes machines (1 to CHIP8_LANES_MAX), each in the power-on state of chip8_create.
+    returns NULL at failure.
+*/
+Chip8Lanes* chip8_lanes_create(int lanes);
+
+void chip8_lanes_destroy(Chip8Lanes** lanes_ptr);
+
+int chip8_lanes_count(Chip8Lanes* lanes);
+
+/*
+    Copies the machine state of chip (memory, display, registers, stack, timers, keys,
+    RNG, cycle count) into one lane, or into every lane if lane is negative.
+    The usual setup is chip8_load_rom on a Chip8 followed by chip8_lanes_load(lanes, -1, chip).
+*/
+bool chip8_lanes_load(Chip8Lanes* lanes, int lane, const Chip8* chip);
+
+/*
+    Copies the machine state of one lane into chip, for inspection or to continue it on
+    the regular core. Host-side settings of chip (backend, ROM path) are kept.
+    If the lane halted on a stack error, that is recorded in the diagnostics of chip;
+    lanes do not report 0NNN or unassigned opcodes.
+*/
+bool chip8_lanes_store(Chip8Lanes* lanes, int lane, Chip8* chip);
+
+/*
+    Runs every lane that has not halted for n instructions, exactly as chip8_step_n(n)
+    would on its own. Returns the number of dispatches it took: n when all lanes stayed
+    together, up to n times the lane count when they all went separate ways.
+*/
+int chip8_lanes_step_n(Chip8Lanes* lanes, int n);
+
+/*
+    Ticks the delay and sound timers of every lane, like chip8_update_timers.
+*/
+void chip8_lanes_update_timers(Chip8Lanes* lanes);
+
+// PER-LANE INPUT
+
+void chip8_lanes_key_press(Chip8Lanes* lanes, int lane, uint8_t key);
+
+void chip8_lanes_key_release(Chip8Lanes* lanes, int lane, uint8_t key);
+
+/*
+    Restarts the CXNN generator of one lane from seed, like chip8_set_seed.
+*/
+void chip8_lanes_seed(Chip8Lanes* lanes, int lane, uint64_t seed);
+
+// PER-LANE STATE
+
+uint16_t chip8_lanes_get_pc(Chip8Lanes* lanes, int lane);
+
+uint8_t chip8_lanes_get_register(Chip8Lanes* lanes, int lane, int reg);
+
+bool chip8_lanes_is_halted(Chip8Lanes* lanes, int lane);
+
+/*
+    Packed display of one lane, laid out like chip8_get_display_rows.
+*/
+const uint64_t* chip8_lanes_get_display_rows(Chip8Lanes* lanes, int lane);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -28,6 +28,9 @@ void chip8_log_screen(Chip8* chip);
 // halt
 void chip8_log_halt(Chip8* chip, const char* reason);
 
+// drains the diagnostic ring of chip and prints one line per entry; call from the host, not while stepping
+void chip8_log_diagnostics(Chip8* chip);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,95 @@
+#ifndef CHIP8_MOVIE_H
+#define CHIP8_MOVIE_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Input movies: everything the host feeds into a Chip8, stamped with cycle_count, so a
+    session replays bit-for-bit on any backend and at any speed.
+
+    A recording attached to an instance captures, as they happen:
+      - key transitions from chip8_key_press / chip8_key_release (repeats are ignored),
+      - timer ticks from chip8_update_timers, one per frame,
+      - the whole state whenever the host replaces it: the start of the recording,
+        chip8_reset, chip8_load_rom, chip8_load_state and chip8_set_seed.
+    Direct memory writes by the host (chip8_write_memory) are not recorded.
+
+    The guest only observes the host through those, and the interpreter reaches the same
+    state at the same cycle no matter how the cycles are batched, so running to each
+    stamp and applying the event there reproduces the session exactly. Every
+    keyframe_interval ticks a keyframe (a full state) is stored as well: playback checks
+    the replayed state against it, and seeking starts from the nearest one.
+
+    Positions in a movie are counted in frames, i.e. timer ticks since the start.
+*/
+
+#define CHIP8_MOVIE_VERSION 1
+
+// RECORDING
+
+/*
+    Starts recording chip from its current state. keyframe_interval <= 0 stores a
+    keyframe every 30 seconds of ticks. An instance records into one movie at a time.
+    returns NULL at failure.
+*/
+Chip8Movie* chip8_movie_record(Chip8* chip, int keyframe_interval);
+
+/*
+    Detaches the movie chip is recording into, which then belongs to the caller.
+    returns NULL if chip was not recording.
+*/
+Chip8Movie* chip8_movie_stop(Chip8* chip);
+
+bool chip8_movie_is_recording(Chip8* chip);
+
+// FILES
+
+bool chip8_movie_save(Chip8Movie* movie, const char* path);
+
+/*
+    returns NULL if the file is missing, truncated or of another version.
+*/
+Chip8Movie* chip8_movie_load(const char* path);
+
+/*
+    Frees the movie and renders the pointer NULL. A movie still attached to an instance
+    has to be detached with chip8_movie_stop first.
+*/
+void chip8_movie_destroy(Chip8Movie** movie_ptr);
+
+// PLAYBACK
+
+/*
+    Frames (timer ticks) in the movie.
+*/
+int chip8_movie_frames(Chip8Movie* movie);
+
+/*
+    Puts chip into the state of the movie at frame and makes it the playback position.
+    Frame 0 is where the recording started. Host settings of chip (backend, AOT module)
+    are kept, so the same movie can be checked on every backend.
+*/
+bool chip8_movie_seek(Chip8Movie* movie, Chip8* chip, int frame);
+
+/*
+    Plays frames from the playback position, running chip between events at full
+    speed. Stops early at the end of the movie or if chip halts.
+    returns the number of frames played.
+*/
+int chip8_movie_play(Chip8Movie* movie, Chip8* chip, int frames);
+
+/*
+    Keyframes passed during playback whose state did not match the replay. Anything
+    above 0 means the core is no longer deterministic for this movie.
+*/
+int chip8_movie_desyncs(Chip8Movie* movie);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
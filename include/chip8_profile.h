@@ -0,0 +1,90 @@
+#ifndef CHIP8_PROFILE_H
+#define CHIP8_PROFILE_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Per-address execution profile. While it is on, every executed instruction adds one
+    to the execution counter of its address, and the bytes it loads (DXYN sprites,
+    FX65) or stores (FX33, FX55) add one to their read or write counter. The counters
+    are flat arrays parallel to Chip8.memory.
+
+    When profiling, chip8_step_n runs the interpreter one instruction at a time on every
+    backend (without superinstructions or idle fast-forward, so each instruction is
+    counted where it ran). That is still far beyond the few hundred thousand
+    instructions per second a ROM needs, so it can stay on during normal play.
+    Instruction fetches are counted as executions, not reads, and bytes the host writes
+    are not counted. The counters survive resets and ROM loads until
+    chip8_profile_reset.
+
+    CALL and RET also move along a shadow call stack, so every cycle is charged to the
+    subroutine (call target) running it and to the chain of calls that led there. When
+    the host replaces the state (reset, loads, rewind, stepping back) the guest stack
+    no longer matches and attribution starts over at the top level; so does a RET
+    from a call made before profiling began.
+*/
+
+// Routine id of code run outside any call the profile saw
+#define CHIP8_PROFILE_TOP_LEVEL 0xFFFF
+
+typedef struct {
+    uint16_t address;
+    uint64_t executions;
+} Chip8ProfileSpot;
+
+typedef struct {
+    uint16_t entry;     // call target, or CHIP8_PROFILE_TOP_LEVEL
+    uint64_t calls;
+    uint64_t inclusive; // cycles in the routine and everything it called (outermost call if recursive)
+    uint64_t exclusive; // cycles in the routine itself
+} Chip8ProfileRoutine;
+
+/*
+    Starts counting from zero, or clears the counters if already on.
+*/
+bool chip8_profile_enable(Chip8* chip);
+
+/*
+    Stops counting and frees the counters.
+*/
+void chip8_profile_disable(Chip8* chip);
+
+bool chip8_profile_is_enabled(Chip8* chip);
+
+void chip8_profile_reset(Chip8* chip);
+
+/*
+    Counters per address, CHIP8_MEMORY_SIZE of each. NULL while profiling is off.
+*/
+const uint64_t* chip8_profile_executions(Chip8* chip);
+const uint64_t* chip8_profile_reads(Chip8* chip);
+const uint64_t* chip8_profile_writes(Chip8* chip);
+
+/*
+    Fills spots with up to max of the most executed addresses, most executed first.
+    returns the number filled; addresses never executed are left out.
+*/
+int chip8_profile_hotspots(Chip8* chip, Chip8ProfileSpot* spots, int max);
+
+/*
+    Fills routines with up to max subroutines, most inclusive cycles first.
+    returns the number filled.
+*/
+int chip8_profile_routines(Chip8* chip, Chip8ProfileRoutine* routines, int max);
+
+/*
+    Writes the call tree in folded-stack format, one "main;sub_2A4;sub_31C cycles" line
+    per call path with cycles of its own, for flamegraph.pl, speedscope and the like.
+    returns false at failure.
+*/
+bool chip8_profile_export_folded(Chip8* chip, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
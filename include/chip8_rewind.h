@@ -0,0 +1,73 @@
+#ifndef CHIP8_REWIND_H
+#define CHIP8_REWIND_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Rewind history: one save state (chip8_state.h) per frame, kept compressed.
+
+    The host pushes a frame after every 60 Hz update. Pushing only copies the state into
+    a staging queue; a background thread XORs it against the previous frame, run-length
+    encodes the result and appends it to the history. Every keyframe_interval frames a
+    full state is stored instead, so seeking decodes one keyframe and at most
+    keyframe_interval - 1 deltas. The oldest frames are dropped, a keyframe interval at a
+    time, once the history outgrows its memory budget.
+
+    Frames are numbered from 0, the oldest one still held.
+*/
+
+typedef struct Chip8Rewind Chip8Rewind;
+
+/*
+    max_bytes <= 0 uses a 4 MB budget, keyframe_interval <= 0 one keyframe per second.
+    returns NULL at failure.
+*/
+Chip8Rewind* chip8_rewind_create(size_t max_bytes, int keyframe_interval);
+
+/*
+    Stops the background thread, frees the history and renders the pointer NULL.
+*/
+void chip8_rewind_destroy(Chip8Rewind** rewind_ptr);
+
+/*
+    Records the current state of chip as the newest frame. Never waits for compression:
+    if the background thread has fallen a whole queue behind, the frame is dropped and
+    false is returned.
+*/
+bool chip8_rewind_push(Chip8Rewind* rewind, Chip8* chip);
+
+/*
+    Number of frames held, including those still waiting to be compressed.
+*/
+int chip8_rewind_count(Chip8Rewind* rewind);
+
+/*
+    Restores frame into chip (see chip8_load_state). Frames newer than it are kept, so
+    seeking back and forth works; call chip8_rewind_truncate before running on from it.
+*/
+bool chip8_rewind_seek(Chip8Rewind* rewind, int frame, Chip8* chip);
+
+/*
+    Forgets every frame after frame, so the next push continues the history from it.
+*/
+void chip8_rewind_truncate(Chip8Rewind* rewind, int frame);
+
+/*
+    Forgets every frame.
+*/
+void chip8_rewind_clear(Chip8Rewind* rewind);
+
+/*
+    Bytes of compressed history currently held.
+*/
+size_t chip8_rewind_memory_used(Chip8Rewind* rewind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef CHIP8_RUNNER_H
+#define CHIP8_RUNNER_H
+
+#include "chip8.h"
+#include "chip8_profile.h"
+#include "chip8_sampler.h"
+#include "chip8_watch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Runs one instance on a thread of its own for an interactive front end, so neither
+    vsync nor a slow UI frame holds the guest back.
+
+    The thread runs frames of cycles_per_frame cycles through chip8_run_until, ticking
+    the timers after each, 60 times a second (or back to back in turbo). Nothing else
+    touches the instance meanwhile; the front end sees it through three publications that
+    never block the thread:
+
+    - the display, through a triple buffer: the thread fills a spare frame and swaps it
+      in with one atomic exchange, and the reader swaps out the newest one.
+    - the CPU and debugger state, through a seqlock-protected Chip8RunnerState: the
+      thread bumps a sequence number around each copy and readers retry a copy that
+      overlapped one.
+    - the profile counters, call tree and sampler report, through a second seqlock, and
+      only while profiling or sampling.
+
+    Commands and keys go the other way through a single-producer single-consumer ring,
+    taken between frames. Everything else (stepping, breakpoint edits, loading states) needs
+    the instance itself: chip8_runner_acquire parks the thread at a frame boundary and
+    hands it over until chip8_runner_release.
+
+    Commands may only be sent from one thread, the one that created the runner.
+*/
+
+#define CHIP8_RUNNER_HZ 60 // frames per second outside turbo
+
+#define CHIP8_RUNNER_BREAKPOINTS 64  // breakpoints listed in Chip8RunnerState
+#define CHIP8_RUNNER_CONDITION   128 // condition bytes kept per breakpoint, longer ones are cut
+#define CHIP8_RUNNER_HOTSPOTS    8   // in Chip8RunnerProfile
+#define CHIP8_RUNNER_ROUTINES    32
+
+typedef struct Chip8Runner Chip8Runner;
+
+// Called on the runner's thread after every frame it runs, with the instance
+typedef void (*Chip8RunnerFrame)(Chip8* chip, void* user);
+
+// Called on the runner's thread by chip8_runner_call
+typedef void (*Chip8RunnerCall)(Chip8* chip, void* arg);
+
+typedef struct {
+    uint16_t address;
+    uint64_t hits;                            // see chip8_break_hits
+    char condition[CHIP8_RUNNER_CONDITION];   // empty for none
+} Chip8RunnerBreakpoint;
+
+typedef struct {
+    // CPU
+    uint16_t PC;
+    uint16_t I;
+    uint8_t SP;
+    uint8_t delay_timer;
+    uint8_t sound_timer;
+    bool halted;
+    uint16_t V[CHIP8_NUM_REGISTERS];
+    uint16_t stack[CHIP8_STACK_SIZE];
+    bool keys[CHIP8_NUM_KEYS];
+    uint64_t cycle_count;
+    uint64_t idle_cycles;
+    uint64_t diag_counts[CHIP8_DIAG_COUNT];
+    uint8_t memory[CHIP8_MEMORY_SIZE];
+    uint8_t backend; // Chip8Backend
+    bool has_aot;    // a module is loaded, see chip8_load_aot
+
+    // debugger
+    uint64_t breakpoints[CHIP8_MEMORY_SIZE / 64]; // bit set for every address with a breakpoint
+    int breakpoint_count;                         // listed below, in address order
+    Chip8RunnerBreakpoint breakpoint_list[CHIP8_RUNNER_BREAKPOINTS];
+    uint32_t watched_registers;                   // bit set for every watched Chip8WatchRegister
+    Chip8MemoryWatch watches[CHIP8_WATCH_MAX];    // by id, length 0 for a free slot
+    bool has_watch_hit;
+    Chip8WatchHit watch_hit;                      // see chip8_watch_last_hit
+    bool undo_enabled;                            // see chip8_undo_is_enabled
+    int undo_available;                           // see chip8_undo_available
+    bool profiling;                               // see chip8_profile_is_enabled
+    bool sampling;                                // see chip8_sampler_is_running
+    bool recording;                               // see chip8_movie_is_recording
+    bool tracing;                                 // see chip8_trace_is_recording
+
+    // runner
+    bool running;     // running frames on its own
+    int stop_reason;  // Chip8StopReason that ended the last run, -1 if a command paused it
+    uint64_t frames;  // frames run on the thread
+    uint64_t commands; // commands taken from the queue so far, see chip8_runner_sent
+} Chip8RunnerState;
+
+typedef struct {
+    // counting profiler, while Chip8RunnerState.profiling
+    uint64_t executions[CHIP8_MEMORY_SIZE];
+    uint64_t reads[CHIP8_MEMORY_SIZE];
+    uint64_t writes[CHIP8_MEMORY_SIZE];
+    int hotspot_count;
+    Chip8ProfileSpot hotspots[CHIP8_RUNNER_HOTSPOTS];    // see chip8_profile_hotspots
+    int routine_count;
+    Chip8ProfileRoutine routines[CHIP8_RUNNER_ROUTINES]; // see chip8_profile_routines
+
+    // sampler, while Chip8RunnerState.sampling
+    Chip8SampleReport samples;
+} Chip8RunnerProfile;
+
+/*
+    Starts a paused thread for chip, which then belongs to the runner until
+    chip8_runner_destroy. on_frame may be NULL. returns NULL at failure.
+*/
+Chip8Runner* chip8_runner_create(Chip8* chip, Chip8RunnerFrame on_frame, void* user);
+
+/*
+    Stops and joins the thread and renders the pointer NULL. The instance is the
+    caller's again; it is not destroyed.
+*/
+void chip8_runner_destroy(Chip8Runner** runner_ptr);
+
+// COMMANDS
+
+void chip8_runner_run(Chip8Runner* runner, bool run);
+
+void chip8_runner_set_key(Chip8Runner* runner, uint8_t key, bool pressed);
+
+/*
+    Cycles per frame, and whether frames run back to back instead of at CHIP8_RUNNER_HZ.
+*/
+void chip8_runner_set_speed(Chip8Runner* runner, int cycles_per_frame, bool turbo);
+
+/*
+    Commands sent so far. A state whose commands field has caught up with it reflects
+    all of them.
+*/
+uint64_t chip8_runner_sent(Chip8Runner* runner);
+
+/*
+    Parks the thread once it finishes the frame it is in, and returns the instance,
+    which the caller may use freely until chip8_runner_release. Commands sent meanwhile
+    are taken after the release.
+*/
+Chip8* chip8_runner_acquire(Chip8Runner* runner);
+
+/*
+    Publishes the state and display as the caller left them and lets the thread go on.
+*/
+void chip8_runner_release(Chip8Runner* runner);
+
+/*
+    Runs fn on the runner's thread between frames, and waits for it; for what has to
+    happen on that thread, such as chip8_sampler_start and chip8_sampler_stop. Not
+    while acquired.
+*/
+void chip8_runner_call(Chip8Runner* runner, Chip8RunnerCall fn, void* arg);
+
+// PUBLICATION
+
+/*
+    Copies the latest published state into state. Never blocks the thread; retries
+    while a copy overlaps a publication.
+*/
+void chip8_runner_read_state(Chip8Runner* runner, Chip8RunnerState* state);
+
+/*
+    Copies the latest published profile into profile, like chip8_runner_read_state.
+    Only published while the instance is profiled or sampled; stale otherwise.
+*/
+void chip8_runner_read_profile(Chip8Runner* runner, Chip8RunnerProfile* profile);
+
+/*
+    The newest display published since the last call, one word per row as in
+    chip8_get_display_rows, or NULL if none is. Valid until the next call.
+*/
+const uint64_t* chip8_runner_take_display(Chip8Runner* runner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef CHIP8_RUNTIME_H
+#define CHIP8_RUNTIME_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Runs many independent Chip8 instances on a pool of worker threads.
+
+    Every submitted instance becomes a job with its own cycle budget. Workers run jobs in
+    slices of a few frames (chip8_step_n, then chip8_update_timers, per frame) and queue
+    unfinished jobs again behind their other work; a worker whose queue is empty steals
+    from the others, so long and short jobs spread evenly over the pool.
+
+    An instance belongs to the runtime from chip8_runtime_submit until its completion
+    callback has started: the host must not touch it, or submit it again, in between.
+*/
+
+typedef struct Chip8Runtime Chip8Runtime;
+
+/*
+    Called on a worker thread once the job's budget is spent or the instance halted.
+    The instance is the host's again from here on; it may be resubmitted or destroyed.
+*/
+typedef void (*Chip8RuntimeDone)(Chip8* chip, void* user);
+
+typedef struct {
+    uint64_t cycles;         // cycle budget of this job
+    int cycles_per_frame;    // timers tick once every cycles_per_frame cycles
+    Chip8RuntimeDone done;   // may be NULL
+    void* user;              // passed to done
+} Chip8RuntimeJob;
+
+/*
+    Starts the worker threads.
+    threads <= 0 uses one per online CPU, slice_frames <= 0 a default slice of 16 frames.
+
+    returns NULL at failure.
+*/
+Chip8Runtime* chip8_runtime_create(int threads, int slice_frames);
+
+/*
+    Waits for every submitted job, stops the workers and renders the pointer NULL.
+*/
+void chip8_runtime_destroy(Chip8Runtime** rt_ptr);
+
+/*
+    Queues chip to run under job. Safe to call from any thread, including from a callback.
+    returns false if the job is invalid or could not be queued.
+*/
+bool chip8_runtime_submit(Chip8Runtime* rt, Chip8* chip, const Chip8RuntimeJob* job);
+
+/*
+    Blocks until every job submitted so far, and any submitted by their callbacks, is done.
+*/
+void chip8_runtime_wait(Chip8Runtime* rt);
+
+int chip8_runtime_thread_count(Chip8Runtime* rt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef CHIP8_SAMPLER_H
+#define CHIP8_SAMPLER_H
+
+#include "chip8.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Statistical profiler. A SIGPROF timer fires on the thread that started it at a
+    fixed rate, and the signal handler notes the guest PC, the stack depth and
+    Chip8.phase (interpreting, running translated code, compiling or in the host) into
+    a lock-free ring. chip8_step_n folds the ring into a report after each call, so the
+    emulation itself pays nothing but two byte stores per chip8_step_n and per
+    translated block. Unlike chip8_profile.h, it leaves every backend running at full
+    speed.
+
+    Under the JIT and AOT backends the sampled PC is the start of the block being run,
+    not the exact instruction inside it. If the ring fills up between two
+    chip8_step_n calls, samples are counted as dropped.
+
+    Linux uses a timer_create timer on the monotonic clock aimed at that thread, so time
+    the thread spends blocked (e.g. waiting for vsync) is sampled too, as the host
+    phase; CPU-time timers only fire on scheduler ticks, too coarse for 1 kHz. Other
+    POSIX hosts use the process-wide ITIMER_PROF and keep only the signals that hit the
+    sampled thread. Only one instance per process can be sampled at a time.
+*/
+
+#define CHIP8_SAMPLER_DEFAULT_HZ 1000
+
+typedef struct {
+    uint64_t samples;                       // samples in the counts below
+    uint64_t dropped;                       // samples lost to a full ring
+    uint64_t phases[CHIP8_PHASE_COUNT];     // samples per Chip8Phase
+    uint64_t depths[CHIP8_STACK_SIZE + 1];  // samples per stack depth (SP)
+    uint64_t pcs[CHIP8_MEMORY_SIZE];        // guest samples (any phase but host) per PC
+} Chip8SampleReport;
+
+/*
+    Starts sampling the calling thread hz times per second (<= 0 for
+    CHIP8_SAMPLER_DEFAULT_HZ), with an empty report. Call it from the thread that runs
+    chip. returns false at failure, if chip is already sampled or if another instance
+    is.
+*/
+bool chip8_sampler_start(Chip8* chip, int hz);
+
+/*
+    Stops the timer and frees the report. Call it from the sampled thread, like
+    chip8_sampler_start, or once that thread has exited (chip8_destroy stops it too):
+    stop frees what the signal handler writes to and puts back the previous SIGPROF
+    action, and only on the sampled thread can no handler still be running or a timer
+    signal still be on its way.
+*/
+void chip8_sampler_stop(Chip8* chip);
+
+bool chip8_sampler_is_running(Chip8* chip);
+
+/*
+    Empties the report; sampling goes on.
+*/
+void chip8_sampler_reset(Chip8* chip);
+
+/*
+    The report with every sample taken so far, or NULL if chip is not sampled. Valid
+    until chip8_sampler_stop.
+*/
+const Chip8SampleReport* chip8_sampler_report(Chip8* chip);
+
+/*
+    Writes the report as text: the phase split, the stack depths and the top most
+    sampled addresses, disassembled.
+*/
+void chip8_sampler_print_report(Chip8* chip, FILE* out, int top);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef CHIP8_SNAPSHOT_H
+#define CHIP8_SNAPSHOT_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Snapshots: immutable, refcounted machine states for forking many runs from one point.
+
+    Memory is held as CHIP8_PAGE_COUNT refcounted pages of CHIP8_PAGE_SIZE bytes. An
+    instance remembers the last snapshot it took or restored and which pages it wrote
+    since (FX33, FX55, chip8_write_memory, ROM and state loads), so:
+      - taking a snapshot allocates only the written pages and shares the rest with the
+        previous one,
+      - restoring copies only the pages that differ from the instance's own snapshot,
+        and keeps the decoded and translated code of every other page.
+    Code and font pages are rarely written, so a tree of thousands of forks stores them
+    once. Live instances keep their memory flat, so execution speed is unaffected.
+
+    Snapshots never change once taken: any number of threads may restore, retain and
+    release the same one concurrently.
+*/
+
+/*
+    Captures chip (the same fields as chip8_save_state). The caller owns the returned
+    reference. returns NULL at failure.
+*/
+Chip8Snapshot* chip8_snapshot_take(Chip8* chip);
+
+/*
+    Puts chip into the state of snapshot. Host settings of chip (backend, AOT module)
+    are kept.
+*/
+bool chip8_snapshot_restore(Chip8* chip, Chip8Snapshot* snapshot);
+
+/*
+    Adds a reference and returns snapshot.
+*/
+Chip8Snapshot* chip8_snapshot_retain(Chip8Snapshot* snapshot);
+
+/*
+    Drops a reference, freeing the snapshot and its unshared pages with the last one,
+    and renders the pointer NULL.
+*/
+void chip8_snapshot_release(Chip8Snapshot** snapshot_ptr);
+
+uint64_t chip8_snapshot_cycle_count(const Chip8Snapshot* snapshot);
+
+/*
+    Pages allocated by all snapshots of the process, to measure how much is shared.
+*/
+size_t chip8_snapshot_live_pages(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
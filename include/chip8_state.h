@@ -0,0 +1,72 @@
+#ifndef CHIP8_STATE_H
+#define CHIP8_STATE_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Snapshots of the machine state in a compact, versioned binary format.
+
+    A state holds what the guest can observe: memory, display, registers, stack, timers,
+    keys, RNG and the cycle counters. Host-side settings (backend, ROM path, loaded AOT
+    module) and diagnostics stay with the instance a state is loaded into, so a state
+    restores into any instance, and loading one is a cheap way to clone or rewind it.
+    All multi-byte fields are little-endian.
+*/
+
+#define CHIP8_STATE_VERSION 1
+
+// Bytes of a state written by chip8_save_state
+#define CHIP8_STATE_SIZE 4466
+
+// Display thumbnail stored in state files: 2x2 pixels per bit, one word per row, bit 31 leftmost
+#define CHIP8_THUMB_WIDTH  (CHIP8_DISPLAY_WIDTH / 2)
+#define CHIP8_THUMB_HEIGHT (CHIP8_DISPLAY_HEIGHT / 2)
+
+/*
+    Writes the state of chip into buf, which must hold CHIP8_STATE_SIZE bytes.
+    returns the number of bytes written, or 0 at failure.
+*/
+size_t chip8_save_state(Chip8* chip, void* buf, size_t size);
+
+/*
+    Restores a state written by chip8_save_state. Decoded and translated code is only
+    dropped for memory that actually differs, so restoring a state of the same ROM
+    keeps the caches warm. Every display row is marked dirty.
+    returns false, leaving chip untouched, if the state is truncated, of another version
+    or holds an out-of-range field (a stack pointer past the stack, unknown flags).
+*/
+bool chip8_load_state(Chip8* chip, const void* buf, size_t size);
+
+/*
+    Whether two states written by chip8_save_state hold the same machine. idle_cycles is
+    left out: how many cycles were fast-forwarded depends on how the decode cache was
+    warmed and on the backend, not on anything the guest did.
+*/
+bool chip8_state_equal(const void* a, const void* b);
+
+/*
+    Saves the state into a file, together with a display thumbnail. The file is written
+    next to path and renamed over it, so an existing slot is never left half written.
+*/
+bool chip8_save_state_file(Chip8* chip, const char* path);
+
+/*
+    Restores a state file written by chip8_save_state_file. The file is mapped rather
+    than read where the platform allows.
+*/
+bool chip8_load_state_file(Chip8* chip, const char* path);
+
+/*
+    Reads only the thumbnail of a state file, e.g. to preview save slots.
+*/
+bool chip8_read_state_thumbnail(const char* path, uint32_t thumb[CHIP8_THUMB_HEIGHT]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
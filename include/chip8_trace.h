@@ -0,0 +1,121 @@
+#ifndef CHIP8_TRACE_H
+#define CHIP8_TRACE_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Binary instruction traces: one packed 16-byte record per executed instruction,
+    written to a file by a background thread.
+
+    While an instance is tracing, chip8_step_n runs the interpreter without
+    superinstructions or idle fast-forward (on every backend) and stores each record
+    straight into a 1 MB buffer. Full buffers go to the writer thread, which appends
+    them to the file; the emulation thread only ever waits if the disk falls 8 MB
+    behind. Records are never dropped.
+
+    File layout: "C8TR" u16 version u16 record size u16 byte order mark (0x0102)
+    u16 0 u32 0, then the records in host byte order. The reader refuses files from a
+    host of the other byte order.
+
+    Next to each trace the writer thread leaves a side index, <path>.idx, that lists for
+    every PC, opcode and written register the 4096-record buckets it occurs in, plus the
+    cycle each bucket reaches. Queries read at most two buckets of the trace, so they
+    answer at once however large it is. A trace whose index is missing or stale (e.g.
+    recording was cut short) is indexed once on open, which does read it all.
+*/
+
+#define CHIP8_TRACE_VERSION 1
+
+typedef struct {
+    uint64_t cycle;  // cycle_count the instruction ran at
+    uint16_t pc;     // address it was fetched from
+    uint16_t opcode;
+    uint16_t i;      // I after it ran
+    uint16_t value;  // the register it wrote after it ran, see chip8_trace_changed_register; 0 if none
+} Chip8TraceRecord;
+
+typedef struct Chip8TraceReader Chip8TraceReader;
+
+// What chip8_trace_find looks for
+typedef enum {
+    CHIP8_TRACE_BY_PC,      // records fetched from an address
+    CHIP8_TRACE_BY_OPCODE,  // records of one opcode
+    CHIP8_TRACE_BY_WRITE,   // records that wrote a register, see chip8_trace_written_registers
+} Chip8TraceKey;
+
+// RECORDING
+
+/*
+    Starts tracing chip into path, replacing the file. returns false at failure or if
+    chip is already tracing.
+*/
+bool chip8_trace_start(Chip8* chip, const char* path);
+
+/*
+    Writes out what is buffered, stops the writer thread and closes the file.
+    returns false if any write failed.
+*/
+bool chip8_trace_stop(Chip8* chip);
+
+bool chip8_trace_is_recording(Chip8* chip);
+
+/*
+    Records produced since chip8_trace_start, written or still buffered.
+*/
+uint64_t chip8_trace_recorded(Chip8* chip);
+
+// READING
+
+/*
+    Maps a trace file for reading and loads its index, building and saving it if
+    needed. returns NULL if it is missing or not a trace.
+*/
+Chip8TraceReader* chip8_trace_open(const char* path);
+
+/*
+    Unmaps the file and renders the pointer NULL.
+*/
+void chip8_trace_close(Chip8TraceReader** reader_ptr);
+
+uint64_t chip8_trace_count(const Chip8TraceReader* reader);
+
+/*
+    All records, oldest first; valid until chip8_trace_close.
+*/
+const Chip8TraceRecord* chip8_trace_records(const Chip8TraceReader* reader);
+
+/*
+    The first record, in file order, that ran at cycle or later. returns -1 if none.
+*/
+int64_t chip8_trace_find_cycle(const Chip8TraceReader* reader, uint64_t cycle);
+
+/*
+    The nearest record after from (or before it, if backward) whose PC, opcode or
+    written register is value. from may be -1, or the record count when backward, to
+    search the whole trace. returns -1 if none.
+*/
+int64_t chip8_trace_find(const Chip8TraceReader* reader, Chip8TraceKey key, uint16_t value,
+                         int64_t from, bool backward);
+
+/*
+    The register whose value a record of this opcode carries: VX for 6XNN, 7XNN, 8XYN,
+    CXNN, FX07, FX0A and FX65 (the last one loaded), VF for DXYN. returns -1 for
+    opcodes that write no register.
+*/
+int chip8_trace_changed_register(uint16_t opcode);
+
+/*
+    Every register an opcode writes, bit r for Vr: VX and VF for 8XY1-8XY7 and 8XYE,
+    V0 through VX for FX65, and so on. What CHIP8_TRACE_BY_WRITE searches match.
+*/
+uint16_t chip8_trace_written_registers(uint16_t opcode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -6,6 +6,15 @@
 #include <string.h>
 
 #include "chip8.h"
+#include "chip8_rewind.h"
+#include "chip8_movie.h"
+#include "chip8_undo.h"
+#include "chip8_trace.h"
+#include "chip8_profile.h"
+#include "chip8_sampler.h"
+#include "chip8_break.h"
+#include "chip8_watch.h"
+#include "chip8_runner.h"
 
 #include "../libs/glad/include/glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -16,17 +25,69 @@
 
 typedef struct {
     // emulator
-    Chip8* chip;
+    Chip8* chip;            // NULL without a ROM; the runner's while it runs, see borrow_chip
+    Chip8Runner* runner;
+    Chip8RunnerState state; // published state, read once per frame; what the windows show
+    Chip8RunnerProfile profile; // published profile, read with state while profiling or sampling
+    bool borrowed;          // runner parked and chip ours until the end of the frame
     bool running;
     char rom_path[256];
+    bool keys[CHIP8_NUM_KEYS]; // last sent to the runner
 
     // display
     GLuint display_texture; // gl texture for chip-8 screen
+    uint64_t display_rows[CHIP8_DISPLAY_HEIGHT]; // in the texture
+    uint32_t display_dirty; // rows to upload whatever they hold, e.g. after a ROM load
     float display_scale;    // zoom level for screen
 
     // execution control
     int cycles_per_frame;   // number of chip8_step() executions per frame
+    bool turbo;             // frames back to back instead of at 60 Hz
+    bool auto_speed;        // tune cycles_per_frame from the ROM's idle fraction
+    float idle_fraction;    // share of the cycles since the last frame spent in idle loops
+    uint64_t seen_cycles;   // cycle and idle counts at the last frame
+    uint64_t seen_idle;
+    int sent_cycles;        // speed the runner has, -1 before the first
+    bool sent_turbo;
     int step_count;         // for "step_n"
+    bool reversing;         // stepping back cycles_per_frame instructions per frame (undo log)
+    int backend;            // Chip8Backend picked in Controls, -1 for the core default
+    int stop_reason;        // Chip8StopReason that last ended a run early, -1 if none
+
+    // breakpoints (kept in chip, see chip8_break.h)
+    char break_address[8];     // fields of the Disassembly window's breakpoint editor
+    char break_condition[128];
+    char break_error[128];     // why the last condition did not compile
+
+    // watchpoints (kept in chip, see chip8_watch.h)
+    char watch_start[8];       // fields of the Memory window's watchpoint editor
+    char watch_length[8];
+    bool watch_read;
+    bool watch_write;
+    char watch_error[64];
+
+    // rewind
+    Chip8Rewind* rewind;    // one state per frame run, pushed from the runner's thread; NULL without a ROM
+    int rewind_frame;       // frame picked on the scrubber, -1 while at the live end
+
+    // movies (recording is attached to chip, see chip8_movie_record)
+    Chip8Movie* movie;      // movie being played back instead of the keyboard, NULL otherwise
+
+    // trace browser (recording is attached to chip, see chip8_trace_start)
+    Chip8TraceReader* trace; // trace open in the Trace window, NULL otherwise
+    int64_t trace_base;      // first record of the listed window
+    int64_t trace_selected;  // -1 for none
+    bool trace_scroll;       // bring the selection into view next frame
+    uint64_t trace_cycle;    // search fields, filled in from the selected record
+    uint16_t trace_pc;
+    uint16_t trace_opcode;
+    int trace_reg;
+
+    // profile heat map: counts since the last frame, decayed every frame
+    float heat[3][CHIP8_MEMORY_SIZE];         // executions, reads, writes
+    uint64_t heat_seen[3][CHIP8_MEMORY_SIZE]; // published profile counters at the last frame
+    float heat_max[3];                        // hottest address of each, for scaling
+    bool show_heat;                           // overlay in the Memory window
 
     // memory and dissasembly viewer
     int memory_cols;        // bytes per row in memory viewer
@@ -39,6 +100,8 @@ typedef struct {
     bool show_cpu_state;
     bool show_keyboard;
     bool show_disassembly;
+    bool show_trace;
+    bool show_profile;
 
     // window exit 
     bool exit_requested;
@@ -73,7 +136,7 @@ void chip8_ui_close_rom(Chip8UI* ui);
 // == Per-frame calls ==
 
 /*
-    Step emulator N steps.
+    Takes the runner's latest state, and plays a movie or runs backwards by a frame.
     Call BEFORE Imgui::NewFrame();
 */
 void chip8_ui_update(Chip8UI* ui);
@@ -0,0 +1,59 @@
+#ifndef CHIP8_UNDO_H
+#define CHIP8_UNDO_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Reverse stepping. While the undo log is enabled, every executed instruction appends
+    a compact record of what it overwrote: PC, I, SP, timers and flags, the registers and
+    stack slots that changed, and the memory bytes (FX33, FX55), display rows (00E0,
+    DXYN) or generator state (CXNN) it touched. Stepping back pops one record, so it
+    costs about as much as stepping forward.
+
+    The log is off by default. When it is on, chip8_step_n runs every backend one
+    instruction at a time, without superinstructions or idle fast-forward, so it is
+    meant for debugging rather than full speed. The oldest records are dropped once the
+    log outgrows its budget, and the log is cleared whenever the host replaces the state
+    (reset, ROM or state load, snapshot restore, seed).
+
+    Timer ticks and key changes made by the host are not instructions: stepping back
+    over a tick restores the timers the instruction saw.
+*/
+
+/*
+    Starts logging, or clears the log and changes its budget if already on.
+    max_bytes <= 0 uses 4 MB, roughly 250k instructions.
+*/
+bool chip8_undo_enable(Chip8* chip, size_t max_bytes);
+
+/*
+    Stops logging and frees the log.
+*/
+void chip8_undo_disable(Chip8* chip);
+
+bool chip8_undo_is_enabled(Chip8* chip);
+
+/*
+    Instructions that can currently be stepped back.
+*/
+int chip8_undo_available(Chip8* chip);
+
+/*
+    Undoes the last executed instruction. returns false if there is none.
+*/
+bool chip8_step_back(Chip8* chip);
+
+/*
+    Undoes up to n instructions. returns the number undone.
+*/
+int chip8_step_back_n(Chip8* chip, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef CHIP8_WATCH_H
+#define CHIP8_WATCH_H
+
+#include "chip8.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Watchpoints: chip8_run_until stops with CHIP8_STOP_WATCHPOINT right after the
+    instruction that reads or writes a watched memory range, or changes a watched
+    register.
+
+    Memory is watched through one read and one write bit per 256-byte page, kept in
+    Chip8, so the guest's loads (DXYN sprites, FX65) and stores (FX33, FX55) outside a
+    watched page pay a single bit test, on every backend; only in a watched page are the
+    ranges themselves compared. The host's own chip8_read_memory/chip8_write_memory are
+    never caught.
+
+    Registers are compared against shadow copies after each instruction, and only while
+    at least one is watched. The shadows are taken when chip8_run_until starts, so
+    changes the host makes between runs (timer ticks, key waits, edits) do not count.
+
+    While anything is watched chip8_run_until runs the switch interpreter, as with
+    breakpoints (see chip8_break.h). Watchpoints survive resets and ROM loads.
+*/
+
+#define CHIP8_WATCH_MAX 32 // memory ranges per instance
+
+// What a memory watch catches; also the kind of a Chip8WatchHit
+typedef enum {
+    CHIP8_WATCH_READ   = 1,
+    CHIP8_WATCH_WRITE  = 2,
+    CHIP8_WATCH_ACCESS = 3, // either
+    CHIP8_WATCH_CHANGE = 4, // a register changed (hits only)
+} Chip8WatchKind;
+
+typedef enum {
+    CHIP8_WATCH_V0 = 0, // V0 to VF are 0 to 15
+    CHIP8_WATCH_VF = 15,
+    CHIP8_WATCH_I,
+    CHIP8_WATCH_DT,
+    CHIP8_WATCH_ST,
+    CHIP8_WATCH_SP,
+    CHIP8_WATCH_REGISTER_COUNT
+} Chip8WatchRegister;
+
+typedef struct {
+    uint16_t start;
+    uint16_t length; // 0 for a free slot
+    uint8_t access;  // CHIP8_WATCH_READ and/or CHIP8_WATCH_WRITE
+    uint64_t hits;   // bytes accessed under it by the guest
+} Chip8MemoryWatch;
+
+typedef struct {
+    uint8_t kind;       // CHIP8_WATCH_READ, CHIP8_WATCH_WRITE or CHIP8_WATCH_CHANGE
+    uint16_t target;    // memory address, or Chip8WatchRegister for CHIP8_WATCH_CHANGE
+    uint16_t pc;        // instruction that made the access
+    uint64_t cycle;     // cycle it ran at
+    uint16_t old_value;
+    uint16_t new_value; // the value read, for CHIP8_WATCH_READ
+} Chip8WatchHit;
+
+// MEMORY
+
+/*
+    Watches length bytes from start (wrapping at the end of memory) for the accesses in
+    access. returns its id, 0 to CHIP8_WATCH_MAX - 1, or -1 at failure or if all are
+    taken.
+*/
+int chip8_watch_memory(Chip8* chip, uint16_t start, uint16_t length, uint8_t access);
+
+void chip8_watch_remove(Chip8* chip, int id);
+
+/*
+    The memory watch with this id, or NULL if the slot is free.
+*/
+const Chip8MemoryWatch* chip8_watch_get(Chip8* chip, int id);
+
+// REGISTERS
+
+bool chip8_watch_register(Chip8* chip, Chip8WatchRegister reg, bool on);
+
+bool chip8_watch_register_is_set(Chip8* chip, Chip8WatchRegister reg);
+
+/*
+    Times the guest changed reg while it was watched.
+*/
+uint64_t chip8_watch_register_hits(Chip8* chip, Chip8WatchRegister reg);
+
+const char* chip8_watch_register_name(Chip8WatchRegister reg);
+
+// BOTH
+
+/*
+    Removes every watch.
+*/
+void chip8_watch_clear_all(Chip8* chip);
+
+/*
+    The first hit since chip8_run_until last started, the one that stopped it with
+    CHIP8_STOP_WATCHPOINT; NULL if there was none.
+*/
+const Chip8WatchHit* chip8_watch_last_hit(Chip8* chip);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,11 +1,34 @@
 #include "../include/chip8.h"
+#include "../include/chip8_movie.h"
+#include "../include/chip8_snapshot.h"
+#include "../include/chip8_undo.h"
+#include "../include/chip8_profile.h"
+#include "../include/chip8_sampler.h"
+#include "../include/chip8_break.h"
+#include "../include/chip8_watch.h"
+#include "chip8_internal.h"
 #include <stdio.h>
 #include <stdlib.h> 
 #include <string.h>
 
+// Computed goto is a GNU extension; other compilers only get the switch backend
+#if defined(__GNUC__) || defined(__clang__)
+#define CHIP8_HAVE_THREADED 1
+#else
+#define CHIP8_HAVE_THREADED 0
+#endif
+
+#ifndef CHIP8_DEFAULT_BACKEND
+#if CHIP8_HAVE_THREADED
+#define CHIP8_DEFAULT_BACKEND CHIP8_BACKEND_THREADED
+#else
+#define CHIP8_DEFAULT_BACKEND CHIP8_BACKEND_SWITCH
+#endif
+#endif
+
 // FONTS
 
-static uint8_t FONT_DATA[80] = {
+static const uint8_t FONT_DATA[80] = {
     0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
     0x20, 0x60, 0x20, 0x20, 0x70, // 1
     0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
@@ -27,6 +50,22 @@ static uint8_t FONT_DATA[80] = {
 // PRIVATE FUNCTIONS
 
 static void chip8_init_state(Chip8* chip) {
+    // host-side settings and resources survive a reset
+    uint8_t backend = chip->backend;
+    uint64_t rand_seed = chip->rand_seed;
+    Chip8Jit* jit = chip->jit;
+    Chip8Aot* aot = chip->aot;
+    Chip8Movie* movie = chip->movie;
+    Chip8Undo* undo = chip->undo;
+    Chip8Trace* trace = chip->trace;
+    Chip8Profile* profile = chip->profile;
+    Chip8Sampler* sampler = chip->sampler;
+    Chip8Breakpoints* breakpoints = chip->breakpoints;
+    Chip8Watches* watches = chip->watches;
+    uint16_t watch_read_pages = chip->watch_read_pages;
+    uint16_t watch_write_pages = chip->watch_write_pages;
+    chip8_snapshot_release(&chip->snapshot); // memory starts over
+
     // memset the entirery of chip to 0
     memset(chip, 0, sizeof(Chip8));
 
@@ -39,339 +78,1069 @@ static void chip8_init_state(Chip8* chip) {
     chip->running = false;
     chip->halted = false;
     chip->cycle_count = 0;
+    chip->rand_seed = rand_seed;
+    chip->rand_state = chip8_rand_seed(rand_seed);
+    chip->dirty_rows = 0xFFFFFFFFu; // whatever showed the old display has to redraw
+    chip->dirty_pages = CHIP8_ALL_PAGES;
+
+    chip->backend = backend;
+    chip->jit = jit;
+    chip->aot = aot;
+    chip->movie = movie;
+    chip->undo = undo;
+    chip->trace = trace;
+    chip->profile = profile;
+    chip->sampler = sampler;
+    chip->breakpoints = breakpoints;
+    chip->watches = watches;
+    chip->watch_read_pages = watch_read_pages;
+    chip->watch_write_pages = watch_write_pages;
+    if (chip->jit) {
+        chip8_jit_flush(chip->jit);
+        chip8_aot_install(chip);
+    }
 }
 
 static uint16_t chip8_fetch(Chip8* chip) {
-    uint8_t byte1 = chip->memory[chip->PC];
-    uint8_t byte2 = chip->memory[chip->PC + 1];
+    uint8_t byte1 = chip->memory[CHIP8_ADDR(chip->PC)];
+    uint8_t byte2 = chip->memory[CHIP8_ADDR(chip->PC + 1)];
 
     uint16_t opcode = (byte1 << 8) | byte2;
     return opcode;
 }
 
-static void chip8_execute(Chip8* chip, uint16_t opcode) {
-    uint8_t x = (opcode & 0x0F00) >> 8;
-    uint8_t y = (opcode & 0x00F0) >> 4;
+// DECODING
+
+/*
+    Handler ids stored in Chip8Instr.op.
+    CHIP8_OP_UNDECODED must stay 0 so that a zeroed cache reads as empty.
+*/
+enum {
+    CHIP8_OP_UNDECODED = 0,
+    CHIP8_OP_INVALID,   // unassigned sub-op (5XY1, 8XY8, EX00, FX00...), ignored like before
+
+    CHIP8_OP_CLS,       // 00E0
+    CHIP8_OP_RET,       // 00EE
+    CHIP8_OP_SYS,       // 0NNN
+    CHIP8_OP_JP,        // 1NNN
+    CHIP8_OP_CALL,      // 2NNN
+    CHIP8_OP_SE_IMM,    // 3XNN
+    CHIP8_OP_SNE_IMM,   // 4XNN
+    CHIP8_OP_SE_REG,    // 5XY0
+    CHIP8_OP_LD_IMM,    // 6XNN
+    CHIP8_OP_ADD_IMM,   // 7XNN
+    CHIP8_OP_LD_REG,    // 8XY0
+    CHIP8_OP_OR,        // 8XY1
+    CHIP8_OP_AND,       // 8XY2
+    CHIP8_OP_XOR,       // 8XY3
+    CHIP8_OP_ADD_REG,   // 8XY4
+    CHIP8_OP_SUB,       // 8XY5
+    CHIP8_OP_SHR,       // 8XY6
+    CHIP8_OP_SUBN,      // 8XY7
+    CHIP8_OP_SHL,       // 8XYE
+    CHIP8_OP_SNE_REG,   // 9XY0
+    CHIP8_OP_LD_I,      // ANNN
+    CHIP8_OP_JP_V0,     // BNNN
+    CHIP8_OP_RND,       // CXNN
+    CHIP8_OP_DRW,       // DXYN
+    CHIP8_OP_SKP,       // EX9E
+    CHIP8_OP_SKNP,      // EXA1
+    CHIP8_OP_LD_VX_DT,  // FX07
+    CHIP8_OP_LD_VX_K,   // FX0A
+    CHIP8_OP_LD_DT_VX,  // FX15
+    CHIP8_OP_LD_ST_VX,  // FX18
+    CHIP8_OP_ADD_I,     // FX1E
+    CHIP8_OP_LD_F,      // FX29
+    CHIP8_OP_LD_B,      // FX33
+    CHIP8_OP_LD_MEM_VX, // FX55
+    CHIP8_OP_LD_VX_MEM, // FX65
+
+    // Superinstructions, only ever stored in the cache slot of their first instruction.
+    // The following instructions keep their own slots, which the fused handlers read operands from.
+    CHIP8_OP_FUSED_SPRITE, // 6XNN; 6YNN; DXYN
+    CHIP8_OP_FUSED_LOOP,   // 7XNN; 3XNN/4XNN; 1NNN
+    CHIP8_OP_FUSED_INDEX,  // ANNN; FX1E
+    CHIP8_OP_IDLE_JP,      // 1NNN jumping to itself
+    CHIP8_OP_IDLE_DT_POLL, // FX07; 3XNN/4XNN; 1NNN back to the FX07
+
+    CHIP8_OP_COUNT
+};
+
+#define CHIP8_OP_FUSED_FIRST CHIP8_OP_FUSED_SPRITE
+#define CHIP8_FUSED_SPAN     3 // longest superinstruction, in instructions
+
+static uint8_t chip8_decode_op(uint16_t opcode) {
     uint8_t n = (opcode & 0x000F);
     uint8_t nn = (opcode & 0x00FF);
-    uint16_t nnn = (opcode & 0x0FFF);
 
     switch (opcode & 0xF000) {
-        // TODO: Implement all 35 opcode
-
-        // === System & Flow Control (0xxx) ===
         case 0x0000:
-            switch (opcode & 0x00FF) {
-                case 0x00E0:
-                // Clear the screen
-                memset(chip->display, 0, sizeof(chip->display));
-                chip->draw_flag = true;
-                break;
+            if (nn == 0xE0) return CHIP8_OP_CLS;
+            if (nn == 0xEE) return CHIP8_OP_RET;
+            return CHIP8_OP_SYS;
+
+        case 0x1000: return CHIP8_OP_JP;
+        case 0x2000: return CHIP8_OP_CALL;
+        case 0x3000: return CHIP8_OP_SE_IMM;
+        case 0x4000: return CHIP8_OP_SNE_IMM;
+        case 0x5000: return (n == 0) ? CHIP8_OP_SE_REG : CHIP8_OP_INVALID;
+        case 0x6000: return CHIP8_OP_LD_IMM;
+        case 0x7000: return CHIP8_OP_ADD_IMM;
 
-                case 0x00EE:
-                // Return from subroutine
-                // Pop adress from stack and jump to it
-                if (chip->SP == 0) {
-                    fprintf(stderr, "ERROR: Stack Underflow!\n");
-                    chip->halted = true;
-                    break;
-                }
-                chip->SP--;
-                chip->PC = chip->stack[chip->SP];
-                return; 
-
-                default: 
-                /*
-                0x0NNN case, 
-                existed for calling original RCA1802 routines  
-                Now typically deprecated in modern emulators
-                */
-                fprintf(stderr, "Warning: 0NNN machine code call ignored: 0x%04X\n", opcode);
-                break;
+        case 0x8000:
+            switch (n) {
+                case 0x0: return CHIP8_OP_LD_REG;
+                case 0x1: return CHIP8_OP_OR;
+                case 0x2: return CHIP8_OP_AND;
+                case 0x3: return CHIP8_OP_XOR;
+                case 0x4: return CHIP8_OP_ADD_REG;
+                case 0x5: return CHIP8_OP_SUB;
+                case 0x6: return CHIP8_OP_SHR;
+                case 0x7: return CHIP8_OP_SUBN;
+                case 0xE: return CHIP8_OP_SHL;
             }
-        break;
-        
-        // === Jumps & Calls (1xxx, 2xxx, Bxxx) ===
-        case 0x1000:
-        // Jump to address NNN
-        chip->PC = nnn;
+            return CHIP8_OP_INVALID;
+
+        case 0x9000: return (n == 0) ? CHIP8_OP_SNE_REG : CHIP8_OP_INVALID;
+        case 0xA000: return CHIP8_OP_LD_I;
+        case 0xB000: return CHIP8_OP_JP_V0;
+        case 0xC000: return CHIP8_OP_RND;
+        case 0xD000: return CHIP8_OP_DRW;
+
+        case 0xE000:
+            if (nn == 0x9E) return CHIP8_OP_SKP;
+            if (nn == 0xA1) return CHIP8_OP_SKNP;
+            return CHIP8_OP_INVALID;
+
+        case 0xF000:
+            switch (nn) {
+                case 0x07: return CHIP8_OP_LD_VX_DT;
+                case 0x0A: return CHIP8_OP_LD_VX_K;
+                case 0x15: return CHIP8_OP_LD_DT_VX;
+                case 0x18: return CHIP8_OP_LD_ST_VX;
+                case 0x1E: return CHIP8_OP_ADD_I;
+                case 0x29: return CHIP8_OP_LD_F;
+                case 0x33: return CHIP8_OP_LD_B;
+                case 0x55: return CHIP8_OP_LD_MEM_VX;
+                case 0x65: return CHIP8_OP_LD_VX_MEM;
+            }
+            return CHIP8_OP_INVALID;
+    }
+
+    return CHIP8_OP_INVALID;
+}
+
+static Chip8Instr chip8_decode(uint16_t opcode) {
+    Chip8Instr instr;
+    instr.opcode = opcode;
+    instr.nnn = (opcode & 0x0FFF);
+    instr.op = chip8_decode_op(opcode);
+    instr.x = (opcode & 0x0F00) >> 8;
+    instr.y = (opcode & 0x00F0) >> 4;
+    instr.nn = (opcode & 0x00FF);
+    return instr;
+}
+
+static Chip8Instr chip8_decode_at(Chip8* chip, uint16_t index) {
+    uint16_t address = index << 1;
+    return chip8_decode((chip->memory[address] << 8) | chip->memory[address + 1]);
+}
+
+static void chip8_fill_slot(Chip8* chip, uint16_t index);
+
+/*
+    Picks the superinstruction or idle loop starting at a freshly decoded slot, if any.
+    A sequence that would run off the end of memory is left alone, so the
+    instructions of a fused group are always in consecutive slots.
+
+    The lookahead decodes into locals: a slot only ever gets cached through
+    chip8_fill_slot, so whether it heads a group of its own does not depend on the
+    order slots were first reached in. The fused handlers read their followers from
+    the cache, so a match fills those slots the same way.
+*/
+static void chip8_fuse(Chip8* chip, uint16_t index) {
+    Chip8Instr* head = &chip->decoded[index];
+    uint16_t address = index << 1;
+    if (head->op == CHIP8_OP_JP && head->nnn == address) {
+        head->op = CHIP8_OP_IDLE_JP;
         return;
+    }
+    if (index + 1 >= CHIP8_DECODE_SIZE) return;
+
+    uint8_t next = chip8_decode_at(chip, index + 1).op;
+    uint8_t fused = CHIP8_OP_UNDECODED;
+    if (head->op == CHIP8_OP_LD_I && next == CHIP8_OP_ADD_I) {
+        fused = CHIP8_OP_FUSED_INDEX;
+    } else if (index + 2 < CHIP8_DECODE_SIZE) {
+        Chip8Instr third = chip8_decode_at(chip, index + 2);
+        if (head->op == CHIP8_OP_LD_IMM && next == CHIP8_OP_LD_IMM) {
+            if (third.op == CHIP8_OP_DRW) fused = CHIP8_OP_FUSED_SPRITE;
+        } else if (head->op == CHIP8_OP_ADD_IMM && (next == CHIP8_OP_SE_IMM || next == CHIP8_OP_SNE_IMM)) {
+            if (third.op == CHIP8_OP_JP) fused = CHIP8_OP_FUSED_LOOP;
+        } else if (head->op == CHIP8_OP_LD_VX_DT && (next == CHIP8_OP_SE_IMM || next == CHIP8_OP_SNE_IMM)) {
+            if (third.op == CHIP8_OP_JP && third.nnn == address) fused = CHIP8_OP_IDLE_DT_POLL;
+        }
+    }
+    if (fused == CHIP8_OP_UNDECODED) return;
 
-        case 0x2000:
-        // Execute subroutine starting at address NNN
-        if (chip->SP >= 16) {
-            fprintf(stderr, "ERROR: Stack Overflow!\n");
-            chip->halted = true;
-            break;
+    // a follower keeps its own fields whatever it heads, which is all the handlers read
+    head->op = fused;
+    chip8_fill_slot(chip, index + 1);
+    if (fused != CHIP8_OP_FUSED_INDEX) chip8_fill_slot(chip, index + 2);
+}
+
+static void chip8_fill_slot(Chip8* chip, uint16_t index) {
+    if (chip->decoded[index].op != CHIP8_OP_UNDECODED) return;
+
+    chip->decoded[index] = chip8_decode_at(chip, index);
+    chip8_fuse(chip, index);
+}
+
+/*
+    Returns the decoded instruction at PC, decoding and caching it on a miss.
+    Odd PCs straddle two slots, so they are decoded on the fly and never cached.
+*/
+static inline Chip8Instr chip8_fetch_decoded(Chip8* chip) {
+    uint16_t pc = chip->PC;
+    if (pc & 1) {
+        return chip8_decode(chip8_fetch(chip));
+    }
+
+    uint16_t index = CHIP8_ADDR(pc) >> 1;
+    if (chip->decoded[index].op == CHIP8_OP_UNDECODED) {
+        chip8_fill_slot(chip, index);
+    }
+    return chip->decoded[index];
+}
+
+static inline bool chip8_is_idle_op(uint8_t op) {
+    return op == CHIP8_OP_IDLE_JP || op == CHIP8_OP_IDLE_DT_POLL || op == CHIP8_OP_LD_VX_K;
+}
+
+static inline void chip8_invalidate(Chip8* chip, uint16_t address) {
+    uint16_t index = address >> 1;
+    chip->decoded[index].op = CHIP8_OP_UNDECODED;
+
+    // a superinstruction up to two slots back may have been built from these bytes
+    for (uint16_t back = 1; back < CHIP8_FUSED_SPAN && back <= index; back++) {
+        if (chip->decoded[index - back].op >= CHIP8_OP_FUSED_FIRST) {
+            chip->decoded[index - back].op = CHIP8_OP_UNDECODED;
+        }
+    }
+
+    if (chip->jit) {
+        chip8_jit_invalidate(chip->jit, address);
+    }
+}
+
+void chip8_invalidate_all(Chip8* chip) {
+    memset(chip->decoded, 0, sizeof(chip->decoded));
+    if (chip->jit) {
+        chip8_jit_flush(chip->jit);
+        chip8_aot_install(chip);
+    }
+}
+
+void chip8_replace_memory(Chip8* chip, const uint8_t* memory) {
+    enum { CHUNK = 64, MAX_CHANGED = 256 };
+    int changed = 0;
+
+    for (uint16_t chunk = 0; chunk < CHIP8_MEMORY_SIZE; chunk += CHUNK) {
+        if (memcmp(chip->memory + chunk, memory + chunk, CHUNK) == 0) continue;
+
+        for (uint16_t address = chunk; address < chunk + CHUNK; address++) {
+            if (chip->memory[address] == memory[address]) continue;
+
+            if (++changed > MAX_CHANGED) {
+                // mostly different memory, cheaper to start over
+                memcpy(chip->memory, memory, CHIP8_MEMORY_SIZE);
+                chip8_invalidate_all(chip);
+                chip->dirty_pages = CHIP8_ALL_PAGES;
+                return;
+            }
+            chip->memory[address] = memory[address];
+            chip->dirty_pages |= (uint16_t)(1u << (address / CHIP8_PAGE_SIZE));
+            chip8_invalidate(chip, address);
         }
+    }
+}
+
+void chip8_replace_page(Chip8* chip, int page, const uint8_t* bytes) {
+    uint8_t* memory = chip->memory + page * CHIP8_PAGE_SIZE;
+    uint16_t base = (uint16_t)(page * CHIP8_PAGE_SIZE);
 
-        chip->stack[chip->SP] = chip->PC + 2;
-        chip->SP++;
-        chip->PC = nnn;
+    for (uint16_t offset = 0; offset < CHIP8_PAGE_SIZE; offset++) {
+        if (memory[offset] == bytes[offset]) continue;
+
+        memory[offset] = bytes[offset];
+        chip8_invalidate(chip, base + offset);
+    }
+}
+
+/*
+    Every guest write goes through here so the decode cache stays coherent.
+*/
+static inline void chip8_store(Chip8* chip, uint16_t address, uint8_t byte) {
+    address = CHIP8_ADDR(address);
+    chip->memory[address] = byte;
+    chip->dirty_pages |= (uint16_t)(1u << (address / CHIP8_PAGE_SIZE)); // the page is no longer shared
+    chip8_invalidate(chip, address);
+}
+
+/*
+    Guest loads and stores, as opposed to the host's: outside a watched page they cost
+    one bit test. A load is a span of at most 16 bytes, so at most two pages.
+*/
+static inline void chip8_guest_store(Chip8* chip, uint16_t address, uint8_t byte) {
+    address = CHIP8_ADDR(address);
+    if ((chip->watch_write_pages >> (address / CHIP8_PAGE_SIZE)) & 1) {
+        chip8_watch_write(chip, address, chip->memory[address], byte);
+    }
+    chip8_store(chip, address, byte);
+}
+
+static inline void chip8_guest_load(Chip8* chip, uint16_t start, uint8_t count) {
+    uint16_t first = CHIP8_ADDR(start) / CHIP8_PAGE_SIZE;
+    uint16_t last = CHIP8_ADDR(start + count - 1) / CHIP8_PAGE_SIZE;
+    if (count && (((chip->watch_read_pages >> first) | (chip->watch_read_pages >> last)) & 1)) {
+        chip8_watch_read(chip, start, count);
+    }
+}
+
+// OPCODE HANDLERS
+// Each handler applies one instruction, including its effect on PC.
+// Both dispatch loops below are built out of these.
+
+// === System & Flow Control (0xxx) ===
+
+static inline void chip8_op_cls(Chip8* chip, Chip8Instr in) {
+    (void)in;
+    // Clear the screen
+    for (uint8_t row = 0; row < CHIP8_DISPLAY_HEIGHT; row++) {
+        if (chip->display[row]) chip->dirty_rows |= 1u << row;
+    }
+    memset(chip->display, 0, sizeof(chip->display));
+    chip->draw_flag = true;
+    chip->PC += 2;
+}
+
+static inline void chip8_op_ret(Chip8* chip, Chip8Instr in, uint64_t cycle) {
+    // Return from subroutine
+    // Pop adress from stack and jump to it
+    if (chip->SP == 0) {
+        chip8_diag(chip, CHIP8_DIAG_STACK_UNDERFLOW, chip->PC, in.opcode, cycle);
+        chip->halted = true;
+        chip->PC += 2;
         return;
+    }
+    chip->SP--;
+    chip->PC = chip->stack[chip->SP];
+}
 
-        case 0xB000:
-        // Original CHIP-8 uses V0; some modern variants use VX. Most ROMs expect V0.
-        // Jump to address NNN + V0
-        chip->PC = nnn + chip->V[0];
+static inline void chip8_op_sys(Chip8* chip, Chip8Instr in, uint64_t cycle) {
+    /*
+    0x0NNN case, 
+    existed for calling original RCA1802 routines  
+    Now typically deprecated in modern emulators
+    */
+    chip8_diag(chip, CHIP8_DIAG_SYS, chip->PC, in.opcode, cycle);
+    chip->PC += 2;
+}
+
+// === Jumps & Calls (1xxx, 2xxx, Bxxx) ===
+
+static inline void chip8_op_jp(Chip8* chip, Chip8Instr in) {
+    // Jump to address NNN
+    chip->PC = in.nnn;
+}
+
+static inline void chip8_op_call(Chip8* chip, Chip8Instr in, uint64_t cycle) {
+    // Execute subroutine starting at address NNN
+    if (chip->SP >= 16) {
+        chip8_diag(chip, CHIP8_DIAG_STACK_OVERFLOW, chip->PC, in.opcode, cycle);
+        chip->halted = true;
+        chip->PC += 2;
         return;
+    }
 
-        //  === Skip Instructions (3xxx, 4xxx, 5xxx, 9xxx, Exxx) ===
+    chip->stack[chip->SP] = chip->PC + 2;
+    chip->SP++;
+    chip->PC = in.nnn;
+}
 
-        case 0x3000:
-        // Skip the following instruction if the value of register VX equals NN
-        if (chip->V[x] == nn) {
-            chip->PC += 2;
-        }
-        break;
+static inline void chip8_op_jp_v0(Chip8* chip, Chip8Instr in) {
+    // Original CHIP-8 uses V0; some modern variants use VX. Most ROMs expect V0.
+    // Jump to address NNN + V0
+    chip->PC = in.nnn + chip->V[0];
+}
 
-        case 0x4000:
-        // Skip the following instruction if the value of register VX is not equal to NN
-        if (chip->V[x] != nn) {
+//  === Skip Instructions (3xxx, 4xxx, 5xxx, 9xxx, Exxx) ===
+
+static inline void chip8_op_se_imm(Chip8* chip, Chip8Instr in) {
+    // Skip the following instruction if the value of register VX equals NN
+    chip->PC += (chip->V[in.x] == in.nn) ? 4 : 2;
+}
+
+static inline void chip8_op_sne_imm(Chip8* chip, Chip8Instr in) {
+    // Skip the following instruction if the value of register VX is not equal to NN
+    chip->PC += (chip->V[in.x] != in.nn) ? 4 : 2;
+}
+
+static inline void chip8_op_se_reg(Chip8* chip, Chip8Instr in) {
+    // Skip the following instruction if the value of register VX is equal to the value of register VY
+    chip->PC += (chip->V[in.x] == chip->V[in.y]) ? 4 : 2;
+}
+
+static inline void chip8_op_sne_reg(Chip8* chip, Chip8Instr in) {
+    // Skip the following instruction if the value of register VX is not equal to the value of register VY
+    chip->PC += (chip->V[in.x] != chip->V[in.y]) ? 4 : 2;
+}
+
+static inline void chip8_op_skp(Chip8* chip, Chip8Instr in) {
+    // Skip the following instruction if the key corresponding to the hex value currently stored in register VX is pressed
+    uint16_t vx = chip->V[in.x];
+    chip->PC += (vx < 16 && chip->keys[vx]) ? 4 : 2;
+}
+
+static inline void chip8_op_sknp(Chip8* chip, Chip8Instr in) {
+    // Skip the following instruction if the key corresponding to the hex value currently stored in register VX is not pressed
+    uint16_t vx = chip->V[in.x];
+    chip->PC += (vx < 16 && !chip->keys[vx]) ? 4 : 2;
+}
+
+// === Register Operations (6xxx, 7xxx, 8xxx) ===
+
+static inline void chip8_op_ld_imm(Chip8* chip, Chip8Instr in) {
+    // Store number NN in register VX
+    chip->V[in.x] = in.nn;
+    chip->PC += 2;
+}
+
+static inline void chip8_op_add_imm(Chip8* chip, Chip8Instr in) {
+    // Add the value NN to register VX
+    chip->V[in.x] += in.nn;
+    chip->PC += 2;
+}
+
+// === ALU Operations (8XYn) ===
+
+static inline void chip8_op_ld_reg(Chip8* chip, Chip8Instr in) {
+    // Store the value of register VY in register VX
+    chip->V[in.x] = chip->V[in.y];
+    chip->PC += 2;
+}
+
+static inline void chip8_op_or(Chip8* chip, Chip8Instr in) {
+    // Set VX to VX OR VY
+    chip->V[in.x] |= chip->V[in.y];
+    chip->V[0xF] = 0;  // VF reset (quirk)
+    chip->PC += 2;
+}
+
+static inline void chip8_op_and(Chip8* chip, Chip8Instr in) {
+    // Set VX to VX AND VY
+    chip->V[in.x] &= chip->V[in.y];
+    chip->V[0xF] = 0;  // VF reset (quirk)
+    chip->PC += 2;
+}
+
+static inline void chip8_op_xor(Chip8* chip, Chip8Instr in) {
+    // Set VX to VX XOR VY
+    chip->V[in.x] ^= chip->V[in.y];
+    chip->V[0xF] = 0;  // VF reset (quirk)
+    chip->PC += 2;
+}
+
+static inline void chip8_op_add_reg(Chip8* chip, Chip8Instr in) {
+    // Add the value of register VY to register VX
+    // Set VF to 01 if a carry occurs
+    // Set VF to 00 if a carry does not occur
+    uint16_t sum = chip->V[in.x] + chip->V[in.y];
+    chip->V[0xF] = (sum > 0xFF) ? 1 : 0;
+    chip->V[in.x] = sum & 0xFF;
+    chip->PC += 2;
+}
+
+static inline void chip8_op_sub(Chip8* chip, Chip8Instr in) {
+    // Subtract the value of register VY from register VX
+    // Set VF to 00 if a borrow occurs
+    // Set VF to 01 if a borrow does not occur
+    chip->V[0xF] = (chip->V[in.x] >= chip->V[in.y]) ? 1 : 0;  // NOT borrow
+    chip->V[in.x] -= chip->V[in.y];
+    chip->PC += 2;
+}
+
+static inline void chip8_op_shr(Chip8* chip, Chip8Instr in) {
+    // Store the value of register VY shifted right one bit in register VX¹
+    // Set register VF to the least significant bit prior to the shift
+    // VY is unchanged
+    chip->V[0xF] = chip->V[in.y] & 0x01;
+    chip->V[in.x] = chip->V[in.y] >> 1;
+    chip->PC += 2;
+}
+
+static inline void chip8_op_subn(Chip8* chip, Chip8Instr in) {
+    // Set register VX to the value of VY minus VX
+    // Set VF to 00 if a borrow occurs
+    // Set VF to 01 if a borrow does not occur
+    chip->V[0xF] = (chip->V[in.y] >= chip->V[in.x]) ? 1 : 0;  // NOT borrow
+    chip->V[in.x] = chip->V[in.y] - chip->V[in.x];
+    chip->PC += 2;
+}
+
+static inline void chip8_op_shl(Chip8* chip, Chip8Instr in) {
+    // Store the value of register VY shifted left one bit in register VX¹
+    // Set register VF to the most significant bit prior to the shift
+    // VY is unchanged
+    chip->V[0xF] = (chip->V[in.y] & 0x80) >> 7;  // MSB before shift
+    chip->V[in.x] = chip->V[in.y] << 1;
+    chip->PC += 2;
+}
+
+// === Memory Operations (Axxx, Fxxx) ===
+
+static inline void chip8_op_ld_i(Chip8* chip, Chip8Instr in) {
+    // Store memory address NNN in register I
+    chip->I = in.nnn;
+    chip->PC += 2;
+}
+
+static inline void chip8_op_ld_vx_dt(Chip8* chip, Chip8Instr in) {
+    // Store the current value of the delay timer in register VX
+    chip->V[in.x] = chip->delay_timer;
+    chip->PC += 2;
+}
+
+// === Input (FX0A) ===
+static inline int chip8_op_ld_vx_k(Chip8* chip, Chip8Instr in, int budget) {
+    // Wait for a keypress and store the result in register VX
+    // Without a key, PC stays put and the instruction runs again next cycle
+    for (uint8_t i = 0; i < 16; i++) {
+        if (chip->keys[i]) {
+            chip->V[in.x] = i;
             chip->PC += 2;
+            return 1;
         }
-        break;
+    }
 
-        case 0x5000:
-        // Skip the following instruction if the value of register VX is equal to the value of register VY
-        if ((opcode & 0x000F) == 0) {
-            if (chip->V[x] == chip->V[y]) {
-                chip->PC += 2;
-            }
-        }
-        break;
+    // keys only change between batches, so every remaining cycle would wait too
+    chip->idle_cycles += budget;
+    return budget;
+}
 
-        case 0x9000:
-        // Skip the following instruction if the value of register VX is not equal to the value of register VY
-        if ((opcode & 0x000F) == 0) {
-            if (chip->V[x] != chip->V[y]) {
-                chip->PC += 2;
-            }
-        }
-        break;
+static inline void chip8_op_ld_dt_vx(Chip8* chip, Chip8Instr in) {
+    // Set the delay timer to the value of register VX
+    chip->delay_timer = chip->V[in.x];
+    chip->PC += 2;
+}
 
-        case 0xE000:
-        switch (nn) {
-            // Skip the following instruction if the key corresponding to the hex value currently stored in register VX is pressed
-            case 0x9E:
-            if (chip->V[x] < 16 && chip->keys[chip->V[x]]) {
-                chip->PC += 2;
-            }
-            break;
-            
-            // Skip the following instruction if the key corresponding to the hex value currently stored in register VX is not pressed
-            case 0xA1:
-            if (chip->V[x] < 16 && !chip->keys[chip->V[x]]) {
-                chip->PC += 2;
-            }
-            break;
-        }
-        break;
+static inline void chip8_op_ld_st_vx(Chip8* chip, Chip8Instr in) {
+    // Set the sound timer to the value of register VX
+    chip->sound_timer = chip->V[in.x];
+    chip->PC += 2;
+}
 
-        // === Register Operations (6xxx, 7xxx, 8xxx) ===
+static inline void chip8_op_add_i(Chip8* chip, Chip8Instr in) {
+    // Add the value stored in register VX to register I
+    chip->I += chip->V[in.x];
+    chip->PC += 2;
+}
 
-        case 0x6000:
-        // Store number NN in register VX
-        chip->V[x] = nn;
-        break;
+static inline void chip8_op_ld_f(Chip8* chip, Chip8Instr in) {
+    // Set I to the memory address of the sprite data corresponding to the hexadecimal digit stored in register VX
+    chip->I = (chip->V[in.x] & 0x0F) * 5;
+    chip->PC += 2;
+}
 
-        case 0x7000:
-        // Add the value NN to register VX
-        chip->V[x] += nn;
-        break;
+static inline void chip8_op_ld_b(Chip8* chip, Chip8Instr in) {
+    // Store the binary-coded decimal equivalent of the value stored in register VX at addresses I, I + 1, and I + 2
+    uint8_t value = chip->V[in.x];
+    chip8_guest_store(chip, chip->I, value / 100); // hundreds
+    chip8_guest_store(chip, chip->I + 1, (value / 10) % 10); // tens
+    chip8_guest_store(chip, chip->I + 2, value % 10); // ones
+    chip->PC += 2;
+}
 
-        // === ALU Operations (8XYn) ===
+static inline void chip8_op_ld_mem_vx(Chip8* chip, Chip8Instr in) {
+    // Store the values of registers V0 to VX inclusive in memory starting at address I. I is set to I + X + 1 after operation
+    for (uint8_t i = 0; i <= in.x; i++) {
+        chip8_guest_store(chip, chip->I + i, chip->V[i]);
+    }
+    chip->I += in.x + 1;
+    chip->PC += 2;
+}
 
-        case 0x8000:
-        switch (n) {
-            case 0x0:
-            // Store the value of register VY in register VX
-            chip->V[x] = chip->V[y];
-            break;
+static inline void chip8_op_ld_vx_mem(Chip8* chip, Chip8Instr in) {
+    // Fill registers V0 to VX inclusive with the values stored in memory starting at address I. I is set to I + X + 1 after operation
+    chip8_guest_load(chip, chip->I, in.x + 1);
+    for (uint8_t i = 0; i <= in.x; i++) {
+        chip->V[i] = chip->memory[CHIP8_ADDR(chip->I + i)];
+    }
+    chip->I += in.x + 1;
+    chip->PC += 2;
+}
 
-            case 0x1:
-            // Set VX to VX OR VY
-            chip->V[x] |= chip->V[y];
-            chip->V[0xF] = 0;  // VF reset (quirk)
-            break;
+static inline void chip8_op_rnd(Chip8* chip, Chip8Instr in) {
+    // Set VX to a random number with a mask of NN
+    chip->V[in.x] = (chip8_rand_next(&chip->rand_state) >> 24) & in.nn;
+    chip->PC += 2;
+}
 
-            case 0x2:
-            // Set VX to VX AND VY
-            chip->V[x] &= chip->V[y];
-            chip->V[0xF] = 0;  // VF reset (quirk)
-            break;
+static inline void chip8_op_drw(Chip8* chip, Chip8Instr in) {
+    // Draw an 8xN sprite from memory at I to (VX, VY), XOR-ing whole rows at once
+    // Set VF to 01 if any set pixel is erased, 00 otherwise
+    uint8_t lx = chip->V[in.x] % 64;
+    uint8_t ly = chip->V[in.y] % 32;
+    uint8_t height = in.nn & 0x0F;
+    uint64_t collision = 0;
+
+    chip8_guest_load(chip, chip->I, height);
+    for (uint8_t row = 0; row < height; row++) {
+        uint64_t sprite = chip8_sprite_row(chip->memory[CHIP8_ADDR(chip->I + row)], lx);
+        uint8_t y = (ly + row) % 32;
+
+        collision |= chip->display[y] & sprite;
+        chip->display[y] ^= sprite;
+        if (sprite) chip->dirty_rows |= 1u << y;
+    }
 
-            case 0x3:
-            // Set VX to VX XOR VY
-            chip->V[x] ^= chip->V[y];
-            chip->V[0xF] = 0;  // VF reset (quirk)
-            break;
+    chip->V[0xF] = (collision != 0) ? 1 : 0;
+    chip->draw_flag = true;
+    chip->PC += 2;
+}
 
+static inline void chip8_op_invalid(Chip8* chip, Chip8Instr in, uint64_t cycle) {
+    // Unassigned sub-ops (5XY1, 8XY8, EX00, FX00...) are ignored
+    chip8_diag(chip, CHIP8_DIAG_INVALID_OPCODE, chip->PC, in.opcode, cycle);
+    chip->PC += 2;
+}
 
-            case 0x4:
-            // Add the value of register VY to register VX
-            // Set VF to 01 if a carry occurs
-            // Set VF to 00 if a carry does not occur
-            uint16_t sum = chip->V[x] + chip->V[y];
-            chip->V[0xF] = (sum > 0xFF) ? 1 : 0;
-            chip->V[x] = sum & 0xFF; 
-            break;
+// === Superinstructions ===
+// Each runs its guest instructions through the handlers above, but never more than
+// budget of them, and returns how many it ran. Only the first instruction is run
+// when the budget is too small, exactly as if it had not been fused.
+// None of the fused instructions write memory or halt, so the slots read here stay valid.
 
-            case 0x5:
-            // Subtract the value of register VY from register VX
-            // Set VF to 00 if a borrow occurs
-            // Set VF to 01 if a borrow does not occur
-            chip->V[0xF] = (chip->V[x] >= chip->V[y]) ? 1 : 0;  // NOT borrow
-            chip->V[x] -= chip->V[y];
-            break;
+static inline int chip8_op_fused_sprite(Chip8* chip, Chip8Instr in, int budget) {
+    uint16_t index = CHIP8_ADDR(chip->PC) >> 1;
+    chip8_op_ld_imm(chip, in);
+    if (budget < 3) return 1;
 
-            case 0x6:
-            // Store the value of register VY shifted right one bit in register VX¹
-            // Set register VF to the least significant bit prior to the shift
-            // VY is unchanged
-            chip->V[0xF] = chip->V[y] & 0x01;
-            chip->V[x] = chip->V[y] >> 1;
-            break;
+    chip8_op_ld_imm(chip, chip->decoded[index + 1]);
+    chip8_op_drw(chip, chip->decoded[index + 2]);
+    return 3;
+}
 
-            case 0x7:
-            // Set register VX to the value of VY minus VX
-            // Set VF to 00 if a borrow occurs
-            // Set VF to 01 if a borrow does not occur
-            chip->V[0xF] = (chip->V[y] >= chip->V[x]) ? 1 : 0;  // NOT borrow
-            chip->V[x] = chip->V[y] - chip->V[x];
-            break;
+static inline int chip8_op_fused_loop(Chip8* chip, Chip8Instr in, int budget) {
+    uint16_t index = CHIP8_ADDR(chip->PC) >> 1;
+    uint16_t jump_pc = chip->PC + 4;
+    chip8_op_add_imm(chip, in);
+    if (budget < 2) return 1;
+
+    Chip8Instr test = chip->decoded[index + 1];
+    if (test.op == CHIP8_OP_SE_IMM) {
+        chip8_op_se_imm(chip, test);
+    } else {
+        chip8_op_sne_imm(chip, test);
+    }
+    // the jump only runs if the test did not skip it
+    if (budget < 3 || chip->PC != jump_pc) return 2;
 
+    chip8_op_jp(chip, chip->decoded[index + 2]);
+    return 3;
+}
 
-            case 0xE:
-            // Store the value of register VY shifted left one bit in register VX¹
-            // Set register VF to the most significant bit prior to the shift
-            // VY is unchanged
-            chip->V[0xF] = (chip->V[y] & 0x80) >> 7;  // MSB before shift
-            chip->V[x] = chip->V[y] << 1;
-            break;
-        }
-        break;
-        
-        // === Memory Operations (Axxx, Fxxx) ===
+static inline int chip8_op_fused_index(Chip8* chip, Chip8Instr in, int budget) {
+    uint16_t index = CHIP8_ADDR(chip->PC) >> 1;
+    chip8_op_ld_i(chip, in);
+    if (budget < 2) return 1;
 
-        case 0xA000:
-        // Store memory address NNN in register I
-        chip->I = nnn;
-        break;
+    chip8_op_add_i(chip, chip->decoded[index + 1]);
+    return 2;
+}
 
-        case 0xF000:
-        switch (nn) {
-            case 0x07:
-            // Store the current value of the delay timer in register VX
-            chip->V[x] = chip->delay_timer;
-            break;
+// === Idle loops ===
+// Timers and keys only change between chip8_step_n batches, so once one of these
+// loops is known to go round again it keeps doing so until the budget runs out.
 
-            // === Input (FX0A) ===
-            case 0x0A:
-            // Wait for a keypress and store the result in register VX
-            bool key_pressed = false;
-            for (uint8_t i = 0; i < 16; i++) {
-                if (chip->keys[i]) {
-                    chip->V[x] = i;
-                    key_pressed = true;
-                    break;
-                }
-            }
-            if (!key_pressed) {
-                    chip->PC -= 2;
-                }
-            break;
-            
+static inline int chip8_op_idle_jp(Chip8* chip, Chip8Instr in, int budget) {
+    (void)in;
+    // PC is already the jump target
+    chip->idle_cycles += budget;
+    return budget;
+}
 
-            case 0x15:
-            // Set the delay timer to the value of register VX
-            chip->delay_timer = chip->V[x];
-            break;
+static inline int chip8_op_idle_dt_poll(Chip8* chip, Chip8Instr in, int budget) {
+    uint16_t index = CHIP8_ADDR(chip->PC) >> 1;
+    uint16_t head_pc = chip->PC;
+    chip8_op_ld_vx_dt(chip, in);
+    if (budget < 2) return 1;
+
+    Chip8Instr test = chip->decoded[index + 1];
+    if (test.op == CHIP8_OP_SE_IMM) {
+        chip8_op_se_imm(chip, test);
+    } else {
+        chip8_op_sne_imm(chip, test);
+    }
+    // skipping the jump leaves the loop
+    if (budget < 3 || chip->PC != head_pc + 4) return 2;
+
+    // the loop only wrote V[x] = DT, so every further round is the same:
+    // land wherever the remaining cycles leave PC within the three instructions
+    int rest = budget - 3;
+    chip->PC = head_pc + 2 * (rest % 3);
+    chip->idle_cycles += budget;
+    return budget;
+}
 
-            case 0x18:
-            // Set the sound timer to the value of register VX
-            chip->sound_timer = chip->V[x];
-            break;
+// EXECUTION
+
+/*
+    Runs the instruction and returns how many guest instructions that was:
+    1, or up to budget for a superinstruction. cycle is the cycle count the instruction
+    runs at, for diagnostics; the run loops only update cycle_count once per batch.
+*/
+static int chip8_execute_instr(Chip8* chip, Chip8Instr instr, int budget, uint64_t cycle) {
+    switch (instr.op) {
+        case CHIP8_OP_FUSED_SPRITE: return chip8_op_fused_sprite(chip, instr, budget);
+        case CHIP8_OP_FUSED_LOOP:   return chip8_op_fused_loop(chip, instr, budget);
+        case CHIP8_OP_FUSED_INDEX:  return chip8_op_fused_index(chip, instr, budget);
+        case CHIP8_OP_IDLE_JP:      return chip8_op_idle_jp(chip, instr, budget);
+        case CHIP8_OP_IDLE_DT_POLL: return chip8_op_idle_dt_poll(chip, instr, budget);
+        case CHIP8_OP_LD_VX_K:      return chip8_op_ld_vx_k(chip, instr, budget);
+        case CHIP8_OP_CLS:       chip8_op_cls(chip, instr); break;
+        case CHIP8_OP_RET:       chip8_op_ret(chip, instr, cycle); break;
+        case CHIP8_OP_SYS:       chip8_op_sys(chip, instr, cycle); break;
+        case CHIP8_OP_JP:        chip8_op_jp(chip, instr); break;
+        case CHIP8_OP_CALL:      chip8_op_call(chip, instr, cycle); break;
+        case CHIP8_OP_SE_IMM:    chip8_op_se_imm(chip, instr); break;
+        case CHIP8_OP_SNE_IMM:   chip8_op_sne_imm(chip, instr); break;
+        case CHIP8_OP_SE_REG:    chip8_op_se_reg(chip, instr); break;
+        case CHIP8_OP_LD_IMM:    chip8_op_ld_imm(chip, instr); break;
+        case CHIP8_OP_ADD_IMM:   chip8_op_add_imm(chip, instr); break;
+        case CHIP8_OP_LD_REG:    chip8_op_ld_reg(chip, instr); break;
+        case CHIP8_OP_OR:        chip8_op_or(chip, instr); break;
+        case CHIP8_OP_AND:       chip8_op_and(chip, instr); break;
+        case CHIP8_OP_XOR:       chip8_op_xor(chip, instr); break;
+        case CHIP8_OP_ADD_REG:   chip8_op_add_reg(chip, instr); break;
+        case CHIP8_OP_SUB:       chip8_op_sub(chip, instr); break;
+        case CHIP8_OP_SHR:       chip8_op_shr(chip, instr); break;
+        case CHIP8_OP_SUBN:      chip8_op_subn(chip, instr); break;
+        case CHIP8_OP_SHL:       chip8_op_shl(chip, instr); break;
+        case CHIP8_OP_SNE_REG:   chip8_op_sne_reg(chip, instr); break;
+        case CHIP8_OP_LD_I:      chip8_op_ld_i(chip, instr); break;
+        case CHIP8_OP_JP_V0:     chip8_op_jp_v0(chip, instr); break;
+        case CHIP8_OP_RND:       chip8_op_rnd(chip, instr); break;
+        case CHIP8_OP_DRW:       chip8_op_drw(chip, instr); break;
+        case CHIP8_OP_SKP:       chip8_op_skp(chip, instr); break;
+        case CHIP8_OP_SKNP:      chip8_op_sknp(chip, instr); break;
+        case CHIP8_OP_LD_VX_DT:  chip8_op_ld_vx_dt(chip, instr); break;
+        case CHIP8_OP_LD_DT_VX:  chip8_op_ld_dt_vx(chip, instr); break;
+        case CHIP8_OP_LD_ST_VX:  chip8_op_ld_st_vx(chip, instr); break;
+        case CHIP8_OP_ADD_I:     chip8_op_add_i(chip, instr); break;
+        case CHIP8_OP_LD_F:      chip8_op_ld_f(chip, instr); break;
+        case CHIP8_OP_LD_B:      chip8_op_ld_b(chip, instr); break;
+        case CHIP8_OP_LD_MEM_VX: chip8_op_ld_mem_vx(chip, instr); break;
+        case CHIP8_OP_LD_VX_MEM: chip8_op_ld_vx_mem(chip, instr); break;
+        default:                 chip8_op_invalid(chip, instr, cycle); break;
+    }
+    return 1;
+}
 
-            case 0x1E:
-            // Add the value stored in register VX to register I
-            chip->I += chip->V[x];
-            break;
+/*
+    Switch backend: one bounds-checked switch per instruction.
+    The caller has already rejected NULL, halted and empty batches.
+*/
+static int chip8_run_switch(Chip8* chip, int n) {
+    int executed = 0;
+    while (executed < n && !chip->halted) {
+        executed += chip8_execute_instr(chip, chip8_fetch_decoded(chip), n - executed, chip->cycle_count + executed);
+    }
 
-            case 0x29:
-            // Set I to the memory address of the sprite data corresponding to the hexadecimal digit stored in register VX
-            chip->I = (chip->V[x] & 0x0F) * 5;
-            break;
+    chip->cycle_count += executed;
+    return executed;
+}
 
-            case 0x33:
-            // Store the binary-coded decimal equivalent of the value stored in register VX at addresses I, I + 1, and I + 2
-            uint8_t value = chip->V[x];
-            chip->memory[chip->I] = value / 100; // hundreds
-            chip->memory[chip->I + 1] = (value / 10) % 10; // tens
-            chip->memory[chip->I + 2] = value % 10; // ones
-            break;
+#if CHIP8_HAVE_THREADED
+/*
+    Threaded backend: every handler jumps straight to the next one through a label table.
+    Only RET and CALL can halt, so they are the only places that look at chip->halted.
+*/
+static int chip8_run_threaded(Chip8* chip, int n) {
+    static void* const labels[CHIP8_OP_COUNT] = {
+        [CHIP8_OP_UNDECODED] = &&op_invalid,
+        [CHIP8_OP_INVALID]   = &&op_invalid,
+        [CHIP8_OP_CLS]       = &&op_cls,
+        [CHIP8_OP_RET]       = &&op_ret,
+        [CHIP8_OP_SYS]       = &&op_sys,
+        [CHIP8_OP_JP]        = &&op_jp,
+        [CHIP8_OP_CALL]      = &&op_call,
+        [CHIP8_OP_SE_IMM]    = &&op_se_imm,
+        [CHIP8_OP_SNE_IMM]   = &&op_sne_imm,
+        [CHIP8_OP_SE_REG]    = &&op_se_reg,
+        [CHIP8_OP_LD_IMM]    = &&op_ld_imm,
+        [CHIP8_OP_ADD_IMM]   = &&op_add_imm,
+        [CHIP8_OP_LD_REG]    = &&op_ld_reg,
+        [CHIP8_OP_OR]        = &&op_or,
+        [CHIP8_OP_AND]       = &&op_and,
+        [CHIP8_OP_XOR]       = &&op_xor,
+        [CHIP8_OP_ADD_REG]   = &&op_add_reg,
+        [CHIP8_OP_SUB]       = &&op_sub,
+        [CHIP8_OP_SHR]       = &&op_shr,
+        [CHIP8_OP_SUBN]      = &&op_subn,
+        [CHIP8_OP_SHL]       = &&op_shl,
+        [CHIP8_OP_SNE_REG]   = &&op_sne_reg,
+        [CHIP8_OP_LD_I]      = &&op_ld_i,
+        [CHIP8_OP_JP_V0]     = &&op_jp_v0,
+        [CHIP8_OP_RND]       = &&op_rnd,
+        [CHIP8_OP_DRW]       = &&op_drw,
+        [CHIP8_OP_SKP]       = &&op_skp,
+        [CHIP8_OP_SKNP]      = &&op_sknp,
+        [CHIP8_OP_LD_VX_DT]  = &&op_ld_vx_dt,
+        [CHIP8_OP_LD_VX_K]   = &&op_ld_vx_k,
+        [CHIP8_OP_LD_DT_VX]  = &&op_ld_dt_vx,
+        [CHIP8_OP_LD_ST_VX]  = &&op_ld_st_vx,
+        [CHIP8_OP_ADD_I]     = &&op_add_i,
+        [CHIP8_OP_LD_F]      = &&op_ld_f,
+        [CHIP8_OP_LD_B]      = &&op_ld_b,
+        [CHIP8_OP_LD_MEM_VX] = &&op_ld_mem_vx,
+        [CHIP8_OP_LD_VX_MEM] = &&op_ld_vx_mem,
+        [CHIP8_OP_FUSED_SPRITE] = &&op_fused_sprite,
+        [CHIP8_OP_FUSED_LOOP]   = &&op_fused_loop,
+        [CHIP8_OP_FUSED_INDEX]  = &&op_fused_index,
+        [CHIP8_OP_IDLE_JP]      = &&op_idle_jp,
+        [CHIP8_OP_IDLE_DT_POLL] = &&op_idle_dt_poll,
+    };
 
-            case 0x55:
-            // Store the values of registers V0 to VX inclusive in memory starting at address I. I is set to I + X + 1 after operation
-            for (uint8_t i = 0; i <= x; i++) {
-                chip->memory[chip->I + i] = chip->V[i];
-            }
-            chip->I += x + 1;
+    int executed = 0;
+    Chip8Instr instr;
+
+#define DISPATCH()                          \
+    do {                                    \
+        if (executed == n) goto done;       \
+        executed++;                         \
+        instr = chip8_fetch_decoded(chip);  \
+        goto *labels[instr.op];             \
+    } while (0)
+
+// cycle of the instruction being run, executed already counts it
+#define CYCLE() (chip->cycle_count + (uint64_t)executed - 1)
+
+    DISPATCH();
+
+    op_cls:       chip8_op_cls(chip, instr);       DISPATCH();
+    op_ret:       chip8_op_ret(chip, instr, CYCLE());  if (chip->halted) goto done; DISPATCH();
+    op_sys:       chip8_op_sys(chip, instr, CYCLE());  DISPATCH();
+    op_jp:        chip8_op_jp(chip, instr);        DISPATCH();
+    op_call:      chip8_op_call(chip, instr, CYCLE()); if (chip->halted) goto done; DISPATCH();
+    op_se_imm:    chip8_op_se_imm(chip, instr);    DISPATCH();
+    op_sne_imm:   chip8_op_sne_imm(chip, instr);   DISPATCH();
+    op_se_reg:    chip8_op_se_reg(chip, instr);    DISPATCH();
+    op_ld_imm:    chip8_op_ld_imm(chip, instr);    DISPATCH();
+    op_add_imm:   chip8_op_add_imm(chip, instr);   DISPATCH();
+    op_ld_reg:    chip8_op_ld_reg(chip, instr);    DISPATCH();
+    op_or:        chip8_op_or(chip, instr);        DISPATCH();
+    op_and:       chip8_op_and(chip, instr);       DISPATCH();
+    op_xor:       chip8_op_xor(chip, instr);       DISPATCH();
+    op_add_reg:   chip8_op_add_reg(chip, instr);   DISPATCH();
+    op_sub:       chip8_op_sub(chip, instr);       DISPATCH();
+    op_shr:       chip8_op_shr(chip, instr);       DISPATCH();
+    op_subn:      chip8_op_subn(chip, instr);      DISPATCH();
+    op_shl:       chip8_op_shl(chip, instr);       DISPATCH();
+    op_sne_reg:   chip8_op_sne_reg(chip, instr);   DISPATCH();
+    op_ld_i:      chip8_op_ld_i(chip, instr);      DISPATCH();
+    op_jp_v0:     chip8_op_jp_v0(chip, instr);     DISPATCH();
+    op_rnd:       chip8_op_rnd(chip, instr);       DISPATCH();
+    op_drw:       chip8_op_drw(chip, instr);       DISPATCH();
+    op_skp:       chip8_op_skp(chip, instr);       DISPATCH();
+    op_sknp:      chip8_op_sknp(chip, instr);      DISPATCH();
+    op_ld_vx_dt:  chip8_op_ld_vx_dt(chip, instr);  DISPATCH();
+    op_ld_dt_vx:  chip8_op_ld_dt_vx(chip, instr);  DISPATCH();
+    op_ld_st_vx:  chip8_op_ld_st_vx(chip, instr);  DISPATCH();
+    op_add_i:     chip8_op_add_i(chip, instr);     DISPATCH();
+    op_ld_f:      chip8_op_ld_f(chip, instr);      DISPATCH();
+    op_ld_b:      chip8_op_ld_b(chip, instr);      DISPATCH();
+    op_ld_mem_vx: chip8_op_ld_mem_vx(chip, instr); DISPATCH();
+    op_ld_vx_mem: chip8_op_ld_vx_mem(chip, instr); DISPATCH();
+    op_invalid:   chip8_op_invalid(chip, instr, CYCLE()); DISPATCH();
+
+    // executed already counts the first instruction of the group
+    op_fused_sprite: executed += chip8_op_fused_sprite(chip, instr, n - executed + 1) - 1; DISPATCH();
+    op_fused_loop:   executed += chip8_op_fused_loop(chip, instr, n - executed + 1) - 1;   DISPATCH();
+    op_fused_index:  executed += chip8_op_fused_index(chip, instr, n - executed + 1) - 1;  DISPATCH();
+    op_idle_jp:      executed += chip8_op_idle_jp(chip, instr, n - executed + 1) - 1;      DISPATCH();
+    op_idle_dt_poll: executed += chip8_op_idle_dt_poll(chip, instr, n - executed + 1) - 1; DISPATCH();
+    op_ld_vx_k:      executed += chip8_op_ld_vx_k(chip, instr, n - executed + 1) - 1;      DISPATCH();
+
+#undef CYCLE
+#undef DISPATCH
+
+done:
+    chip->cycle_count += executed;
+    return executed;
+}
+#endif
+
+/*
+    Counts instr, about to run at PC, and the memory it is about to load or store.
+*/
+static inline void chip8_profile_count(Chip8* chip, Chip8Instr instr) {
+    Chip8Profile* profile = chip->profile;
+    profile->executions[CHIP8_ADDR(chip->PC)]++;
+    profile->nodes[profile->current].self++;
+
+    // superinstructions never start with any of these, so op is the instruction itself
+    switch (instr.op) {
+        case CHIP8_OP_CALL:
+            if (chip->SP < CHIP8_STACK_SIZE) chip8_profile_call(profile, instr.nnn);
             break;
-
-            case 0x65:
-            // Fill registers V0 to VX inclusive with the values stored in memory starting at address I. I is set to I + X + 1 after operation
-            for (uint8_t i = 0; i <= x; i++) {
-                chip->V[i] = chip->memory[chip->I + i];
-            }
-            chip->I += x + 1;
+        case CHIP8_OP_RET:
+            if (chip->SP > 0) chip8_profile_return(profile);
+            break;
+        case CHIP8_OP_DRW:
+            for (uint8_t row = 0; row < (instr.nn & 0x0F); row++) profile->reads[CHIP8_ADDR(chip->I + row)]++;
+            break;
+        case CHIP8_OP_LD_VX_MEM:
+            for (uint8_t i = 0; i <= instr.x; i++) profile->reads[CHIP8_ADDR(chip->I + i)]++;
+            break;
+        case CHIP8_OP_LD_MEM_VX:
+            for (uint8_t i = 0; i <= instr.x; i++) profile->writes[CHIP8_ADDR(chip->I + i)]++;
+            break;
+        case CHIP8_OP_LD_B:
+            for (uint8_t i = 0; i < 3; i++) profile->writes[CHIP8_ADDR(chip->I + i)]++;
             break;
+        default:
+            break;
+    }
+}
+
+/*
+    chip8_step with the undo log, the trace and/or the profile on.
+*/
+static bool chip8_step_logged(Chip8* chip) {
+    Chip8UndoMark mark;
+    if (chip->undo) chip8_undo_begin(chip, &mark);
+
+    Chip8Instr instr = chip8_fetch_decoded(chip);
+    if (chip->profile) chip8_profile_count(chip, instr);
+    Chip8TraceRecord* record = NULL;
+    if (chip->trace) {
+        size_t room;
+        record = chip8_trace_span(chip->trace, &room);
+        *record = (Chip8TraceRecord){ .cycle = chip->cycle_count, .pc = chip->PC, .opcode = instr.opcode };
+    }
 
+    chip8_execute_instr(chip, instr, 1, chip->cycle_count);
+    chip->cycle_count++;
+
+    if (record) {
+        chip8_trace_fill(chip, record);
+        chip8_trace_commit(chip->trace, 1);
+    }
+    if (chip->undo) chip8_undo_end(chip, &mark);
+    return !chip->halted;
+}
+
+/*
+    Tracing backend: the switch loop one instruction at a time (no superinstructions or
+    idle fast-forward), writing a record per instruction straight into the trace buffer.
+*/
+static int chip8_run_traced(Chip8* chip, int n) {
+    int executed = 0;
+    while (executed < n && !chip->halted) {
+        size_t room;
+        Chip8TraceRecord* out = chip8_trace_span(chip->trace, &room);
+
+        size_t written = 0;
+        while (written < room && executed < n && !chip->halted) {
+            Chip8Instr instr = chip8_fetch_decoded(chip);
+            uint64_t cycle = chip->cycle_count + (uint64_t)executed;
+            Chip8TraceRecord* record = &out[written++];
+            record->cycle = cycle;
+            record->pc = chip->PC;
+            record->opcode = instr.opcode;
+            if (chip->profile) chip8_profile_count(chip, instr);
+
+            chip8_execute_instr(chip, instr, 1, cycle);
+            chip8_trace_fill(chip, record);
+            executed++;
         }
-        break;
+        chip8_trace_commit(chip->trace, written);
+    }
 
-        case 0xC000:
-        // Set VX to a random number with a mask of NN
-        chip->V[x] = (rand() % 256) & nn;
-        break;
+    chip->cycle_count += executed;
+    return executed;
+}
 
-        case 0xD000:
-            {
-                uint8_t lx = chip->V[x] % 64;
-                uint8_t ly = chip->V[y] % 32;
-                uint8_t height = n;
-                chip->V[0xF] = 0;
-
-                for (uint8_t row = 0; row < height; row++) {
-                    uint16_t sprite_byte = chip->memory[chip->I + row];
-
-                    for (uint8_t col = 0; col < 8; col++) {
-                        if (sprite_byte & (0x80 >> col)) {
-                            uint8_t px = (lx + col) % 64;
-                            uint8_t py = (ly + row) % 32;
-                            uint16_t index = py * CHIP8_DISPLAY_WIDTH + px;
-
-                            if (chip->display[index]) {
-                                chip->V[0xF] = 1;
-                            }
-
-                            chip->display[index] ^= 1;
-                        }
-                    }
-                }
-
-                chip->draw_flag = true;
-            }
-        break;
-        
+/*
+    Profiling backend: the switch loop one instruction at a time, counting each where
+    it ran.
+*/
+static int chip8_run_profiled(Chip8* chip, int n) {
+    int executed = 0;
+    while (executed < n && !chip->halted) {
+        Chip8Instr instr = chip8_fetch_decoded(chip);
+        chip8_profile_count(chip, instr);
+        chip8_execute_instr(chip, instr, 1, chip->cycle_count + (uint64_t)executed);
+        executed++;
+    }
 
-        default:
-            fprintf(stderr, "Unkown opcode: 0x%04X\n", opcode);
-            chip->halted = true;
-            break;
+    chip->cycle_count += executed;
+    return executed;
+}
+
+/*
+    With the undo log on, every backend runs one logged chip8_step at a time, without
+    superinstructions or idle fast-forward, so each instruction can be stepped back.
+*/
+static int chip8_run_undo(Chip8* chip, int n) {
+    int executed = 0;
+    while (executed < n && !chip->halted) {
+        chip8_step(chip);
+        executed++;
     }
+    return executed;
+}
 
-    chip->PC += 2;
+// ENTRY POINTS FOR OTHER BACKENDS (see chip8_internal.h)
+
+void chip8_exec_opcode(Chip8* chip, uint16_t opcode) {
+    chip8_execute_instr(chip, chip8_decode(opcode), 1, chip->cycle_count);
+}
+
+int chip8_interpret(Chip8* chip, int n) {
+    return chip8_run_switch(chip, n);
+}
+
+int chip8_interpret_idle(Chip8* chip, int n) {
+    if (chip->PC & 1) return 0;
+
+    Chip8Instr instr = chip8_fetch_decoded(chip);
+    if (!chip8_is_idle_op(instr.op)) return 0;
+
+    int executed = chip8_execute_instr(chip, instr, n, chip->cycle_count);
+    chip->cycle_count += executed;
+    return executed;
+}
+
+bool chip8_is_idle_loop(Chip8* chip, uint16_t address) {
+    if (address & 1) return false;
+
+    uint16_t pc = chip->PC;
+    chip->PC = address;
+    Chip8Instr instr = chip8_fetch_decoded(chip);
+    chip->PC = pc;
+    return chip8_is_idle_op(instr.op);
+}
+
+bool chip8_is_fused(Chip8* chip, uint16_t address) {
+    if (address & 1) return false;
+
+    uint16_t pc = chip->PC;
+    chip->PC = address;
+    Chip8Instr instr = chip8_fetch_decoded(chip);
+    chip->PC = pc;
+    return instr.op >= CHIP8_OP_FUSED_FIRST && !chip8_is_idle_op(instr.op);
 }
 
 // PUBLIC FUNCTIONS (INTERFACE)
@@ -384,7 +1153,9 @@ Chip8* chip8_create(void) {
         return NULL;
     }
     
+    chip->rand_seed = CHIP8_DEFAULT_SEED;
     chip8_init_state(chip);
+    chip8_set_backend(chip, CHIP8_DEFAULT_BACKEND); // stays on the switch backend if unavailable
     return chip;
 }
 
@@ -393,6 +1164,16 @@ void chip8_destroy(Chip8** chip_ptr) {
         return;
     }
 
+    chip8_unload_aot(*chip_ptr);
+    chip8_jit_destroy((*chip_ptr)->jit);
+    chip8_movie_destroy(&(*chip_ptr)->movie);
+    chip8_snapshot_release(&(*chip_ptr)->snapshot);
+    chip8_undo_disable(*chip_ptr);
+    chip8_trace_stop(*chip_ptr);
+    chip8_profile_disable(*chip_ptr);
+    chip8_sampler_stop(*chip_ptr);
+    chip8_break_clear_all(*chip_ptr);
+    chip8_watch_clear_all(*chip_ptr);
     free(*chip_ptr);
     *chip_ptr = NULL;
 }
@@ -407,7 +1188,9 @@ void chip8_reset(Chip8* chip) {
     chip8_init_state(chip);
 
     if (rom_path_temp[0] != '\0') {
-        chip8_load_rom(chip, rom_path_temp);
+        chip8_load_rom(chip, rom_path_temp); // reports the new state itself
+    } else {
+        chip8_state_replaced(chip);
     }
 }
 
@@ -443,6 +1226,8 @@ bool chip8_load_rom(Chip8* chip, const char* path) {
     // load (fread) into memory
     size_t byte_read = fread(chip->memory + 0x200, 1, file_size, file);
     fclose(file);
+    chip8_invalidate_all(chip);
+    chip->dirty_pages = CHIP8_ALL_PAGES;
 
     if (byte_read != (size_t) file_size) {
         fprintf(stderr, "ERROR: Failed to read ROM!\n");
@@ -453,7 +1238,7 @@ bool chip8_load_rom(Chip8* chip, const char* path) {
     chip->rom_size = file_size;
     strncpy(chip->rom_path, path, sizeof(chip->rom_path));
 
-    printf("Succesfully loaded ROM: %s (%ld bytes)\n", path, file_size);
+    chip8_state_replaced(chip);
     return true;
 }
 
@@ -481,6 +1266,8 @@ void chip8_update_timers(Chip8* chip) {
     if (chip->sound_timer > 0) {
         chip->sound_timer--;
     }
+
+    if (chip->movie) chip8_movie_on_tick(chip);
 }
 
 bool chip8_step(Chip8* chip) {
@@ -488,25 +1275,204 @@ bool chip8_step(Chip8* chip) {
         return false;
     }
 
-    uint16_t opcode = chip8_fetch(chip);
-    chip8_execute(chip, opcode);
+    if (chip->undo || chip->trace || chip->profile) {
+        return chip8_step_logged(chip);
+    }
+
+    chip8_execute_instr(chip, chip8_fetch_decoded(chip), 1, chip->cycle_count);
     chip->cycle_count++;
 
     return !chip->halted;
 }
 
+static int chip8_run(Chip8* chip, int n) {
+    if (chip->undo) return chip8_run_undo(chip, n);
+    if (chip->trace) return chip8_run_traced(chip, n);
+    if (chip->profile) return chip8_run_profiled(chip, n);
+
+    switch (chip->backend) {
+#if CHIP8_HAVE_THREADED
+        case CHIP8_BACKEND_THREADED: return chip8_run_threaded(chip, n);
+#endif
+        case CHIP8_BACKEND_JIT:      return chip8_jit_run(chip, n, true);
+        case CHIP8_BACKEND_AOT:      return chip8_jit_run(chip, n, false);
+        default:                     return chip8_run_switch(chip, n);
+    }
+}
+
 int chip8_step_n(Chip8* chip, int n) {
-    if (!chip) return 0;
+    if (!chip || chip->halted || n <= 0) return 0;
 
-    int executed = 0;
-    for (int i = 0; i < n && !chip->halted; i++) {
-        chip8_step(chip);
-        executed++;
-    }
+    chip->phase = CHIP8_PHASE_INTERPRET;
+    int executed = chip8_run(chip, n);
+    chip->phase = CHIP8_PHASE_HOST;
 
+    if (chip->sampler) chip8_sampler_poll(chip);
     return executed;
 }
 
+// a dispatch has to stop short of any breakpoint within the slots it may go through
+_Static_assert(CHIP8_BREAK_SPAN >= CHIP8_FUSED_SPAN, "breakpoint guard narrower than a superinstruction");
+
+/*
+    chip8_run_until with breakpoints, a target or watchpoints armed: the switch loop plus
+    one test of the guard bit of every address it dispatches. Only near a breakpoint or
+    the target does it look closer, running single instructions and the conditions;
+    elsewhere superinstructions and idle fast-forward work as usual. Memory watches are
+    caught by the loads and stores themselves, so only a pending hit is checked after
+    each dispatch; register watches run single instructions throughout.
+*/
+static Chip8StopReason chip8_run_checked(Chip8* chip, uint64_t max_cycles) {
+    static const uint64_t no_guard[CHIP8_MEMORY_SIZE / 64];
+    Chip8Breakpoints* breakpoints = chip->breakpoints;
+    const uint64_t* guard = breakpoints ? breakpoints->guard : no_guard;
+    bool logged = chip->undo || chip->trace || chip->profile;
+    // step out: any address once SP is back at target_sp
+    int sp_limit = (breakpoints && breakpoints->has_target && breakpoints->target == CHIP8_BREAK_ANY) ?
+                   breakpoints->target_sp : -1;
+
+    Chip8Watches* watches = chip8_watch_armed(chip->watches) ? chip->watches : NULL;
+    bool registers = watches && watches->registers;
+
+    // only a run resuming from the last stop runs its first instruction unchecked; any
+    // other stops before it, or a breakpoint where the previous budget ran out is missed
+    bool resuming = chip8_break_resuming(breakpoints, chip);
+
+    Chip8StopReason reason = CHIP8_STOP_BUDGET;
+    uint64_t executed = 0;
+    while (executed < max_cycles) {
+        if (chip->halted) {
+            reason = CHIP8_STOP_HALTED;
+            break;
+        }
+
+        uint16_t pc = CHIP8_ADDR(chip->PC);
+        bool check = executed > 0 || !resuming;
+        if ((int)chip->SP <= sp_limit && check) {
+            reason = CHIP8_STOP_TARGET;
+            break;
+        }
+
+        uint64_t left = max_cycles - executed;
+        int budget = (left > (1u << 20)) ? (1 << 20) : (int)left;
+        if (registers) budget = 1;
+        if ((guard[pc >> 6] >> (pc & 63)) & 1) {
+            if (check && breakpoints->has_target && breakpoints->target == pc &&
+                chip->SP <= breakpoints->target_sp) {
+                reason = CHIP8_STOP_TARGET;
+                break;
+            }
+            if (check && chip8_break_armed(breakpoints, pc) && chip8_break_take(chip)) {
+                reason = CHIP8_STOP_BREAKPOINT;
+                break;
+            }
+            budget = 1;
+        }
+
+        uint64_t cycle = logged ? chip->cycle_count : chip->cycle_count + executed;
+        int ran = 1;
+        if (logged) {
+            chip8_step_logged(chip); // counts its own cycle
+        } else {
+            ran = chip8_execute_instr(chip, chip8_fetch_decoded(chip), budget, cycle);
+        }
+        executed += ran;
+
+        if (watches && (watches->pending || (registers && chip8_watch_check_registers(chip, pc)))) {
+            // memory is only touched by the last instruction of a dispatch (DXYN ends its superinstruction)
+            watches->hit.cycle = cycle + ran - 1;
+            reason = CHIP8_STOP_WATCHPOINT;
+            break;
+        }
+    }
+
+    if (!logged) chip->cycle_count += executed;
+    if (breakpoints) {
+        // a breakpoint or watchpoint ends a step over or out as well
+        if (reason != CHIP8_STOP_BUDGET && reason != CHIP8_STOP_HALTED) breakpoints->has_target = false;
+        breakpoints->has_resume = false;
+        if (reason == CHIP8_STOP_BREAKPOINT || reason == CHIP8_STOP_TARGET) chip8_break_note_resume(breakpoints, chip);
+    }
+    return reason;
+}
+
+Chip8StopReason chip8_run_until(Chip8* chip, uint64_t max_cycles) {
+    if (!chip || chip->halted) return CHIP8_STOP_HALTED;
+    if (chip->watches) chip8_watch_begin(chip);
+
+    Chip8Breakpoints* breakpoints = chip->breakpoints;
+    if ((breakpoints && (breakpoints->count > 0 || breakpoints->has_target)) || chip8_watch_armed(chip->watches)) {
+        chip->phase = CHIP8_PHASE_INTERPRET;
+        Chip8StopReason reason = chip8_run_checked(chip, max_cycles);
+        chip->phase = CHIP8_PHASE_HOST;
+
+        if (chip->sampler) chip8_sampler_poll(chip);
+        return reason;
+    }
+
+    // nothing can stop it early, so the backend runs as usual
+    while (max_cycles > 0 && !chip->halted) {
+        int n = (max_cycles > (1u << 20)) ? (1 << 20) : (int)max_cycles;
+        chip8_step_n(chip, n);
+        max_cycles -= (uint64_t)n;
+    }
+    return chip->halted ? CHIP8_STOP_HALTED : CHIP8_STOP_BUDGET;
+}
+
+const char* chip8_stop_reason_name(Chip8StopReason reason) {
+    switch (reason) {
+        case CHIP8_STOP_BUDGET:     return "budget";
+        case CHIP8_STOP_BREAKPOINT: return "breakpoint";
+        case CHIP8_STOP_TARGET:     return "target";
+        case CHIP8_STOP_HALTED:     return "halted";
+        case CHIP8_STOP_WATCHPOINT: return "watchpoint";
+        default:                    return "unknown";
+    }
+}
+
+bool chip8_set_backend(Chip8* chip, Chip8Backend backend) {
+    if (!chip || !chip8_backend_available(backend)) return false;
+    if (backend == CHIP8_BACKEND_AOT && !chip->aot) return false;
+
+    bool uses_blocks = (backend == CHIP8_BACKEND_JIT || backend == CHIP8_BACKEND_AOT);
+    if (uses_blocks && !chip->jit) {
+        chip->jit = chip8_jit_create();
+        if (!chip->jit) return false;
+        chip8_aot_install(chip);
+    } else if (!uses_blocks && chip->jit && !chip->aot) {
+        // a loaded module keeps its blocks installed so the AOT backend can be picked again
+        chip8_jit_destroy(chip->jit);
+        chip->jit = NULL;
+    }
+
+    chip->backend = (uint8_t)backend;
+    return true;
+}
+
+Chip8Backend chip8_get_backend(Chip8* chip) {
+    return chip ? (Chip8Backend)chip->backend : CHIP8_BACKEND_SWITCH;
+}
+
+bool chip8_backend_available(Chip8Backend backend) {
+    switch (backend) {
+        case CHIP8_BACKEND_SWITCH:   return true;
+        case CHIP8_BACKEND_THREADED: return CHIP8_HAVE_THREADED;
+        case CHIP8_BACKEND_JIT:      return chip8_jit_supported();
+        case CHIP8_BACKEND_AOT:      return chip8_aot_supported();
+        default:                     return false;
+    }
+}
+
+const char* chip8_backend_name(Chip8Backend backend) {
+    switch (backend) {
+        case CHIP8_BACKEND_SWITCH:   return "switch";
+        case CHIP8_BACKEND_THREADED: return "threaded";
+        case CHIP8_BACKEND_JIT:      return "jit";
+        case CHIP8_BACKEND_AOT:      return "aot";
+        default:                     return "unknown";
+    }
+}
+
 void chip8_start(Chip8* chip) {
     if (!chip) return;
     chip->running = true;
@@ -525,15 +1491,60 @@ bool chip8_is_halted(Chip8* chip) {
     return chip && chip->halted;
 }
 
+void chip8_set_seed(Chip8* chip, uint64_t seed) {
+    if (!chip) return;
+
+    chip->rand_seed = seed;
+    chip->rand_state = chip8_rand_seed(seed);
+
+    chip8_state_replaced(chip);
+}
+
+uint64_t chip8_get_seed(Chip8* chip) {
+    return chip ? chip->rand_seed : 0;
+}
+
+size_t chip8_drain_diagnostics(Chip8* chip, Chip8Diag* out, size_t max) {
+    if (!chip || !out) return 0;
+
+    size_t count = 0;
+    while (count < max && chip->diag_used > 0) {
+        Chip8Diag entry = chip->diag_ring[chip->diag_head];
+        chip->diag_head = (uint8_t)((chip->diag_head + 1) % CHIP8_DIAG_RING_SIZE);
+        chip->diag_used--;
+        chip->diag_queued[entry.code]--;
+        out[count++] = entry;
+    }
+    return count;
+}
+
+uint64_t chip8_get_diag_count(Chip8* chip, Chip8DiagCode code) {
+    if (!chip || code < 0 || code >= CHIP8_DIAG_COUNT) return 0;
+
+    return chip->diag_counts[code];
+}
+
+const char* chip8_diag_name(Chip8DiagCode code) {
+    switch (code) {
+        case CHIP8_DIAG_SYS:             return "0NNN call ignored";
+        case CHIP8_DIAG_INVALID_OPCODE:  return "invalid opcode";
+        case CHIP8_DIAG_STACK_UNDERFLOW: return "stack underflow";
+        case CHIP8_DIAG_STACK_OVERFLOW:  return "stack overflow";
+        default:                         return "unknown";
+    }
+}
+
 void chip8_key_press(Chip8* chip, uint8_t key) {
     if (!chip || key >= CHIP8_NUM_KEYS) return;
 
+    if (chip->movie && !chip->keys[key]) chip8_movie_on_key(chip, key, true);
     chip->keys[key] = true;
 }
 
 void chip8_key_release(Chip8* chip, uint8_t key) {
     if (!chip || key >= CHIP8_NUM_KEYS) return;
 
+    if (chip->movie && chip->keys[key]) chip8_movie_on_key(chip, key, false);
     chip->keys[key] = false;
 }
 
@@ -583,11 +1594,25 @@ uint64_t chip8_get_cycle_count(Chip8* chip) {
     return chip ? chip->cycle_count : 0;
 }
 
+uint64_t chip8_get_idle_cycles(Chip8* chip) {
+    return chip ? chip->idle_cycles : 0;
+}
+
 const uint8_t* chip8_get_memory(Chip8* chip) {
     return chip ? chip->memory : 0;
 }
 
-const bool* chip8_get_display(Chip8* chip) {
+void chip8_get_display(Chip8* chip, bool* pixels) {
+    if (!chip || !pixels) return;
+
+    for (uint16_t y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) {
+        for (uint16_t x = 0; x < CHIP8_DISPLAY_WIDTH; x++) {
+            pixels[y * CHIP8_DISPLAY_WIDTH + x] = CHIP8_PIXEL(chip->display, x, y);
+        }
+    }
+}
+
+const uint64_t* chip8_get_display_rows(Chip8* chip) {
     return chip ? chip->display : 0;
 }
 
@@ -599,6 +1624,14 @@ bool chip8_should_draw(Chip8* chip) {
     return should_draw;
 }
 
+uint32_t chip8_take_dirty_rows(Chip8* chip) {
+    if (!chip) return 0;
+
+    uint32_t dirty_rows = chip->dirty_rows;
+    chip->dirty_rows = 0;
+    return dirty_rows;
+}
+
 uint8_t chip8_read_memory(Chip8* chip, uint16_t address) {
     if (!chip || address >= CHIP8_MEMORY_SIZE) return 0;
 
@@ -608,7 +1641,7 @@ uint8_t chip8_read_memory(Chip8* chip, uint16_t address) {
 void chip8_write_memory(Chip8* chip, uint16_t address, uint8_t byte) {
     if (!chip || address >= CHIP8_MEMORY_SIZE) return;
 
-    chip->memory[address] = byte;
+    chip8_store(chip, address, byte);
 }
 
 uint16_t chip8_read_opcode(Chip8* chip, uint16_t address) {
@@ -632,8 +1665,12 @@ void chip8_disassemble(Chip8* chip, uint16_t address, char* buffer, size_t bufsi
         return;
     }
     
-    uint16_t opcode = chip8_read_opcode(chip, address);
-    
+    chip8_disassemble_opcode(chip8_read_opcode(chip, address), buffer, bufsize);
+}
+
+void chip8_disassemble_opcode(uint16_t opcode, char* buffer, size_t bufsize) {
+    if (!buffer || bufsize == 0) return;
+
     // Extract common components
     uint8_t x = (opcode & 0x0F00) >> 8;
     uint8_t y = (opcode & 0x00F0) >> 4;
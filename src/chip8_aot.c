@@ -0,0 +1,157 @@
+#include "../include/chip8.h"
+#include "../include/chip8_aot.h"
+#include "chip8_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Loader for modules produced by tools/chip8_aotc.c.
+
+    The module's blocks are installed into the instance's translation cache (chip8_jit.c),
+    which already handles dispatch, budgets and invalidation on guest writes. Every time the
+    cache is flushed (ROM load, reset) the blocks are checked again against memory, so only
+    code that still matches the ROM image the module was built from ever runs natively.
+*/
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHIP8_HAVE_AOT 1
+#include <dlfcn.h>
+#else
+#define CHIP8_HAVE_AOT 0
+#endif
+
+struct Chip8Aot {
+    void* handle;
+    const Chip8AotModule* module;
+};
+
+#if CHIP8_HAVE_AOT
+
+static bool chip8_aot_validate(const Chip8AotModule* module, const char* path) {
+    if (module->abi_version != CHIP8_AOT_ABI_VERSION) {
+        fprintf(stderr, "ERROR: AOT module %s has ABI version %u, expected %u\n",
+                path, module->abi_version, CHIP8_AOT_ABI_VERSION);
+        return false;
+    }
+    if (module->chip8_size != sizeof(Chip8)) {
+        fprintf(stderr, "ERROR: AOT module %s was built against a different core, rebuild it with chip8aotc\n", path);
+        return false;
+    }
+    if (!module->blocks || !module->image || !module->exec_opcode ||
+        module->image_size > CHIP8_MEMORY_SIZE - 0x200) {
+        fprintf(stderr, "ERROR: AOT module %s is malformed\n", path);
+        return false;
+    }
+    return true;
+}
+
+bool chip8_aot_supported(void) {
+    return true;
+}
+
+void chip8_aot_install(Chip8* chip) {
+    if (!chip->aot || !chip->jit) return;
+
+    const Chip8AotModule* module = chip->aot->module;
+    for (uint32_t b = 0; b < module->block_count; b++) {
+        const Chip8AotBlock* block = &module->blocks[b];
+        uint32_t bytes = (uint32_t)block->length * 2;
+
+        if (block->start < 0x200 || block->start + bytes > 0x200 + module->image_size) continue;
+        if (memcmp(chip->memory + block->start, module->image + (block->start - 0x200), bytes) != 0) continue;
+        if (chip8_is_idle_loop(chip, block->start)) continue;
+
+        chip8_jit_install(chip->jit, block->start, block->length, block->fn);
+    }
+}
+
+bool chip8_load_aot(Chip8* chip, const char* path) {
+    if (!chip || !path || path[0] == '\0') {
+        fprintf(stderr, "ERROR: Invalid instance or path while loading AOT module\n");
+        return false;
+    }
+
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        fprintf(stderr, "ERROR: Failed to open AOT module: %s\n", dlerror());
+        return false;
+    }
+
+    const Chip8AotModule* module = (const Chip8AotModule*)dlsym(handle, CHIP8_AOT_SYMBOL);
+    if (!module) {
+        fprintf(stderr, "ERROR: %s does not export %s\n", path, CHIP8_AOT_SYMBOL);
+        dlclose(handle);
+        return false;
+    }
+    if (!chip8_aot_validate(module, path)) {
+        dlclose(handle);
+        return false;
+    }
+
+    struct Chip8Aot* aot = calloc(1, sizeof(struct Chip8Aot));
+    if (!aot) {
+        fprintf(stderr, "ERROR: Failed to allocate AOT state\n");
+        dlclose(handle);
+        return false;
+    }
+    aot->handle = handle;
+    aot->module = module;
+    *module->exec_opcode = chip8_exec_opcode;
+
+    chip8_unload_aot(chip);
+    if (!chip->jit) {
+        chip->jit = chip8_jit_create();
+        if (!chip->jit) {
+            dlclose(handle);
+            free(aot);
+            return false;
+        }
+    }
+
+    chip->aot = aot;
+    chip8_jit_flush(chip->jit);
+    chip8_aot_install(chip);
+    chip8_set_backend(chip, CHIP8_BACKEND_AOT);
+    return true;
+}
+
+void chip8_unload_aot(Chip8* chip) {
+    if (!chip || !chip->aot) return;
+
+    // the module's code is about to go away, so none of its blocks may stay installed
+    if (chip->jit) {
+        chip8_jit_flush(chip->jit);
+    }
+
+    dlclose(chip->aot->handle);
+    free(chip->aot);
+    chip->aot = NULL;
+
+    if (chip->backend == CHIP8_BACKEND_AOT) {
+        chip8_set_backend(chip, CHIP8_BACKEND_SWITCH);
+    }
+}
+
+#else
+
+bool chip8_aot_supported(void) {
+    return false;
+}
+
+void chip8_aot_install(Chip8* chip) {
+    (void)chip;
+}
+
+bool chip8_load_aot(Chip8* chip, const char* path) {
+    (void)chip;
+    (void)path;
+    fprintf(stderr, "ERROR: AOT modules are not supported on this platform\n");
+    return false;
+}
+
+void chip8_unload_aot(Chip8* chip) {
+    (void)chip;
+}
+
+#endif
@@ -0,0 +1,515 @@
+#include "../include/chip8_break.h"
+#include "chip8_internal.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// CONDITIONS
+
+/*
+    Stack machine ops. Loads push a value, LOAD replaces an address with the byte there,
+    NOT replaces a value, the binary ops pop two and push one. Values are ints and
+    comparisons push 0 or 1, as in C.
+*/
+enum {
+    COND_CONST = 1, // arg
+    COND_V,         // V[arg]
+    COND_I,
+    COND_PC,
+    COND_SP,
+    COND_DT,
+    COND_ST,
+    COND_LOAD,
+    COND_NOT,
+    COND_ADD,
+    COND_SUB,
+    COND_AND,
+    COND_EQ,
+    COND_NE,
+    COND_LT,
+    COND_LE,
+    COND_GT,
+    COND_GE,
+    COND_LAND,
+    COND_LOR,
+};
+
+typedef struct {
+    const char* text;
+    const char* at;
+    Chip8Condition* out;
+    int depth; // values on the stack once the code so far has run
+    bool failed;
+    char* error;
+    size_t error_size;
+} Chip8ConditionParser;
+
+static void chip8_condition_fail(Chip8ConditionParser* parser, const char* format, ...) {
+    if (parser->failed) return; // keep the first reason
+    parser->failed = true;
+    if (!parser->error || parser->error_size == 0) return;
+
+    int column = (int)(parser->at - parser->text) + 1;
+    int written = snprintf(parser->error, parser->error_size, "column %d: ", column);
+    if (written < 0 || (size_t)written >= parser->error_size) return;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(parser->error + written, parser->error_size - (size_t)written, format, args);
+    va_end(args);
+}
+
+static void chip8_condition_emit(Chip8ConditionParser* parser, uint8_t op, uint16_t arg, int pushes) {
+    if (parser->failed) return;
+    if (parser->out->length >= CHIP8_CONDITION_CODE) {
+        chip8_condition_fail(parser, "condition too long");
+        return;
+    }
+    parser->depth += pushes;
+    if (parser->depth > CHIP8_CONDITION_STACK) {
+        chip8_condition_fail(parser, "condition nested too deep");
+        return;
+    }
+    parser->out->code[parser->out->length++] = (Chip8ConditionOp){ .op = op, .arg = arg };
+}
+
+static void chip8_condition_skip_space(Chip8ConditionParser* parser) {
+    while (isspace((unsigned char)*parser->at)) parser->at++;
+}
+
+// Consumes token if the input continues with it
+static bool chip8_condition_accept(Chip8ConditionParser* parser, const char* token) {
+    chip8_condition_skip_space(parser);
+    size_t length = strlen(token);
+    if (strncmp(parser->at, token, length) != 0) return false;
+    parser->at += length;
+    return true;
+}
+
+static void chip8_condition_or(Chip8ConditionParser* parser);
+
+static void chip8_condition_primary(Chip8ConditionParser* parser) {
+    chip8_condition_skip_space(parser);
+    const char* start = parser->at;
+
+    if (chip8_condition_accept(parser, "(")) {
+        chip8_condition_or(parser);
+        if (!chip8_condition_accept(parser, ")")) chip8_condition_fail(parser, "expected ')'");
+        return;
+    }
+    if (chip8_condition_accept(parser, "[")) {
+        chip8_condition_or(parser);
+        chip8_condition_emit(parser, COND_LOAD, 0, 0);
+        if (!chip8_condition_accept(parser, "]")) chip8_condition_fail(parser, "expected ']'");
+        return;
+    }
+
+    if (isdigit((unsigned char)*start)) {
+        bool hex = (start[0] == '0' && (start[1] == 'x' || start[1] == 'X'));
+        char* end;
+        unsigned long value = strtoul(hex ? start + 2 : start, &end, hex ? 16 : 10);
+        if (end == start + 2 && hex) {
+            chip8_condition_fail(parser, "expected hex digits");
+            return;
+        }
+        if (isalnum((unsigned char)*end) || value > 0xFFFF) {
+            chip8_condition_fail(parser, "bad number");
+            return;
+        }
+        parser->at = end;
+        chip8_condition_emit(parser, COND_CONST, (uint16_t)value, 1);
+        return;
+    }
+
+    if (isalpha((unsigned char)*start)) {
+        const char* end = start;
+        while (isalnum((unsigned char)*end)) end++;
+        size_t length = (size_t)(end - start);
+
+        char name[4] = { 0 };
+        if (length < sizeof(name)) {
+            for (size_t c = 0; c < length; c++) name[c] = (char)toupper((unsigned char)start[c]);
+        }
+
+        if (length == 2 && name[0] == 'V' && isxdigit((unsigned char)name[1])) {
+            uint16_t reg = (uint16_t)(isdigit((unsigned char)name[1]) ? name[1] - '0' : name[1] - 'A' + 10);
+            chip8_condition_emit(parser, COND_V, reg, 1);
+        } else if (strcmp(name, "I") == 0) {
+            chip8_condition_emit(parser, COND_I, 0, 1);
+        } else if (strcmp(name, "PC") == 0) {
+            chip8_condition_emit(parser, COND_PC, 0, 1);
+        } else if (strcmp(name, "SP") == 0) {
+            chip8_condition_emit(parser, COND_SP, 0, 1);
+        } else if (strcmp(name, "DT") == 0) {
+            chip8_condition_emit(parser, COND_DT, 0, 1);
+        } else if (strcmp(name, "ST") == 0) {
+            chip8_condition_emit(parser, COND_ST, 0, 1);
+        } else {
+            chip8_condition_fail(parser, "unknown name '%.*s'", (int)length, start);
+            return;
+        }
+        parser->at = end;
+        return;
+    }
+
+    if (*start == '\0') {
+        chip8_condition_fail(parser, "unexpected end");
+    } else {
+        chip8_condition_fail(parser, "unexpected '%c'", *start);
+    }
+}
+
+static void chip8_condition_unary(Chip8ConditionParser* parser) {
+    chip8_condition_skip_space(parser);
+    if (parser->at[0] == '!' && parser->at[1] != '=') {
+        parser->at++;
+        chip8_condition_unary(parser);
+        chip8_condition_emit(parser, COND_NOT, 0, 0);
+        return;
+    }
+    chip8_condition_primary(parser);
+}
+
+static void chip8_condition_additive(Chip8ConditionParser* parser) {
+    chip8_condition_unary(parser);
+    while (!parser->failed) {
+        if (chip8_condition_accept(parser, "+")) {
+            chip8_condition_unary(parser);
+            chip8_condition_emit(parser, COND_ADD, 0, -1);
+        } else if (chip8_condition_accept(parser, "-")) {
+            chip8_condition_unary(parser);
+            chip8_condition_emit(parser, COND_SUB, 0, -1);
+        } else {
+            break;
+        }
+    }
+}
+
+static void chip8_condition_relational(Chip8ConditionParser* parser) {
+    chip8_condition_additive(parser);
+    while (!parser->failed) {
+        // the two-character operators first
+        uint8_t op;
+        if (chip8_condition_accept(parser, "<="))     op = COND_LE;
+        else if (chip8_condition_accept(parser, ">=")) op = COND_GE;
+        else if (chip8_condition_accept(parser, "<"))  op = COND_LT;
+        else if (chip8_condition_accept(parser, ">"))  op = COND_GT;
+        else break;
+
+        chip8_condition_additive(parser);
+        chip8_condition_emit(parser, op, 0, -1);
+    }
+}
+
+static void chip8_condition_equality(Chip8ConditionParser* parser) {
+    chip8_condition_relational(parser);
+    while (!parser->failed) {
+        uint8_t op;
+        if (chip8_condition_accept(parser, "=="))      op = COND_EQ;
+        else if (chip8_condition_accept(parser, "!=")) op = COND_NE;
+        else break;
+
+        chip8_condition_relational(parser);
+        chip8_condition_emit(parser, op, 0, -1);
+    }
+}
+
+static void chip8_condition_bitand(Chip8ConditionParser* parser) {
+    chip8_condition_equality(parser);
+    while (!parser->failed) {
+        chip8_condition_skip_space(parser);
+        if (parser->at[0] != '&' || parser->at[1] == '&') break;
+        parser->at++;
+
+        chip8_condition_equality(parser);
+        chip8_condition_emit(parser, COND_AND, 0, -1);
+    }
+}
+
+static void chip8_condition_and(Chip8ConditionParser* parser) {
+    chip8_condition_bitand(parser);
+    while (!parser->failed && chip8_condition_accept(parser, "&&")) {
+        chip8_condition_bitand(parser);
+        chip8_condition_emit(parser, COND_LAND, 0, -1);
+    }
+}
+
+static void chip8_condition_or(Chip8ConditionParser* parser) {
+    chip8_condition_and(parser);
+    while (!parser->failed && chip8_condition_accept(parser, "||")) {
+        chip8_condition_and(parser);
+        chip8_condition_emit(parser, COND_LOR, 0, -1);
+    }
+}
+
+static bool chip8_condition_compile(const char* text, Chip8Condition* out, char* error, size_t error_size) {
+    memset(out, 0, sizeof(Chip8Condition));
+    Chip8ConditionParser parser = {
+        .text = text,
+        .at = text,
+        .out = out,
+        .error = error,
+        .error_size = error_size,
+    };
+
+    chip8_condition_or(&parser);
+    chip8_condition_skip_space(&parser);
+    if (!parser.failed && *parser.at != '\0') {
+        chip8_condition_fail(&parser, "unexpected '%c'", *parser.at);
+    }
+    return !parser.failed;
+}
+
+// Conditions are pure, so && and || need not short-circuit
+bool chip8_condition_eval(Chip8* chip, const Chip8Condition* condition) {
+    int32_t stack[CHIP8_CONDITION_STACK];
+    int top = -1;
+
+    for (uint8_t pc = 0; pc < condition->length; pc++) {
+        Chip8ConditionOp op = condition->code[pc];
+        switch (op.op) {
+            case COND_CONST: stack[++top] = op.arg; break;
+            case COND_V:     stack[++top] = chip->V[op.arg & 0xF]; break;
+            case COND_I:     stack[++top] = chip->I; break;
+            case COND_PC:    stack[++top] = chip->PC; break;
+            case COND_SP:    stack[++top] = chip->SP; break;
+            case COND_DT:    stack[++top] = chip->delay_timer; break;
+            case COND_ST:    stack[++top] = chip->sound_timer; break;
+            case COND_LOAD:  stack[top] = chip->memory[CHIP8_ADDR((uint32_t)stack[top])]; break;
+            case COND_NOT:   stack[top] = !stack[top]; break;
+            case COND_ADD:   top--; stack[top] = stack[top] + stack[top + 1]; break;
+            case COND_SUB:   top--; stack[top] = stack[top] - stack[top + 1]; break;
+            case COND_AND:   top--; stack[top] = stack[top] & stack[top + 1]; break;
+            case COND_EQ:    top--; stack[top] = stack[top] == stack[top + 1]; break;
+            case COND_NE:    top--; stack[top] = stack[top] != stack[top + 1]; break;
+            case COND_LT:    top--; stack[top] = stack[top] < stack[top + 1]; break;
+            case COND_LE:    top--; stack[top] = stack[top] <= stack[top + 1]; break;
+            case COND_GT:    top--; stack[top] = stack[top] > stack[top + 1]; break;
+            case COND_GE:    top--; stack[top] = stack[top] >= stack[top + 1]; break;
+            case COND_LAND:  top--; stack[top] = stack[top] && stack[top + 1]; break;
+            case COND_LOR:   top--; stack[top] = stack[top] || stack[top + 1]; break;
+        }
+    }
+    return top >= 0 && stack[top] != 0;
+}
+
+static void chip8_condition_free(Chip8Condition** condition_ptr) {
+    if (!*condition_ptr) return;
+    free((*condition_ptr)->source);
+    free(*condition_ptr);
+    *condition_ptr = NULL;
+}
+
+// Blank conditions mean none
+static bool chip8_condition_is_blank(const char* condition) {
+    if (!condition) return true;
+    while (isspace((unsigned char)*condition)) condition++;
+    return *condition == '\0';
+}
+
+bool chip8_break_check_condition(const char* condition, char* error, size_t error_size) {
+    if (chip8_condition_is_blank(condition)) return true;
+
+    Chip8Condition compiled;
+    return chip8_condition_compile(condition, &compiled, error, error_size);
+}
+
+// BREAKPOINTS
+
+static void chip8_break_guard(Chip8Breakpoints* breakpoints, uint16_t address) {
+    // every dispatch that could run through address
+    for (int back = 0; back < CHIP8_BREAK_SPAN; back++) {
+        uint16_t from = CHIP8_ADDR(address - 2 * back);
+        breakpoints->guard[from >> 6] |= (uint64_t)1 << (from & 63);
+    }
+}
+
+/*
+    Rebuilds the guard bits after a change. A target dropped by chip8_run_until or by a
+    state change leaves its bits behind; they only cost a closer look there.
+*/
+static void chip8_break_update_guard(Chip8Breakpoints* breakpoints) {
+    memset(breakpoints->guard, 0, sizeof(breakpoints->guard));
+    for (int word = 0; word < CHIP8_MEMORY_SIZE / 64; word++) {
+        for (uint64_t bits = breakpoints->armed[word]; bits; bits &= bits - 1) {
+            chip8_break_guard(breakpoints, (uint16_t)(word * 64 + __builtin_ctzll(bits)));
+        }
+    }
+    if (breakpoints->has_target && breakpoints->target != CHIP8_BREAK_ANY) {
+        chip8_break_guard(breakpoints, breakpoints->target);
+    }
+}
+
+static Chip8Breakpoints* chip8_break_get(Chip8* chip) {
+    if (!chip->breakpoints) {
+        chip->breakpoints = calloc(1, sizeof(Chip8Breakpoints));
+        if (!chip->breakpoints) {
+            fprintf(stderr, "ERROR: Failed to allocate breakpoints\n");
+        }
+    }
+    return chip->breakpoints;
+}
+
+bool chip8_break_set(Chip8* chip, uint16_t address, const char* condition) {
+    if (!chip) {
+        fprintf(stderr, "ERROR: Invalid instance of Chip-8 emulator while setting a breakpoint\n");
+        return false;
+    }
+    address = CHIP8_ADDR(address);
+
+    Chip8Condition* compiled = NULL;
+    if (!chip8_condition_is_blank(condition)) {
+        compiled = malloc(sizeof(Chip8Condition));
+        if (!compiled) {
+            fprintf(stderr, "ERROR: Failed to allocate a breakpoint condition\n");
+            return false;
+        }
+
+        char error[128];
+        if (!chip8_condition_compile(condition, compiled, error, sizeof(error))) {
+            fprintf(stderr, "ERROR: Bad breakpoint condition \"%s\": %s\n", condition, error);
+            free(compiled);
+            return false;
+        }
+        size_t length = strlen(condition);
+        compiled->source = malloc(length + 1);
+        if (compiled->source) memcpy(compiled->source, condition, length + 1);
+        if (!compiled->source) {
+            fprintf(stderr, "ERROR: Failed to allocate a breakpoint condition\n");
+            free(compiled);
+            return false;
+        }
+    }
+
+    Chip8Breakpoints* breakpoints = chip8_break_get(chip);
+    if (!breakpoints) {
+        chip8_condition_free(&compiled);
+        return false;
+    }
+
+    if (!chip8_break_armed(breakpoints, address)) {
+        breakpoints->armed[address >> 6] |= (uint64_t)1 << (address & 63);
+        breakpoints->count++;
+    }
+    chip8_condition_free(&breakpoints->conditions[address]);
+    breakpoints->conditions[address] = compiled;
+    breakpoints->hits[address] = 0;
+    chip8_break_update_guard(breakpoints);
+    return true;
+}
+
+void chip8_break_clear(Chip8* chip, uint16_t address) {
+    if (!chip || !chip->breakpoints) return;
+
+    Chip8Breakpoints* breakpoints = chip->breakpoints;
+    address = CHIP8_ADDR(address);
+    if (!chip8_break_armed(breakpoints, address)) return;
+
+    breakpoints->armed[address >> 6] &= ~((uint64_t)1 << (address & 63));
+    breakpoints->count--;
+    chip8_condition_free(&breakpoints->conditions[address]);
+    breakpoints->hits[address] = 0;
+    chip8_break_update_guard(breakpoints);
+}
+
+void chip8_break_clear_all(Chip8* chip) {
+    if (!chip || !chip->breakpoints) return;
+
+    for (int address = 0; address < CHIP8_MEMORY_SIZE; address++) {
+        chip8_condition_free(&chip->breakpoints->conditions[address]);
+    }
+    free(chip->breakpoints);
+    chip->breakpoints = NULL;
+}
+
+bool chip8_break_is_set(Chip8* chip, uint16_t address) {
+    return chip && chip->breakpoints && chip8_break_armed(chip->breakpoints, address);
+}
+
+const char* chip8_break_condition(Chip8* chip, uint16_t address) {
+    if (!chip8_break_is_set(chip, address)) return NULL;
+
+    const Chip8Condition* condition = chip->breakpoints->conditions[CHIP8_ADDR(address)];
+    return condition ? condition->source : NULL;
+}
+
+uint64_t chip8_break_hits(Chip8* chip, uint16_t address) {
+    if (!chip8_break_is_set(chip, address)) return 0;
+    return chip->breakpoints->hits[CHIP8_ADDR(address)];
+}
+
+int chip8_break_list(Chip8* chip, uint16_t* addresses, int max) {
+    if (!chip || !chip->breakpoints || !addresses) return 0;
+
+    int count = 0;
+    for (int word = 0; word < CHIP8_MEMORY_SIZE / 64 && count < max; word++) {
+        uint64_t bits = chip->breakpoints->armed[word];
+        while (bits && count < max) {
+            addresses[count++] = (uint16_t)(word * 64 + __builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+    return count;
+}
+
+bool chip8_break_at_pc(Chip8* chip) {
+    if (!chip || !chip->breakpoints || !chip8_break_armed(chip->breakpoints, chip->PC)) return false;
+
+    const Chip8Condition* condition = chip->breakpoints->conditions[CHIP8_ADDR(chip->PC)];
+    if (condition && !chip8_condition_eval(chip, condition)) return false;
+
+    chip8_break_note_resume(chip->breakpoints, chip); // the host stops here, a run goes on from it
+    return true;
+}
+
+bool chip8_break_take(Chip8* chip) {
+    if (!chip8_break_at_pc(chip)) return false;
+
+    chip->breakpoints->hits[CHIP8_ADDR(chip->PC)]++;
+    return true;
+}
+
+// RUN-TO TARGET
+
+bool chip8_break_set_target(Chip8* chip, uint16_t address, uint8_t max_sp) {
+    if (!chip) return false;
+
+    Chip8Breakpoints* breakpoints = chip8_break_get(chip);
+    if (!breakpoints) return false;
+
+    breakpoints->has_target = true;
+    breakpoints->target = (address == CHIP8_BREAK_ANY) ? CHIP8_BREAK_ANY : CHIP8_ADDR(address);
+    breakpoints->target_sp = max_sp;
+    chip8_break_note_resume(breakpoints, chip); // so the target may be the current address
+    chip8_break_update_guard(breakpoints);
+    return true;
+}
+
+void chip8_break_clear_target(Chip8* chip) {
+    if (!chip || !chip->breakpoints) return;
+
+    chip->breakpoints->has_target = false;
+    chip8_break_update_guard(chip->breakpoints);
+}
+
+bool chip8_break_has_target(Chip8* chip) {
+    return chip && chip->breakpoints && chip->breakpoints->has_target;
+}
+
+bool chip8_break_step_over(Chip8* chip) {
+    if (!chip || chip->halted) return false;
+
+    uint16_t opcode = chip8_read_opcode(chip, chip->PC);
+    if ((opcode & 0xF000) != 0x2000) return false;
+
+    // back from the call (and any recursion in it) with the stack as it is now
+    return chip8_break_set_target(chip, (uint16_t)(chip->PC + 2), chip->SP);
+}
+
+bool chip8_break_step_out(Chip8* chip) {
+    if (!chip || chip->halted || chip->SP == 0) return false;
+
+    return chip8_break_set_target(chip, CHIP8_BREAK_ANY, (uint8_t)(chip->SP - 1));
+}
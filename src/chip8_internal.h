@@ -0,0 +1,496 @@
+#ifndef CHIP8_INTERNAL_H
+#define CHIP8_INTERNAL_H
+
+/*
+    Core-private declarations shared between the translation units of the emulator core.
+    Not part of the public API; the UI and tools must only use chip8.h.
+*/
+
+#include "../include/chip8.h"
+#include "../include/chip8_trace.h"
+#include "../include/chip8_watch.h"
+
+// Guest addresses wrap at the end of memory
+#define CHIP8_ADDR(a) ((a) & (CHIP8_MEMORY_SIZE - 1))
+
+/*
+    CXNN generator: PCG32 (XSH RR output, fixed stream) stepped on caller-owned state.
+    Shared by the core and the lane interpreter so both draw the same sequence from a seed.
+*/
+#define CHIP8_DEFAULT_SEED 0x853C49E6748FEA9BULL
+
+static inline uint32_t chip8_rand_next(uint64_t* state) {
+    uint64_t old = *state;
+    *state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+// Generator state for a seed, as in the reference pcg32_srandom
+static inline uint64_t chip8_rand_seed(uint64_t seed) {
+    uint64_t state = 0;
+    chip8_rand_next(&state);
+    state += seed;
+    chip8_rand_next(&state);
+    return state;
+}
+
+/*
+    A sprite byte placed at column x of a packed display row. Pixels that run past the
+    right edge wrap around to the left, like the per-pixel % 64 of the original DXYN.
+*/
+static inline uint64_t chip8_sprite_row(uint8_t sprite_byte, uint8_t x) {
+    uint64_t bits = (uint64_t)sprite_byte << 56;
+    return (bits >> x) | (x ? bits << (64 - x) : 0);
+}
+
+/*
+    Records a diagnostic, see chip8_drain_diagnostics. Only touches the instance, so it is
+    safe on the execution path. The ring holds CHIP8_DIAG_BURST entries of every code,
+    so it cannot overflow.
+*/
+static inline void chip8_diag(Chip8* chip, Chip8DiagCode code, uint16_t pc, uint16_t opcode, uint64_t cycle) {
+    chip->diag_counts[code]++;
+    if (chip->diag_queued[code] >= CHIP8_DIAG_BURST) return;
+
+    uint8_t slot = (uint8_t)((chip->diag_head + chip->diag_used) % CHIP8_DIAG_RING_SIZE);
+    chip->diag_ring[slot] = (Chip8Diag){ cycle, pc, opcode, (uint8_t)code };
+    chip->diag_queued[code]++;
+    chip->diag_used++;
+}
+
+// INTERPRETER ENTRY POINTS (chip8.c)
+
+/*
+    Decodes and executes one raw opcode, including its effect on PC.
+    Does not touch cycle_count. Used by translated code for the complex opcodes.
+*/
+void chip8_exec_opcode(Chip8* chip, uint16_t opcode);
+
+/*
+    Runs up to n instructions through the switch interpreter and accounts them in cycle_count.
+    Returns the number of instructions executed.
+*/
+int chip8_interpret(Chip8* chip, int n);
+
+/*
+    Drops every cached decode and translated block after memory was replaced wholesale.
+*/
+void chip8_invalidate_all(Chip8* chip);
+
+/*
+    Overwrites all of memory and drops only the decoded and translated code whose bytes
+    changed, falling back to chip8_invalidate_all when most of memory did.
+*/
+void chip8_replace_memory(Chip8* chip, const uint8_t* memory);
+
+#define CHIP8_ALL_PAGES ((uint16_t)((1u << CHIP8_PAGE_COUNT) - 1))
+
+/*
+    chip8_replace_memory for one page: copies the bytes that differ and drops the decoded
+    and translated code covering them. Leaves dirty_pages alone.
+*/
+void chip8_replace_page(Chip8* chip, int page, const uint8_t* bytes);
+
+/*
+    If PC is at an idle loop (jump to itself, delay-timer poll, FX0A without a key), runs it
+    through the interpreter with a budget of n, which fast-forwards to the end of the budget,
+    and returns the instructions accounted. Returns 0 without doing anything anywhere else.
+    Translated code never fast-forwards, so backends call this before dispatching a block.
+*/
+int chip8_interpret_idle(Chip8* chip, int n);
+
+/*
+    Whether the instruction at address starts an idle loop. Such addresses are never
+    translated, so that chip8_interpret_idle gets to see them.
+*/
+bool chip8_is_idle_loop(Chip8* chip, uint16_t address);
+
+/*
+    Whether the instruction at address starts a superinstruction, which runs it and the
+    one or two after it in a single dispatch.
+*/
+bool chip8_is_fused(Chip8* chip, uint16_t address);
+
+// TRANSLATION CACHE / JIT (chip8_jit.c)
+
+// A translated block: runs all of its guest instructions and leaves PC at the next one
+typedef void (*Chip8JitFn)(Chip8* chip);
+
+/*
+    Whether this build can emit native code for the host at all.
+*/
+bool chip8_jit_supported(void);
+
+/*
+    Allocates the per-instance block table. Executable memory is only mapped on first translation.
+*/
+Chip8Jit* chip8_jit_create(void);
+
+void chip8_jit_destroy(Chip8Jit* jit);
+
+/*
+    Drops every block (ROM load, reset).
+*/
+void chip8_jit_flush(Chip8Jit* jit);
+
+/*
+    Registers an externally compiled block of length instructions at start.
+    Returns false if the block does not fit the table's limits.
+*/
+bool chip8_jit_install(Chip8Jit* jit, uint16_t start, uint8_t length, Chip8JitFn code);
+
+/*
+    Drops the blocks whose guest range covers address. Called on every guest write.
+*/
+void chip8_jit_invalidate(Chip8Jit* jit, uint16_t address);
+
+/*
+    Block dispatcher for chip8_step_n: runs blocks from the table and interprets the rest.
+    With translate set, addresses that get hot are compiled to native code first.
+*/
+int chip8_jit_run(Chip8* chip, int n, bool translate);
+
+// AHEAD-OF-TIME MODULES (chip8_aot.c)
+
+/*
+    Whether this build can load chip8aotc modules.
+*/
+bool chip8_aot_supported(void);
+
+/*
+    Installs the loaded module's blocks whose guest bytes still match memory.
+    Called after every flush of the translation cache.
+*/
+void chip8_aot_install(Chip8* chip);
+
+// MOVIE RECORDING (chip8_movie.c)
+// called by the core only while chip->movie is set
+
+/*
+    A key changed state; repeats are filtered by the caller.
+*/
+void chip8_movie_on_key(Chip8* chip, uint8_t key, bool down);
+
+/*
+    chip8_update_timers ran.
+*/
+void chip8_movie_on_tick(Chip8* chip);
+
+/*
+    The host replaced the state (reset, ROM, save state, seed); stores all of it.
+*/
+void chip8_movie_on_state(Chip8* chip);
+
+// INSTRUCTION TRACE (chip8_trace.c)
+// used by chip8_step and chip8_step_n only while chip->trace is set
+
+/*
+    Free space at the end of the current buffer, at least one record. Blocks while the
+    writer thread is a whole ring of buffers behind.
+*/
+Chip8TraceRecord* chip8_trace_span(Chip8Trace* trace, size_t* room);
+
+/*
+    Marks count records of the span as written; hands the buffer over once it is full.
+*/
+void chip8_trace_commit(Chip8Trace* trace, size_t count);
+
+// TRACE INDEX (chip8_trace_index.c)
+// built by the writer thread while recording, or by chip8_trace_open for a trace without one
+
+typedef struct Chip8TraceIndex Chip8TraceIndex;
+
+Chip8TraceIndex* chip8_trace_index_create(void);
+
+/*
+    Indexes the next count records of the trace. A failed allocation leaves the index
+    unusable rather than wrong.
+*/
+void chip8_trace_index_add(Chip8TraceIndex* index, const Chip8TraceRecord* records, size_t count);
+
+/*
+    Turns the added records into the lists queries use; no more can be added after.
+    returns false if the index is unusable.
+*/
+bool chip8_trace_index_finish(Chip8TraceIndex* index);
+
+bool chip8_trace_index_save(Chip8TraceIndex* index, const char* path);
+
+/*
+    returns NULL, quietly, if the file is missing or does not index exactly records records.
+*/
+Chip8TraceIndex* chip8_trace_index_load(const char* path, uint64_t records);
+
+void chip8_trace_index_destroy(Chip8TraceIndex** index_ptr);
+
+// Queries on a finished index over records, see chip8_trace_find_cycle and chip8_trace_find
+int64_t chip8_trace_index_find_cycle(const Chip8TraceIndex* index, const Chip8TraceRecord* records, uint64_t cycle);
+int64_t chip8_trace_index_find(const Chip8TraceIndex* index, const Chip8TraceRecord* records,
+                               Chip8TraceKey kind, uint16_t value, int64_t from, bool backward);
+
+// Registers an opcode writes, bit r for Vr; see chip8_trace_written_registers
+static inline uint16_t chip8_trace_written(uint16_t opcode) {
+    uint16_t vx = (uint16_t)(1u << ((opcode >> 8) & 0xF));
+    uint16_t vf = (uint16_t)(1u << 0xF);
+    switch (opcode >> 12) {
+        case 0x6: case 0x7: case 0xC:
+            return vx;
+        case 0x8:
+            switch (opcode & 0xF) {
+                case 0x0:                               return vx;
+                case 0x1: case 0x2: case 0x3:           return vx | vf; // VF reset quirk
+                case 0x4: case 0x5: case 0x6: case 0x7:
+                case 0xE:                               return vx | vf; // carry, borrow or shifted bit
+                default:                                return 0;
+            }
+        case 0xD:
+            return vf;
+        case 0xF:
+            switch (opcode & 0xFF) {
+                case 0x07: case 0x0A: return vx;
+                case 0x65:            return (uint16_t)((vx << 1) - 1); // V0 through VX
+                default:              return 0;
+            }
+        default:
+            return 0;
+    }
+}
+
+// Register a record carries: VX if written, else VF; see chip8_trace_changed_register
+static inline int chip8_trace_register(uint16_t opcode) {
+    uint16_t written = chip8_trace_written(opcode);
+    int x = (opcode >> 8) & 0xF;
+    if (written & (1u << x)) return x;
+    return (written & (1u << 0xF)) ? 0xF : -1;
+}
+
+static inline void chip8_trace_fill(Chip8* chip, Chip8TraceRecord* record) {
+    int reg = chip8_trace_register(record->opcode);
+    record->i = chip->I;
+    record->value = (reg >= 0) ? chip->V[reg] : 0;
+}
+
+// PROFILE (chip8_profile.c)
+// counted by chip8_step and chip8_step_n only while chip->profile is set
+
+#define CHIP8_CALL_NODES 4096
+#define CHIP8_CALL_NONE  0xFFFF
+
+/*
+    One node per distinct call path. Node 0 is the top level; the others are created
+    on the first CALL along their path and never move, so a parent always comes before
+    its children.
+*/
+typedef struct {
+    uint64_t self;    // cycles run on this path, callees excluded
+    uint64_t calls;   // times the path was entered
+    uint16_t entry;   // routine address, CHIP8_PROFILE_TOP_LEVEL for node 0
+    uint16_t parent;
+    uint16_t child;   // first callee, CHIP8_CALL_NONE if none
+    uint16_t sibling; // next callee of the same parent
+} Chip8CallNode;
+
+struct Chip8Profile {
+    uint64_t executions[CHIP8_MEMORY_SIZE];
+    uint64_t reads[CHIP8_MEMORY_SIZE];
+    uint64_t writes[CHIP8_MEMORY_SIZE];
+
+    // shadow call stack, as a path in the call tree
+    Chip8CallNode nodes[CHIP8_CALL_NODES];
+    uint16_t node_count;
+    uint16_t current;   // routine running now
+    uint8_t lost_depth; // calls made while the tree was full; their cycles stay with the caller
+};
+
+/*
+    CALL to entry and RET, about to run with room on the guest stack.
+*/
+void chip8_profile_call(Chip8Profile* profile, uint16_t entry);
+void chip8_profile_return(Chip8Profile* profile);
+
+/*
+    The host replaced the state; the guest stack no longer matches the shadow one, so
+    it starts over at the top level.
+*/
+void chip8_profile_on_state(Chip8* chip);
+
+// BREAKPOINTS (chip8_break.c)
+// checked by chip8_run_until only while chip->breakpoints is set
+
+#define CHIP8_CONDITION_CODE  64 // ops in a compiled condition
+#define CHIP8_CONDITION_STACK 16 // values it may keep on the stack at once
+
+/*
+    A condition compiled to postfix code for a small stack machine; see
+    chip8_condition_eval for the ops.
+*/
+typedef struct {
+    uint8_t op;
+    uint16_t arg;
+} Chip8ConditionOp;
+
+typedef struct {
+    char* source; // as the host wrote it
+    uint8_t length;
+    Chip8ConditionOp code[CHIP8_CONDITION_CODE];
+} Chip8Condition;
+
+// longest run of consecutive slots one dispatch can go through (superinstructions, idle loops)
+#define CHIP8_BREAK_SPAN 3
+
+struct Chip8Breakpoints {
+    uint64_t armed[CHIP8_MEMORY_SIZE / 64]; // one bit per address
+    uint64_t guard[CHIP8_MEMORY_SIZE / 64]; // bit set if a breakpoint or the target is within CHIP8_BREAK_SPAN slots
+    uint16_t count;
+    Chip8Condition* conditions[CHIP8_MEMORY_SIZE]; // NULL for a breakpoint without one
+    uint64_t hits[CHIP8_MEMORY_SIZE];
+
+    // run-to target, stopped at once reached
+    bool has_target;
+    uint16_t target;    // address, or CHIP8_BREAK_ANY
+    uint8_t target_sp;  // only reached with SP at most this deep
+
+    // where the last run stopped (or the target was set): a run starting there, with
+    // nothing run in between, lets that instruction go first instead of stopping again
+    bool has_resume;
+    uint16_t resume_pc;
+    uint64_t resume_cycle;
+};
+
+static inline void chip8_break_note_resume(Chip8Breakpoints* breakpoints, const Chip8* chip) {
+    breakpoints->has_resume = true;
+    breakpoints->resume_pc = CHIP8_ADDR(chip->PC);
+    breakpoints->resume_cycle = chip->cycle_count;
+}
+
+static inline bool chip8_break_resuming(const Chip8Breakpoints* breakpoints, const Chip8* chip) {
+    return breakpoints && breakpoints->has_resume && breakpoints->resume_pc == CHIP8_ADDR(chip->PC) &&
+           breakpoints->resume_cycle == chip->cycle_count;
+}
+
+static inline bool chip8_break_armed(const Chip8Breakpoints* breakpoints, uint16_t address) {
+    address = CHIP8_ADDR(address);
+    return (breakpoints->armed[address >> 6] >> (address & 63)) & 1;
+}
+
+static inline bool chip8_break_guarded(const Chip8Breakpoints* breakpoints, uint16_t address) {
+    address = CHIP8_ADDR(address);
+    return (breakpoints->guard[address >> 6] >> (address & 63)) & 1;
+}
+
+bool chip8_condition_eval(Chip8* chip, const Chip8Condition* condition);
+
+/*
+    Whether the armed breakpoint at PC stops chip8_run_until: its condition holds, or
+    it has none. Counts the hit if so.
+*/
+bool chip8_break_take(Chip8* chip);
+
+// WATCHPOINTS (chip8_watch.c)
+// the guest's loads and stores test chip->watch_*_pages, and only call in here on a set bit
+
+struct Chip8Watches {
+    Chip8MemoryWatch memory[CHIP8_WATCH_MAX];
+    uint8_t memory_count;
+
+    uint32_t registers; // one bit per Chip8WatchRegister
+    uint16_t shadow[CHIP8_WATCH_REGISTER_COUNT]; // values at the last check
+    uint64_t register_hits[CHIP8_WATCH_REGISTER_COUNT];
+
+    // first hit since chip8_watch_begin; its cycle is filled in by chip8_run_until
+    bool pending;
+    Chip8WatchHit hit;
+};
+
+/*
+    A guest load of count bytes from start touched a page with a read watch.
+*/
+void chip8_watch_read(Chip8* chip, uint16_t start, uint8_t count);
+
+/*
+    A guest store of byte over old at address touched a page with a write watch.
+*/
+void chip8_watch_write(Chip8* chip, uint16_t address, uint8_t old, uint8_t byte);
+
+/*
+    Takes the register shadows and drops the pending hit; chip8_run_until calls it
+    before running.
+*/
+void chip8_watch_begin(Chip8* chip);
+
+/*
+    Records a hit for the first watched register that differs from its shadow, and
+    takes the shadows again. returns whether one did.
+*/
+bool chip8_watch_check_registers(Chip8* chip, uint16_t pc);
+
+static inline bool chip8_watch_armed(const Chip8Watches* watches) {
+    return watches && (watches->memory_count > 0 || watches->registers);
+}
+
+// SAMPLER (chip8_sampler.c)
+
+/*
+    Folds the samples the signal handler queued into the report. Called by chip8_step_n
+    on the thread being sampled, only while chip->sampler is set.
+*/
+void chip8_sampler_poll(Chip8* chip);
+
+// UNDO LOG (chip8_undo.c)
+// used by chip8_step only while chip->undo is set
+
+/*
+    What an instruction may overwrite, captured before it runs. The display and memory
+    are only captured for the opcodes that write them (00E0, DXYN, FX33, FX55).
+*/
+typedef struct {
+    uint16_t PC;
+    uint16_t I;
+    uint8_t SP;
+    uint8_t delay_timer;
+    uint8_t sound_timer;
+    uint8_t flags; // bit 0 halted, bit 1 draw_flag
+    uint16_t V[CHIP8_NUM_REGISTERS];
+    uint16_t stack[CHIP8_STACK_SIZE];
+    uint64_t rand_state;
+    uint64_t idle_cycles;
+
+    bool has_display;
+    uint64_t display[CHIP8_DISPLAY_HEIGHT];
+
+    uint8_t memory_count;
+    uint16_t memory_address;
+    uint8_t memory[CHIP8_NUM_REGISTERS];
+} Chip8UndoMark;
+
+void chip8_undo_begin(Chip8* chip, Chip8UndoMark* mark);
+
+/*
+    Appends the record of what changed since chip8_undo_begin.
+*/
+void chip8_undo_end(Chip8* chip, const Chip8UndoMark* mark);
+
+/*
+    Forgets the log; steps taken before the host replaced the state cannot be undone.
+*/
+void chip8_undo_clear(Chip8* chip);
+
+/*
+    Called wherever the host replaces the machine state as a whole (reset, ROM load,
+    save states, snapshots, lanes, seed).
+*/
+static inline void chip8_state_replaced(Chip8* chip) {
+    if (chip->undo) chip8_undo_clear(chip);
+    if (chip->movie) chip8_movie_on_state(chip);
+    if (chip->profile) chip8_profile_on_state(chip);
+    if (chip->breakpoints) {
+        // both belonged to the old state
+        chip->breakpoints->has_target = false;
+        chip->breakpoints->has_resume = false;
+    }
+}
+
+#endif
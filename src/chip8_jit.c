@@ -0,0 +1,567 @@
+// mmap/MAP_ANONYMOUS are hidden under -std=c11
+#define _DEFAULT_SOURCE
+#define _DARWIN_C_SOURCE
+
+#include "../include/chip8.h"
+#include "chip8_internal.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Translation cache and basic-block JIT.
+
+    A block is a run of instructions starting at an even address and ending at the first
+    instruction that can change control flow (1NNN, 2NNN, 00EE, BNNN, skips, FX0A), at a
+    guest store (FX33, FX55, which may rewrite the block itself), or after
+    CHIP8_JIT_MAX_BLOCK instructions. Addresses are interpreted until they have been entered
+    CHIP8_JIT_HOT_THRESHOLD times, then translated into x86-64 code in an mmap'd cache.
+
+    Register moves, ALU ops, I/timer ops and branches are emitted inline; the rest (DXYN,
+    00E0, CXNN, FX65, FX33, FX55, calls, key ops) call back into chip8_exec_opcode so the
+    interpreter stays the single source of truth for them.
+
+    Guest registers are uint16_t in Chip8, so all register arithmetic is emitted 16-bit wide
+    to stay bit-identical with the interpreter.
+
+    The block table, invalidation and dispatch loop are portable: ahead-of-time modules
+    (chip8_aot.c) install their precompiled blocks here as well, and hosts without an
+    emitter simply interpret whatever has not been installed.
+*/
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__))
+#define CHIP8_HAVE_JIT 1
+#include <sys/mman.h>
+#else
+#define CHIP8_HAVE_JIT 0
+#endif
+
+#define CHIP8_JIT_CACHE_SIZE    (512 * 1024)
+#define CHIP8_JIT_MAX_BLOCK     64
+#define CHIP8_JIT_HOT_THRESHOLD 16
+#define CHIP8_JIT_MAX_INSN_SIZE 64 // upper bound of bytes emitted per guest instruction
+
+typedef struct {
+    Chip8JitFn code;  // NULL if no block starts here
+    uint8_t length;   // guest instructions in the block
+    bool native;      // emitted into the code cache (as opposed to installed from an AOT module)
+} Chip8JitBlock;
+
+struct Chip8Jit {
+    uint8_t* cache;   // mapped on first translation
+    size_t cache_used;
+    bool cache_failed;
+
+    Chip8JitBlock blocks[CHIP8_DECODE_SIZE]; // indexed by start address / 2
+    uint8_t heat[CHIP8_DECODE_SIZE];         // entries while still interpreted
+    uint8_t cover[CHIP8_DECODE_SIZE];        // how many blocks contain each instruction slot
+};
+
+static void chip8_jit_drop(Chip8Jit* jit, uint16_t slot);
+
+#if CHIP8_HAVE_JIT
+
+// === x86-64 emitter ===
+// The translated function keeps the Chip8* in rbx and addresses fields as [rbx + disp32].
+
+enum { RAX = 0, RCX = 1, RDX = 2 };
+
+typedef struct {
+    uint8_t* p;
+} Emitter;
+
+static void emit8(Emitter* e, uint8_t b) { *e->p++ = b; }
+
+static void emit16(Emitter* e, uint16_t v) {
+    memcpy(e->p, &v, 2);
+    e->p += 2;
+}
+
+static void emit32(Emitter* e, uint32_t v) {
+    memcpy(e->p, &v, 4);
+    e->p += 4;
+}
+
+static void emit64(Emitter* e, uint64_t v) {
+    memcpy(e->p, &v, 8);
+    e->p += 8;
+}
+
+// ModRM for [rbx + disp32] with the given reg field
+static void emit_mem(Emitter* e, uint8_t reg, uint32_t disp) {
+    emit8(e, 0x80 | (reg << 3) | 0x03);
+    emit32(e, disp);
+}
+
+static uint32_t off_v(uint8_t reg) { return (uint32_t)(offsetof(Chip8, V) + reg * sizeof(uint16_t)); }
+
+#define OFF_PC    ((uint32_t)offsetof(Chip8, PC))
+#define OFF_I     ((uint32_t)offsetof(Chip8, I))
+#define OFF_DELAY ((uint32_t)offsetof(Chip8, delay_timer))
+#define OFF_SOUND ((uint32_t)offsetof(Chip8, sound_timer))
+
+// movzx r32, word [rbx + disp]
+static void emit_load16(Emitter* e, uint8_t reg, uint32_t disp) {
+    emit8(e, 0x0F); emit8(e, 0xB7); emit_mem(e, reg, disp);
+}
+
+// movzx r32, byte [rbx + disp]
+static void emit_load8(Emitter* e, uint8_t reg, uint32_t disp) {
+    emit8(e, 0x0F); emit8(e, 0xB6); emit_mem(e, reg, disp);
+}
+
+// mov word [rbx + disp], r16
+static void emit_store16(Emitter* e, uint8_t reg, uint32_t disp) {
+    emit8(e, 0x66); emit8(e, 0x89); emit_mem(e, reg, disp);
+}
+
+// mov byte [rbx + disp], r8
+static void emit_store8(Emitter* e, uint8_t reg, uint32_t disp) {
+    emit8(e, 0x88); emit_mem(e, reg, disp);
+}
+
+// mov word [rbx + disp], imm16
+static void emit_store16_imm(Emitter* e, uint32_t disp, uint16_t imm) {
+    emit8(e, 0x66); emit8(e, 0xC7); emit_mem(e, 0, disp); emit16(e, imm);
+}
+
+// <op> word [rbx + disp], ax  (op: 0x01 add, 0x09 or, 0x21 and, 0x31 xor)
+static void emit_alu16_mem_ax(Emitter* e, uint8_t op, uint32_t disp) {
+    emit8(e, 0x66); emit8(e, op); emit_mem(e, RAX, disp);
+}
+
+// cmp ax, word [rbx + disp]
+static void emit_cmp16_ax_mem(Emitter* e, uint32_t disp) {
+    emit8(e, 0x66); emit8(e, 0x3B); emit_mem(e, RAX, disp);
+}
+
+// setcc dl; movzx edx, dl; mov word [rbx + disp], dx
+static void emit_flag_store(Emitter* e, uint8_t setcc, uint32_t disp) {
+    emit8(e, 0x0F); emit8(e, setcc); emit8(e, 0xC2);
+    emit8(e, 0x0F); emit8(e, 0xB6); emit8(e, 0xD2);
+    emit_store16(e, RDX, disp);
+}
+
+// mov ecx, pc + 2; mov edx, pc + 4; <flags already set>; cmovcc ecx, edx; mov [PC], cx
+static void emit_skip_tail(Emitter* e, uint8_t cmovcc) {
+    emit8(e, 0x0F); emit8(e, cmovcc); emit8(e, 0xCA);
+    emit_store16(e, RCX, OFF_PC);
+}
+
+static void emit_skip_head(Emitter* e, uint16_t pc) {
+    emit8(e, 0xB9); emit32(e, (uint16_t)(pc + 2));
+    emit8(e, 0xBA); emit32(e, (uint16_t)(pc + 4));
+}
+
+// mov word [PC], pc; mov rdi, rbx; mov esi, opcode; mov rax, chip8_exec_opcode; call rax
+static void emit_helper(Emitter* e, uint16_t pc, uint16_t opcode) {
+    emit_store16_imm(e, OFF_PC, pc);
+    emit8(e, 0x48); emit8(e, 0x89); emit8(e, 0xDF);
+    emit8(e, 0xBE); emit32(e, opcode);
+    emit8(e, 0x48); emit8(e, 0xB8); emit64(e, (uint64_t)(uintptr_t)&chip8_exec_opcode);
+    emit8(e, 0xFF); emit8(e, 0xD0);
+}
+
+/*
+    Emits one guest instruction. Returns true if it ends the block.
+*/
+static bool emit_instruction(Emitter* e, uint16_t pc, uint16_t opcode) {
+    uint8_t x = (opcode & 0x0F00) >> 8;
+    uint8_t y = (opcode & 0x00F0) >> 4;
+    uint8_t n = (opcode & 0x000F);
+    uint8_t nn = (opcode & 0x00FF);
+    uint16_t nnn = (opcode & 0x0FFF);
+
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            // CLS, SYS: no control flow; RET: can halt and jumps
+            emit_helper(e, pc, opcode);
+            return nn == 0xEE;
+
+        case 0x1000:
+            emit_store16_imm(e, OFF_PC, nnn);
+            return true;
+
+        case 0x2000:
+            emit_helper(e, pc, opcode);
+            return true;
+
+        case 0x3000:
+        case 0x4000:
+            emit_skip_head(e, pc);
+            emit8(e, 0x66); emit8(e, 0x81); emit_mem(e, 7, off_v(x)); emit16(e, nn); // cmp word [Vx], nn
+            emit_skip_tail(e, (opcode & 0xF000) == 0x3000 ? 0x44 : 0x45);           // cmove / cmovne
+            return true;
+
+        case 0x5000:
+        case 0x9000:
+            if (n != 0) {
+                emit_helper(e, pc, opcode); // unassigned, the interpreter records it
+                return false;
+            }
+            emit_skip_head(e, pc);
+            emit_load16(e, RAX, off_v(x));
+            emit_cmp16_ax_mem(e, off_v(y));
+            emit_skip_tail(e, (opcode & 0xF000) == 0x5000 ? 0x44 : 0x45);
+            return true;
+
+        case 0x6000:
+            emit_store16_imm(e, off_v(x), nn);
+            return false;
+
+        case 0x7000:
+            emit8(e, 0x66); emit8(e, 0x81); emit_mem(e, 0, off_v(x)); emit16(e, nn); // add word [Vx], nn
+            return false;
+
+        case 0x8000:
+            switch (n) {
+                case 0x0:
+                    emit_load16(e, RAX, off_v(y));
+                    emit_store16(e, RAX, off_v(x));
+                    return false;
+
+                case 0x1:
+                case 0x2:
+                case 0x3:
+                    emit_load16(e, RAX, off_v(y));
+                    emit_alu16_mem_ax(e, n == 0x1 ? 0x09 : (n == 0x2 ? 0x21 : 0x31), off_v(x));
+                    emit_store16_imm(e, off_v(0xF), 0);
+                    return false;
+
+                case 0x4:
+                    // sum is uint16_t in the interpreter: 16-bit add, VF = sum > 0xFF, VX = sum & 0xFF
+                    emit_load16(e, RAX, off_v(x));
+                    emit_load16(e, RCX, off_v(y));
+                    emit8(e, 0x66); emit8(e, 0x01); emit8(e, 0xC8);             // add ax, cx
+                    emit8(e, 0x66); emit8(e, 0x3D); emit16(e, 0x00FF);          // cmp ax, 0xFF
+                    emit_flag_store(e, 0x97, off_v(0xF));                       // seta
+                    emit8(e, 0x0F); emit8(e, 0xB6); emit8(e, 0xC0);             // movzx eax, al
+                    emit_store16(e, RAX, off_v(x));
+                    return false;
+
+                case 0x5:
+                case 0x7: {
+                    // VF is written before the subtraction re-reads its operands, like the interpreter
+                    uint8_t a = (n == 0x5) ? x : y;
+                    uint8_t b = (n == 0x5) ? y : x;
+                    emit_load16(e, RAX, off_v(a));
+                    emit_cmp16_ax_mem(e, off_v(b));
+                    emit_flag_store(e, 0x93, off_v(0xF));                       // setae
+                    emit_load16(e, RAX, off_v(a));
+                    emit_load16(e, RCX, off_v(b));
+                    emit8(e, 0x29); emit8(e, 0xC8);                             // sub eax, ecx
+                    emit_store16(e, RAX, off_v(x));
+                    return false;
+                }
+
+                case 0x6:
+                    emit_load16(e, RAX, off_v(y));
+                    emit8(e, 0x83); emit8(e, 0xE0); emit8(e, 0x01);             // and eax, 1
+                    emit_store16(e, RAX, off_v(0xF));
+                    emit_load16(e, RAX, off_v(y));
+                    emit8(e, 0xD1); emit8(e, 0xE8);                             // shr eax, 1
+                    emit_store16(e, RAX, off_v(x));
+                    return false;
+
+                case 0xE:
+                    emit_load16(e, RAX, off_v(y));
+                    emit8(e, 0x25); emit32(e, 0x80);                            // and eax, 0x80
+                    emit8(e, 0xC1); emit8(e, 0xE8); emit8(e, 0x07);             // shr eax, 7
+                    emit_store16(e, RAX, off_v(0xF));
+                    emit_load16(e, RAX, off_v(y));
+                    emit8(e, 0xD1); emit8(e, 0xE0);                             // shl eax, 1
+                    emit_store16(e, RAX, off_v(x));
+                    return false;
+            }
+            emit_helper(e, pc, opcode); // unassigned 8XYn, the interpreter records it
+            return false;
+
+        case 0xA000:
+            emit_store16_imm(e, OFF_I, nnn);
+            return false;
+
+        case 0xB000:
+            emit_load16(e, RAX, off_v(0));
+            emit8(e, 0x05); emit32(e, nnn);                                     // add eax, nnn
+            emit_store16(e, RAX, OFF_PC);
+            return true;
+
+        case 0xC000:
+        case 0xD000:
+            emit_helper(e, pc, opcode);
+            return false;
+
+        case 0xE000:
+            emit_helper(e, pc, opcode);
+            return nn == 0x9E || nn == 0xA1; // unassigned EXnn only gets recorded
+
+        case 0xF000:
+            switch (nn) {
+                case 0x07:
+                    emit_load8(e, RAX, OFF_DELAY);
+                    emit_store16(e, RAX, off_v(x));
+                    return false;
+
+                case 0x15:
+                case 0x18:
+                    emit_load16(e, RAX, off_v(x));
+                    emit_store8(e, RAX, nn == 0x15 ? OFF_DELAY : OFF_SOUND);
+                    return false;
+
+                case 0x1E:
+                    emit_load16(e, RAX, off_v(x));
+                    emit_alu16_mem_ax(e, 0x01, OFF_I);
+                    return false;
+
+                case 0x29:
+                    emit_load16(e, RAX, off_v(x));
+                    emit8(e, 0x83); emit8(e, 0xE0); emit8(e, 0x0F);             // and eax, 0xF
+                    emit8(e, 0x8D); emit8(e, 0x04); emit8(e, 0x80);             // lea eax, [rax + rax*4]
+                    emit_store16(e, RAX, OFF_I);
+                    return false;
+
+                case 0x65:
+                    emit_helper(e, pc, opcode);
+                    return false;
+
+                case 0x0A: // may leave PC in place
+                case 0x33: // stores may hit this very block
+                case 0x55:
+                    emit_helper(e, pc, opcode);
+                    return true;
+            }
+            emit_helper(e, pc, opcode); // unassigned FXnn, the interpreter records it
+            return false;
+    }
+
+    return false;
+}
+
+// === Native translation ===
+
+static bool chip8_jit_map_cache(Chip8Jit* jit) {
+    if (jit->cache) return true;
+    if (jit->cache_failed) return false;
+
+    void* cache = mmap(NULL, CHIP8_JIT_CACHE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (cache == MAP_FAILED) {
+        fprintf(stderr, "ERROR: Failed to map executable memory for the JIT, interpreting instead\n");
+        jit->cache_failed = true;
+        return false;
+    }
+
+    jit->cache = cache;
+    return true;
+}
+
+static void chip8_jit_unmap_cache(Chip8Jit* jit) {
+    if (jit->cache) {
+        munmap(jit->cache, CHIP8_JIT_CACHE_SIZE);
+    }
+}
+
+/*
+    Drops every native block and rewinds the code cache. Installed AOT blocks stay.
+*/
+static void chip8_jit_reset_cache(Chip8Jit* jit) {
+    for (uint16_t s = 0; s < CHIP8_DECODE_SIZE; s++) {
+        if (jit->blocks[s].code && jit->blocks[s].native) {
+            chip8_jit_drop(jit, s);
+        }
+    }
+    jit->cache_used = 0;
+}
+
+static Chip8JitBlock* chip8_jit_compile(Chip8* chip, Chip8Jit* jit, uint16_t start) {
+    if (!chip8_jit_map_cache(jit)) return NULL;
+
+    size_t worst = 16 + (size_t)CHIP8_JIT_MAX_BLOCK * CHIP8_JIT_MAX_INSN_SIZE;
+    if (jit->cache_used + worst > CHIP8_JIT_CACHE_SIZE) {
+        chip8_jit_reset_cache(jit);
+    }
+
+    uint8_t* entry = jit->cache + jit->cache_used;
+    Emitter e = { entry };
+
+    emit8(&e, 0x53);                                  // push rbx
+    emit8(&e, 0x48); emit8(&e, 0x89); emit8(&e, 0xFB); // mov rbx, rdi
+
+    uint16_t pc = start;
+    uint8_t length = 0;
+    bool ended = false;
+    while (!ended && length < CHIP8_JIT_MAX_BLOCK && pc < CHIP8_MEMORY_SIZE) {
+        uint16_t opcode = (chip->memory[pc] << 8) | chip->memory[pc + 1];
+        ended = emit_instruction(&e, pc, opcode);
+        pc += 2;
+        length++;
+    }
+
+    if (!ended) {
+        emit_store16_imm(&e, OFF_PC, pc); // fell off the end of the block
+    }
+
+    emit8(&e, 0x5B); // pop rbx
+    emit8(&e, 0xC3); // ret
+
+    jit->cache_used += (size_t)(e.p - entry);
+
+    chip8_jit_install(jit, start, length, (Chip8JitFn)(void*)entry);
+    Chip8JitBlock* block = &jit->blocks[start >> 1];
+    block->native = true;
+    return block;
+}
+
+bool chip8_jit_supported(void) {
+    return true;
+}
+
+#else
+
+static Chip8JitBlock* chip8_jit_compile(Chip8* chip, Chip8Jit* jit, uint16_t start) {
+    (void)chip;
+    (void)jit;
+    (void)start;
+    return NULL;
+}
+
+static void chip8_jit_unmap_cache(Chip8Jit* jit) {
+    (void)jit;
+}
+
+bool chip8_jit_supported(void) {
+    return false;
+}
+
+#endif
+
+// === Block management ===
+
+static void chip8_jit_drop(Chip8Jit* jit, uint16_t slot) {
+    Chip8JitBlock* block = &jit->blocks[slot];
+    for (uint16_t s = slot; s < slot + block->length; s++) {
+        jit->cover[s]--;
+    }
+    block->code = NULL;
+    block->length = 0;
+    block->native = false;
+    jit->heat[slot] = 0;
+}
+
+Chip8Jit* chip8_jit_create(void) {
+    Chip8Jit* jit = calloc(1, sizeof(Chip8Jit));
+    if (!jit) {
+        fprintf(stderr, "ERROR: Failed to allocate translation cache\n");
+        return NULL;
+    }
+    return jit;
+}
+
+void chip8_jit_destroy(Chip8Jit* jit) {
+    if (!jit) return;
+
+    chip8_jit_unmap_cache(jit);
+    free(jit);
+}
+
+void chip8_jit_flush(Chip8Jit* jit) {
+    if (!jit) return;
+
+    memset(jit->blocks, 0, sizeof(jit->blocks));
+    memset(jit->heat, 0, sizeof(jit->heat));
+    memset(jit->cover, 0, sizeof(jit->cover));
+    jit->cache_used = 0;
+}
+
+bool chip8_jit_install(Chip8Jit* jit, uint16_t start, uint8_t length, Chip8JitFn code) {
+    if (!jit || !code || (start & 1) || length == 0 || length > CHIP8_JIT_MAX_BLOCK ||
+        start + length * 2 > CHIP8_MEMORY_SIZE) {
+        return false;
+    }
+
+    uint16_t slot = start >> 1;
+    if (jit->blocks[slot].code) {
+        chip8_jit_drop(jit, slot);
+    }
+
+    for (uint16_t s = slot; s < slot + length; s++) {
+        jit->cover[s]++;
+    }
+
+    Chip8JitBlock* block = &jit->blocks[slot];
+    block->code = code;
+    block->length = length;
+    block->native = false;
+    return true;
+}
+
+void chip8_jit_invalidate(Chip8Jit* jit, uint16_t address) {
+    uint16_t slot = CHIP8_ADDR(address) >> 1;
+    if (!jit->cover[slot]) return;
+
+    // only blocks starting up to CHIP8_JIT_MAX_BLOCK slots back can reach this one
+    int first = slot - (CHIP8_JIT_MAX_BLOCK - 1);
+    if (first < 0) first = 0;
+
+    for (int s = first; s <= slot && jit->cover[slot]; s++) {
+        Chip8JitBlock* block = &jit->blocks[s];
+        if (block->code && s + block->length > slot) {
+            chip8_jit_drop(jit, (uint16_t)s);
+        }
+    }
+}
+
+int chip8_jit_run(Chip8* chip, int n, bool translate) {
+    Chip8Jit* jit = chip->jit;
+    int executed = 0;
+
+    while (executed < n && !chip->halted) {
+        uint16_t pc = chip->PC;
+        if ((pc & 1) || pc >= CHIP8_MEMORY_SIZE) {
+            executed += chip8_interpret(chip, 1);
+            continue;
+        }
+
+        uint16_t slot = pc >> 1;
+        Chip8JitBlock* block = &jit->blocks[slot];
+        if (!block->code) {
+            // idle loops stay untranslated so the interpreter can fast-forward them
+            int idle = chip8_interpret_idle(chip, n - executed);
+            if (idle > 0) {
+                executed += idle;
+                continue;
+            }
+
+            if (!translate || ++jit->heat[slot] < CHIP8_JIT_HOT_THRESHOLD) {
+                executed += chip8_interpret(chip, 1);
+                continue;
+            }
+
+            chip->phase = CHIP8_PHASE_COMPILE;
+            block = chip8_jit_compile(chip, jit, pc);
+            chip->phase = CHIP8_PHASE_INTERPRET;
+            if (!block) {
+                jit->heat[slot] = 0;
+                executed += chip8_interpret(chip, 1);
+                continue;
+            }
+        }
+
+        // a block always runs to its end, so it has to fit in the remaining budget
+        uint8_t length = block->length;
+        if (length > n - executed) {
+            executed += chip8_interpret(chip, 1);
+            continue;
+        }
+
+        // read length first: a store at the end of the block may drop it while it runs
+        chip->phase = CHIP8_PHASE_TRANSLATED;
+        block->code(chip);
+        chip->phase = CHIP8_PHASE_INTERPRET;
+        chip->cycle_count += length;
+        executed += length;
+    }
+
+    return executed;
+}
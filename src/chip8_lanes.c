@@ -0,0 +1,617 @@
+#include "../include/chip8_lanes.h"
+#include "chip8_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Registers, I, PC, SP, timers and keys are GNU C vectors with one 16-bit element per
+    lane, so an instruction that only touches them is a handful of vector operations on
+    all lanes at once; lanes outside the dispatch keep their old values through a select
+    with the dispatch mask. Instructions that touch memory, the display, the stack or the
+    RNG run per lane on the scalar state below the vectors.
+
+    Every instruction reproduces the matching handler in chip8.c, including the order in
+    which VF and VX are written and the 16-bit V registers.
+*/
+
+#if !defined(__GNUC__) && !defined(__clang__)
+#error "chip8_lanes.c needs GNU C vector extensions"
+#endif
+
+#define LANES CHIP8_LANES_MAX
+
+typedef uint16_t Chip8LaneVec  __attribute__((vector_size(LANES * sizeof(uint16_t))));
+typedef int16_t  Chip8LaneMask __attribute__((vector_size(LANES * sizeof(int16_t)))); // 0 or -1 per lane
+
+struct Chip8Lanes {
+    Chip8LaneVec V[CHIP8_NUM_REGISTERS];
+    Chip8LaneVec PC;
+    Chip8LaneVec I;
+    Chip8LaneVec SP;
+    Chip8LaneVec delay_timer;
+    Chip8LaneVec sound_timer;
+    Chip8LaneVec keys;   // bit k set while key k is held
+    Chip8LaneMask halted;
+    Chip8LaneMask live;  // lanes below count
+
+    int count;
+    uint32_t unique;     // lanes whose memory may differ from lane 0
+    uint64_t rand_seed[LANES];
+    uint64_t rand_state[LANES];
+    uint64_t cycle_count[LANES];
+    uint16_t stack[CHIP8_STACK_SIZE][LANES];
+    bool draw_flag[LANES];
+    Chip8Diag halt_diag[LANES]; // why a lane halted, handed to its Chip8 by chip8_lanes_store
+    uint32_t halt_pending;      // lanes with a halt_diag not handed over yet
+
+    uint8_t memory[LANES][CHIP8_MEMORY_SIZE];
+    uint64_t display[LANES][CHIP8_DISPLAY_HEIGHT];
+};
+
+// Runs body only for the lanes in mask
+#define LANE_EACH(mask, l) for (int l = 0; l < LANES; l++) if ((mask) & (1u << l))
+
+static bool chip8_lanes_valid(Chip8Lanes* lanes, int lane) {
+    return lanes && lane >= 0 && lane < lanes->count;
+}
+
+// === Vector helpers ===
+
+static inline Chip8LaneVec chip8_lanes_splat(uint16_t value) {
+    Chip8LaneVec v = {0};
+    return v + value;
+}
+
+// on ? a : b, per lane
+static inline Chip8LaneVec chip8_lanes_select(Chip8LaneMask on, Chip8LaneVec a, Chip8LaneVec b) {
+    Chip8LaneVec m = (Chip8LaneVec)on;
+    return (a & m) | (b & ~m);
+}
+
+// 1 where the mask is set, 0 elsewhere
+static inline Chip8LaneVec chip8_lanes_bool(Chip8LaneMask m) {
+    return (Chip8LaneVec)m & 1;
+}
+
+static inline bool chip8_lanes_any(Chip8LaneMask m) {
+    uint64_t words[sizeof(m) / sizeof(uint64_t)];
+    memcpy(words, &m, sizeof(m));
+
+    uint64_t any = 0;
+    for (size_t i = 0; i < sizeof(m) / sizeof(uint64_t); i++) any |= words[i];
+    return any != 0;
+}
+
+static inline uint32_t chip8_lanes_bits(Chip8LaneMask m) {
+    uint32_t bits = 0;
+    for (int l = 0; l < LANES; l++) bits |= (uint32_t)(m[l] & 1) << l;
+    return bits;
+}
+
+static inline uint16_t chip8_lanes_min(Chip8LaneVec v) {
+    uint16_t min = v[0];
+    for (int l = 1; l < LANES; l++) min = (v[l] < min) ? v[l] : min;
+    return min;
+}
+
+// === Instruction groups ===
+
+static inline void chip8_lanes_advance(Chip8Lanes* ln, Chip8LaneMask on) {
+    ln->PC += (Chip8LaneVec)on & 2;
+}
+
+// taken selects between skipping the next instruction and falling through
+static inline void chip8_lanes_skip(Chip8Lanes* ln, Chip8LaneMask on, Chip8LaneMask taken) {
+    ln->PC += (Chip8LaneVec)on & (2 + ((Chip8LaneVec)taken & 2));
+}
+
+static inline void chip8_lanes_set_v(Chip8Lanes* ln, Chip8LaneMask on, uint8_t x, Chip8LaneVec value) {
+    ln->V[x] = chip8_lanes_select(on, value, ln->V[x]);
+}
+
+static inline void chip8_lanes_set_vf(Chip8Lanes* ln, Chip8LaneMask on, Chip8LaneMask flag) {
+    ln->V[0xF] = chip8_lanes_select(on, chip8_lanes_bool(flag), ln->V[0xF]);
+}
+
+static void chip8_lanes_alu(Chip8Lanes* ln, Chip8LaneMask on, uint8_t x, uint8_t y, uint8_t n) {
+    Chip8LaneVec* V = ln->V;
+
+    switch (n) {
+        case 0x0:
+            chip8_lanes_set_v(ln, on, x, V[y]);
+            break;
+
+        case 0x1:
+            chip8_lanes_set_v(ln, on, x, V[x] | V[y]);
+            V[0xF] &= ~(Chip8LaneVec)on; // VF reset (quirk)
+            break;
+
+        case 0x2:
+            chip8_lanes_set_v(ln, on, x, V[x] & V[y]);
+            V[0xF] &= ~(Chip8LaneVec)on;
+            break;
+
+        case 0x3:
+            chip8_lanes_set_v(ln, on, x, V[x] ^ V[y]);
+            V[0xF] &= ~(Chip8LaneVec)on;
+            break;
+
+        case 0x4: {
+            Chip8LaneVec sum = V[x] + V[y];
+            chip8_lanes_set_vf(ln, on, sum > 0xFF);
+            chip8_lanes_set_v(ln, on, x, sum & 0xFF);
+            break;
+        }
+
+        case 0x5:
+            chip8_lanes_set_vf(ln, on, V[x] >= V[y]);
+            chip8_lanes_set_v(ln, on, x, V[x] - V[y]);
+            break;
+
+        case 0x6:
+            V[0xF] = chip8_lanes_select(on, V[y] & 0x01, V[0xF]);
+            chip8_lanes_set_v(ln, on, x, V[y] >> 1);
+            break;
+
+        case 0x7:
+            chip8_lanes_set_vf(ln, on, V[y] >= V[x]);
+            chip8_lanes_set_v(ln, on, x, V[y] - V[x]);
+            break;
+
+        case 0xE:
+            V[0xF] = chip8_lanes_select(on, (V[y] & 0x80) >> 7, V[0xF]);
+            chip8_lanes_set_v(ln, on, x, V[y] << 1);
+            break;
+
+        default:
+            break; // unassigned 8XYn, ignored
+    }
+
+    chip8_lanes_advance(ln, on);
+}
+
+static void chip8_lanes_draw(Chip8Lanes* ln, int l, uint8_t x, uint8_t y, uint8_t height) {
+    uint8_t lx = ln->V[x][l] % 64;
+    uint8_t ly = ln->V[y][l] % 32;
+    const uint8_t* memory = ln->memory[l];
+    uint64_t* display = ln->display[l];
+    uint64_t collision = 0;
+
+    for (uint8_t row = 0; row < height; row++) {
+        uint64_t sprite = chip8_sprite_row(memory[CHIP8_ADDR(ln->I[l] + row)], lx);
+        uint64_t* line = &display[(ly + row) % 32];
+
+        collision |= *line & sprite;
+        *line ^= sprite;
+    }
+
+    ln->V[0xF][l] = (collision != 0) ? 1 : 0;
+    ln->draw_flag[l] = true;
+}
+
+/*
+    Halts a lane the way RET and CALL halt the core. The cycle is filled in by
+    chip8_lanes_store: a halted lane stops counting right after the halting instruction.
+*/
+static void chip8_lanes_halt(Chip8Lanes* ln, int l, Chip8DiagCode code, uint16_t pc, uint16_t opcode) {
+    ln->halted[l] = -1;
+    ln->halt_diag[l] = (Chip8Diag){ 0, pc, opcode, (uint8_t)code };
+    ln->halt_pending |= 1u << l;
+}
+
+/*
+    Executes opcode at pc for the lanes in on (mask holds the same set as bits).
+    Returns the lanes that are stuck on it until something outside the lane changes
+    (a jump to itself, FX0A without a key), which step_n fast-forwards like the core does.
+*/
+static Chip8LaneMask chip8_lanes_execute(Chip8Lanes* ln, uint16_t opcode, uint16_t pc,
+                                         Chip8LaneMask on, uint32_t mask) {
+    uint8_t x = (opcode & 0x0F00) >> 8;
+    uint8_t y = (opcode & 0x00F0) >> 4;
+    uint8_t n = (opcode & 0x000F);
+    uint8_t nn = (opcode & 0x00FF);
+    uint16_t nnn = (opcode & 0x0FFF);
+    Chip8LaneMask none = {0};
+
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            if (nn == 0xE0) {
+                LANE_EACH(mask, l) {
+                    memset(ln->display[l], 0, sizeof(ln->display[l]));
+                    ln->draw_flag[l] = true;
+                }
+                chip8_lanes_advance(ln, on);
+            } else if (nn == 0xEE) {
+                LANE_EACH(mask, l) {
+                    if (ln->SP[l] == 0) {
+                        chip8_lanes_halt(ln, l, CHIP8_DIAG_STACK_UNDERFLOW, pc, opcode);
+                        ln->PC[l] += 2;
+                        continue;
+                    }
+                    ln->SP[l]--;
+                    ln->PC[l] = ln->stack[ln->SP[l]][l];
+                }
+            } else {
+                chip8_lanes_advance(ln, on); // 0NNN, ignored
+            }
+            break;
+
+        case 0x1000:
+            if (nnn == pc) {
+                return on; // jumps to itself
+            }
+            ln->PC = chip8_lanes_select(on, chip8_lanes_splat(nnn), ln->PC);
+            break;
+
+        case 0x2000:
+            LANE_EACH(mask, l) {
+                if (ln->SP[l] >= CHIP8_STACK_SIZE) {
+                    chip8_lanes_halt(ln, l, CHIP8_DIAG_STACK_OVERFLOW, pc, opcode);
+                    ln->PC[l] += 2;
+                    continue;
+                }
+                ln->stack[ln->SP[l]][l] = ln->PC[l] + 2;
+                ln->SP[l]++;
+                ln->PC[l] = nnn;
+            }
+            break;
+
+        case 0x3000:
+            chip8_lanes_skip(ln, on, ln->V[x] == nn);
+            break;
+
+        case 0x4000:
+            chip8_lanes_skip(ln, on, ln->V[x] != nn);
+            break;
+
+        case 0x5000:
+            if (n == 0) chip8_lanes_skip(ln, on, ln->V[x] == ln->V[y]);
+            else        chip8_lanes_advance(ln, on);
+            break;
+
+        case 0x6000:
+            chip8_lanes_set_v(ln, on, x, chip8_lanes_splat(nn));
+            chip8_lanes_advance(ln, on);
+            break;
+
+        case 0x7000:
+            chip8_lanes_set_v(ln, on, x, ln->V[x] + nn);
+            chip8_lanes_advance(ln, on);
+            break;
+
+        case 0x8000:
+            chip8_lanes_alu(ln, on, x, y, n);
+            break;
+
+        case 0x9000:
+            if (n == 0) chip8_lanes_skip(ln, on, ln->V[x] != ln->V[y]);
+            else        chip8_lanes_advance(ln, on);
+            break;
+
+        case 0xA000:
+            ln->I = chip8_lanes_select(on, chip8_lanes_splat(nnn), ln->I);
+            chip8_lanes_advance(ln, on);
+            break;
+
+        case 0xB000:
+            ln->PC = chip8_lanes_select(on, ln->V[0] + nnn, ln->PC);
+            break;
+
+        case 0xC000:
+            LANE_EACH(mask, l) {
+                ln->V[x][l] = (chip8_rand_next(&ln->rand_state[l]) >> 24) & nn;
+            }
+            chip8_lanes_advance(ln, on);
+            break;
+
+        case 0xD000:
+            LANE_EACH(mask, l) {
+                chip8_lanes_draw(ln, l, x, y, n);
+            }
+            chip8_lanes_advance(ln, on);
+            break;
+
+        case 0xE000:
+            if (nn == 0x9E || nn == 0xA1) {
+                Chip8LaneVec vx = ln->V[x];
+                Chip8LaneMask pressed = ((ln->keys >> (vx & 0x0F)) & 1) != 0;
+                if (nn == 0xA1) pressed = ~pressed;
+                chip8_lanes_skip(ln, on, pressed & (vx < 16));
+            } else {
+                chip8_lanes_advance(ln, on);
+            }
+            break;
+
+        case 0xF000:
+            switch (nn) {
+                case 0x07:
+                    chip8_lanes_set_v(ln, on, x, ln->delay_timer);
+                    break;
+
+                case 0x0A:
+                    // without a key the lane stays on this instruction
+                    LANE_EACH(mask, l) {
+                        if (ln->keys[l] != 0) {
+                            ln->V[x][l] = __builtin_ctz(ln->keys[l]);
+                            ln->PC[l] += 2;
+                        }
+                    }
+                    return on & (ln->keys == 0);
+
+                case 0x15:
+                    ln->delay_timer = chip8_lanes_select(on, ln->V[x] & 0xFF, ln->delay_timer);
+                    break;
+
+                case 0x18:
+                    ln->sound_timer = chip8_lanes_select(on, ln->V[x] & 0xFF, ln->sound_timer);
+                    break;
+
+                case 0x1E:
+                    ln->I = chip8_lanes_select(on, ln->I + ln->V[x], ln->I);
+                    break;
+
+                case 0x29:
+                    ln->I = chip8_lanes_select(on, (ln->V[x] & 0x0F) * 5, ln->I);
+                    break;
+
+                case 0x33:
+                    ln->unique |= mask;
+                    LANE_EACH(mask, l) {
+                        uint8_t bcd = (uint8_t)ln->V[x][l];
+                        ln->memory[l][CHIP8_ADDR(ln->I[l])] = bcd / 100;
+                        ln->memory[l][CHIP8_ADDR(ln->I[l] + 1)] = (bcd / 10) % 10;
+                        ln->memory[l][CHIP8_ADDR(ln->I[l] + 2)] = bcd % 10;
+                    }
+                    break;
+
+                case 0x55:
+                    ln->unique |= mask;
+                    LANE_EACH(mask, l) {
+                        for (uint8_t i = 0; i <= x; i++) {
+                            ln->memory[l][CHIP8_ADDR(ln->I[l] + i)] = (uint8_t)ln->V[i][l];
+                        }
+                        ln->I[l] += x + 1;
+                    }
+                    break;
+
+                case 0x65:
+                    LANE_EACH(mask, l) {
+                        for (uint8_t i = 0; i <= x; i++) {
+                            ln->V[i][l] = ln->memory[l][CHIP8_ADDR(ln->I[l] + i)];
+                        }
+                        ln->I[l] += x + 1;
+                    }
+                    break;
+
+                default:
+                    break; // unassigned FXnn, ignored
+            }
+            chip8_lanes_advance(ln, on);
+            break;
+    }
+
+    return none;
+}
+
+/*
+    One run of step_n with a budget that fits the 16-bit lane counters.
+*/
+static int chip8_lanes_run(Chip8Lanes* ln, int16_t n) {
+    Chip8LaneMask left = {0};
+    left += n;
+
+    int dispatches = 0;
+    for (;;) {
+        Chip8LaneMask pending = ln->live & ~ln->halted & (left > 0);
+        if (!chip8_lanes_any(pending)) break;
+
+        // lowest PC first, so lanes that ran ahead wait for the others to catch up
+        uint16_t pc = chip8_lanes_min(chip8_lanes_select(pending, ln->PC, chip8_lanes_splat(0xFFFF)));
+        Chip8LaneMask on = pending & (ln->PC == pc);
+        uint32_t mask = chip8_lanes_bits(on);
+
+        int leader = __builtin_ctz(mask);
+        const uint8_t* memory = ln->memory[leader];
+        uint16_t opcode = (memory[CHIP8_ADDR(pc)] << 8) | memory[CHIP8_ADDR(pc + 1)];
+
+        // lanes that rewrote this instruction in their own memory take a separate dispatch
+        uint32_t check = (ln->unique & (1u << leader)) ? mask : (mask & ln->unique);
+        LANE_EACH(check, l) {
+            if (ln->memory[l][CHIP8_ADDR(pc)] != (opcode >> 8) ||
+                ln->memory[l][CHIP8_ADDR(pc + 1)] != (opcode & 0xFF)) {
+                on[l] = 0;
+                mask &= ~(1u << l);
+            }
+        }
+
+        Chip8LaneMask stuck = chip8_lanes_execute(ln, opcode, pc, on, mask);
+        dispatches++;
+
+        // a stuck lane spends the rest of its budget on the instruction
+        left -= on & ((stuck & left) | (~stuck & 1));
+    }
+
+    for (int l = 0; l < LANES; l++) {
+        ln->cycle_count[l] += (uint64_t)(n - left[l]);
+    }
+    return dispatches;
+}
+
+// === Interface ===
+
+Chip8Lanes* chip8_lanes_create(int lanes) {
+    if (lanes < 1 || lanes > CHIP8_LANES_MAX) {
+        fprintf(stderr, "ERROR: Lane count must be between 1 and %d\n", CHIP8_LANES_MAX);
+        return NULL;
+    }
+
+    // the vectors need their natural alignment, which malloc does not promise
+    Chip8Lanes* ln = aligned_alloc(_Alignof(Chip8Lanes), sizeof(Chip8Lanes));
+    if (!ln) {
+        fprintf(stderr, "ERROR: Failed to allocate Chip-8 lanes\n");
+        return NULL;
+    }
+    memset(ln, 0, sizeof(Chip8Lanes));
+    ln->count = lanes;
+    for (int l = 0; l < lanes; l++) ln->live[l] = -1;
+
+    Chip8* chip = chip8_create();
+    if (!chip) {
+        free(ln);
+        return NULL;
+    }
+    chip8_lanes_load(ln, -1, chip);
+    chip8_destroy(&chip);
+    return ln;
+}
+
+void chip8_lanes_destroy(Chip8Lanes** lanes_ptr) {
+    if (!lanes_ptr || !*lanes_ptr) return;
+
+    free(*lanes_ptr);
+    *lanes_ptr = NULL;
+}
+
+int chip8_lanes_count(Chip8Lanes* lanes) {
+    return lanes ? lanes->count : 0;
+}
+
+bool chip8_lanes_load(Chip8Lanes* lanes, int lane, const Chip8* chip) {
+    if (!lanes || !chip || lane >= lanes->count) {
+        fprintf(stderr, "ERROR: Invalid lanes, lane or instance while loading lanes\n");
+        return false;
+    }
+
+    int first = (lane < 0) ? 0 : lane;
+    int last = (lane < 0) ? lanes->count - 1 : lane;
+    for (int l = first; l <= last; l++) {
+        memcpy(lanes->memory[l], chip->memory, CHIP8_MEMORY_SIZE);
+        memcpy(lanes->display[l], chip->display, sizeof(lanes->display[l]));
+
+        for (int r = 0; r < CHIP8_NUM_REGISTERS; r++) lanes->V[r][l] = chip->V[r];
+        for (int s = 0; s < CHIP8_STACK_SIZE; s++) lanes->stack[s][l] = chip->stack[s];
+
+        lanes->PC[l] = chip->PC;
+        lanes->I[l] = chip->I;
+        lanes->SP[l] = chip->SP;
+        lanes->delay_timer[l] = chip->delay_timer;
+        lanes->sound_timer[l] = chip->sound_timer;
+        lanes->rand_seed[l] = chip->rand_seed;
+        lanes->rand_state[l] = chip->rand_state;
+        lanes->cycle_count[l] = chip->cycle_count;
+        lanes->draw_flag[l] = chip->draw_flag;
+        lanes->halted[l] = chip->halted ? -1 : 0;
+        lanes->halt_pending &= ~(1u << l);
+
+        lanes->keys[l] = 0;
+        for (int k = 0; k < CHIP8_NUM_KEYS; k++) {
+            if (chip->keys[k]) lanes->keys[l] |= 1u << k;
+        }
+    }
+
+    // lanes whose memory matches lane 0 can skip the opcode check in step_n
+    lanes->unique = 0;
+    for (int l = 1; l < lanes->count && lane >= 0; l++) {
+        if (memcmp(lanes->memory[l], lanes->memory[0], CHIP8_MEMORY_SIZE) != 0) {
+            lanes->unique |= 1u << l;
+        }
+    }
+    return true;
+}
+
+bool chip8_lanes_store(Chip8Lanes* lanes, int l, Chip8* chip) {
+    if (!chip8_lanes_valid(lanes, l) || !chip) {
+        fprintf(stderr, "ERROR: Invalid lanes, lane or instance while storing a lane\n");
+        return false;
+    }
+
+    chip8_replace_memory(chip, lanes->memory[l]);
+    memcpy(chip->display, lanes->display[l], sizeof(chip->display));
+
+    for (int r = 0; r < CHIP8_NUM_REGISTERS; r++) chip->V[r] = lanes->V[r][l];
+    for (int s = 0; s < CHIP8_STACK_SIZE; s++) chip->stack[s] = lanes->stack[s][l];
+
+    chip->PC = lanes->PC[l];
+    chip->I = lanes->I[l];
+    chip->SP = (uint8_t)lanes->SP[l];
+    chip->delay_timer = (uint8_t)lanes->delay_timer[l];
+    chip->sound_timer = (uint8_t)lanes->sound_timer[l];
+    chip->rand_seed = lanes->rand_seed[l];
+    chip->rand_state = lanes->rand_state[l];
+    chip->cycle_count = lanes->cycle_count[l];
+    chip->draw_flag = lanes->draw_flag[l];
+    chip->dirty_rows = 0xFFFFFFFFu; // the display was replaced as a whole
+    chip->halted = lanes->halted[l] != 0;
+
+    if (lanes->halt_pending & (1u << l)) {
+        Chip8Diag* d = &lanes->halt_diag[l];
+        chip8_diag(chip, (Chip8DiagCode)d->code, d->pc, d->opcode, chip->cycle_count - 1);
+        lanes->halt_pending &= ~(1u << l);
+    }
+
+    for (int k = 0; k < CHIP8_NUM_KEYS; k++) {
+        chip->keys[k] = (lanes->keys[l] >> k) & 1;
+    }
+
+    chip8_state_replaced(chip);
+    return true;
+}
+
+int chip8_lanes_step_n(Chip8Lanes* lanes, int n) {
+    if (!lanes || n <= 0) return 0;
+
+    int dispatches = 0;
+    for (int done = 0; done < n; ) {
+        int chunk = (n - done < INT16_MAX) ? n - done : INT16_MAX;
+        dispatches += chip8_lanes_run(lanes, (int16_t)chunk);
+        done += chunk;
+    }
+    return dispatches;
+}
+
+void chip8_lanes_update_timers(Chip8Lanes* lanes) {
+    if (!lanes) return;
+
+    lanes->delay_timer -= chip8_lanes_bool(lanes->delay_timer != 0);
+    lanes->sound_timer -= chip8_lanes_bool(lanes->sound_timer != 0);
+}
+
+void chip8_lanes_key_press(Chip8Lanes* lanes, int lane, uint8_t key) {
+    if (!chip8_lanes_valid(lanes, lane) || key >= CHIP8_NUM_KEYS) return;
+
+    lanes->keys[lane] |= 1u << key;
+}
+
+void chip8_lanes_key_release(Chip8Lanes* lanes, int lane, uint8_t key) {
+    if (!chip8_lanes_valid(lanes, lane) || key >= CHIP8_NUM_KEYS) return;
+
+    lanes->keys[lane] &= ~(1u << key);
+}
+
+void chip8_lanes_seed(Chip8Lanes* lanes, int lane, uint64_t seed) {
+    if (!chip8_lanes_valid(lanes, lane)) return;
+
+    lanes->rand_seed[lane] = seed;
+    lanes->rand_state[lane] = chip8_rand_seed(seed);
+}
+
+uint16_t chip8_lanes_get_pc(Chip8Lanes* lanes, int lane) {
+    return chip8_lanes_valid(lanes, lane) ? lanes->PC[lane] : 0;
+}
+
+uint8_t chip8_lanes_get_register(Chip8Lanes* lanes, int lane, int reg) {
+    if (!chip8_lanes_valid(lanes, lane) || reg < 0 || reg >= CHIP8_NUM_REGISTERS) {
+        return 0;
+    }
+
+    return lanes->V[reg][lane];
+}
+
+bool chip8_lanes_is_halted(Chip8Lanes* lanes, int lane) {
+    return chip8_lanes_valid(lanes, lane) ? lanes->halted[lane] != 0 : false;
+}
+
+const uint64_t* chip8_lanes_get_display_rows(Chip8Lanes* lanes, int lane) {
+    return chip8_lanes_valid(lanes, lane) ? lanes->display[lane] : NULL;
+}
@@ -1,77 +1,84 @@
 #include "../include/chip8_log.h"
 #include "../include/chip8.h"
+#include <stdatomic.h>
 #include <stdio.h>
 
-static bool g_debug_enabled;
-static bool g_verbose_enabled;
+// Process-wide switches read from any thread; every message goes out in a single
+// stdio call so lines from instances on different threads do not interleave.
+static atomic_bool g_debug_enabled;
+static atomic_bool g_verbose_enabled;
 
 // PRIVATE FUNCTIONS
 
 void chip8_log_draw_screen(Chip8* chip) {
     if (!chip) return;
 
-    const bool* display = chip8_get_display(chip);
+    const uint64_t* rows = chip8_get_display_rows(chip);
+    char screen[CHIP8_DISPLAY_HEIGHT * (CHIP8_DISPLAY_WIDTH + 2) + 2];
+    size_t len = 0;
 
     for (uint16_t y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) {
-        printf(" ");
+        screen[len++] = ' ';
 
         for (uint16_t x = 0; x < CHIP8_DISPLAY_WIDTH; x++) {
-            if (display[(y * CHIP8_DISPLAY_WIDTH + x)]) {
-                printf("#");
+            if (CHIP8_PIXEL(rows, x, y)) {
+                screen[len++] = '#';
             } else {
-                printf(".");
+                screen[len++] = '.';
             }
         }
-        printf("\n");
+        screen[len++] = '\n';
     }
-    fprintf(stderr, "\n");
+    screen[len++] = '\n';
+    screen[len] = '\0';
+    fputs(screen, stderr);
 }
 
 // INTERFACE
 
 void chip8_log_debug_set_enabled(bool debug) {
-    g_debug_enabled = debug;
+    atomic_store(&g_debug_enabled, debug);
 }
 
 void chip8_log_verbose_set_enabled(bool verbose) {
-    g_verbose_enabled = verbose;
+    atomic_store(&g_verbose_enabled, verbose);
 }
 
 void chip8_log_instructions(Chip8* chip, uint16_t opcode) {
-    if (!chip || !g_debug_enabled) return;
+    if (!chip || !atomic_load(&g_debug_enabled)) return;
 
     uint16_t local_cycle = chip8_get_cycle_count(chip);
     uint16_t local_pc = chip8_get_pc(chip);
     uint16_t affected_register = ((opcode & 0x0F00) >> 8);
 
-    fprintf(stderr, "[%06llu] PC=0x%03X OP=0x%04X ", (unsigned long long)local_cycle, local_pc, opcode);
-
     char disasm_buffer[CHIP8_DISASM_BUFSIZE];
     chip8_disassemble(chip, local_pc, disasm_buffer, sizeof(disasm_buffer));
 
-    if (g_verbose_enabled) {
-        fprintf(stderr, " -> V%X = %02X", affected_register, chip8_get_register(chip, affected_register));
+    if (atomic_load(&g_verbose_enabled)) {
+        fprintf(stderr, "[%06llu] PC=0x%03X OP=0x%04X  -> V%X = %02X\n", (unsigned long long)local_cycle, local_pc, opcode,
+                affected_register, chip8_get_register(chip, affected_register));
+    } else {
+        fprintf(stderr, "[%06llu] PC=0x%03X OP=0x%04X \n", (unsigned long long)local_cycle, local_pc, opcode);
     }
-
-    fprintf(stderr, "\n");
 }
 
 void chip8_log_registers(Chip8* chip) {
-    if (!chip || !g_verbose_enabled) return;
+    if (!chip || !atomic_load(&g_verbose_enabled)) return;
 
-    fprintf(stderr, " [REG] ");
+    char line[16 * CHIP8_NUM_REGISTERS + 16];
+    int len = snprintf(line, sizeof(line), " [REG] ");
     for (uint8_t i = 0; i < CHIP8_NUM_REGISTERS; i++) {
-        fprintf(stderr, " V%X = %02X", i, chip8_get_register(chip, i));
+        len += snprintf(line + len, sizeof(line) - len, " V%X = %02X", i, chip8_get_register(chip, i));
     }
-    fprintf(stderr, "\n");
+    fprintf(stderr, "%s\n", line);
 
 }
 
 void chip8_log_screen(Chip8* chip) {
-    if (!chip || !g_debug_enabled) return;
+    if (!chip || !atomic_load(&g_debug_enabled)) return;
 
-    fprintf(stderr, "[DRAW] Display updated at PC = 0x%03X\n", chip8_get_pc(chip));
-    fprintf(stderr, " [DISPLAY %2dx%2d]\n", CHIP8_DISPLAY_WIDTH, CHIP8_DISPLAY_HEIGHT);
+    fprintf(stderr, "[DRAW] Display updated at PC = 0x%03X\n [DISPLAY %2dx%2d]\n",
+            chip8_get_pc(chip), CHIP8_DISPLAY_WIDTH, CHIP8_DISPLAY_HEIGHT);
     chip8_log_draw_screen(chip);
 }
 
@@ -81,4 +88,17 @@ void chip8_log_halt(Chip8* chip, const char* reason) {
             reason ? reason : "Unknown",
             chip8_get_pc(chip),
             (unsigned long long)chip8_get_cycle_count(chip));
-}
\ No newline at end of file
+}
+
+void chip8_log_diagnostics(Chip8* chip) {
+    if (!chip) return;
+
+    Chip8Diag entries[CHIP8_DIAG_RING_SIZE];
+    size_t count = chip8_drain_diagnostics(chip, entries, CHIP8_DIAG_RING_SIZE);
+    for (size_t i = 0; i < count; i++) {
+        fprintf(stderr, "[DIAG] %s (PC=0x%03X OP=0x%04X, Cycle=%llu, %llu so far)\n",
+                chip8_diag_name((Chip8DiagCode)entries[i].code), entries[i].pc, entries[i].opcode,
+                (unsigned long long)entries[i].cycle,
+                (unsigned long long)chip8_get_diag_count(chip, (Chip8DiagCode)entries[i].code));
+    }
+}
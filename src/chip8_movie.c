@@ -0,0 +1,426 @@
+#include "../include/chip8_movie.h"
+#include "../include/chip8_state.h"
+#include "chip8_internal.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    A movie is a list of events in the order they happened plus the states that the
+    KEYFRAME and STATE events refer to, in the same order.
+
+    File layout (little-endian):
+
+        "C8MV"  u16 version  u16 0  u32 keyframe_interval  u64 seed
+        u32 event count  u32 state count
+        events: u8 type << 4 | key, zigzag varint of the cycle minus the previous event's
+        states: CHIP8_STATE_SIZE bytes each
+
+    A key or tick costs two or three bytes, so the keyframes make up most of a file.
+*/
+
+#define DEFAULT_KEYFRAME_INTERVAL (30 * 60)
+#define INITIAL_EVENTS            1024
+#define INITIAL_STATES            8
+
+enum {
+    EV_KEY_DOWN = 1,
+    EV_KEY_UP,
+    EV_TICK,
+    EV_KEYFRAME, // state to check against, right after a tick
+    EV_STATE,    // state the host put in place, replaces the replayed one
+};
+
+typedef struct {
+    uint64_t cycle;  // cycle_count the event happened at (after it, for EV_STATE)
+    uint32_t frame;  // ticks before it, counting an EV_TICK itself
+    uint32_t state;  // index into states, for EV_KEYFRAME and EV_STATE
+    uint8_t type;
+    uint8_t key;
+} Chip8MovieEvent;
+
+struct Chip8Movie {
+    Chip8MovieEvent* events;
+    int event_count;
+    int event_capacity;
+
+    uint8_t* states;
+    int state_count;
+    int state_capacity;
+
+    uint64_t seed;          // chip8_get_seed when recording started, for reference
+    int keyframe_interval;
+    int frames;
+    int since_keyframe;
+
+    // playback
+    int position;           // next event to apply
+    int frame;              // frames played up to position
+    int desyncs;
+};
+
+// === Building ===
+
+static Chip8Movie* chip8_movie_alloc(int keyframe_interval) {
+    Chip8Movie* movie = calloc(1, sizeof(Chip8Movie));
+    if (!movie) {
+        fprintf(stderr, "ERROR: Failed to allocate movie\n");
+        return NULL;
+    }
+    movie->keyframe_interval = (keyframe_interval > 0) ? keyframe_interval : DEFAULT_KEYFRAME_INTERVAL;
+    return movie;
+}
+
+static bool chip8_movie_reserve(void** items, int* capacity, int count, int initial, size_t item_size) {
+    if (count < *capacity) return true;
+
+    int grown = (*capacity > 0) ? *capacity * 2 : initial;
+    void* p = realloc(*items, (size_t)grown * item_size);
+    if (!p) {
+        fprintf(stderr, "ERROR: Failed to grow movie\n");
+        return false;
+    }
+    *items = p;
+    *capacity = grown;
+    return true;
+}
+
+static Chip8MovieEvent* chip8_movie_add(Chip8Movie* movie, uint8_t type, uint8_t key, uint64_t cycle) {
+    if (!chip8_movie_reserve((void**)&movie->events, &movie->event_capacity, movie->event_count,
+                             INITIAL_EVENTS, sizeof(Chip8MovieEvent))) {
+        return NULL;
+    }
+
+    if (type == EV_TICK) movie->frames++;
+
+    Chip8MovieEvent* ev = &movie->events[movie->event_count++];
+    ev->cycle = cycle;
+    ev->frame = (uint32_t)movie->frames;
+    ev->state = 0;
+    ev->type = type;
+    ev->key = key;
+    return ev;
+}
+
+static uint8_t* chip8_movie_state(Chip8Movie* movie, uint32_t index) {
+    return movie->states + (size_t)index * CHIP8_STATE_SIZE;
+}
+
+static bool chip8_movie_add_state(Chip8Movie* movie, uint8_t type, Chip8* chip) {
+    if (!chip8_movie_reserve((void**)&movie->states, &movie->state_capacity, movie->state_count,
+                             INITIAL_STATES, CHIP8_STATE_SIZE)) {
+        return false;
+    }
+
+    Chip8MovieEvent* ev = chip8_movie_add(movie, type, 0, chip->cycle_count);
+    if (!ev) return false;
+
+    ev->state = (uint32_t)movie->state_count++;
+    chip8_save_state(chip, chip8_movie_state(movie, ev->state), CHIP8_STATE_SIZE);
+    return true;
+}
+
+// === Recording hooks (chip8_internal.h) ===
+
+void chip8_movie_on_key(Chip8* chip, uint8_t key, bool down) {
+    chip8_movie_add(chip->movie, down ? EV_KEY_DOWN : EV_KEY_UP, key, chip->cycle_count);
+}
+
+void chip8_movie_on_tick(Chip8* chip) {
+    Chip8Movie* movie = chip->movie;
+    if (!chip8_movie_add(movie, EV_TICK, 0, chip->cycle_count)) return;
+
+    if (++movie->since_keyframe >= movie->keyframe_interval) {
+        chip8_movie_add_state(movie, EV_KEYFRAME, chip);
+        movie->since_keyframe = 0;
+    }
+}
+
+void chip8_movie_on_state(Chip8* chip) {
+    chip8_movie_add_state(chip->movie, EV_STATE, chip);
+}
+
+// === Recording ===
+
+Chip8Movie* chip8_movie_record(Chip8* chip, int keyframe_interval) {
+    if (!chip || chip->movie) {
+        fprintf(stderr, "ERROR: Invalid instance, or it is already recording\n");
+        return NULL;
+    }
+
+    Chip8Movie* movie = chip8_movie_alloc(keyframe_interval);
+    if (!movie) return NULL;
+
+    movie->seed = chip->rand_seed;
+    chip->movie = movie;
+    if (!chip8_movie_add_state(movie, EV_STATE, chip)) {
+        chip->movie = NULL;
+        chip8_movie_destroy(&movie);
+        return NULL;
+    }
+    return movie;
+}
+
+Chip8Movie* chip8_movie_stop(Chip8* chip) {
+    if (!chip) return NULL;
+
+    Chip8Movie* movie = chip->movie;
+    chip->movie = NULL;
+    return movie;
+}
+
+bool chip8_movie_is_recording(Chip8* chip) {
+    return chip && chip->movie;
+}
+
+void chip8_movie_destroy(Chip8Movie** movie_ptr) {
+    if (!movie_ptr || !*movie_ptr) return;
+
+    free((*movie_ptr)->events);
+    free((*movie_ptr)->states);
+    free(*movie_ptr);
+    *movie_ptr = NULL;
+}
+
+// === Files ===
+
+static void put_u16(FILE* file, uint16_t v) {
+    fputc(v & 0xFF, file);
+    fputc(v >> 8, file);
+}
+
+static void put_u32(FILE* file, uint32_t v) {
+    put_u16(file, (uint16_t)v);
+    put_u16(file, (uint16_t)(v >> 16));
+}
+
+static void put_u64(FILE* file, uint64_t v) {
+    put_u32(file, (uint32_t)v);
+    put_u32(file, (uint32_t)(v >> 32));
+}
+
+static void put_varint(FILE* file, uint64_t v) {
+    while (v >= 0x80) {
+        fputc((int)(v & 0x7F) | 0x80, file);
+        v >>= 7;
+    }
+    fputc((int)v, file);
+}
+
+static bool get_bytes(FILE* file, void* out, size_t size) {
+    return fread(out, 1, size, file) == size;
+}
+
+static bool get_u32(FILE* file, uint32_t* v) {
+    uint8_t b[4];
+    if (!get_bytes(file, b, sizeof(b))) return false;
+    *v = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    return true;
+}
+
+static bool get_u64(FILE* file, uint64_t* v) {
+    uint32_t lo, hi;
+    if (!get_u32(file, &lo) || !get_u32(file, &hi)) return false;
+    *v = (uint64_t)lo | ((uint64_t)hi << 32);
+    return true;
+}
+
+static bool get_varint(FILE* file, uint64_t* v) {
+    *v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(file);
+        if (c == EOF) return false;
+        *v |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+bool chip8_movie_save(Chip8Movie* movie, const char* path) {
+    if (!movie || !path || path[0] == '\0') {
+        fprintf(stderr, "ERROR: Invalid movie or path while saving movie\n");
+        return false;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Failed to open movie file: %s\n", path);
+        return false;
+    }
+
+    fwrite("C8MV", 1, 4, file);
+    put_u16(file, CHIP8_MOVIE_VERSION);
+    put_u16(file, 0);
+    put_u32(file, (uint32_t)movie->keyframe_interval);
+    put_u64(file, movie->seed);
+    put_u32(file, (uint32_t)movie->event_count);
+    put_u32(file, (uint32_t)movie->state_count);
+
+    uint64_t prev = 0;
+    for (int i = 0; i < movie->event_count; i++) {
+        const Chip8MovieEvent* ev = &movie->events[i];
+        // zigzag, since the cycle count goes back when the host loads an older state
+        int64_t delta = (int64_t)(ev->cycle - prev);
+        fputc((ev->type << 4) | ev->key, file);
+        put_varint(file, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+        prev = ev->cycle;
+    }
+    fwrite(movie->states, CHIP8_STATE_SIZE, (size_t)movie->state_count, file);
+
+    bool ok = !ferror(file);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "ERROR: Failed to write movie file: %s\n", path);
+    }
+    return ok;
+}
+
+Chip8Movie* chip8_movie_load(const char* path) {
+    if (!path || path[0] == '\0') {
+        fprintf(stderr, "ERROR: Invalid or absent path to movie\n");
+        return NULL;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Failed to open movie file: %s\n", path);
+        return NULL;
+    }
+
+    uint8_t magic[8];
+    uint32_t interval, event_count, state_count;
+    uint64_t seed;
+    if (!get_bytes(file, magic, sizeof(magic)) || memcmp(magic, "C8MV", 4) != 0 ||
+        !get_u32(file, &interval) || !get_u64(file, &seed) ||
+        !get_u32(file, &event_count) || !get_u32(file, &state_count)) {
+        fprintf(stderr, "ERROR: Not a Chip-8 movie: %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    uint16_t version = (uint16_t)(magic[4] | (magic[5] << 8));
+    if (version != CHIP8_MOVIE_VERSION) {
+        fprintf(stderr, "ERROR: Movie %s has version %u, expected %u\n", path, version, CHIP8_MOVIE_VERSION);
+        fclose(file);
+        return NULL;
+    }
+
+    Chip8Movie* movie = chip8_movie_alloc((int)interval);
+    if (!movie) {
+        fclose(file);
+        return NULL;
+    }
+    movie->seed = seed;
+
+    bool ok = event_count > 0 && event_count <= INT_MAX && state_count <= INT_MAX / CHIP8_STATE_SIZE;
+    uint64_t cycle = 0;
+    uint32_t states_used = 0;
+    for (uint32_t i = 0; ok && i < event_count; i++) {
+        int tag = fgetc(file);
+        uint64_t zigzag;
+        ok = tag != EOF && get_varint(file, &zigzag);
+        if (!ok) break;
+
+        uint8_t type = (uint8_t)(tag >> 4);
+        ok = type >= EV_KEY_DOWN && type <= EV_STATE && (i > 0 || type == EV_STATE);
+        if (!ok) break;
+
+        cycle += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        Chip8MovieEvent* ev = chip8_movie_add(movie, type, (uint8_t)(tag & 0x0F), cycle);
+        ok = ev != NULL;
+        if (ok && (type == EV_KEYFRAME || type == EV_STATE)) {
+            ev->state = states_used++;
+        }
+    }
+
+    ok = ok && states_used == state_count;
+    if (ok) {
+        movie->states = malloc((size_t)state_count * CHIP8_STATE_SIZE);
+        movie->state_count = movie->state_capacity = (int)state_count;
+        ok = movie->states && get_bytes(file, movie->states, (size_t)state_count * CHIP8_STATE_SIZE);
+    }
+    fclose(file);
+
+    if (!ok) {
+        fprintf(stderr, "ERROR: Truncated or corrupt movie: %s\n", path);
+        chip8_movie_destroy(&movie);
+    }
+    return movie;
+}
+
+// === Playback ===
+
+int chip8_movie_frames(Chip8Movie* movie) {
+    return movie ? movie->frames : 0;
+}
+
+int chip8_movie_desyncs(Chip8Movie* movie) {
+    return movie ? movie->desyncs : 0;
+}
+
+bool chip8_movie_seek(Chip8Movie* movie, Chip8* chip, int frame) {
+    if (!movie || !chip || chip->movie || frame < 0 || frame > movie->frames) {
+        fprintf(stderr, "ERROR: Invalid movie, instance or frame while seeking\n");
+        return false;
+    }
+
+    // the last stored state at or before frame; a STATE stamped with frame itself was
+    // put in place after that frame's tick, so only a keyframe there is "at" frame
+    int start = 0;
+    for (int i = 0; i < movie->event_count && movie->events[i].frame <= (uint32_t)frame; i++) {
+        const Chip8MovieEvent* ev = &movie->events[i];
+        if (ev->type == EV_KEYFRAME || (ev->type == EV_STATE && (ev->frame < (uint32_t)frame || i == 0))) {
+            start = i;
+        }
+    }
+
+    const Chip8MovieEvent* ev = &movie->events[start];
+    if (!chip8_load_state(chip, chip8_movie_state(movie, ev->state), CHIP8_STATE_SIZE)) return false;
+
+    movie->position = start + 1;
+    movie->frame = (int)ev->frame;
+    movie->desyncs = 0;
+    chip8_movie_play(movie, chip, frame - movie->frame);
+    return movie->frame == frame;
+}
+
+int chip8_movie_play(Chip8Movie* movie, Chip8* chip, int frames) {
+    if (!movie || !chip || chip->movie) return 0;
+
+    uint8_t state[CHIP8_STATE_SIZE];
+    int played = 0;
+    while (played < frames && movie->position < movie->event_count) {
+        const Chip8MovieEvent* ev = &movie->events[movie->position];
+
+        if (ev->type != EV_STATE) {
+            // run up to the stamp
+            while (chip->cycle_count < ev->cycle && !chip->halted) {
+                uint64_t left = ev->cycle - chip->cycle_count;
+                chip8_step_n(chip, left > INT_MAX ? INT_MAX : (int)left);
+            }
+            if (chip->cycle_count < ev->cycle) break; // halted before the recording did
+        }
+
+        switch (ev->type) {
+            case EV_KEY_DOWN: chip8_key_press(chip, ev->key); break;
+            case EV_KEY_UP:   chip8_key_release(chip, ev->key); break;
+            case EV_TICK:
+                chip8_update_timers(chip);
+                movie->frame++;
+                played++;
+                break;
+            case EV_KEYFRAME:
+                chip8_save_state(chip, state, sizeof(state));
+                if (!chip8_state_equal(state, chip8_movie_state(movie, ev->state))) {
+                    movie->desyncs++;
+                }
+                break;
+            case EV_STATE:
+                chip8_load_state(chip, chip8_movie_state(movie, ev->state), CHIP8_STATE_SIZE);
+                break;
+        }
+        movie->position++;
+    }
+    return played;
+}
@@ -0,0 +1,237 @@
+#include "../include/chip8_profile.h"
+#include "chip8_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool chip8_profile_enable(Chip8* chip) {
+    if (!chip) {
+        fprintf(stderr, "ERROR: Invalid instance of Chip-8 emulator while enabling the profile\n");
+        return false;
+    }
+
+    if (!chip->profile) {
+        chip->profile = malloc(sizeof(Chip8Profile));
+        if (!chip->profile) {
+            fprintf(stderr, "ERROR: Failed to allocate profile counters\n");
+            return false;
+        }
+    }
+    chip8_profile_reset(chip);
+    return true;
+}
+
+void chip8_profile_disable(Chip8* chip) {
+    if (!chip || !chip->profile) return;
+
+    free(chip->profile);
+    chip->profile = NULL;
+}
+
+bool chip8_profile_is_enabled(Chip8* chip) {
+    return chip && chip->profile;
+}
+
+void chip8_profile_reset(Chip8* chip) {
+    if (!chip || !chip->profile) return;
+
+    Chip8Profile* profile = chip->profile;
+    memset(profile, 0, sizeof(Chip8Profile));
+    profile->nodes[0] = (Chip8CallNode){
+        .entry = CHIP8_PROFILE_TOP_LEVEL, .parent = 0, .child = CHIP8_CALL_NONE, .sibling = CHIP8_CALL_NONE
+    };
+    profile->node_count = 1;
+}
+
+const uint64_t* chip8_profile_executions(Chip8* chip) {
+    return (chip && chip->profile) ? chip->profile->executions : NULL;
+}
+
+const uint64_t* chip8_profile_reads(Chip8* chip) {
+    return (chip && chip->profile) ? chip->profile->reads : NULL;
+}
+
+const uint64_t* chip8_profile_writes(Chip8* chip) {
+    return (chip && chip->profile) ? chip->profile->writes : NULL;
+}
+
+// === Call tree (chip8_internal.h) ===
+
+void chip8_profile_call(Chip8Profile* profile, uint16_t entry) {
+    if (profile->lost_depth > 0) {
+        profile->lost_depth++;
+        return;
+    }
+
+    Chip8CallNode* caller = &profile->nodes[profile->current];
+    uint16_t node = caller->child;
+    while (node != CHIP8_CALL_NONE && profile->nodes[node].entry != entry) {
+        node = profile->nodes[node].sibling;
+    }
+
+    if (node == CHIP8_CALL_NONE) {
+        if (profile->node_count == CHIP8_CALL_NODES) {
+            profile->lost_depth = 1;
+            return;
+        }
+        node = profile->node_count++;
+        profile->nodes[node] = (Chip8CallNode){
+            .entry = entry, .parent = profile->current, .child = CHIP8_CALL_NONE, .sibling = caller->child
+        };
+        caller->child = node;
+    }
+
+    profile->nodes[node].calls++;
+    profile->current = node;
+}
+
+void chip8_profile_return(Chip8Profile* profile) {
+    if (profile->lost_depth > 0) {
+        profile->lost_depth--;
+    } else {
+        // a return past the top level (from a call made before profiling) stays there
+        profile->current = profile->nodes[profile->current].parent;
+    }
+}
+
+void chip8_profile_on_state(Chip8* chip) {
+    chip->profile->current = 0;
+    chip->profile->lost_depth = 0;
+}
+
+// === Queries ===
+
+int chip8_profile_hotspots(Chip8* chip, Chip8ProfileSpot* spots, int max) {
+    if (!chip || !chip->profile || !spots || max <= 0) return 0;
+
+    // insertion into a short sorted list; max is a handful in practice
+    int count = 0;
+    for (int address = 0; address < CHIP8_MEMORY_SIZE; address++) {
+        uint64_t executions = chip->profile->executions[address];
+        if (executions == 0) continue;
+        if (count == max && executions <= spots[count - 1].executions) continue;
+
+        int slot = (count < max) ? count++ : max - 1;
+        while (slot > 0 && spots[slot - 1].executions < executions) {
+            spots[slot] = spots[slot - 1];
+            slot--;
+        }
+        spots[slot] = (Chip8ProfileSpot){ .address = (uint16_t)address, .executions = executions };
+    }
+    return count;
+}
+
+// Cycles of each node including its callees; children come after their parents
+static uint64_t* chip8_profile_totals(const Chip8Profile* profile) {
+    uint64_t* totals = malloc(profile->node_count * sizeof(uint64_t));
+    if (!totals) return NULL;
+
+    for (int n = 0; n < profile->node_count; n++) {
+        totals[n] = profile->nodes[n].self;
+    }
+    for (int n = profile->node_count - 1; n > 0; n--) {
+        totals[profile->nodes[n].parent] += totals[n];
+    }
+    return totals;
+}
+
+static int chip8_profile_compare_routines(const void* a, const void* b) {
+    uint64_t left = ((const Chip8ProfileRoutine*)a)->inclusive;
+    uint64_t right = ((const Chip8ProfileRoutine*)b)->inclusive;
+    return (left < right) - (left > right);
+}
+
+int chip8_profile_routines(Chip8* chip, Chip8ProfileRoutine* routines, int max) {
+    if (!chip || !chip->profile || !routines || max <= 0) return 0;
+
+    const Chip8Profile* profile = chip->profile;
+    uint64_t* totals = chip8_profile_totals(profile);
+    Chip8ProfileRoutine* all = malloc(profile->node_count * sizeof(Chip8ProfileRoutine));
+    if (!totals || !all) {
+        fprintf(stderr, "ERROR: Failed to allocate profile summary\n");
+        free(totals);
+        free(all);
+        return 0;
+    }
+
+    // one slot per routine; the top level goes last, at index CHIP8_MEMORY_SIZE
+    uint16_t slot_of[CHIP8_MEMORY_SIZE + 1];
+    memset(slot_of, 0xFF, sizeof(slot_of));
+    int count = 0;
+
+    for (int n = 0; n < profile->node_count; n++) {
+        const Chip8CallNode* node = &profile->nodes[n];
+        int key = (n == 0) ? CHIP8_MEMORY_SIZE : CHIP8_ADDR(node->entry);
+        if (slot_of[key] == CHIP8_CALL_NONE) {
+            slot_of[key] = (uint16_t)count;
+            all[count++] = (Chip8ProfileRoutine){ .entry = node->entry };
+        }
+        Chip8ProfileRoutine* routine = &all[slot_of[key]];
+        routine->calls += node->calls;
+        routine->exclusive += node->self;
+
+        // under recursion only the outermost call counts, or cycles would count twice
+        bool nested = false;
+        for (int up = node->parent; n != 0 && up != 0 && !nested; up = profile->nodes[up].parent) {
+            nested = profile->nodes[up].entry == node->entry;
+        }
+        if (!nested) routine->inclusive += totals[n];
+    }
+
+    qsort(all, (size_t)count, sizeof(Chip8ProfileRoutine), chip8_profile_compare_routines);
+    if (count > max) count = max;
+    memcpy(routines, all, (size_t)count * sizeof(Chip8ProfileRoutine));
+
+    free(totals);
+    free(all);
+    return count;
+}
+
+// One frame of a folded stack
+static void chip8_profile_frame_name(const Chip8CallNode* node, char* buffer, size_t bufsize) {
+    if (node->entry == CHIP8_PROFILE_TOP_LEVEL) {
+        snprintf(buffer, bufsize, "main");
+    } else {
+        snprintf(buffer, bufsize, "sub_%03X", node->entry);
+    }
+}
+
+bool chip8_profile_export_folded(Chip8* chip, const char* path) {
+    if (!chip || !chip->profile || !path || path[0] == '\0') {
+        fprintf(stderr, "ERROR: Invalid instance or path, or profiling is off\n");
+        return false;
+    }
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "ERROR: Failed to open folded stack file: %s\n", path);
+        return false;
+    }
+
+    // each path with cycles of its own, as "main;sub_2A4;sub_31C 1234"
+    const Chip8Profile* profile = chip->profile;
+    for (int n = 0; n < profile->node_count; n++) {
+        if (profile->nodes[n].self == 0) continue;
+
+        uint16_t path_nodes[CHIP8_STACK_SIZE + 2];
+        int depth = 0;
+        for (int up = n; depth < CHIP8_STACK_SIZE + 2; up = profile->nodes[up].parent) {
+            path_nodes[depth++] = (uint16_t)up;
+            if (up == 0) break;
+        }
+
+        for (int d = depth - 1; d >= 0; d--) {
+            char frame[16];
+            chip8_profile_frame_name(&profile->nodes[path_nodes[d]], frame, sizeof(frame));
+            fprintf(file, "%s%c", frame, d > 0 ? ';' : ' ');
+        }
+        fprintf(file, "%llu\n", (unsigned long long)profile->nodes[n].self);
+    }
+
+    bool ok = !ferror(file);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "ERROR: Failed to write folded stack file: %s\n", path);
+    }
+    return ok;
+}
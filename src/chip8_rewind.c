@@ -0,0 +1,372 @@
+#include "../include/chip8_rewind.h"
+#include "../include/chip8_state.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    The history is a ring of encoded frames. A keyframe is a whole state, any other frame
+    the XOR of its state with the previous frame's; both are run-length encoded with one
+    control byte per run:
+
+        0x80 | (n - 1)   n zero bytes (1 to 128)
+        n - 1, bytes     n literal bytes (1 to 128)
+
+    Between two frames only the cycle counters, a few registers and the odd display row
+    or memory byte change, so a delta is mostly one long zero run.
+
+    The UI thread only copies states into the staging queue. The worker takes them out one
+    at a time, encodes outside the lock and appends under it. Seek and truncate wait until
+    the worker is idle, so they always see the complete history and the worker's base
+    state (prev) can be rewritten by truncate.
+*/
+
+#define DEFAULT_MAX_BYTES         ((size_t)4 << 20)
+#define DEFAULT_KEYFRAME_INTERVAL 60
+#define QUEUE_SIZE                32
+#define INITIAL_FRAMES            1024
+#define ENCODED_MAX               (CHIP8_STATE_SIZE + CHIP8_STATE_SIZE / 128 + 1)
+
+typedef struct {
+    uint8_t* data;
+    uint32_t size;
+    bool keyframe;
+} Chip8RewindFrame;
+
+struct Chip8Rewind {
+    pthread_t thread;
+    pthread_mutex_t lock;     // guards everything below except the worker-owned part
+    pthread_cond_t work_cond; // a state was queued, or stopping
+    pthread_cond_t idle_cond; // queue empty and worker not encoding
+    bool stopping;
+
+    // staging queue, filled by chip8_rewind_push
+    uint8_t (*queue)[CHIP8_STATE_SIZE];
+    int queue_head;
+    int queue_count;
+    bool busy;                // worker holds a state taken from the queue
+
+    // history, oldest frame at frame_head
+    Chip8RewindFrame* frames;
+    int frame_head;
+    int frame_count;
+    int frame_capacity;
+    int since_keyframe;       // frames from the newest keyframe to the newest frame, inclusive
+    int keyframe_interval;
+    size_t bytes_used;
+    size_t max_bytes;
+
+    // worker-owned, or touched by truncate while the worker is idle
+    uint8_t prev[CHIP8_STATE_SIZE];
+    uint8_t current[CHIP8_STATE_SIZE];
+    uint8_t encoded[ENCODED_MAX];
+};
+
+// === Run-length coding ===
+
+// Encodes src, XORed with base unless base is NULL. Returns the encoded size.
+static size_t chip8_rewind_encode(const uint8_t* src, const uint8_t* base, uint8_t* out) {
+    uint8_t diff[CHIP8_STATE_SIZE];
+    for (size_t i = 0; i < CHIP8_STATE_SIZE; i++) {
+        diff[i] = base ? (uint8_t)(src[i] ^ base[i]) : src[i];
+    }
+
+    size_t len = 0;
+    size_t i = 0;
+    while (i < CHIP8_STATE_SIZE) {
+        size_t run = 0;
+        if (diff[i] == 0) {
+            while (i + run < CHIP8_STATE_SIZE && run < 128 && diff[i + run] == 0) run++;
+            out[len++] = (uint8_t)(0x80 | (run - 1));
+        } else {
+            // a lone zero is cheaper to carry as a literal than to end the run for
+            while (i + run < CHIP8_STATE_SIZE && run < 128 &&
+                   !(diff[i + run] == 0 && (i + run + 1 == CHIP8_STATE_SIZE || diff[i + run + 1] == 0))) {
+                run++;
+            }
+            out[len++] = (uint8_t)(run - 1);
+            memcpy(out + len, diff + i, run);
+            len += run;
+        }
+        i += run;
+    }
+    return len;
+}
+
+// Decodes a frame onto state: a keyframe replaces it, a delta is XORed into it
+static void chip8_rewind_decode(const Chip8RewindFrame* frame, uint8_t* state) {
+    const uint8_t* p = frame->data;
+    const uint8_t* end = p + frame->size;
+    size_t pos = 0;
+
+    while (p < end && pos < CHIP8_STATE_SIZE) {
+        uint8_t control = *p++;
+        size_t run = (size_t)(control & 0x7F) + 1;
+        if (run > CHIP8_STATE_SIZE - pos) run = CHIP8_STATE_SIZE - pos;
+
+        if (control & 0x80) {
+            if (frame->keyframe) memset(state + pos, 0, run);
+        } else if (frame->keyframe) {
+            memcpy(state + pos, p, run);
+            p += run;
+        } else {
+            for (size_t i = 0; i < run; i++) state[pos + i] ^= p[i];
+            p += run;
+        }
+        pos += run;
+    }
+}
+
+// === History (lock held) ===
+
+static Chip8RewindFrame* chip8_rewind_frame(Chip8Rewind* rw, int index) {
+    return &rw->frames[(rw->frame_head + index) % rw->frame_capacity];
+}
+
+static bool chip8_rewind_grow(Chip8Rewind* rw) {
+    int capacity = rw->frame_capacity * 2;
+    Chip8RewindFrame* frames = malloc((size_t)capacity * sizeof(Chip8RewindFrame));
+    if (!frames) return false;
+
+    for (int i = 0; i < rw->frame_count; i++) {
+        frames[i] = *chip8_rewind_frame(rw, i);
+    }
+    free(rw->frames);
+    rw->frames = frames;
+    rw->frame_head = 0;
+    rw->frame_capacity = capacity;
+    return true;
+}
+
+static void chip8_rewind_drop_oldest(Chip8Rewind* rw) {
+    Chip8RewindFrame* frame = chip8_rewind_frame(rw, 0);
+    rw->bytes_used -= frame->size;
+    free(frame->data);
+    frame->data = NULL;
+    rw->frame_head = (rw->frame_head + 1) % rw->frame_capacity;
+    rw->frame_count--;
+}
+
+static void chip8_rewind_drop_newest(Chip8Rewind* rw) {
+    Chip8RewindFrame* frame = chip8_rewind_frame(rw, rw->frame_count - 1);
+    rw->bytes_used -= frame->size;
+    free(frame->data);
+    frame->data = NULL;
+    rw->frame_count--;
+}
+
+// Drops whole keyframe intervals from the front, keeping at least the newest one
+static void chip8_rewind_evict(Chip8Rewind* rw) {
+    while (rw->bytes_used > rw->max_bytes && rw->frame_count > rw->since_keyframe) {
+        do {
+            chip8_rewind_drop_oldest(rw);
+        } while (rw->frame_count > 0 && !chip8_rewind_frame(rw, 0)->keyframe);
+    }
+}
+
+// Decodes frame index into state: its keyframe, then every delta up to it
+static void chip8_rewind_restore(Chip8Rewind* rw, int index, uint8_t* state) {
+    int key = index;
+    while (key > 0 && !chip8_rewind_frame(rw, key)->keyframe) key--;
+
+    for (int i = key; i <= index; i++) {
+        chip8_rewind_decode(chip8_rewind_frame(rw, i), state);
+    }
+}
+
+static void chip8_rewind_wait_idle(Chip8Rewind* rw) {
+    while (rw->queue_count > 0 || rw->busy) {
+        pthread_cond_wait(&rw->idle_cond, &rw->lock);
+    }
+}
+
+// === Worker ===
+
+static void* chip8_rewind_worker(void* arg) {
+    Chip8Rewind* rw = arg;
+
+    pthread_mutex_lock(&rw->lock);
+    for (;;) {
+        while (rw->queue_count == 0 && !rw->stopping) {
+            pthread_cond_wait(&rw->work_cond, &rw->lock);
+        }
+        if (rw->queue_count == 0) break; // stopping with nothing left
+
+        memcpy(rw->current, rw->queue[rw->queue_head], CHIP8_STATE_SIZE);
+        rw->queue_head = (rw->queue_head + 1) % QUEUE_SIZE;
+        rw->queue_count--;
+        rw->busy = true;
+        bool keyframe = rw->frame_count == 0 || rw->since_keyframe >= rw->keyframe_interval;
+        pthread_mutex_unlock(&rw->lock);
+
+        size_t size = chip8_rewind_encode(rw->current, keyframe ? NULL : rw->prev, rw->encoded);
+        uint8_t* data = malloc(size);
+        if (data) {
+            memcpy(data, rw->encoded, size);
+        }
+
+        pthread_mutex_lock(&rw->lock);
+        if (data && (rw->frame_count < rw->frame_capacity || chip8_rewind_grow(rw))) {
+            Chip8RewindFrame* frame = chip8_rewind_frame(rw, rw->frame_count);
+            frame->data = data;
+            frame->size = (uint32_t)size;
+            frame->keyframe = keyframe;
+            rw->frame_count++;
+            rw->bytes_used += size;
+            rw->since_keyframe = keyframe ? 1 : rw->since_keyframe + 1;
+            memcpy(rw->prev, rw->current, CHIP8_STATE_SIZE); // the next delta is against this frame
+            chip8_rewind_evict(rw);
+        } else {
+            // out of memory: drop this frame, prev still matches the newest one held
+            fprintf(stderr, "ERROR: Failed to allocate rewind frame\n");
+            free(data);
+        }
+
+        rw->busy = false;
+        if (rw->queue_count == 0) {
+            pthread_cond_broadcast(&rw->idle_cond);
+        }
+    }
+    pthread_mutex_unlock(&rw->lock);
+    return NULL;
+}
+
+// === Interface ===
+
+Chip8Rewind* chip8_rewind_create(size_t max_bytes, int keyframe_interval) {
+    Chip8Rewind* rw = calloc(1, sizeof(Chip8Rewind));
+    if (!rw) {
+        fprintf(stderr, "ERROR: Failed to allocate rewind buffer\n");
+        return NULL;
+    }
+
+    rw->queue = malloc(QUEUE_SIZE * sizeof(*rw->queue));
+    rw->frames = calloc(INITIAL_FRAMES, sizeof(Chip8RewindFrame));
+    if (!rw->queue || !rw->frames) {
+        fprintf(stderr, "ERROR: Failed to allocate rewind buffer\n");
+        free(rw->queue);
+        free(rw->frames);
+        free(rw);
+        return NULL;
+    }
+
+    rw->frame_capacity = INITIAL_FRAMES;
+    rw->max_bytes = (max_bytes > 0) ? max_bytes : DEFAULT_MAX_BYTES;
+    rw->keyframe_interval = (keyframe_interval > 0) ? keyframe_interval : DEFAULT_KEYFRAME_INTERVAL;
+    pthread_mutex_init(&rw->lock, NULL);
+    pthread_cond_init(&rw->work_cond, NULL);
+    pthread_cond_init(&rw->idle_cond, NULL);
+
+    if (pthread_create(&rw->thread, NULL, chip8_rewind_worker, rw) != 0) {
+        fprintf(stderr, "ERROR: Failed to start rewind worker\n");
+        pthread_cond_destroy(&rw->idle_cond);
+        pthread_cond_destroy(&rw->work_cond);
+        pthread_mutex_destroy(&rw->lock);
+        free(rw->queue);
+        free(rw->frames);
+        free(rw);
+        return NULL;
+    }
+    return rw;
+}
+
+void chip8_rewind_destroy(Chip8Rewind** rewind_ptr) {
+    if (!rewind_ptr || !*rewind_ptr) return;
+    Chip8Rewind* rw = *rewind_ptr;
+
+    pthread_mutex_lock(&rw->lock);
+    rw->stopping = true;
+    pthread_cond_signal(&rw->work_cond);
+    pthread_mutex_unlock(&rw->lock);
+    pthread_join(rw->thread, NULL);
+
+    while (rw->frame_count > 0) {
+        chip8_rewind_drop_oldest(rw);
+    }
+    pthread_cond_destroy(&rw->idle_cond);
+    pthread_cond_destroy(&rw->work_cond);
+    pthread_mutex_destroy(&rw->lock);
+    free(rw->queue);
+    free(rw->frames);
+    free(rw);
+    *rewind_ptr = NULL;
+}
+
+bool chip8_rewind_push(Chip8Rewind* rw, Chip8* chip) {
+    if (!rw || !chip) return false;
+
+    pthread_mutex_lock(&rw->lock);
+    if (rw->queue_count == QUEUE_SIZE) {
+        pthread_mutex_unlock(&rw->lock);
+        return false;
+    }
+
+    int slot = (rw->queue_head + rw->queue_count) % QUEUE_SIZE;
+    chip8_save_state(chip, rw->queue[slot], CHIP8_STATE_SIZE);
+    rw->queue_count++;
+    pthread_cond_signal(&rw->work_cond);
+    pthread_mutex_unlock(&rw->lock);
+    return true;
+}
+
+int chip8_rewind_count(Chip8Rewind* rw) {
+    if (!rw) return 0;
+
+    pthread_mutex_lock(&rw->lock);
+    int count = rw->frame_count + rw->queue_count + (rw->busy ? 1 : 0);
+    pthread_mutex_unlock(&rw->lock);
+    return count;
+}
+
+bool chip8_rewind_seek(Chip8Rewind* rw, int frame, Chip8* chip) {
+    if (!rw || !chip) return false;
+
+    uint8_t state[CHIP8_STATE_SIZE];
+    pthread_mutex_lock(&rw->lock);
+    chip8_rewind_wait_idle(rw);
+
+    bool valid = frame >= 0 && frame < rw->frame_count;
+    if (valid) {
+        chip8_rewind_restore(rw, frame, state);
+    }
+    pthread_mutex_unlock(&rw->lock);
+
+    return valid && chip8_load_state(chip, state, sizeof(state));
+}
+
+void chip8_rewind_truncate(Chip8Rewind* rw, int frame) {
+    if (!rw) return;
+
+    pthread_mutex_lock(&rw->lock);
+    chip8_rewind_wait_idle(rw);
+
+    while (rw->frame_count > 0 && rw->frame_count - 1 > frame) {
+        chip8_rewind_drop_newest(rw);
+    }
+
+    // the next push is encoded against the new newest frame
+    rw->since_keyframe = 0;
+    if (rw->frame_count > 0) {
+        int last = rw->frame_count - 1;
+        while (rw->since_keyframe <= last && !chip8_rewind_frame(rw, last - rw->since_keyframe)->keyframe) {
+            rw->since_keyframe++;
+        }
+        rw->since_keyframe++;
+        chip8_rewind_restore(rw, last, rw->prev);
+    }
+    pthread_mutex_unlock(&rw->lock);
+}
+
+void chip8_rewind_clear(Chip8Rewind* rw) {
+    chip8_rewind_truncate(rw, -1);
+}
+
+size_t chip8_rewind_memory_used(Chip8Rewind* rw) {
+    if (!rw) return 0;
+
+    pthread_mutex_lock(&rw->lock);
+    size_t used = rw->bytes_used;
+    pthread_mutex_unlock(&rw->lock);
+    return used;
+}
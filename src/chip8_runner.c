@@ -0,0 +1,522 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime under -std=c11
+
+#include "../include/chip8_runner.h"
+#include "../include/chip8_break.h"
+#include "../include/chip8_movie.h"
+#include "../include/chip8_undo.h"
+#include "chip8_internal.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+    The command ring is written only by the front end and read only by the thread: the
+    front end fills a slot and publishes tail, the thread reads up to tail and hands the
+    slots back by publishing head. lock only serves to sleep and wake: the thread sets
+    sleeping before its last look at the ring, and the front end looks at sleeping after
+    publishing tail, both sequentially consistent, so a command is either seen or
+    followed by a signal.
+
+    Whoever holds the instance (the thread, or the front end between acquire and
+    release) is the only writer of both publications. Handing it over goes through lock,
+    which orders everything the last holder wrote before what the next one does.
+*/
+
+#define QUEUE_SIZE             256
+#define DEFAULT_CYCLES         10
+#define TURBO_PUBLISH_INTERVAL (1.0 / 240.0) // seconds between state copies in turbo
+#define MAX_LATENESS           0.1           // seconds behind before frames stop catching up
+
+#define DISPLAY_INDEX 3u // index bits of middle
+#define DISPLAY_FRESH 4u // middle was published after the reader last took one
+
+typedef enum {
+    RUNNER_RUN,
+    RUNNER_KEY,
+    RUNNER_SPEED,
+    RUNNER_PARK,
+    RUNNER_CALL,
+    RUNNER_QUIT,
+} Chip8RunnerOp;
+
+typedef struct {
+    uint8_t op;
+    uint8_t key;
+    bool flag;
+    int value;
+    Chip8RunnerCall call;
+    void* arg;
+} Chip8RunnerCommand;
+
+struct Chip8Runner {
+    Chip8* chip;
+    Chip8RunnerFrame on_frame;
+    void* user;
+    pthread_t thread;
+
+    // command ring
+    Chip8RunnerCommand queue[QUEUE_SIZE];
+    atomic_size_t head; // next slot the thread takes
+    atomic_size_t tail; // next slot the front end fills
+    uint64_t sent;      // front end only
+
+    pthread_mutex_t lock;     // guards the counters below and both condition variables
+    pthread_cond_t wake_cond; // a command was queued, or the instance released
+    pthread_cond_t reply_cond; // parked, or a call finished
+    atomic_bool sleeping;
+    uint64_t parks;     // times the thread parked
+    uint64_t releases;  // times the front end released it
+    uint64_t calls;     // calls the thread finished
+    uint64_t park_requests; // front end only
+    uint64_t call_requests; // front end only
+
+    // owned by whoever holds the instance
+    bool running;
+    int stop_reason;
+    int cycles_per_frame;
+    bool turbo;
+    uint64_t frames;
+    uint64_t commands;
+    double next_frame;   // when the next frame is due, outside turbo
+    double last_publish;
+    unsigned back;       // display frame being filled
+
+    // seqlocks: odd while being written
+    atomic_uint sequence;
+    Chip8RunnerState state;
+    atomic_uint profile_sequence;
+    Chip8RunnerProfile profile;
+
+    // triple buffer
+    uint64_t displays[3][CHIP8_DISPLAY_HEIGHT];
+    atomic_uint middle; // frame between the two sides, with DISPLAY_FRESH
+    unsigned front;     // frame the reader has
+};
+
+static double chip8_runner_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+// === Command ring ===
+
+static void chip8_runner_push(Chip8Runner* runner, const Chip8RunnerCommand* command) {
+    size_t tail = atomic_load_explicit(&runner->tail, memory_order_relaxed);
+    while (tail - atomic_load_explicit(&runner->head, memory_order_acquire) == QUEUE_SIZE) {
+        sched_yield(); // full, the thread empties it between frames
+    }
+
+    runner->queue[tail % QUEUE_SIZE] = *command;
+    atomic_store(&runner->tail, tail + 1);
+    runner->sent++;
+
+    if (atomic_load(&runner->sleeping)) {
+        pthread_mutex_lock(&runner->lock);
+        pthread_cond_signal(&runner->wake_cond);
+        pthread_mutex_unlock(&runner->lock);
+    }
+}
+
+static bool chip8_runner_pop(Chip8Runner* runner, Chip8RunnerCommand* command) {
+    size_t head = atomic_load_explicit(&runner->head, memory_order_relaxed);
+    if (head == atomic_load_explicit(&runner->tail, memory_order_acquire)) return false;
+
+    *command = runner->queue[head % QUEUE_SIZE];
+    atomic_store_explicit(&runner->head, head + 1, memory_order_release);
+    return true;
+}
+
+/*
+    Waits for a command, for at most seconds if seconds > 0.
+*/
+static void chip8_runner_sleep(Chip8Runner* runner, double seconds) {
+    pthread_mutex_lock(&runner->lock);
+    atomic_store(&runner->sleeping, true);
+    if (atomic_load(&runner->tail) == atomic_load_explicit(&runner->head, memory_order_relaxed)) {
+        if (seconds > 0) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            long long nanoseconds = until.tv_nsec + (long long)(seconds * 1e9);
+            until.tv_sec += (time_t)(nanoseconds / 1000000000);
+            until.tv_nsec = (long)(nanoseconds % 1000000000);
+            pthread_cond_timedwait(&runner->wake_cond, &runner->lock, &until);
+        } else {
+            pthread_cond_wait(&runner->wake_cond, &runner->lock);
+        }
+    }
+    atomic_store(&runner->sleeping, false);
+    pthread_mutex_unlock(&runner->lock);
+}
+
+// === Publication ===
+
+static void chip8_runner_write_begin(atomic_uint* sequence) {
+    unsigned value = atomic_load_explicit(sequence, memory_order_relaxed);
+    atomic_store_explicit(sequence, value + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void chip8_runner_write_end(atomic_uint* sequence) {
+    unsigned value = atomic_load_explicit(sequence, memory_order_relaxed);
+    atomic_store_explicit(sequence, value + 1, memory_order_release);
+}
+
+// Copies a publication, retrying while a copy overlaps a write
+static void chip8_runner_read(atomic_uint* sequence, void* copy, const void* published, size_t size) {
+    for (;;) {
+        unsigned before = atomic_load_explicit(sequence, memory_order_acquire);
+        if (!(before & 1)) {
+            memcpy(copy, published, size);
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(sequence, memory_order_relaxed) == before) return;
+        }
+        sched_yield(); // a copy takes microseconds
+    }
+}
+
+static void chip8_runner_fill_breakpoints(Chip8* chip, Chip8RunnerState* state) {
+    uint16_t addresses[CHIP8_RUNNER_BREAKPOINTS];
+    state->breakpoint_count = chip8_break_list(chip, addresses, CHIP8_RUNNER_BREAKPOINTS);
+
+    for (int b = 0; b < state->breakpoint_count; b++) {
+        Chip8RunnerBreakpoint* breakpoint = &state->breakpoint_list[b];
+        const char* condition = chip8_break_condition(chip, addresses[b]);
+        breakpoint->address = addresses[b];
+        breakpoint->hits = chip8_break_hits(chip, addresses[b]);
+        snprintf(breakpoint->condition, sizeof(breakpoint->condition), "%s", condition ? condition : "");
+    }
+}
+
+static void chip8_runner_fill(Chip8Runner* runner, Chip8RunnerState* state) {
+    Chip8* chip = runner->chip;
+
+    state->PC = chip->PC;
+    state->I = chip->I;
+    state->SP = chip->SP;
+    state->delay_timer = chip->delay_timer;
+    state->sound_timer = chip->sound_timer;
+    state->halted = chip->halted;
+    memcpy(state->V, chip->V, sizeof(state->V));
+    memcpy(state->stack, chip->stack, sizeof(state->stack));
+    memcpy(state->keys, chip->keys, sizeof(state->keys));
+    state->cycle_count = chip->cycle_count;
+    state->idle_cycles = chip->idle_cycles;
+    memcpy(state->diag_counts, chip->diag_counts, sizeof(state->diag_counts));
+    memcpy(state->memory, chip->memory, sizeof(state->memory));
+    state->backend = chip->backend;
+    state->has_aot = chip->aot != NULL;
+
+    if (chip->breakpoints) {
+        memcpy(state->breakpoints, chip->breakpoints->armed, sizeof(state->breakpoints));
+    } else {
+        memset(state->breakpoints, 0, sizeof(state->breakpoints));
+    }
+    chip8_runner_fill_breakpoints(chip, state);
+    if (chip->watches) {
+        state->watched_registers = chip->watches->registers;
+        memcpy(state->watches, chip->watches->memory, sizeof(state->watches));
+    } else {
+        state->watched_registers = 0;
+        memset(state->watches, 0, sizeof(state->watches));
+    }
+    const Chip8WatchHit* hit = chip8_watch_last_hit(chip);
+    state->has_watch_hit = hit != NULL;
+    if (hit) state->watch_hit = *hit;
+    state->undo_enabled = chip8_undo_is_enabled(chip);
+    state->undo_available = chip8_undo_available(chip);
+    state->profiling = chip8_profile_is_enabled(chip);
+    state->sampling = chip8_sampler_is_running(chip);
+    state->recording = chip8_movie_is_recording(chip);
+    state->tracing = chip8_trace_is_recording(chip);
+
+    state->running = runner->running;
+    state->stop_reason = runner->stop_reason;
+    state->frames = runner->frames;
+    state->commands = runner->commands;
+}
+
+static void chip8_runner_fill_profile(Chip8* chip, Chip8RunnerProfile* profile) {
+    const uint64_t* counters[3] = {
+        chip8_profile_executions(chip), chip8_profile_reads(chip), chip8_profile_writes(chip)
+    };
+    uint64_t* copies[3] = { profile->executions, profile->reads, profile->writes };
+    for (int k = 0; k < 3; k++) {
+        if (counters[k]) {
+            memcpy(copies[k], counters[k], sizeof(profile->executions));
+        } else {
+            memset(copies[k], 0, sizeof(profile->executions));
+        }
+    }
+    profile->hotspot_count = chip8_profile_hotspots(chip, profile->hotspots, CHIP8_RUNNER_HOTSPOTS);
+    profile->routine_count = chip8_profile_routines(chip, profile->routines, CHIP8_RUNNER_ROUTINES);
+
+    const Chip8SampleReport* samples = chip8_sampler_report(chip);
+    if (samples) {
+        profile->samples = *samples;
+    } else {
+        memset(&profile->samples, 0, sizeof(profile->samples));
+    }
+}
+
+static void chip8_runner_publish(Chip8Runner* runner) {
+    chip8_runner_write_begin(&runner->sequence);
+    chip8_runner_fill(runner, &runner->state);
+    chip8_runner_write_end(&runner->sequence);
+
+    // counters and the call tree are over 100 KB, and nobody looks without a profiler on
+    if (runner->state.profiling || runner->state.sampling) {
+        chip8_runner_write_begin(&runner->profile_sequence);
+        chip8_runner_fill_profile(runner->chip, &runner->profile);
+        chip8_runner_write_end(&runner->profile_sequence);
+    }
+}
+
+static void chip8_runner_publish_display(Chip8Runner* runner) {
+    memcpy(runner->displays[runner->back], runner->chip->display, sizeof(runner->displays[0]));
+    unsigned spare = atomic_exchange_explicit(&runner->middle, runner->back | DISPLAY_FRESH, memory_order_acq_rel);
+    runner->back = spare & DISPLAY_INDEX;
+}
+
+// === Thread ===
+
+static void chip8_runner_park(Chip8Runner* runner) {
+    pthread_mutex_lock(&runner->lock);
+    runner->parks++;
+    pthread_cond_broadcast(&runner->reply_cond);
+    while (runner->releases != runner->parks) {
+        pthread_cond_wait(&runner->wake_cond, &runner->lock);
+    }
+    pthread_mutex_unlock(&runner->lock);
+
+    // time spent parked is not caught up on
+    runner->next_frame = chip8_runner_now();
+}
+
+static void chip8_runner_frame(Chip8Runner* runner) {
+    Chip8* chip = runner->chip;
+
+    Chip8StopReason reason = chip8_run_until(chip, (uint64_t)runner->cycles_per_frame);
+    chip8_update_timers(chip);
+    runner->frames++;
+    if (reason != CHIP8_STOP_BUDGET) {
+        runner->running = false;
+        runner->stop_reason = reason;
+    }
+
+    if (runner->on_frame) runner->on_frame(chip, runner->user);
+    if (chip8_take_dirty_rows(chip)) chip8_runner_publish_display(runner);
+}
+
+static void* chip8_runner_main(void* arg) {
+    Chip8Runner* runner = arg;
+
+    for (;;) {
+        Chip8RunnerCommand command;
+        bool taken = false;
+        while (chip8_runner_pop(runner, &command)) {
+            runner->commands++;
+            taken = true;
+
+            switch (command.op) {
+                case RUNNER_RUN:
+                    runner->running = command.flag && !runner->chip->halted;
+                    runner->stop_reason = -1;
+                    runner->next_frame = chip8_runner_now();
+                    break;
+                case RUNNER_KEY:
+                    if (command.flag) {
+                        chip8_key_press(runner->chip, command.key);
+                    } else {
+                        chip8_key_release(runner->chip, command.key);
+                    }
+                    break;
+                case RUNNER_SPEED:
+                    runner->cycles_per_frame = command.value;
+                    runner->turbo = command.flag;
+                    break;
+                case RUNNER_PARK:
+                    chip8_runner_park(runner);
+                    break;
+                case RUNNER_CALL:
+                    command.call(runner->chip, command.arg);
+                    pthread_mutex_lock(&runner->lock);
+                    runner->calls++;
+                    pthread_cond_broadcast(&runner->reply_cond);
+                    pthread_mutex_unlock(&runner->lock);
+                    break;
+                case RUNNER_QUIT:
+                    return NULL;
+            }
+        }
+
+        if (!runner->running) {
+            if (taken) chip8_runner_publish(runner); // key presses and pauses show while paused
+            chip8_runner_sleep(runner, 0);
+            continue;
+        }
+
+        double now = chip8_runner_now();
+        if (!runner->turbo && now < runner->next_frame) {
+            if (taken) chip8_runner_publish(runner);
+            chip8_runner_sleep(runner, runner->next_frame - now);
+            continue;
+        }
+        // a thread that fell far behind (a stalled machine) starts afresh instead of racing to catch up
+        runner->next_frame = (now - runner->next_frame > MAX_LATENESS) ? now : runner->next_frame;
+        runner->next_frame += 1.0 / CHIP8_RUNNER_HZ;
+
+        chip8_runner_frame(runner);
+        if (!runner->turbo || !runner->running || now - runner->last_publish >= TURBO_PUBLISH_INTERVAL) {
+            chip8_runner_publish(runner);
+            runner->last_publish = now;
+        }
+    }
+}
+
+// === Interface ===
+
+Chip8Runner* chip8_runner_create(Chip8* chip, Chip8RunnerFrame on_frame, void* user) {
+    if (!chip) {
+        fprintf(stderr, "ERROR: Invalid instance of Chip-8 emulator while creating a runner\n");
+        return NULL;
+    }
+
+    Chip8Runner* runner = calloc(1, sizeof(Chip8Runner));
+    if (!runner) {
+        fprintf(stderr, "ERROR: Failed to allocate runner\n");
+        return NULL;
+    }
+
+    runner->chip = chip;
+    runner->on_frame = on_frame;
+    runner->user = user;
+    runner->stop_reason = -1;
+    runner->cycles_per_frame = DEFAULT_CYCLES;
+    runner->back = 0;
+    atomic_init(&runner->middle, 1);
+    runner->front = 2;
+    chip8_runner_publish(runner);
+    chip8_runner_publish_display(runner);
+
+    pthread_mutex_init(&runner->lock, NULL);
+    pthread_cond_init(&runner->wake_cond, NULL);
+    pthread_cond_init(&runner->reply_cond, NULL);
+
+    if (pthread_create(&runner->thread, NULL, chip8_runner_main, runner) != 0) {
+        fprintf(stderr, "ERROR: Failed to start runner thread\n");
+        pthread_cond_destroy(&runner->reply_cond);
+        pthread_cond_destroy(&runner->wake_cond);
+        pthread_mutex_destroy(&runner->lock);
+        free(runner);
+        return NULL;
+    }
+    return runner;
+}
+
+void chip8_runner_destroy(Chip8Runner** runner_ptr) {
+    if (!runner_ptr || !*runner_ptr) return;
+    Chip8Runner* runner = *runner_ptr;
+
+    Chip8RunnerCommand command = { .op = RUNNER_QUIT };
+    chip8_runner_push(runner, &command);
+    pthread_join(runner->thread, NULL);
+
+    pthread_cond_destroy(&runner->reply_cond);
+    pthread_cond_destroy(&runner->wake_cond);
+    pthread_mutex_destroy(&runner->lock);
+    free(runner);
+    *runner_ptr = NULL;
+}
+
+void chip8_runner_run(Chip8Runner* runner, bool run) {
+    if (!runner) return;
+
+    Chip8RunnerCommand command = { .op = RUNNER_RUN, .flag = run };
+    chip8_runner_push(runner, &command);
+}
+
+void chip8_runner_set_key(Chip8Runner* runner, uint8_t key, bool pressed) {
+    if (!runner || key >= CHIP8_NUM_KEYS) return;
+
+    Chip8RunnerCommand command = { .op = RUNNER_KEY, .key = key, .flag = pressed };
+    chip8_runner_push(runner, &command);
+}
+
+void chip8_runner_set_speed(Chip8Runner* runner, int cycles_per_frame, bool turbo) {
+    if (!runner || cycles_per_frame <= 0) return;
+
+    Chip8RunnerCommand command = { .op = RUNNER_SPEED, .value = cycles_per_frame, .flag = turbo };
+    chip8_runner_push(runner, &command);
+}
+
+uint64_t chip8_runner_sent(Chip8Runner* runner) {
+    return runner ? runner->sent : 0;
+}
+
+Chip8* chip8_runner_acquire(Chip8Runner* runner) {
+    if (!runner) return NULL;
+
+    uint64_t park = ++runner->park_requests;
+    Chip8RunnerCommand command = { .op = RUNNER_PARK };
+    chip8_runner_push(runner, &command);
+
+    pthread_mutex_lock(&runner->lock);
+    while (runner->parks < park) {
+        pthread_cond_wait(&runner->reply_cond, &runner->lock);
+    }
+    pthread_mutex_unlock(&runner->lock);
+    return runner->chip;
+}
+
+void chip8_runner_release(Chip8Runner* runner) {
+    if (!runner) return;
+
+    // what the holder did is not in the dirty rows the thread looks at
+    chip8_take_dirty_rows(runner->chip);
+    runner->running = runner->running && !runner->chip->halted;
+    chip8_runner_publish(runner);
+    chip8_runner_publish_display(runner);
+
+    pthread_mutex_lock(&runner->lock);
+    runner->releases++;
+    pthread_cond_broadcast(&runner->wake_cond);
+    pthread_mutex_unlock(&runner->lock);
+}
+
+void chip8_runner_call(Chip8Runner* runner, Chip8RunnerCall fn, void* arg) {
+    if (!runner || !fn) return;
+
+    uint64_t call = ++runner->call_requests;
+    Chip8RunnerCommand command = { .op = RUNNER_CALL, .call = fn, .arg = arg };
+    chip8_runner_push(runner, &command);
+
+    pthread_mutex_lock(&runner->lock);
+    while (runner->calls < call) {
+        pthread_cond_wait(&runner->reply_cond, &runner->lock);
+    }
+    pthread_mutex_unlock(&runner->lock);
+}
+
+void chip8_runner_read_state(Chip8Runner* runner, Chip8RunnerState* state) {
+    if (!runner || !state) return;
+    chip8_runner_read(&runner->sequence, state, &runner->state, sizeof(*state));
+}
+
+void chip8_runner_read_profile(Chip8Runner* runner, Chip8RunnerProfile* profile) {
+    if (!runner || !profile) return;
+    chip8_runner_read(&runner->profile_sequence, profile, &runner->profile, sizeof(*profile));
+}
+
+const uint64_t* chip8_runner_take_display(Chip8Runner* runner) {
+    if (!runner) return NULL;
+    if (!(atomic_load_explicit(&runner->middle, memory_order_acquire) & DISPLAY_FRESH)) return NULL;
+
+    unsigned newest = atomic_exchange_explicit(&runner->middle, runner->front, memory_order_acq_rel);
+    runner->front = newest & DISPLAY_INDEX;
+    return runner->displays[runner->front];
+}
@@ -0,0 +1,361 @@
+#define _DEFAULT_SOURCE // sysconf(_SC_NPROCESSORS_ONLN)
+
+#include "../include/chip8_runtime.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+    Each worker owns a FIFO queue of tasks. A worker takes from the front of its own queue
+    and, when that is empty, from the front of a randomly chosen other queue. A task that
+    still has budget after its slice goes to the back of the queue of the worker that ran
+    it, so instances sharing a worker take turns instead of one running to completion.
+
+    Workers with nothing to do sleep on work_cond. queued and sleeping are updated with
+    sequentially consistent atomics on both sides, so a push either sees the sleeper and
+    signals it, or the sleeper sees the queued task before it waits.
+*/
+
+#define DEFAULT_SLICE_FRAMES  16
+#define INITIAL_QUEUE_SIZE    64
+
+typedef struct {
+    Chip8* chip;
+    Chip8RuntimeJob job;
+    uint64_t remaining;  // cycles left in the budget
+    int frame_cycles;    // cycles run in the current frame
+} Chip8Task;
+
+typedef struct {
+    pthread_mutex_t lock;
+    Chip8Task** items;   // ring buffer
+    size_t head;
+    size_t count;
+    size_t capacity;
+} Chip8TaskQueue;
+
+typedef struct {
+    Chip8Runtime* rt;
+    pthread_t thread;
+    Chip8TaskQueue queue;
+    uint32_t victim_seed; // picks where to start stealing
+} Chip8Worker;
+
+struct Chip8Runtime {
+    Chip8Worker* workers;
+    int thread_count;
+    int slice_frames;
+
+    atomic_size_t queued;   // tasks sitting in any queue
+    atomic_size_t pending;  // tasks submitted and not completed yet
+    atomic_int sleeping;    // workers waiting on work_cond
+    atomic_uint next_queue; // round-robin target for submissions
+
+    pthread_mutex_t lock;   // guards stopping and both condition variables
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    bool stopping;
+};
+
+// === Queues ===
+
+static bool chip8_queue_init(Chip8TaskQueue* queue) {
+    queue->items = malloc(INITIAL_QUEUE_SIZE * sizeof(Chip8Task*));
+    if (!queue->items) return false;
+
+    queue->head = 0;
+    queue->count = 0;
+    queue->capacity = INITIAL_QUEUE_SIZE;
+    pthread_mutex_init(&queue->lock, NULL);
+    return true;
+}
+
+static void chip8_queue_free(Chip8TaskQueue* queue) {
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+}
+
+static bool chip8_queue_push(Chip8TaskQueue* queue, Chip8Task* task) {
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->count == queue->capacity) {
+        size_t capacity = queue->capacity * 2;
+        Chip8Task** items = malloc(capacity * sizeof(Chip8Task*));
+        if (!items) {
+            pthread_mutex_unlock(&queue->lock);
+            return false;
+        }
+        for (size_t i = 0; i < queue->count; i++) {
+            items[i] = queue->items[(queue->head + i) % queue->capacity];
+        }
+        free(queue->items);
+        queue->items = items;
+        queue->head = 0;
+        queue->capacity = capacity;
+    }
+
+    queue->items[(queue->head + queue->count) % queue->capacity] = task;
+    queue->count++;
+
+    pthread_mutex_unlock(&queue->lock);
+    return true;
+}
+
+static Chip8Task* chip8_queue_pop(Chip8TaskQueue* queue) {
+    Chip8Task* task = NULL;
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->count > 0) {
+        task = queue->items[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return task;
+}
+
+// === Scheduling ===
+
+static void chip8_runtime_wake(Chip8Runtime* rt) {
+    if (atomic_load(&rt->sleeping) == 0) return;
+
+    pthread_mutex_lock(&rt->lock);
+    pthread_cond_signal(&rt->work_cond);
+    pthread_mutex_unlock(&rt->lock);
+}
+
+static bool chip8_runtime_enqueue(Chip8Runtime* rt, Chip8Worker* worker, Chip8Task* task) {
+    // count first so queued never drops below what the queues hold
+    atomic_fetch_add(&rt->queued, 1);
+    if (!chip8_queue_push(&worker->queue, task)) {
+        atomic_fetch_sub(&rt->queued, 1);
+        return false;
+    }
+
+    chip8_runtime_wake(rt);
+    return true;
+}
+
+static Chip8Task* chip8_runtime_take(Chip8Runtime* rt, Chip8Worker* self) {
+    Chip8Task* task = chip8_queue_pop(&self->queue);
+
+    if (!task && atomic_load(&rt->queued) > 0) {
+        // xorshift32, only used to spread thieves over the victims
+        uint32_t r = self->victim_seed;
+        r ^= r << 13;
+        r ^= r >> 17;
+        r ^= r << 5;
+        self->victim_seed = r;
+
+        int start = (int)(r % (uint32_t)rt->thread_count);
+        for (int i = 0; i < rt->thread_count && !task; i++) {
+            Chip8Worker* victim = &rt->workers[(start + i) % rt->thread_count];
+            if (victim != self) {
+                task = chip8_queue_pop(&victim->queue);
+            }
+        }
+    }
+
+    if (task) {
+        atomic_fetch_sub(&rt->queued, 1);
+    }
+    return task;
+}
+
+/*
+    Runs one slice of the task. Returns true once its budget is spent or the instance halted.
+*/
+static bool chip8_runtime_run_slice(Chip8Runtime* rt, Chip8Task* task) {
+    Chip8* chip = task->chip;
+    int cycles_per_frame = task->job.cycles_per_frame;
+
+    for (int frame = 0; frame < rt->slice_frames; ) {
+        if (task->remaining == 0 || chip8_is_halted(chip)) return true;
+
+        int want = cycles_per_frame - task->frame_cycles;
+        if ((uint64_t)want > task->remaining) want = (int)task->remaining;
+
+        int ran = chip8_step_n(chip, want);
+        if (ran <= 0) return true;
+
+        task->remaining -= (uint64_t)ran;
+        task->frame_cycles += ran;
+        if (task->frame_cycles == cycles_per_frame) {
+            chip8_update_timers(chip);
+            task->frame_cycles = 0;
+            frame++;
+        }
+    }
+
+    return task->remaining == 0 || chip8_is_halted(chip);
+}
+
+static void chip8_runtime_release(Chip8Runtime* rt) {
+    if (atomic_fetch_sub(&rt->pending, 1) == 1) {
+        pthread_mutex_lock(&rt->lock);
+        pthread_cond_broadcast(&rt->done_cond);
+        pthread_mutex_unlock(&rt->lock);
+    }
+}
+
+static void chip8_runtime_complete(Chip8Runtime* rt, Chip8Task* task) {
+    if (task->job.done) {
+        task->job.done(task->chip, task->job.user);
+    }
+    free(task);
+    chip8_runtime_release(rt);
+}
+
+static void* chip8_runtime_worker(void* arg) {
+    Chip8Worker* self = arg;
+    Chip8Runtime* rt = self->rt;
+
+    for (;;) {
+        Chip8Task* task = chip8_runtime_take(rt, self);
+        if (task) {
+            if (chip8_runtime_run_slice(rt, task) || !chip8_runtime_enqueue(rt, self, task)) {
+                chip8_runtime_complete(rt, task);
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&rt->lock);
+        atomic_fetch_add(&rt->sleeping, 1);
+        while (atomic_load(&rt->queued) == 0 && !rt->stopping) {
+            pthread_cond_wait(&rt->work_cond, &rt->lock);
+        }
+        atomic_fetch_sub(&rt->sleeping, 1);
+        bool stop = rt->stopping && atomic_load(&rt->queued) == 0;
+        pthread_mutex_unlock(&rt->lock);
+
+        if (stop) break;
+    }
+
+    return NULL;
+}
+
+// === Interface ===
+
+Chip8Runtime* chip8_runtime_create(int threads, int slice_frames) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (int)cpus : 1;
+    }
+
+    Chip8Runtime* rt = calloc(1, sizeof(Chip8Runtime));
+    if (!rt) {
+        fprintf(stderr, "ERROR: Failed to allocate Chip-8 runtime\n");
+        return NULL;
+    }
+
+    rt->workers = calloc((size_t)threads, sizeof(Chip8Worker));
+    if (!rt->workers) {
+        fprintf(stderr, "ERROR: Failed to allocate Chip-8 runtime workers\n");
+        free(rt);
+        return NULL;
+    }
+
+    rt->slice_frames = (slice_frames > 0) ? slice_frames : DEFAULT_SLICE_FRAMES;
+    atomic_init(&rt->queued, 0);
+    atomic_init(&rt->pending, 0);
+    atomic_init(&rt->sleeping, 0);
+    atomic_init(&rt->next_queue, 0);
+    pthread_mutex_init(&rt->lock, NULL);
+    pthread_cond_init(&rt->work_cond, NULL);
+    pthread_cond_init(&rt->done_cond, NULL);
+
+    // workers read thread_count to pick victims, so it is stored once, after the last
+    // one started and before any task can make them look
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        Chip8Worker* worker = &rt->workers[i];
+        worker->rt = rt;
+        worker->victim_seed = 0x9E3779B9u * (uint32_t)(i + 1);
+
+        if (!chip8_queue_init(&worker->queue)) {
+            fprintf(stderr, "ERROR: Failed to allocate Chip-8 runtime queue\n");
+            break;
+        }
+        if (pthread_create(&worker->thread, NULL, chip8_runtime_worker, worker) != 0) {
+            fprintf(stderr, "ERROR: Failed to start Chip-8 runtime worker\n");
+            chip8_queue_free(&worker->queue);
+            break;
+        }
+        started++;
+    }
+    rt->thread_count = started;
+
+    if (started < threads) {
+        chip8_runtime_destroy(&rt);
+        return NULL;
+    }
+    return rt;
+}
+
+void chip8_runtime_destroy(Chip8Runtime** rt_ptr) {
+    if (!rt_ptr || !*rt_ptr) return;
+    Chip8Runtime* rt = *rt_ptr;
+
+    chip8_runtime_wait(rt);
+
+    pthread_mutex_lock(&rt->lock);
+    rt->stopping = true;
+    pthread_cond_broadcast(&rt->work_cond);
+    pthread_mutex_unlock(&rt->lock);
+
+    for (int i = 0; i < rt->thread_count; i++) {
+        pthread_join(rt->workers[i].thread, NULL);
+        chip8_queue_free(&rt->workers[i].queue);
+    }
+
+    pthread_cond_destroy(&rt->done_cond);
+    pthread_cond_destroy(&rt->work_cond);
+    pthread_mutex_destroy(&rt->lock);
+    free(rt->workers);
+    free(rt);
+    *rt_ptr = NULL;
+}
+
+bool chip8_runtime_submit(Chip8Runtime* rt, Chip8* chip, const Chip8RuntimeJob* job) {
+    if (!rt || !chip || !job || job->cycles_per_frame <= 0) {
+        fprintf(stderr, "ERROR: Invalid runtime, instance or job while submitting\n");
+        return false;
+    }
+
+    Chip8Task* task = calloc(1, sizeof(Chip8Task));
+    if (!task) {
+        fprintf(stderr, "ERROR: Failed to allocate runtime task\n");
+        return false;
+    }
+    task->chip = chip;
+    task->job = *job;
+    task->remaining = job->cycles;
+
+    atomic_fetch_add(&rt->pending, 1);
+
+    unsigned target = atomic_fetch_add(&rt->next_queue, 1) % (unsigned)rt->thread_count;
+    if (!chip8_runtime_enqueue(rt, &rt->workers[target], task)) {
+        fprintf(stderr, "ERROR: Failed to queue runtime task\n");
+        free(task);
+        chip8_runtime_release(rt);
+        return false;
+    }
+    return true;
+}
+
+void chip8_runtime_wait(Chip8Runtime* rt) {
+    if (!rt) return;
+
+    pthread_mutex_lock(&rt->lock);
+    while (atomic_load(&rt->pending) > 0) {
+        pthread_cond_wait(&rt->done_cond, &rt->lock);
+    }
+    pthread_mutex_unlock(&rt->lock);
+}
+
+int chip8_runtime_thread_count(Chip8Runtime* rt) {
+    return rt ? rt->thread_count : 0;
+}
@@ -0,0 +1,342 @@
+#define _GNU_SOURCE // timer_create, SIGEV_THREAD_ID and gettid under -std=c11
+
+#include "../include/chip8_sampler.h"
+#include "chip8_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    The signal handler is the only producer and the poll, under drain_lock, the only
+    consumer of a single-producer single-consumer ring: the handler writes a slot and
+    then publishes head with release order, the poll reads up to head with acquire
+    order and hands the slots back by publishing tail. Neither side ever waits, and
+    the handler touches nothing but the ring, so it can interrupt the emulation thread
+    anywhere, the poll included.
+*/
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHIP8_HAVE_SAMPLER 1
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#define CHIP8_THREAD_TIMER 1
+#include <sys/syscall.h>
+#ifndef sigev_notify_thread_id // older glibc leaves it out
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#else
+#define CHIP8_THREAD_TIMER 0
+#endif
+#else
+#define CHIP8_HAVE_SAMPLER 0
+#endif
+
+#define RING_SIZE (64 * 1024) // samples; over a minute at the default rate
+#define RING_MASK (RING_SIZE - 1)
+
+typedef struct {
+    uint16_t pc;
+    uint8_t sp;
+    uint8_t phase;
+} Chip8Sample;
+
+#if CHIP8_HAVE_SAMPLER
+
+struct Chip8Sampler {
+    Chip8* chip;
+    pthread_t thread;
+#if CHIP8_THREAD_TIMER
+    timer_t timer;
+#endif
+    struct sigaction previous;
+
+    _Atomic uint32_t head; // next slot the handler fills
+    _Atomic uint32_t tail; // next slot the poll reads
+    _Atomic uint64_t dropped;
+    Chip8Sample ring[RING_SIZE];
+
+    pthread_mutex_t drain_lock;
+    Chip8SampleReport report;
+};
+
+// the instance the handler samples; at most one per process
+static Chip8Sampler* _Atomic active_sampler;
+
+static void chip8_sampler_signal(int sig, siginfo_t* info, void* context) {
+    (void)sig;
+    (void)info;
+    (void)context;
+
+    Chip8Sampler* sampler = atomic_load_explicit(&active_sampler, memory_order_acquire);
+    if (!sampler) return;
+#if !CHIP8_THREAD_TIMER
+    // ITIMER_PROF signals whichever thread is running
+    if (!pthread_equal(pthread_self(), sampler->thread)) return;
+#endif
+
+    uint32_t head = atomic_load_explicit(&sampler->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&sampler->tail, memory_order_acquire);
+    if (head - tail >= RING_SIZE) {
+        atomic_fetch_add_explicit(&sampler->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    Chip8* chip = sampler->chip;
+    sampler->ring[head & RING_MASK] = (Chip8Sample){
+        .pc = chip->PC,
+        .sp = chip->SP,
+        .phase = chip->phase,
+    };
+    atomic_store_explicit(&sampler->head, head + 1, memory_order_release);
+}
+
+static bool chip8_sampler_arm(Chip8Sampler* sampler, int hz) {
+    long interval_ns = 1000000000L / hz;
+    if (interval_ns < 1) interval_ns = 1;
+
+#if CHIP8_THREAD_TIMER
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    if (timer_create(CLOCK_MONOTONIC, &event, &sampler->timer) != 0) {
+        fprintf(stderr, "ERROR: Failed to create the sampling timer: %s\n", strerror(errno));
+        return false;
+    }
+
+    struct itimerspec spec = {
+        .it_interval = { interval_ns / 1000000000L, interval_ns % 1000000000L },
+        .it_value = { interval_ns / 1000000000L, interval_ns % 1000000000L },
+    };
+    if (timer_settime(sampler->timer, 0, &spec, NULL) != 0) {
+        fprintf(stderr, "ERROR: Failed to start the sampling timer: %s\n", strerror(errno));
+        timer_delete(sampler->timer);
+        return false;
+    }
+#else
+    long interval_us = interval_ns / 1000;
+    if (interval_us < 1) interval_us = 1;
+    struct itimerval spec = {
+        .it_interval = { interval_us / 1000000L, interval_us % 1000000L },
+        .it_value = { interval_us / 1000000L, interval_us % 1000000L },
+    };
+    if (setitimer(ITIMER_PROF, &spec, NULL) != 0) {
+        fprintf(stderr, "ERROR: Failed to start the sampling timer: %s\n", strerror(errno));
+        return false;
+    }
+#endif
+    return true;
+}
+
+static void chip8_sampler_disarm(Chip8Sampler* sampler) {
+#if CHIP8_THREAD_TIMER
+    timer_delete(sampler->timer);
+#else
+    (void)sampler;
+    struct itimerval off;
+    memset(&off, 0, sizeof(off));
+    setitimer(ITIMER_PROF, &off, NULL);
+#endif
+}
+
+bool chip8_sampler_start(Chip8* chip, int hz) {
+    if (!chip) {
+        fprintf(stderr, "ERROR: Invalid instance of Chip-8 emulator while starting the sampler\n");
+        return false;
+    }
+    if (chip->sampler) return false;
+    if (hz <= 0) hz = CHIP8_SAMPLER_DEFAULT_HZ;
+
+    Chip8Sampler* sampler = calloc(1, sizeof(Chip8Sampler));
+    if (!sampler) {
+        fprintf(stderr, "ERROR: Failed to allocate the sampler\n");
+        return false;
+    }
+    sampler->chip = chip;
+    sampler->thread = pthread_self();
+    pthread_mutex_init(&sampler->drain_lock, NULL);
+
+    Chip8Sampler* expected = NULL;
+    if (!atomic_compare_exchange_strong(&active_sampler, &expected, sampler)) {
+        fprintf(stderr, "ERROR: Another instance is already being sampled\n");
+        pthread_mutex_destroy(&sampler->drain_lock);
+        free(sampler);
+        return false;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = chip8_sampler_signal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &sampler->previous) != 0) {
+        fprintf(stderr, "ERROR: Failed to install the SIGPROF handler: %s\n", strerror(errno));
+        atomic_store(&active_sampler, NULL);
+        pthread_mutex_destroy(&sampler->drain_lock);
+        free(sampler);
+        return false;
+    }
+
+    if (!chip8_sampler_arm(sampler, hz)) {
+        sigaction(SIGPROF, &sampler->previous, NULL);
+        atomic_store(&active_sampler, NULL);
+        pthread_mutex_destroy(&sampler->drain_lock);
+        free(sampler);
+        return false;
+    }
+
+    chip->sampler = sampler;
+    return true;
+}
+
+void chip8_sampler_stop(Chip8* chip) {
+    if (!chip || !chip->sampler) return;
+
+    // on the sampled thread (see the header), so the handler is not running, and
+    // deleting the timer discards a signal it still had pending
+    Chip8Sampler* sampler = chip->sampler;
+    chip8_sampler_disarm(sampler);
+    // a signal already pending finds no sampler and returns
+    atomic_store(&active_sampler, NULL);
+    sigaction(SIGPROF, &sampler->previous, NULL);
+
+    pthread_mutex_destroy(&sampler->drain_lock);
+    free(sampler);
+    chip->sampler = NULL;
+}
+
+static void chip8_sampler_drain(Chip8Sampler* sampler) {
+    uint32_t tail = atomic_load_explicit(&sampler->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&sampler->head, memory_order_acquire);
+    Chip8SampleReport* report = &sampler->report;
+
+    for (; tail != head; tail++) {
+        Chip8Sample sample = sampler->ring[tail & RING_MASK];
+        uint8_t phase = (sample.phase < CHIP8_PHASE_COUNT) ? sample.phase : CHIP8_PHASE_HOST;
+        report->samples++;
+        report->phases[phase]++;
+        report->depths[(sample.sp <= CHIP8_STACK_SIZE) ? sample.sp : CHIP8_STACK_SIZE]++;
+        if (phase != CHIP8_PHASE_HOST) report->pcs[CHIP8_ADDR(sample.pc)]++;
+    }
+    atomic_store_explicit(&sampler->tail, tail, memory_order_release);
+    report->dropped = atomic_load_explicit(&sampler->dropped, memory_order_relaxed);
+}
+
+void chip8_sampler_poll(Chip8* chip) {
+    Chip8Sampler* sampler = chip->sampler;
+    if (atomic_load_explicit(&sampler->head, memory_order_relaxed) ==
+        atomic_load_explicit(&sampler->tail, memory_order_relaxed)) {
+        return;
+    }
+
+    // a report being read on another thread drains for us
+    if (pthread_mutex_trylock(&sampler->drain_lock) != 0) return;
+    chip8_sampler_drain(sampler);
+    pthread_mutex_unlock(&sampler->drain_lock);
+}
+
+void chip8_sampler_reset(Chip8* chip) {
+    if (!chip || !chip->sampler) return;
+
+    Chip8Sampler* sampler = chip->sampler;
+    pthread_mutex_lock(&sampler->drain_lock);
+    chip8_sampler_drain(sampler);
+    atomic_store_explicit(&sampler->dropped, 0, memory_order_relaxed);
+    memset(&sampler->report, 0, sizeof(sampler->report));
+    pthread_mutex_unlock(&sampler->drain_lock);
+}
+
+const Chip8SampleReport* chip8_sampler_report(Chip8* chip) {
+    if (!chip || !chip->sampler) return NULL;
+
+    Chip8Sampler* sampler = chip->sampler;
+    pthread_mutex_lock(&sampler->drain_lock);
+    chip8_sampler_drain(sampler);
+    pthread_mutex_unlock(&sampler->drain_lock);
+    return &sampler->report;
+}
+
+#else // no SIGPROF on this host
+
+struct Chip8Sampler {
+    Chip8SampleReport report;
+};
+
+bool chip8_sampler_start(Chip8* chip, int hz) {
+    (void)chip;
+    (void)hz;
+    fprintf(stderr, "ERROR: The sampler is not supported on this platform\n");
+    return false;
+}
+
+void chip8_sampler_stop(Chip8* chip) { (void)chip; }
+void chip8_sampler_poll(Chip8* chip) { (void)chip; }
+void chip8_sampler_reset(Chip8* chip) { (void)chip; }
+
+const Chip8SampleReport* chip8_sampler_report(Chip8* chip) {
+    (void)chip;
+    return NULL;
+}
+
+#endif
+
+bool chip8_sampler_is_running(Chip8* chip) {
+    return chip && chip->sampler;
+}
+
+static const char* const PHASE_NAMES[CHIP8_PHASE_COUNT] = {
+    "host", "interpreter", "translated", "compiler",
+};
+
+void chip8_sampler_print_report(Chip8* chip, FILE* out, int top) {
+    const Chip8SampleReport* report = chip8_sampler_report(chip);
+    if (!report || !out) return;
+
+    uint64_t total = report->samples ? report->samples : 1;
+    fprintf(out, "%llu samples, %llu dropped\n",
+            (unsigned long long)report->samples, (unsigned long long)report->dropped);
+
+    fprintf(out, "\nphase\n");
+    for (int phase = 0; phase < CHIP8_PHASE_COUNT; phase++) {
+        fprintf(out, "  %-12s %10llu  %5.1f%%\n", PHASE_NAMES[phase],
+                (unsigned long long)report->phases[phase], 100.0 * report->phases[phase] / total);
+    }
+
+    fprintf(out, "\nstack depth\n");
+    for (int depth = 0; depth <= CHIP8_STACK_SIZE; depth++) {
+        if (!report->depths[depth]) continue;
+        fprintf(out, "  %-12d %10llu  %5.1f%%\n", depth,
+                (unsigned long long)report->depths[depth], 100.0 * report->depths[depth] / total);
+    }
+
+    // selection of the top addresses; top is small
+    uint64_t guest = report->samples - report->phases[CHIP8_PHASE_HOST];
+    fprintf(out, "\naddress (of %llu guest samples)\n", (unsigned long long)guest);
+    if (!guest) return;
+
+    bool* shown = calloc(CHIP8_MEMORY_SIZE, sizeof(bool));
+    if (!shown) return;
+    for (int rank = 0; rank < top; rank++) {
+        int best = -1;
+        for (int address = 0; address < CHIP8_MEMORY_SIZE; address++) {
+            if (shown[address] || !report->pcs[address]) continue;
+            if (best < 0 || report->pcs[address] > report->pcs[best]) best = address;
+        }
+        if (best < 0) break;
+        shown[best] = true;
+
+        char text[32];
+        uint16_t opcode = (uint16_t)(chip->memory[best] << 8 | chip->memory[CHIP8_ADDR(best + 1)]);
+        chip8_disassemble_opcode(opcode, text, sizeof(text));
+        fprintf(out, "  0x%03X %-20s %10llu  %5.1f%%\n", best, text,
+                (unsigned long long)report->pcs[best], 100.0 * report->pcs[best] / guest);
+    }
+    free(shown);
+}
@@ -0,0 +1,194 @@
+#include "../include/chip8_snapshot.h"
+#include "chip8_internal.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(CHIP8_PAGE_COUNT <= 16, "dirty_pages has one bit per page");
+
+typedef struct {
+    atomic_int refs;
+    uint8_t bytes[CHIP8_PAGE_SIZE];
+} Chip8Page;
+
+struct Chip8Snapshot {
+    atomic_int refs;
+    Chip8Page* pages[CHIP8_PAGE_COUNT];
+
+    // everything else chip8_save_state covers
+    uint64_t display[CHIP8_DISPLAY_HEIGHT];
+    uint16_t V[CHIP8_NUM_REGISTERS];
+    uint16_t stack[CHIP8_STACK_SIZE];
+    uint16_t PC;
+    uint16_t I;
+    uint8_t SP;
+    uint8_t delay_timer;
+    uint8_t sound_timer;
+    bool halted;
+    bool draw_flag;
+    bool keys[CHIP8_NUM_KEYS];
+    uint64_t cycle_count;
+    uint64_t idle_cycles;
+    uint64_t rand_seed;
+    uint64_t rand_state;
+};
+
+static atomic_size_t g_live_pages;
+
+// === Pages ===
+
+static Chip8Page* chip8_page_create(const uint8_t* bytes) {
+    Chip8Page* page = malloc(sizeof(Chip8Page));
+    if (!page) return NULL;
+
+    atomic_init(&page->refs, 1);
+    memcpy(page->bytes, bytes, CHIP8_PAGE_SIZE);
+    atomic_fetch_add_explicit(&g_live_pages, 1, memory_order_relaxed);
+    return page;
+}
+
+static Chip8Page* chip8_page_retain(Chip8Page* page) {
+    atomic_fetch_add_explicit(&page->refs, 1, memory_order_relaxed);
+    return page;
+}
+
+static void chip8_page_release(Chip8Page* page) {
+    if (!page || atomic_fetch_sub_explicit(&page->refs, 1, memory_order_acq_rel) != 1) return;
+
+    atomic_fetch_sub_explicit(&g_live_pages, 1, memory_order_relaxed);
+    free(page);
+}
+
+// === Snapshots ===
+
+Chip8Snapshot* chip8_snapshot_take(Chip8* chip) {
+    if (!chip) {
+        fprintf(stderr, "ERROR: Invalid instance of Chip-8 emulator while taking a snapshot\n");
+        return NULL;
+    }
+
+    Chip8Snapshot* snapshot = calloc(1, sizeof(Chip8Snapshot));
+    if (!snapshot) {
+        fprintf(stderr, "ERROR: Failed to allocate snapshot\n");
+        return NULL;
+    }
+    atomic_init(&snapshot->refs, 2); // the caller's and chip->snapshot
+
+    const Chip8Snapshot* base = chip->snapshot;
+    for (int p = 0; p < CHIP8_PAGE_COUNT; p++) {
+        const uint8_t* bytes = chip->memory + p * CHIP8_PAGE_SIZE;
+
+        // a written page may still hold what it did, e.g. a score stored back unchanged
+        if (base && (!((chip->dirty_pages >> p) & 1) ||
+                     memcmp(base->pages[p]->bytes, bytes, CHIP8_PAGE_SIZE) == 0)) {
+            snapshot->pages[p] = chip8_page_retain(base->pages[p]);
+            continue;
+        }
+
+        snapshot->pages[p] = chip8_page_create(bytes);
+        if (!snapshot->pages[p]) {
+            fprintf(stderr, "ERROR: Failed to allocate snapshot page\n");
+            atomic_store(&snapshot->refs, 1);
+            chip8_snapshot_release(&snapshot);
+            return NULL;
+        }
+    }
+
+    memcpy(snapshot->display, chip->display, sizeof(snapshot->display));
+    memcpy(snapshot->V, chip->V, sizeof(snapshot->V));
+    memcpy(snapshot->stack, chip->stack, sizeof(snapshot->stack));
+    snapshot->PC = chip->PC;
+    snapshot->I = chip->I;
+    snapshot->SP = chip->SP;
+    snapshot->delay_timer = chip->delay_timer;
+    snapshot->sound_timer = chip->sound_timer;
+    snapshot->halted = chip->halted;
+    snapshot->draw_flag = chip->draw_flag;
+    memcpy(snapshot->keys, chip->keys, sizeof(snapshot->keys));
+    snapshot->cycle_count = chip->cycle_count;
+    snapshot->idle_cycles = chip->idle_cycles;
+    snapshot->rand_seed = chip->rand_seed;
+    snapshot->rand_state = chip->rand_state;
+
+    chip8_snapshot_release(&chip->snapshot);
+    chip->snapshot = snapshot;
+    chip->dirty_pages = 0;
+    return snapshot;
+}
+
+bool chip8_snapshot_restore(Chip8* chip, Chip8Snapshot* snapshot) {
+    if (!chip || !snapshot) {
+        fprintf(stderr, "ERROR: Invalid instance or snapshot while restoring\n");
+        return false;
+    }
+
+    const Chip8Snapshot* base = chip->snapshot;
+    if (!base) {
+        // nothing known about memory, cheaper to start over than to diff it
+        for (int p = 0; p < CHIP8_PAGE_COUNT; p++) {
+            memcpy(chip->memory + p * CHIP8_PAGE_SIZE, snapshot->pages[p]->bytes, CHIP8_PAGE_SIZE);
+        }
+        chip8_invalidate_all(chip);
+    } else {
+        for (int p = 0; p < CHIP8_PAGE_COUNT; p++) {
+            bool same = base->pages[p] == snapshot->pages[p] && !((chip->dirty_pages >> p) & 1);
+            if (!same) {
+                chip8_replace_page(chip, p, snapshot->pages[p]->bytes);
+            }
+        }
+    }
+
+    memcpy(chip->display, snapshot->display, sizeof(chip->display));
+    memcpy(chip->V, snapshot->V, sizeof(chip->V));
+    memcpy(chip->stack, snapshot->stack, sizeof(chip->stack));
+    chip->PC = snapshot->PC;
+    chip->I = snapshot->I;
+    chip->SP = snapshot->SP;
+    chip->delay_timer = snapshot->delay_timer;
+    chip->sound_timer = snapshot->sound_timer;
+    chip->halted = snapshot->halted;
+    chip->draw_flag = snapshot->draw_flag;
+    chip->dirty_rows = 0xFFFFFFFFu; // the display was replaced as a whole
+    memcpy(chip->keys, snapshot->keys, sizeof(chip->keys));
+    chip->cycle_count = snapshot->cycle_count;
+    chip->idle_cycles = snapshot->idle_cycles;
+    chip->rand_seed = snapshot->rand_seed;
+    chip->rand_state = snapshot->rand_state;
+
+    chip8_snapshot_retain(snapshot);
+    chip8_snapshot_release(&chip->snapshot);
+    chip->snapshot = snapshot;
+    chip->dirty_pages = 0;
+
+    chip8_state_replaced(chip);
+    return true;
+}
+
+Chip8Snapshot* chip8_snapshot_retain(Chip8Snapshot* snapshot) {
+    if (snapshot) {
+        atomic_fetch_add_explicit(&snapshot->refs, 1, memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+void chip8_snapshot_release(Chip8Snapshot** snapshot_ptr) {
+    if (!snapshot_ptr || !*snapshot_ptr) return;
+
+    Chip8Snapshot* snapshot = *snapshot_ptr;
+    *snapshot_ptr = NULL;
+    if (atomic_fetch_sub_explicit(&snapshot->refs, 1, memory_order_acq_rel) != 1) return;
+
+    for (int p = 0; p < CHIP8_PAGE_COUNT; p++) {
+        chip8_page_release(snapshot->pages[p]);
+    }
+    free(snapshot);
+}
+
+uint64_t chip8_snapshot_cycle_count(const Chip8Snapshot* snapshot) {
+    return snapshot ? snapshot->cycle_count : 0;
+}
+
+size_t chip8_snapshot_live_pages(void) {
+    return atomic_load_explicit(&g_live_pages, memory_order_relaxed);
+}
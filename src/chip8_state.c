@@ -0,0 +1,349 @@
+#define _DEFAULT_SOURCE // mmap under -std=c11
+
+#include "../include/chip8_state.h"
+#include "chip8_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    State layout (CHIP8_STATE_SIZE bytes):
+
+        "C8ST"  u16 version  u16 0
+        memory[4096]  display u64[32]  V u16[16]  stack u16[16]
+        PC u16  I u16  SP u8  delay u8  sound u8  flags u8 (bit 0 halted, bit 1 draw_flag)
+        keys u16 (bit k for key k)
+        cycle_count u64  idle_cycles u64  rand_seed u64  rand_state u64
+
+    A state file is a small header in front of it:
+
+        "C8SF"  u16 version  u8 thumb width  u8 thumb height  thumbnail u32[16]  state
+*/
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHIP8_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define CHIP8_HAVE_MMAP 0
+#endif
+
+#define STATE_MAGIC "C8ST"
+#define FILE_MAGIC  "C8SF"
+
+#define STATE_HEADER_SIZE 8
+#define FILE_HEADER_SIZE  (8 + CHIP8_THUMB_HEIGHT * 4)
+#define FILE_SIZE         (FILE_HEADER_SIZE + CHIP8_STATE_SIZE)
+
+// idle_cycles, followed by rand_seed and rand_state at the end of a state
+#define STATE_IDLE_OFFSET (CHIP8_STATE_SIZE - 3 * 8)
+
+_Static_assert(CHIP8_STATE_SIZE == STATE_HEADER_SIZE + CHIP8_MEMORY_SIZE + CHIP8_DISPLAY_HEIGHT * 8 +
+               CHIP8_NUM_REGISTERS * 2 + CHIP8_STACK_SIZE * 2 + 2 + 2 + 4 + 2 + 4 * 8,
+               "CHIP8_STATE_SIZE does not match the layout");
+
+// === Little-endian cursor ===
+
+typedef struct {
+    uint8_t* p;
+} Writer;
+
+typedef struct {
+    const uint8_t* p;
+} Reader;
+
+static inline void put8(Writer* w, uint8_t v) { *w->p++ = v; }
+
+static inline void put16(Writer* w, uint16_t v) {
+    w->p[0] = (uint8_t)v;
+    w->p[1] = (uint8_t)(v >> 8);
+    w->p += 2;
+}
+
+static inline void put32(Writer* w, uint32_t v) {
+    put16(w, (uint16_t)v);
+    put16(w, (uint16_t)(v >> 16));
+}
+
+static inline void put64(Writer* w, uint64_t v) {
+    put32(w, (uint32_t)v);
+    put32(w, (uint32_t)(v >> 32));
+}
+
+static inline uint8_t get8(Reader* r) { return *r->p++; }
+
+static inline uint16_t get16(Reader* r) {
+    uint16_t v = (uint16_t)(r->p[0] | (r->p[1] << 8));
+    r->p += 2;
+    return v;
+}
+
+static inline uint32_t get32(Reader* r) {
+    uint32_t lo = get16(r);
+    return lo | ((uint32_t)get16(r) << 16);
+}
+
+static inline uint64_t get64(Reader* r) {
+    uint64_t lo = get32(r);
+    return lo | ((uint64_t)get32(r) << 32);
+}
+
+// === Buffers ===
+
+size_t chip8_save_state(Chip8* chip, void* buf, size_t size) {
+    if (!chip || !buf || size < CHIP8_STATE_SIZE) {
+        fprintf(stderr, "ERROR: Invalid instance or state buffer smaller than %d bytes\n", CHIP8_STATE_SIZE);
+        return 0;
+    }
+
+    Writer w = { buf };
+    memcpy(w.p, STATE_MAGIC, 4);
+    w.p += 4;
+    put16(&w, CHIP8_STATE_VERSION);
+    put16(&w, 0);
+
+    memcpy(w.p, chip->memory, CHIP8_MEMORY_SIZE);
+    w.p += CHIP8_MEMORY_SIZE;
+    for (int y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) put64(&w, chip->display[y]);
+    for (int r = 0; r < CHIP8_NUM_REGISTERS; r++) put16(&w, chip->V[r]);
+    for (int s = 0; s < CHIP8_STACK_SIZE; s++) put16(&w, chip->stack[s]);
+
+    put16(&w, chip->PC);
+    put16(&w, chip->I);
+    put8(&w, chip->SP);
+    put8(&w, chip->delay_timer);
+    put8(&w, chip->sound_timer);
+    put8(&w, (uint8_t)((chip->halted ? 1 : 0) | (chip->draw_flag ? 2 : 0)));
+
+    uint16_t keys = 0;
+    for (int k = 0; k < CHIP8_NUM_KEYS; k++) {
+        if (chip->keys[k]) keys |= (uint16_t)(1u << k);
+    }
+    put16(&w, keys);
+
+    put64(&w, chip->cycle_count);
+    put64(&w, chip->idle_cycles);
+    put64(&w, chip->rand_seed);
+    put64(&w, chip->rand_state);
+
+    return (size_t)(w.p - (uint8_t*)buf);
+}
+
+bool chip8_state_equal(const void* a, const void* b) {
+    const uint8_t* left = a;
+    const uint8_t* right = b;
+    return memcmp(left, right, STATE_IDLE_OFFSET) == 0 &&
+           memcmp(left + STATE_IDLE_OFFSET + 8, right + STATE_IDLE_OFFSET + 8,
+                  CHIP8_STATE_SIZE - STATE_IDLE_OFFSET - 8) == 0;
+}
+
+/*
+    Checks the fields a state could hold out of range before any of it is loaded. PC, I
+    and return addresses are masked wherever they are used; SP indexes the stack.
+*/
+static bool chip8_state_check_fields(const uint8_t* body) {
+    Reader r = { body + CHIP8_MEMORY_SIZE + CHIP8_DISPLAY_HEIGHT * 8 + CHIP8_NUM_REGISTERS * 2 + CHIP8_STACK_SIZE * 2 };
+    get16(&r); // PC
+    get16(&r); // I
+    uint8_t sp = get8(&r);
+    get8(&r);  // delay timer
+    get8(&r);  // sound timer
+    uint8_t flags = get8(&r);
+
+    if (sp > CHIP8_STACK_SIZE) {
+        fprintf(stderr, "ERROR: State has stack pointer %u, at most %d\n", sp, CHIP8_STACK_SIZE);
+        return false;
+    }
+    if (flags & ~3u) {
+        fprintf(stderr, "ERROR: State has unknown flags 0x%02X\n", flags);
+        return false;
+    }
+    return true;
+}
+
+bool chip8_load_state(Chip8* chip, const void* buf, size_t size) {
+    if (!chip || !buf || size < CHIP8_STATE_SIZE) {
+        fprintf(stderr, "ERROR: Invalid instance or truncated state\n");
+        return false;
+    }
+
+    Reader r = { buf };
+    if (memcmp(r.p, STATE_MAGIC, 4) != 0) {
+        fprintf(stderr, "ERROR: Not a Chip-8 state\n");
+        return false;
+    }
+    r.p += 4;
+
+    uint16_t version = get16(&r);
+    if (version != CHIP8_STATE_VERSION) {
+        fprintf(stderr, "ERROR: State has version %u, expected %u\n", version, CHIP8_STATE_VERSION);
+        return false;
+    }
+    get16(&r);
+    if (!chip8_state_check_fields(r.p)) return false;
+
+    chip8_replace_memory(chip, r.p);
+    r.p += CHIP8_MEMORY_SIZE;
+    for (int y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) chip->display[y] = get64(&r);
+    for (int v = 0; v < CHIP8_NUM_REGISTERS; v++) chip->V[v] = get16(&r);
+    for (int s = 0; s < CHIP8_STACK_SIZE; s++) chip->stack[s] = get16(&r);
+
+    chip->PC = get16(&r);
+    chip->I = get16(&r);
+    chip->SP = get8(&r);
+    chip->delay_timer = get8(&r);
+    chip->sound_timer = get8(&r);
+
+    uint8_t flags = get8(&r);
+    chip->halted = (flags & 1) != 0;
+    chip->draw_flag = (flags & 2) != 0;
+    chip->dirty_rows = 0xFFFFFFFFu; // the display was replaced as a whole
+
+    uint16_t keys = get16(&r);
+    for (int k = 0; k < CHIP8_NUM_KEYS; k++) {
+        chip->keys[k] = (keys >> k) & 1;
+    }
+
+    chip->cycle_count = get64(&r);
+    chip->idle_cycles = get64(&r);
+    chip->rand_seed = get64(&r);
+    chip->rand_state = get64(&r);
+
+    chip8_state_replaced(chip);
+    return true;
+}
+
+// === Files ===
+
+// ORs each 2x2 block of the display into one bit
+static void chip8_state_thumbnail(const uint64_t* display, uint32_t thumb[CHIP8_THUMB_HEIGHT]) {
+    for (int y = 0; y < CHIP8_THUMB_HEIGHT; y++) {
+        uint64_t both = display[2 * y] | display[2 * y + 1];
+        uint32_t row = 0;
+        for (int x = 0; x < CHIP8_THUMB_WIDTH; x++) {
+            if ((both >> (62 - 2 * x)) & 3) row |= 1u << (31 - x);
+        }
+        thumb[y] = row;
+    }
+}
+
+static bool chip8_state_check_file(const uint8_t* data, size_t size, const char* path) {
+    if (size < FILE_HEADER_SIZE || memcmp(data, FILE_MAGIC, 4) != 0) {
+        fprintf(stderr, "ERROR: Not a Chip-8 state file: %s\n", path);
+        return false;
+    }
+
+    uint16_t version = (uint16_t)(data[4] | (data[5] << 8));
+    if (version != CHIP8_STATE_VERSION) {
+        fprintf(stderr, "ERROR: State file %s has version %u, expected %u\n", path, version, CHIP8_STATE_VERSION);
+        return false;
+    }
+    return true;
+}
+
+bool chip8_save_state_file(Chip8* chip, const char* path) {
+    if (!chip || !path || path[0] == '\0') {
+        fprintf(stderr, "ERROR: Invalid instance or path while saving state\n");
+        return false;
+    }
+
+    uint8_t data[FILE_SIZE];
+    uint32_t thumb[CHIP8_THUMB_HEIGHT];
+    chip8_state_thumbnail(chip->display, thumb);
+
+    Writer w = { data };
+    memcpy(w.p, FILE_MAGIC, 4);
+    w.p += 4;
+    put16(&w, CHIP8_STATE_VERSION);
+    put8(&w, CHIP8_THUMB_WIDTH);
+    put8(&w, CHIP8_THUMB_HEIGHT);
+    for (int y = 0; y < CHIP8_THUMB_HEIGHT; y++) put32(&w, thumb[y]);
+    chip8_save_state(chip, w.p, CHIP8_STATE_SIZE);
+
+    char temp_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Failed to open state file: %s\n", temp_path);
+        return false;
+    }
+    bool written = fwrite(data, 1, sizeof(data), file) == sizeof(data);
+    written = (fclose(file) == 0) && written;
+
+    if (!written || rename(temp_path, path) != 0) {
+        fprintf(stderr, "ERROR: Failed to write state file: %s\n", path);
+        remove(temp_path);
+        return false;
+    }
+    return true;
+}
+
+bool chip8_load_state_file(Chip8* chip, const char* path) {
+    if (!chip || !path || path[0] == '\0') {
+        fprintf(stderr, "ERROR: Invalid instance or path while loading state\n");
+        return false;
+    }
+
+#if CHIP8_HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Failed to open state file: %s\n", path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < FILE_SIZE) {
+        fprintf(stderr, "ERROR: Truncated state file: %s\n", path);
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, FILE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "ERROR: Failed to map state file: %s\n", path);
+        return false;
+    }
+
+    const uint8_t* data = map;
+    bool ok = chip8_state_check_file(data, FILE_SIZE, path) &&
+              chip8_load_state(chip, data + FILE_HEADER_SIZE, CHIP8_STATE_SIZE);
+    munmap(map, FILE_SIZE);
+    return ok;
+#else
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Failed to open state file: %s\n", path);
+        return false;
+    }
+
+    uint8_t data[FILE_SIZE];
+    size_t size = fread(data, 1, sizeof(data), file);
+    fclose(file);
+
+    return chip8_state_check_file(data, size, path) &&
+           chip8_load_state(chip, data + FILE_HEADER_SIZE, size - FILE_HEADER_SIZE);
+#endif
+}
+
+bool chip8_read_state_thumbnail(const char* path, uint32_t thumb[CHIP8_THUMB_HEIGHT]) {
+    if (!path || !thumb) return false;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Failed to open state file: %s\n", path);
+        return false;
+    }
+
+    uint8_t header[FILE_HEADER_SIZE];
+    size_t size = fread(header, 1, sizeof(header), file);
+    fclose(file);
+    if (!chip8_state_check_file(header, size, path)) return false;
+
+    Reader r = { header + 8 };
+    for (int y = 0; y < CHIP8_THUMB_HEIGHT; y++) thumb[y] = get32(&r);
+    return true;
+}
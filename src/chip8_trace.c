@@ -0,0 +1,404 @@
+#define _DEFAULT_SOURCE // mmap under -std=c11
+
+#include "../include/chip8_trace.h"
+#include "chip8_internal.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    The emulation thread fills a ring of CHUNK_COUNT buffers in order. A full buffer is
+    handed to the writer thread by bumping filled_count; the writer appends the oldest
+    one to the file and adds it to the side index outside the lock, then gives it back.
+    The emulation thread only takes the lock once per buffer, i.e. every 65536
+    instructions.
+*/
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHIP8_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define CHIP8_HAVE_MMAP 0
+#endif
+
+#define TRACE_MAGIC      "C8TR"
+#define TRACE_BOM        0x0102
+#define HEADER_SIZE      16
+#define CHUNK_RECORDS    (64 * 1024)
+#define CHUNK_COUNT      8
+
+_Static_assert(sizeof(Chip8TraceRecord) == 16, "trace records are packed into 16 bytes");
+
+struct Chip8Trace {
+    pthread_t thread;
+    pthread_mutex_t lock;      // guards the ring positions below and the flags
+    pthread_cond_t work_cond;  // a buffer was filled, or stopping
+    pthread_cond_t free_cond;  // the writer gave a buffer back
+    bool stopping;
+    bool failed;               // a write failed; set by the writer
+
+    FILE* file;
+    Chip8TraceIndex* index;    // fed by the writer, saved to index_path on stop
+    char* index_path;
+    Chip8TraceRecord* chunks[CHUNK_COUNT];
+    size_t sizes[CHUNK_COUNT]; // records in each filled buffer
+    int filled_head;           // oldest filled buffer
+    int filled_count;
+
+    // emulation-thread side
+    int current;               // buffer being filled, right after the filled ones
+    size_t used;
+    uint64_t recorded;
+};
+
+struct Chip8TraceReader {
+    const uint8_t* data;
+    size_t size;
+    bool mapped;
+    Chip8TraceIndex* index;
+};
+
+// The side index lives next to the trace
+static char* chip8_trace_index_path(const char* path) {
+    size_t length = strlen(path);
+    char* index_path = malloc(length + sizeof(".idx"));
+    if (index_path) {
+        memcpy(index_path, path, length);
+        memcpy(index_path + length, ".idx", sizeof(".idx"));
+    }
+    return index_path;
+}
+
+// === Writer thread ===
+
+static void* chip8_trace_writer(void* arg) {
+    Chip8Trace* trace = arg;
+
+    pthread_mutex_lock(&trace->lock);
+    for (;;) {
+        while (trace->filled_count == 0 && !trace->stopping) {
+            pthread_cond_wait(&trace->work_cond, &trace->lock);
+        }
+        if (trace->filled_count == 0) break; // stopping and drained
+
+        int index = trace->filled_head;
+        size_t count = trace->sizes[index];
+        pthread_mutex_unlock(&trace->lock);
+
+        bool ok = fwrite(trace->chunks[index], sizeof(Chip8TraceRecord), count, trace->file) == count;
+        chip8_trace_index_add(trace->index, trace->chunks[index], count);
+
+        pthread_mutex_lock(&trace->lock);
+        if (!ok) trace->failed = true;
+        trace->filled_head = (index + 1) % CHUNK_COUNT;
+        trace->filled_count--;
+        pthread_cond_signal(&trace->free_cond);
+    }
+    pthread_mutex_unlock(&trace->lock);
+    return NULL;
+}
+
+// Hands the current buffer to the writer and moves on to the next one
+static void chip8_trace_submit(Chip8Trace* trace) {
+    pthread_mutex_lock(&trace->lock);
+    trace->sizes[trace->current] = trace->used;
+    trace->filled_count++;
+    pthread_cond_signal(&trace->work_cond);
+
+    while (trace->filled_count == CHUNK_COUNT) {
+        pthread_cond_wait(&trace->free_cond, &trace->lock);
+    }
+    pthread_mutex_unlock(&trace->lock);
+
+    trace->current = (trace->current + 1) % CHUNK_COUNT;
+    trace->used = 0;
+}
+
+// === Emulation side (chip8_internal.h) ===
+
+Chip8TraceRecord* chip8_trace_span(Chip8Trace* trace, size_t* room) {
+    if (trace->used == CHUNK_RECORDS) {
+        chip8_trace_submit(trace);
+    }
+    *room = CHUNK_RECORDS - trace->used;
+    return trace->chunks[trace->current] + trace->used;
+}
+
+void chip8_trace_commit(Chip8Trace* trace, size_t count) {
+    trace->used += count;
+    trace->recorded += count;
+    if (trace->used == CHUNK_RECORDS) {
+        chip8_trace_submit(trace);
+    }
+}
+
+// === Recording ===
+
+static void chip8_trace_free(Chip8Trace* trace) {
+    for (int c = 0; c < CHUNK_COUNT; c++) {
+        free(trace->chunks[c]);
+    }
+    if (trace->file) fclose(trace->file);
+    chip8_trace_index_destroy(&trace->index);
+    free(trace->index_path);
+    free(trace);
+}
+
+bool chip8_trace_start(Chip8* chip, const char* path) {
+    if (!chip || chip->trace || !path || path[0] == '\0') {
+        fprintf(stderr, "ERROR: Invalid instance or path, or already tracing\n");
+        return false;
+    }
+
+    Chip8Trace* trace = calloc(1, sizeof(Chip8Trace));
+    if (!trace) {
+        fprintf(stderr, "ERROR: Failed to allocate trace\n");
+        return false;
+    }
+    for (int c = 0; c < CHUNK_COUNT; c++) {
+        trace->chunks[c] = malloc(CHUNK_RECORDS * sizeof(Chip8TraceRecord));
+        if (!trace->chunks[c]) {
+            fprintf(stderr, "ERROR: Failed to allocate trace buffers\n");
+            chip8_trace_free(trace);
+            return false;
+        }
+    }
+    trace->index = chip8_trace_index_create();
+    trace->index_path = chip8_trace_index_path(path);
+    if (!trace->index || !trace->index_path) {
+        fprintf(stderr, "ERROR: Failed to allocate trace index\n");
+        chip8_trace_free(trace);
+        return false;
+    }
+
+    // an index left over from an earlier trace at path would not match this one
+    remove(trace->index_path);
+    trace->file = fopen(path, "wb");
+    if (!trace->file) {
+        fprintf(stderr, "ERROR: Failed to open trace file: %s\n", path);
+        chip8_trace_free(trace);
+        return false;
+    }
+
+    uint8_t header[HEADER_SIZE] = { 0 };
+    uint16_t version = CHIP8_TRACE_VERSION;
+    uint16_t record_size = sizeof(Chip8TraceRecord);
+    uint16_t bom = TRACE_BOM;
+    memcpy(header, TRACE_MAGIC, 4);
+    memcpy(header + 4, &version, 2);
+    memcpy(header + 6, &record_size, 2);
+    memcpy(header + 8, &bom, 2);
+    if (fwrite(header, 1, sizeof(header), trace->file) != sizeof(header)) {
+        fprintf(stderr, "ERROR: Failed to write trace file: %s\n", path);
+        chip8_trace_free(trace);
+        return false;
+    }
+
+    pthread_mutex_init(&trace->lock, NULL);
+    pthread_cond_init(&trace->work_cond, NULL);
+    pthread_cond_init(&trace->free_cond, NULL);
+    if (pthread_create(&trace->thread, NULL, chip8_trace_writer, trace) != 0) {
+        fprintf(stderr, "ERROR: Failed to start trace writer thread\n");
+        pthread_cond_destroy(&trace->free_cond);
+        pthread_cond_destroy(&trace->work_cond);
+        pthread_mutex_destroy(&trace->lock);
+        chip8_trace_free(trace);
+        return false;
+    }
+
+    chip->trace = trace;
+    return true;
+}
+
+bool chip8_trace_stop(Chip8* chip) {
+    if (!chip || !chip->trace) return false;
+
+    Chip8Trace* trace = chip->trace;
+    chip->trace = NULL;
+
+    pthread_mutex_lock(&trace->lock);
+    if (trace->used > 0) {
+        trace->sizes[trace->current] = trace->used;
+        trace->filled_count++;
+    }
+    trace->stopping = true;
+    pthread_cond_signal(&trace->work_cond);
+    pthread_mutex_unlock(&trace->lock);
+    pthread_join(trace->thread, NULL);
+
+    bool ok = !trace->failed;
+    ok = (fclose(trace->file) == 0) && ok;
+    trace->file = NULL;
+    if (!ok) {
+        fprintf(stderr, "ERROR: Failed to write trace file\n");
+    } else {
+        // without its index the trace is still good; chip8_trace_open rebuilds it
+        chip8_trace_index_save(trace->index, trace->index_path);
+    }
+
+    pthread_cond_destroy(&trace->free_cond);
+    pthread_cond_destroy(&trace->work_cond);
+    pthread_mutex_destroy(&trace->lock);
+    chip8_trace_free(trace);
+    return ok;
+}
+
+bool chip8_trace_is_recording(Chip8* chip) {
+    return chip && chip->trace;
+}
+
+uint64_t chip8_trace_recorded(Chip8* chip) {
+    return (chip && chip->trace) ? chip->trace->recorded : 0;
+}
+
+// === Reading ===
+
+static bool chip8_trace_check(const uint8_t* data, size_t size, const char* path) {
+    uint16_t version, record_size, bom;
+    if (size < HEADER_SIZE || memcmp(data, TRACE_MAGIC, 4) != 0) {
+        fprintf(stderr, "ERROR: Not a Chip-8 trace: %s\n", path);
+        return false;
+    }
+
+    memcpy(&version, data + 4, 2);
+    memcpy(&record_size, data + 6, 2);
+    memcpy(&bom, data + 8, 2);
+    if (version != CHIP8_TRACE_VERSION || record_size != sizeof(Chip8TraceRecord) || bom != TRACE_BOM) {
+        fprintf(stderr, "ERROR: Trace %s is of another version or byte order\n", path);
+        return false;
+    }
+    return true;
+}
+
+Chip8TraceReader* chip8_trace_open(const char* path) {
+    if (!path || path[0] == '\0') {
+        fprintf(stderr, "ERROR: Invalid or absent path to trace\n");
+        return NULL;
+    }
+
+    Chip8TraceReader* reader = calloc(1, sizeof(Chip8TraceReader));
+    if (!reader) {
+        fprintf(stderr, "ERROR: Failed to allocate trace reader\n");
+        return NULL;
+    }
+
+#if CHIP8_HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "ERROR: Failed to open trace file: %s\n", path);
+        if (fd >= 0) close(fd);
+        free(reader);
+        return NULL;
+    }
+
+    reader->size = (size_t)st.st_size;
+    void* map = (reader->size > 0) ? mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "ERROR: Failed to map trace file: %s\n", path);
+        free(reader);
+        return NULL;
+    }
+    reader->data = map;
+    reader->mapped = true;
+#else
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Failed to open trace file: %s\n", path);
+        free(reader);
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = (size > 0) ? malloc((size_t)size) : NULL;
+    if (!data || fread(data, 1, (size_t)size, file) != (size_t)size) {
+        fprintf(stderr, "ERROR: Failed to read trace file: %s\n", path);
+        free(data);
+        fclose(file);
+        free(reader);
+        return NULL;
+    }
+    fclose(file);
+    reader->data = data;
+    reader->size = (size_t)size;
+#endif
+
+    if (!chip8_trace_check(reader->data, reader->size, path)) {
+        chip8_trace_close(&reader);
+        return NULL;
+    }
+
+    char* index_path = chip8_trace_index_path(path);
+    uint64_t count = chip8_trace_count(reader);
+    reader->index = index_path ? chip8_trace_index_load(index_path, count) : NULL;
+    if (!reader->index && index_path) {
+        reader->index = chip8_trace_index_create();
+        chip8_trace_index_add(reader->index, chip8_trace_records(reader), (size_t)count);
+        if (chip8_trace_index_finish(reader->index)) {
+            chip8_trace_index_save(reader->index, index_path);
+        } else {
+            chip8_trace_index_destroy(&reader->index);
+        }
+    }
+    free(index_path);
+
+    if (!reader->index) {
+        fprintf(stderr, "ERROR: Failed to index trace: %s\n", path);
+        chip8_trace_close(&reader);
+        return NULL;
+    }
+    return reader;
+}
+
+void chip8_trace_close(Chip8TraceReader** reader_ptr) {
+    if (!reader_ptr || !*reader_ptr) return;
+
+    Chip8TraceReader* reader = *reader_ptr;
+#if CHIP8_HAVE_MMAP
+    if (reader->mapped) munmap((void*)reader->data, reader->size);
+#else
+    free((void*)reader->data);
+#endif
+    chip8_trace_index_destroy(&reader->index);
+    free(reader);
+    *reader_ptr = NULL;
+}
+
+uint64_t chip8_trace_count(const Chip8TraceReader* reader) {
+    // a trace cut short by a crash may end in a partial record, which is left out
+    return reader ? (reader->size - HEADER_SIZE) / sizeof(Chip8TraceRecord) : 0;
+}
+
+const Chip8TraceRecord* chip8_trace_records(const Chip8TraceReader* reader) {
+    return reader ? (const Chip8TraceRecord*)(reader->data + HEADER_SIZE) : NULL;
+}
+
+int64_t chip8_trace_find_cycle(const Chip8TraceReader* reader, uint64_t cycle) {
+    if (!reader) return -1;
+    return chip8_trace_index_find_cycle(reader->index, chip8_trace_records(reader), cycle);
+}
+
+int64_t chip8_trace_find(const Chip8TraceReader* reader, Chip8TraceKey key, uint16_t value,
+                         int64_t from, bool backward) {
+    if (!reader) return -1;
+    if ((key == CHIP8_TRACE_BY_PC && value >= CHIP8_MEMORY_SIZE) ||
+        (key == CHIP8_TRACE_BY_WRITE && value >= CHIP8_NUM_REGISTERS)) {
+        return -1;
+    }
+    return chip8_trace_index_find(reader->index, chip8_trace_records(reader), key, value, from, backward);
+}
+
+int chip8_trace_changed_register(uint16_t opcode) {
+    return chip8_trace_register(opcode);
+}
+
+uint16_t chip8_trace_written_registers(uint16_t opcode) {
+    return chip8_trace_written(opcode);
+}
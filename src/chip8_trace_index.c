@@ -0,0 +1,364 @@
+#include "../include/chip8_trace.h"
+#include "chip8_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    The index splits a trace into buckets of 4096 records and keeps, per bucket, the
+    highest cycle seen so far, and per key (a PC, an opcode or a written register) the
+    sorted list of buckets that contain it. A query scans what is left of the bucket it
+    starts in, then binary-searches the key's list for the next bucket and scans only
+    that one, so it touches at most two buckets of the trace whatever its size.
+
+    While building, the distinct keys of each bucket are appended to one array in
+    bucket order; chip8_trace_index_finish counting-sorts them into the per-key lists.
+
+    File layout: "C8TI" u16 version u16 bucket shift u16 byte order mark (0x0102) u16 0
+    u32 key count, u64 records u64 postings, then u64 cycle per bucket, u32 list start
+    per key plus one, u32 bucket per posting, all in host byte order.
+*/
+
+#define INDEX_MAGIC    "C8TI"
+#define INDEX_VERSION  2 // 1 posted FX65 and 8XYN under VX alone
+#define INDEX_BOM      0x0102
+#define HEADER_SIZE    32
+#define BUCKET_SHIFT   12
+#define BUCKET_RECORDS ((uint64_t)1 << BUCKET_SHIFT)
+
+// key space: PCs, then opcodes, then written registers
+#define KEY_PC         0
+#define KEY_OPCODE     (KEY_PC + CHIP8_MEMORY_SIZE)
+#define KEY_WRITE      (KEY_OPCODE + 0x10000)
+#define KEY_COUNT      (KEY_WRITE + CHIP8_NUM_REGISTERS)
+#define RECORD_KEYS    (2 + CHIP8_NUM_REGISTERS) // most one record can add: its PC, opcode and writes
+
+struct Chip8TraceIndex {
+    uint64_t records;
+    uint64_t* cycles;       // highest cycle up to the end of each bucket
+    size_t bucket_count;
+    size_t bucket_capacity;
+    uint64_t max_cycle;
+
+    // building
+    uint32_t* seen;         // bucket + 1 that last added each key
+    uint32_t* keys;         // distinct keys of each bucket, bucket after bucket
+    uint32_t* bucket_first; // first of each bucket's keys
+    size_t key_count;
+    size_t key_capacity;
+    bool failed;            // ran out of memory; the index is unusable
+
+    // finished
+    uint32_t* offsets;      // KEY_COUNT + 1 list starts into postings
+    uint32_t* postings;
+};
+
+static uint32_t chip8_trace_key(Chip8TraceKey kind, uint16_t value) {
+    switch (kind) {
+        case CHIP8_TRACE_BY_PC:     return KEY_PC + value;
+        case CHIP8_TRACE_BY_OPCODE: return KEY_OPCODE + value;
+        default:                    return KEY_WRITE + value;
+    }
+}
+
+static bool chip8_trace_matches(const Chip8TraceRecord* record, Chip8TraceKey kind, uint16_t value) {
+    switch (kind) {
+        case CHIP8_TRACE_BY_PC:     return CHIP8_ADDR(record->pc) == value;
+        case CHIP8_TRACE_BY_OPCODE: return record->opcode == value;
+        default:                    return (chip8_trace_written(record->opcode) >> value) & 1;
+    }
+}
+
+// === Building ===
+
+Chip8TraceIndex* chip8_trace_index_create(void) {
+    Chip8TraceIndex* index = calloc(1, sizeof(Chip8TraceIndex));
+    if (!index) return NULL;
+
+    index->seen = calloc(KEY_COUNT, sizeof(uint32_t));
+    if (!index->seen) {
+        free(index);
+        return NULL;
+    }
+    return index;
+}
+
+static bool chip8_trace_index_grow(void** array, size_t* capacity, size_t needed, size_t size) {
+    if (needed <= *capacity) return true;
+
+    size_t grown = *capacity ? *capacity * 2 : 1024;
+    while (grown < needed) grown *= 2;
+    void* bigger = realloc(*array, grown * size);
+    if (!bigger) return false;
+    *array = bigger;
+    *capacity = grown;
+    return true;
+}
+
+static inline void chip8_trace_index_note(Chip8TraceIndex* index, uint32_t key, uint32_t stamp) {
+    if (index->seen[key] == stamp) return;
+    index->seen[key] = stamp;
+    index->keys[index->key_count++] = key;
+}
+
+void chip8_trace_index_add(Chip8TraceIndex* index, const Chip8TraceRecord* records, size_t count) {
+    if (!index || index->failed || index->offsets) return;
+
+    size_t done = 0;
+    while (done < count) {
+        size_t bucket = (size_t)(index->records >> BUCKET_SHIFT);
+        size_t room = (size_t)(BUCKET_RECORDS - (index->records & (BUCKET_RECORDS - 1)));
+        size_t take = (count - done < room) ? count - done : room;
+
+        if (bucket == index->bucket_count) {
+            size_t capacity = index->bucket_capacity; // both arrays grow in step
+            if (!chip8_trace_index_grow((void**)&index->cycles, &index->bucket_capacity, bucket + 1, sizeof(uint64_t)) ||
+                !chip8_trace_index_grow((void**)&index->bucket_first, &capacity, bucket + 1, sizeof(uint32_t))) {
+                index->failed = true;
+                return;
+            }
+            index->bucket_first[bucket] = (uint32_t)index->key_count;
+            index->cycles[bucket] = index->max_cycle;
+            index->bucket_count++;
+        }
+
+        size_t most = index->key_count + RECORD_KEYS * take;
+        if (most > UINT32_MAX ||
+            !chip8_trace_index_grow((void**)&index->keys, &index->key_capacity, most, sizeof(uint32_t))) {
+            index->failed = true;
+            return;
+        }
+
+        uint32_t stamp = (uint32_t)bucket + 1;
+        uint64_t max_cycle = index->max_cycle;
+        for (size_t r = done; r < done + take; r++) {
+            const Chip8TraceRecord* record = &records[r];
+            chip8_trace_index_note(index, KEY_PC + CHIP8_ADDR(record->pc), stamp);
+            chip8_trace_index_note(index, KEY_OPCODE + record->opcode, stamp);
+            for (uint16_t written = chip8_trace_written(record->opcode); written; written &= written - 1) {
+                chip8_trace_index_note(index, KEY_WRITE + (uint32_t)__builtin_ctz(written), stamp);
+            }
+            if (record->cycle > max_cycle) max_cycle = record->cycle;
+        }
+        index->max_cycle = max_cycle;
+        index->cycles[bucket] = max_cycle;
+
+        index->records += take;
+        done += take;
+    }
+}
+
+bool chip8_trace_index_finish(Chip8TraceIndex* index) {
+    if (!index || index->failed) return false;
+    if (index->offsets) return true;
+
+    index->offsets = calloc(KEY_COUNT + 1, sizeof(uint32_t));
+    index->postings = malloc((index->key_count > 0 ? index->key_count : 1) * sizeof(uint32_t));
+    if (!index->offsets || !index->postings) {
+        free(index->offsets);
+        free(index->postings);
+        index->offsets = NULL;
+        index->postings = NULL;
+        index->failed = true;
+        return false;
+    }
+
+    for (size_t k = 0; k < index->key_count; k++) {
+        index->offsets[index->keys[k] + 1]++;
+    }
+    for (size_t key = 0; key < KEY_COUNT; key++) {
+        index->offsets[key + 1] += index->offsets[key];
+    }
+
+    // seen is spent; reuse it as the fill position of each list
+    memcpy(index->seen, index->offsets, KEY_COUNT * sizeof(uint32_t));
+    for (size_t bucket = 0; bucket < index->bucket_count; bucket++) {
+        size_t end = (bucket + 1 < index->bucket_count) ? index->bucket_first[bucket + 1] : index->key_count;
+        for (size_t k = index->bucket_first[bucket]; k < end; k++) {
+            index->postings[index->seen[index->keys[k]]++] = (uint32_t)bucket;
+        }
+    }
+
+    free(index->seen);
+    free(index->keys);
+    free(index->bucket_first);
+    index->seen = NULL;
+    index->keys = NULL;
+    index->bucket_first = NULL;
+    return true;
+}
+
+void chip8_trace_index_destroy(Chip8TraceIndex** index_ptr) {
+    if (!index_ptr || !*index_ptr) return;
+
+    Chip8TraceIndex* index = *index_ptr;
+    free(index->cycles);
+    free(index->seen);
+    free(index->keys);
+    free(index->bucket_first);
+    free(index->offsets);
+    free(index->postings);
+    free(index);
+    *index_ptr = NULL;
+}
+
+// === Files ===
+
+bool chip8_trace_index_save(Chip8TraceIndex* index, const char* path) {
+    if (!chip8_trace_index_finish(index)) {
+        fprintf(stderr, "ERROR: Trace index is incomplete: %s\n", path);
+        return false;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Failed to open trace index: %s\n", path);
+        return false;
+    }
+
+    uint8_t header[HEADER_SIZE] = { 0 };
+    uint16_t version = INDEX_VERSION;
+    uint16_t shift = BUCKET_SHIFT;
+    uint16_t bom = INDEX_BOM;
+    uint32_t key_count = KEY_COUNT;
+    uint64_t postings = index->offsets[KEY_COUNT];
+    memcpy(header, INDEX_MAGIC, 4);
+    memcpy(header + 4, &version, 2);
+    memcpy(header + 6, &shift, 2);
+    memcpy(header + 8, &bom, 2);
+    memcpy(header + 12, &key_count, 4);
+    memcpy(header + 16, &index->records, 8);
+    memcpy(header + 24, &postings, 8);
+
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+              fwrite(index->cycles, sizeof(uint64_t), index->bucket_count, file) == index->bucket_count &&
+              fwrite(index->offsets, sizeof(uint32_t), KEY_COUNT + 1, file) == KEY_COUNT + 1 &&
+              fwrite(index->postings, sizeof(uint32_t), (size_t)postings, file) == postings;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "ERROR: Failed to write trace index: %s\n", path);
+        remove(path);
+    }
+    return ok;
+}
+
+Chip8TraceIndex* chip8_trace_index_load(const char* path, uint64_t records) {
+    // a missing or stale index is not an error, the caller rebuilds it
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    uint8_t header[HEADER_SIZE];
+    uint16_t version, shift, bom;
+    uint32_t key_count;
+    uint64_t indexed, postings;
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, INDEX_MAGIC, 4) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    memcpy(&version, header + 4, 2);
+    memcpy(&shift, header + 6, 2);
+    memcpy(&bom, header + 8, 2);
+    memcpy(&key_count, header + 12, 4);
+    memcpy(&indexed, header + 16, 8);
+    memcpy(&postings, header + 24, 8);
+    if (version != INDEX_VERSION || shift != BUCKET_SHIFT || bom != INDEX_BOM ||
+        key_count != KEY_COUNT || indexed != records || postings > UINT32_MAX) {
+        fclose(file);
+        return NULL;
+    }
+
+    Chip8TraceIndex* index = calloc(1, sizeof(Chip8TraceIndex));
+    if (!index) {
+        fclose(file);
+        return NULL;
+    }
+    index->records = records;
+    index->bucket_count = (size_t)((records + BUCKET_RECORDS - 1) >> BUCKET_SHIFT);
+    index->cycles = malloc((index->bucket_count ? index->bucket_count : 1) * sizeof(uint64_t));
+    index->offsets = malloc((KEY_COUNT + 1) * sizeof(uint32_t));
+    index->postings = malloc((postings ? (size_t)postings : 1) * sizeof(uint32_t));
+
+    bool ok = index->cycles && index->offsets && index->postings &&
+              fread(index->cycles, sizeof(uint64_t), index->bucket_count, file) == index->bucket_count &&
+              fread(index->offsets, sizeof(uint32_t), KEY_COUNT + 1, file) == KEY_COUNT + 1 &&
+              fread(index->postings, sizeof(uint32_t), (size_t)postings, file) == postings &&
+              index->offsets[KEY_COUNT] == postings;
+    fclose(file);
+    if (!ok) {
+        chip8_trace_index_destroy(&index);
+        return NULL;
+    }
+    return index;
+}
+
+// === Queries ===
+
+int64_t chip8_trace_index_find_cycle(const Chip8TraceIndex* index, const Chip8TraceRecord* records, uint64_t cycle) {
+    // the bucket maxima never decrease, so the first bucket reaching cycle holds the answer
+    size_t lo = 0, hi = index->bucket_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->cycles[mid] < cycle) lo = mid + 1; else hi = mid;
+    }
+    if (lo == index->bucket_count) return -1;
+
+    uint64_t first = (uint64_t)lo << BUCKET_SHIFT;
+    uint64_t end = first + BUCKET_RECORDS < index->records ? first + BUCKET_RECORDS : index->records;
+    for (uint64_t r = first; r < end; r++) {
+        if (records[r].cycle >= cycle) return (int64_t)r;
+    }
+    return -1;
+}
+
+int64_t chip8_trace_index_find(const Chip8TraceIndex* index, const Chip8TraceRecord* records,
+                               Chip8TraceKey kind, uint16_t value, int64_t from, bool backward) {
+    int64_t count = (int64_t)index->records;
+    int64_t start = backward ? from - 1 : from + 1;
+    if (start < 0 || start >= count) return -1;
+
+    // the rest of the starting bucket
+    int64_t bucket = start >> BUCKET_SHIFT;
+    int64_t first = bucket << BUCKET_SHIFT;
+    int64_t end = (first + (int64_t)BUCKET_RECORDS < count) ? first + (int64_t)BUCKET_RECORDS : count;
+    if (backward) {
+        for (int64_t r = start; r >= first; r--) {
+            if (chip8_trace_matches(&records[r], kind, value)) return r;
+        }
+    } else {
+        for (int64_t r = start; r < end; r++) {
+            if (chip8_trace_matches(&records[r], kind, value)) return r;
+        }
+    }
+
+    // the nearest other bucket holding the key, from its list
+    uint32_t key = chip8_trace_key(kind, value);
+    const uint32_t* list = index->postings + index->offsets[key];
+    size_t lo = 0, hi = index->offsets[key + 1] - index->offsets[key];
+    size_t size = hi;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((int64_t)list[mid] <= bucket) lo = mid + 1; else hi = mid;
+    }
+    // lo is the first listed bucket after the starting one
+    if (backward) {
+        while (lo > 0 && (int64_t)list[lo - 1] >= bucket) lo--;
+        if (lo == 0) return -1;
+        bucket = list[lo - 1];
+    } else {
+        if (lo == size) return -1;
+        bucket = list[lo];
+    }
+
+    first = bucket << BUCKET_SHIFT;
+    end = (first + (int64_t)BUCKET_RECORDS < count) ? first + (int64_t)BUCKET_RECORDS : count;
+    if (backward) {
+        for (int64_t r = end - 1; r >= first; r--) {
+            if (chip8_trace_matches(&records[r], kind, value)) return r;
+        }
+    } else {
+        for (int64_t r = first; r < end; r++) {
+            if (chip8_trace_matches(&records[r], kind, value)) return r;
+        }
+    }
+    return -1;
+}
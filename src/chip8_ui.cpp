@@ -1,5 +1,8 @@
 #include "../include/chip8_ui.h"
+#include "../include/chip8_log.h"
+#include "../include/chip8_state.h"
 
+#include <cmath>
 #include <cstdint>
 
 #include <stdio.h>
@@ -25,25 +28,108 @@ static GLuint create_display_texture() {
     return tex;
 }
 
-static void upload_display_texture(Chip8UI* ui) {
-    const bool* display = chip8_get_display(ui->chip);
-    if (!display) return;
+static void upload_display_texture(Chip8UI* ui, uint32_t dirty_rows) {
+    const uint64_t* rows = ui->display_rows;
+    if (!dirty_rows) return;
 
     static uint8_t pixels[CHIP8_DISPLAY_WIDTH * CHIP8_DISPLAY_HEIGHT * 4];
-    for (int i = 0; i < CHIP8_DISPLAY_HEIGHT * CHIP8_DISPLAY_WIDTH; i++) {
-        uint8_t v = display[i] ? 0xFF : 0x00;
-        pixels[i*4+0] = v;
-        pixels[i*4+1] = v;
-        pixels[i*4+2] = v;
-        pixels[i*4+3] = 0xFF;
-    }
     glBindTexture(GL_TEXTURE_2D, ui->display_texture);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
-                    CHIP8_DISPLAY_WIDTH, CHIP8_DISPLAY_HEIGHT,
-                    GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    // convert and upload each run of consecutive dirty rows with a single call
+    int y = 0;
+    while (y < CHIP8_DISPLAY_HEIGHT) {
+        if (!((dirty_rows >> y) & 1)) {
+            y++;
+            continue;
+        }
+
+        int first = y;
+        for (; y < CHIP8_DISPLAY_HEIGHT && ((dirty_rows >> y) & 1); y++) {
+            for (int x = 0; x < CHIP8_DISPLAY_WIDTH; x++) {
+                int i = y * CHIP8_DISPLAY_WIDTH + x;
+                uint8_t v = CHIP8_PIXEL(rows, x, y) ? 0xFF : 0x00;
+                pixels[i*4+0] = v;
+                pixels[i*4+1] = v;
+                pixels[i*4+2] = v;
+                pixels[i*4+3] = 0xFF;
+            }
+        }
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first,
+                        CHIP8_DISPLAY_WIDTH, y - first,
+                        GL_RGBA, GL_UNSIGNED_BYTE, &pixels[first * CHIP8_DISPLAY_WIDTH * 4]);
+    }
+
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+/*
+    The instance runs on the runner's thread, and the windows show the state and
+    profile it publishes. What needs the instance itself (stepping, debugger edits,
+    resets) borrows it, and only when the user asks for it: the runner parks at the
+    end of its frame and the instance is ours until return_chip at the end of the UI
+    frame, so a window can borrow it as often as it likes for the price of one
+    hand-over. Borrowing every frame would hold the ROM to a frame per UI frame.
+*/
+static void read_published(Chip8UI* ui) {
+    chip8_runner_read_state(ui->runner, &ui->state);
+    if (ui->state.profiling || ui->state.sampling) {
+        chip8_runner_read_profile(ui->runner, &ui->profile);
+    }
+}
+
+static Chip8* borrow_chip(Chip8UI* ui) {
+    if (ui->runner && !ui->borrowed) {
+        chip8_runner_acquire(ui->runner);
+        ui->borrowed = true;
+    }
+    return ui->chip;
+}
+
+static void return_chip(Chip8UI* ui) {
+    if (!ui->borrowed) return;
+
+    chip8_log_diagnostics(ui->chip); // what stepping by hand ran into
+    chip8_runner_release(ui->runner);
+    ui->borrowed = false;
+    read_published(ui);
+}
+
+// Disassembles from published memory, for the windows that list addresses
+static void disassemble_at(Chip8UI* ui, uint16_t address, char* buffer, size_t size) {
+    uint16_t opcode = (uint16_t)(ui->state.memory[address] << 8 | ui->state.memory[(address + 1) % CHIP8_MEMORY_SIZE]);
+    chip8_disassemble_opcode(opcode, buffer, size);
+}
+
+// Runs on the runner's thread after every frame it runs
+static void on_emulation_frame(Chip8* chip, void* user) {
+    Chip8UI* ui = (Chip8UI*)user;
+
+    chip8_log_diagnostics(chip);
+    chip8_rewind_push(ui->rewind, chip); // the history takes its own lock
+}
+
+/*
+    Movies and reverse execution run from the UI frame on the borrowed instance, so the
+    runner only runs the ROM itself.
+*/
+static void set_running(Chip8UI* ui, bool run) {
+    if (run && ui->rewind_frame >= 0) {
+        // resuming from a rewound frame replaces the frames after it
+        chip8_rewind_truncate(ui->rewind, ui->rewind_frame);
+        ui->rewind_frame = -1;
+    }
+    ui->running = run;
+    chip8_runner_run(ui->runner, run && !ui->movie && !ui->reversing);
+}
+
+static void send_key(Chip8UI* ui, uint8_t key, bool pressed) {
+    if (ui->keys[key] == pressed) return;
+
+    ui->keys[key] = pressed;
+    chip8_runner_set_key(ui->runner, key, pressed);
+}
+
 static void open_rom_dialog(Chip8UI* ui) {
     const char* filter_patterns[] = { "*.ch8", "*.c8", "*.rom" };
     const char* path = tinyfd_openFileDialog(
@@ -52,6 +138,196 @@ static void open_rom_dialog(Chip8UI* ui) {
     if (path) chip8_ui_load_rom(ui, path);
 }
 
+/*
+    Auto speed: a ROM that paces itself waits on the delay timer or a key every frame,
+    so keep some idle time per frame. Without any, the ROM is starved and gets more
+    cycles; mostly idle frames give cycles back.
+*/
+static void tune_speed(Chip8UI* ui) {
+    const int   min_cycles = 1;
+    const int   max_cycles = 1000;
+    const float starved    = 0.05f;
+    const float idle       = 0.50f;
+
+    int cycles = ui->cycles_per_frame;
+    if (ui->idle_fraction < starved) {
+        cycles += cycles / 8 + 1;
+    } else if (ui->idle_fraction > idle) {
+        cycles -= cycles / 16 + 1;
+    }
+
+    if (cycles < min_cycles) cycles = min_cycles;
+    if (cycles > max_cycles) cycles = max_cycles;
+    ui->cycles_per_frame = cycles;
+}
+
+/*
+    Step over, step out and run to cursor usually arrive within a few thousand cycles,
+    so they run straight to the stop in one go. One that takes longer (a loop waiting
+    on the delay timer, say) goes on as a normal run, frame by frame, until it stops.
+*/
+#define STEP_RUN_CYCLES 100000
+
+// On the borrowed instance, with a target set; the runner takes over a long one
+static void run_to_target(Chip8UI* ui) {
+    ui->reversing = false;
+    ui->stop_reason = -1;
+    Chip8StopReason reason = chip8_run_until(borrow_chip(ui), STEP_RUN_CYCLES);
+    if (reason == CHIP8_STOP_BUDGET) {
+        set_running(ui, true);
+    } else {
+        ui->stop_reason = reason;
+    }
+}
+
+static void step_over(Chip8UI* ui) {
+    set_running(ui, false);
+    Chip8* chip = borrow_chip(ui);
+    if (chip8_break_step_over(chip)) {
+        run_to_target(ui);
+    } else {
+        chip8_step(chip);
+    }
+}
+
+static void step_out(Chip8UI* ui) {
+    set_running(ui, false);
+    if (chip8_break_step_out(borrow_chip(ui))) {
+        run_to_target(ui);
+    }
+}
+
+static void run_to_cursor(Chip8UI* ui, uint16_t address) {
+    set_running(ui, false);
+    if (chip8_break_set_target(borrow_chip(ui), address, CHIP8_STACK_SIZE)) {
+        run_to_target(ui);
+    }
+}
+
+// Modules come from chip8aotc and only speed up the ROM they were built from
+static void open_aot_dialog(Chip8UI* ui) {
+    const char* filter_patterns[] = { "*.so", "*.dylib" };
+    const char* path = tinyfd_openFileDialog(
+        "Load AOT Module", "", 2, filter_patterns, "chip8aotc modules", 0
+    );
+    if (path && chip8_load_aot(borrow_chip(ui), path)) {
+        ui->backend = CHIP8_BACKEND_AOT;
+    }
+}
+
+// The quick-save slot lives next to the ROM, so every ROM has its own
+static void quick_slot_path(Chip8UI* ui, char* buffer, size_t bufsize) {
+    snprintf(buffer, bufsize, "%s.c8s", ui->rom_path);
+}
+
+static void quick_save(Chip8UI* ui) {
+    char path[300];
+    quick_slot_path(ui, path, sizeof(path));
+    if (chip8_save_state_file(borrow_chip(ui), path)) {
+        printf("Saved state: %s\n", path);
+    }
+}
+
+static void quick_load(Chip8UI* ui) {
+    char path[300];
+    quick_slot_path(ui, path, sizeof(path));
+    if (chip8_load_state_file(borrow_chip(ui), path)) {
+        printf("Loaded state: %s\n", path);
+    }
+}
+
+// Like the quick-save slot, one movie per ROM next to it
+static void movie_path(Chip8UI* ui, char* buffer, size_t bufsize) {
+    snprintf(buffer, bufsize, "%s.c8m", ui->rom_path);
+}
+
+static void start_recording(Chip8UI* ui) {
+    if (chip8_movie_record(borrow_chip(ui), 0)) {
+        printf("Recording movie\n");
+    }
+}
+
+static void stop_recording(Chip8UI* ui) {
+    Chip8Movie* movie = chip8_movie_stop(borrow_chip(ui));
+    if (!movie) return;
+
+    char path[300];
+    movie_path(ui, path, sizeof(path));
+    if (chip8_movie_save(movie, path)) {
+        printf("Saved movie: %s (%d frames)\n", path, chip8_movie_frames(movie));
+    }
+    chip8_movie_destroy(&movie);
+}
+
+static void play_movie(Chip8UI* ui) {
+    char path[300];
+    movie_path(ui, path, sizeof(path));
+
+    chip8_movie_destroy(&ui->movie);
+    ui->movie = chip8_movie_load(path);
+    if (ui->movie && chip8_movie_seek(ui->movie, borrow_chip(ui), 0)) {
+        printf("Playing movie: %s (%d frames)\n", path, chip8_movie_frames(ui->movie));
+        set_running(ui, true);
+    } else {
+        chip8_movie_destroy(&ui->movie);
+    }
+}
+
+static void stop_movie(Chip8UI* ui) {
+    if (!ui->movie) return;
+
+    printf("Movie stopped, %d desyncs\n", chip8_movie_desyncs(ui->movie));
+    chip8_movie_destroy(&ui->movie);
+
+    // the keyboard takes over from whatever keys the movie left down
+    Chip8* chip = borrow_chip(ui);
+    for (uint8_t key = 0; key < CHIP8_NUM_KEYS; key++) {
+        ui->keys[key] = chip8_is_key_pressed(chip, key);
+    }
+}
+
+static void open_trace(Chip8UI* ui, const char* path) {
+    chip8_trace_close(&ui->trace);
+    ui->trace = chip8_trace_open(path);
+    ui->trace_base = 0;
+    ui->trace_selected = -1;
+    if (ui->trace) {
+        printf("Opened trace: %s (%llu instructions)\n", path, (unsigned long long)chip8_trace_count(ui->trace));
+        ui->show_trace = true;
+    }
+}
+
+static void open_trace_dialog(Chip8UI* ui) {
+    const char* filter_patterns[] = { "*.c8t" };
+    const char* path = tinyfd_openFileDialog(
+        "Open Trace", "", 1, filter_patterns, "Chip-8 traces", 0
+    );
+    if (path) open_trace(ui, path);
+}
+
+// The trace goes next to the ROM too; a finished one opens in the Trace window
+static void toggle_trace(Chip8UI* ui) {
+    char path[300];
+    snprintf(path, sizeof(path), "%s.c8t", ui->rom_path);
+
+    Chip8* chip = borrow_chip(ui);
+    if (chip8_trace_is_recording(chip)) {
+        uint64_t records = chip8_trace_recorded(chip);
+        if (chip8_trace_stop(chip)) {
+            printf("Trace stopped, %llu instructions\n", (unsigned long long)records);
+            open_trace(ui, path);
+        }
+        return;
+    }
+
+    // the Trace window may be showing the file about to be overwritten, which would
+    // pull it out from under the mapping
+    chip8_trace_close(&ui->trace);
+    if (chip8_trace_start(chip, path)) {
+        printf("Tracing to %s\n", path);
+    }
+}
+
 static void render_controls(Chip8UI* ui) {
     if (!ui || !ui->show_controls) return;
 
@@ -94,14 +370,17 @@ static void render_controls(Chip8UI* ui) {
 
     const char* run_label = ui->running ? "Pause##run" : "Run##run";
     if (ImGui::Button(run_label, ImVec2(80, 0))) {
-        ui->running = !ui->running;
+        ui->reversing = false;
+        ui->stop_reason = -1;
+        set_running(ui, !ui->running);
+        if (!ui->running) chip8_break_clear_target(borrow_chip(ui)); // pausing abandons a step over or out
     }
 
     ImGui::SameLine(0, 8);
 
     if (ImGui::Button("Step", ImVec2(80, 0))) {
-        ui->running = false;
-        chip8_step(ui->chip);
+        set_running(ui, false);
+        chip8_step(borrow_chip(ui));
     }
 
     ImGui::SameLine(0, 8);
@@ -109,29 +388,175 @@ static void render_controls(Chip8UI* ui) {
     char step_n_label[32];
     snprintf(step_n_label, sizeof(step_n_label), "Step %d##stepn", ui->step_count);
     if (ImGui::Button(step_n_label, ImVec2(80, 0))) {
-        ui->running = false;
-        chip8_step_n(ui->chip, ui->step_count);
+        set_running(ui, false);
+        chip8_step_n(borrow_chip(ui), ui->step_count);
     }
     ImGui::SameLine(0, 8);
     ImGui::SetNextItemWidth(100);
     ImGui::InputInt("##step_count", &ui->step_count, 1, 10);
 
+    if (ImGui::Button("Step over", ImVec2(80, 0))) {
+        step_over(ui);
+    }
+    ImGui::SameLine(0, 8);
+    ImGui::BeginDisabled(has_rom && ui->state.SP == 0);
+    if (ImGui::Button("Step out", ImVec2(80, 0))) {
+        step_out(ui);
+    }
+    ImGui::EndDisabled();
+
+    // Reverse execution, from the undo log
+    bool undo_on = ui->state.undo_enabled;
+    if (ImGui::Checkbox("Undo log", &undo_on)) {
+        if (undo_on) {
+            chip8_undo_enable(borrow_chip(ui), 0);
+        } else {
+            chip8_undo_disable(borrow_chip(ui));
+            ui->reversing = false;
+        }
+    }
+
+    int undoable = ui->state.undo_available;
+    ImGui::BeginDisabled(undoable == 0 && !ui->reversing);
+
+    if (ImGui::Button("Back", ImVec2(80, 0))) {
+        ui->reversing = false;
+        set_running(ui, false);
+        chip8_step_back(borrow_chip(ui));
+    }
+
+    ImGui::SameLine(0, 8);
+
+    char back_n_label[32];
+    snprintf(back_n_label, sizeof(back_n_label), "Back %d##backn", ui->step_count);
+    if (ImGui::Button(back_n_label, ImVec2(80, 0))) {
+        ui->reversing = false;
+        set_running(ui, false);
+        chip8_step_back_n(borrow_chip(ui), ui->step_count);
+    }
+
+    ImGui::SameLine(0, 8);
+
+    if (ImGui::Button(ui->reversing ? "Stop##reverse" : "Reverse##reverse", ImVec2(80, 0))) {
+        ui->reversing = !ui->reversing;
+        set_running(ui, false);
+    }
+
+    ImGui::EndDisabled();
+    if (undo_on) {
+        ImGui::Text("%d instructions to step back", undoable);
+    }
+
     if (!has_rom) ImGui::EndDisabled();
 
+    // Profile
+    ImGui::SeparatorText("Profile");
+
+    if (!has_rom) ImGui::BeginDisabled();
+
+    bool profile_on = ui->state.profiling;
+    if (ImGui::Checkbox("Count executions", &profile_on)) {
+        if (profile_on) {
+            chip8_profile_enable(borrow_chip(ui));
+        } else {
+            chip8_profile_disable(borrow_chip(ui));
+        }
+    }
+    if (profile_on && ui->state.profiling) {
+        ImGui::SameLine();
+        if (ImGui::Button("Reset##profile")) {
+            chip8_profile_reset(borrow_chip(ui));
+        }
+
+        // the routines worth optimizing or fusing
+        const Chip8ProfileSpot* spots = ui->profile.hotspots;
+        int count = (ui->profile.hotspot_count < 5) ? ui->profile.hotspot_count : 5;
+        uint64_t total = 0;
+        for (int a = 0; a < CHIP8_MEMORY_SIZE; a++) total += ui->profile.executions[a];
+        for (int s = 0; s < count && total > 0; s++) {
+            char disasm[64];
+            disassemble_at(ui, spots[s].address, disasm, sizeof(disasm));
+            ImGui::Text("0x%03X %5.1f%% %s", spots[s].address, 100.0 * spots[s].executions / total, disasm);
+        }
+    }
+
+    if (!has_rom) ImGui::EndDisabled();
+
+    // Rewind
+    ImGui::SeparatorText("Rewind");
+
+    if (has_rom && ui->rewind) {
+        int count = chip8_rewind_count(ui->rewind);
+        int frame = (ui->rewind_frame >= 0) ? ui->rewind_frame : count - 1;
+
+        ImGui::BeginDisabled(count == 0);
+        ImGui::SetNextItemWidth(260);
+        if (ImGui::SliderInt("##rewind", &frame, 0, count > 0 ? count - 1 : 0, "frame %d") &&
+            chip8_rewind_seek(ui->rewind, frame, borrow_chip(ui))) {
+            // scrubbing pauses and leaves the movie; running again continues the history from here
+            stop_movie(ui);
+            set_running(ui, false);
+            ui->rewind_frame = frame;
+        }
+        ImGui::EndDisabled();
+        ImGui::Text("%.1f s of history in %.2f MB", count / 60.0f,
+                    chip8_rewind_memory_used(ui->rewind) / (1024.0f * 1024.0f));
+    } else {
+        ImGui::TextDisabled("No history");
+    }
+
     // Status
     ImGui::SeparatorText("Status");
 
     if (has_rom) {
         const char* status;
-        if (chip8_is_halted(ui->chip))  status = "HALTED";
-        else if (ui->running)           status = "running";
-        else                            status = "paused";
-
-        ImGui::Text("State: %s", status);
-        ImGui::Text("Cycles: %llu", (unsigned long long)chip8_get_cycle_count(ui->chip));
-        ImGui::Text("Speed: %d cycles/frame", ui->cycles_per_frame);
+        if (ui->state.halted)  status = "HALTED";
+        else if (ui->running)  status = "running";
+        else                   status = "paused";
+
+        const Chip8WatchHit* hit = ui->state.has_watch_hit ? &ui->state.watch_hit : nullptr;
+        if (ui->stop_reason == CHIP8_STOP_BREAKPOINT || ui->stop_reason == CHIP8_STOP_TARGET) {
+            ImGui::Text("State: %s at %s 0x%03X", status,
+                        chip8_stop_reason_name((Chip8StopReason)ui->stop_reason), ui->state.PC);
+        } else if (ui->stop_reason == CHIP8_STOP_WATCHPOINT && hit) {
+            ImGui::Text("State: %s after watchpoint, 0x%03X at cycle %llu", status, hit->pc,
+                        (unsigned long long)hit->cycle);
+            if (hit->kind == CHIP8_WATCH_CHANGE) {
+                ImGui::Text("  %s: 0x%02X -> 0x%02X", chip8_watch_register_name((Chip8WatchRegister)hit->target),
+                            hit->old_value, hit->new_value);
+            } else if (hit->kind == CHIP8_WATCH_WRITE) {
+                ImGui::Text("  wrote [0x%03X]: 0x%02X -> 0x%02X", hit->target, hit->old_value, hit->new_value);
+            } else {
+                ImGui::Text("  read [0x%03X]: 0x%02X", hit->target, hit->new_value);
+            }
+        } else {
+            ImGui::Text("State: %s", status);
+        }
+        ImGui::Text("Cycles: %llu", (unsigned long long)ui->state.cycle_count);
+        ImGui::Text("Speed: %d cycles/frame (%.0f%% idle)", ui->cycles_per_frame, ui->idle_fraction * 100.0f);
+        ImGui::BeginDisabled(ui->auto_speed);
         ImGui::SetNextItemWidth(160);
         ImGui::SliderInt("##speed", &ui->cycles_per_frame, 1, 100, "%d cycles/frame");
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::Checkbox("Auto##speed", &ui->auto_speed);
+        ImGui::SameLine();
+        ImGui::Checkbox("Turbo", &ui->turbo); // as fast as the host goes, for skipping ahead
+
+        Chip8Backend current = (Chip8Backend)ui->state.backend;
+        ImGui::SetNextItemWidth(160);
+        if (ImGui::BeginCombo("Backend##backend", chip8_backend_name(current))) {
+            for (int b = 0; b < CHIP8_BACKEND_COUNT; b++) {
+                if (!chip8_backend_available((Chip8Backend)b)) continue;
+                if (b == CHIP8_BACKEND_AOT && !ui->state.has_aot) continue;
+
+                if (ImGui::Selectable(chip8_backend_name((Chip8Backend)b), b == (int)current)) {
+                    chip8_set_backend(borrow_chip(ui), (Chip8Backend)b);
+                    ui->backend = b;
+                }
+            }
+            ImGui::EndCombo();
+        }
     } else {
         ImGui::TextDisabled("Load a ROM to begin");
     }
@@ -145,13 +570,14 @@ static void render_cpu_state(Chip8UI* ui) {
     ImGui::Begin("CPU State", &ui->show_cpu_state);
 
     ImGui::SeparatorText("Registers");
-    ImGui::Text("PC : 0x%03X (%d)", chip8_get_pc(ui->chip), chip8_get_pc(ui->chip));
-    ImGui::Text("I  : 0x%03X (%d)", chip8_get_i(ui->chip), chip8_get_i(ui->chip));
-    ImGui::Text("SP : 0x%03X (%d)", chip8_get_sp(ui->chip), chip8_get_sp(ui->chip));
+    const Chip8RunnerState* state = &ui->state;
+    ImGui::Text("PC : 0x%03X (%d)", state->PC, state->PC);
+    ImGui::Text("I  : 0x%03X (%d)", state->I, state->I);
+    ImGui::Text("SP : 0x%03X (%d)", state->SP, state->SP);
 
     ImGui::SeparatorText("Timers");
-    ImGui::Text("Delay  : %d", chip8_get_delay_timer(ui->chip));
-    ImGui::Text("Sound  : %d", chip8_get_sound_timer(ui->chip));
+    ImGui::Text("Delay  : %d", state->delay_timer);
+    ImGui::Text("Sound  : %d", state->sound_timer);
 
     ImGui::SeparatorText("V0-VF");
     ImGui::Columns(4, "vregs", true);
@@ -162,7 +588,7 @@ static void render_cpu_state(Chip8UI* ui) {
     ImGui::Separator();
 
     for (int i = 0; i < CHIP8_NUM_REGISTERS; i++) {
-        uint8_t v = chip8_get_register(ui->chip, i);
+        uint8_t v = (uint8_t)state->V[i];
 
         ImGui::Text("V%0X", i); ImGui::NextColumn();
         ImGui::Text("0x%02X", v); ImGui::NextColumn();
@@ -177,16 +603,40 @@ static void render_cpu_state(Chip8UI* ui) {
 
     ImGui::Columns(1, nullptr, false);
 
+    ImGui::SeparatorText("Watch");
+    // stop a run when the guest changes any checked register
+    for (int r = 0; r < CHIP8_WATCH_REGISTER_COUNT; r++) {
+        Chip8WatchRegister reg = (Chip8WatchRegister)r;
+        bool watched = (state->watched_registers >> r) & 1;
+        if (r % 8 != 0) ImGui::SameLine();
+        if (ImGui::Checkbox(chip8_watch_register_name(reg), &watched)) {
+            chip8_watch_register(borrow_chip(ui), reg, watched);
+        }
+    }
+
     ImGui::SeparatorText("Call Stack");
-    uint8_t sp = chip8_get_sp(ui->chip);
+    uint8_t sp = state->SP;
     if (sp == 0) {
         ImGui::TextDisabled("(Empty)");
     } else {
         for (int i = sp - 1; i >= 0; i--) {
-            ImGui::Text("[%d] 0x%03X", i, chip8_get_stack(ui->chip, i));
+            ImGui::Text("[%d] 0x%03X", i, state->stack[i]);
         }
     }
 
+    ImGui::SeparatorText("Diagnostics");
+    bool any = false;
+    for (int d = 0; d < CHIP8_DIAG_COUNT; d++) {
+        uint64_t count = state->diag_counts[d];
+        if (count > 0) {
+            ImGui::Text("%s: %llu", chip8_diag_name((Chip8DiagCode)d), (unsigned long long)count);
+            any = true;
+        }
+    }
+    if (!any) {
+        ImGui::TextDisabled("(None)");
+    }
+
     ImGui::End();
 }
 
@@ -202,9 +652,16 @@ static void render_display(Chip8UI* ui) {
         return;
     }
 
-    if (chip8_should_draw(ui->chip)) {
-        upload_display_texture(ui);
+    // only the rows that changed since the last frame shown go to the texture
+    const uint64_t* rows = chip8_runner_take_display(ui->runner);
+    if (rows) {
+        for (int y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) {
+            if (rows[y] != ui->display_rows[y]) ui->display_dirty |= 1u << y;
+        }
+        memcpy(ui->display_rows, rows, sizeof(ui->display_rows));
     }
+    upload_display_texture(ui, ui->display_dirty);
+    ui->display_dirty = 0;
 
     ImVec2 available = ImGui::GetContentRegionAvail();
 
@@ -229,6 +686,92 @@ static void render_display(Chip8UI* ui) {
     ImGui::End();
 }
 
+/*
+    Heat is the count of the last frame plus most of the heat before it, so an address
+    that stops being touched fades out over a second or so.
+*/
+static void update_heat(Chip8UI* ui) {
+    const float decay = 0.92f;
+    const uint64_t* counters[3] = { ui->profile.executions, ui->profile.reads, ui->profile.writes };
+
+    for (int k = 0; k < 3; k++) {
+        float hottest = 0.0f;
+        for (int a = 0; a < CHIP8_MEMORY_SIZE; a++) {
+            uint64_t count = counters[k][a];
+            // counters that went down were reset
+            uint64_t delta = (count >= ui->heat_seen[k][a]) ? count - ui->heat_seen[k][a] : count;
+            ui->heat_seen[k][a] = count;
+            ui->heat[k][a] = ui->heat[k][a] * decay + (float)delta;
+            if (ui->heat[k][a] > hottest) hottest = ui->heat[k][a];
+        }
+        ui->heat_max[k] = hottest;
+    }
+}
+
+// Writes in red, reads in green and executions in blue, on a log scale
+static ImU32 heat_color(Chip8UI* ui, int address) {
+    float channel[3];
+    float strongest = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        float heat = ui->heat[k][address];
+        channel[k] = (ui->heat_max[k] >= 1.0f && heat > 0.0f) ? logf(1.0f + heat) / logf(1.0f + ui->heat_max[k]) : 0.0f;
+        if (channel[k] > strongest) strongest = channel[k];
+    }
+    return ImGui::GetColorU32(ImVec4(channel[2], channel[1], channel[0], strongest * 0.7f));
+}
+
+// Memory watchpoint list and editor, above the dump
+static void render_watchpoints(Chip8UI* ui) {
+    if (!ImGui::CollapsingHeader("Watchpoints")) return;
+
+    for (int id = 0; id < CHIP8_WATCH_MAX; id++) {
+        const Chip8MemoryWatch* watch = &ui->state.watches[id];
+        if (watch->length == 0) continue;
+
+        ImGui::PushID(id);
+        if (ImGui::SmallButton("x")) {
+            chip8_watch_remove(borrow_chip(ui), id);
+        }
+        ImGui::SameLine();
+        ImGui::Text("0x%03X-0x%03X  %c%c  %llu hits", watch->start, (watch->start + watch->length - 1) % CHIP8_MEMORY_SIZE,
+                    (watch->access & CHIP8_WATCH_READ) ? 'R' : '-', (watch->access & CHIP8_WATCH_WRITE) ? 'W' : '-',
+                    (unsigned long long)watch->hits);
+        ImGui::PopID();
+    }
+
+    ImGui::SetNextItemWidth(60);
+    ImGui::InputTextWithHint("##watch_start", "addr", ui->watch_start, sizeof(ui->watch_start),
+                             ImGuiInputTextFlags_CharsHexadecimal);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(60);
+    ImGui::InputTextWithHint("##watch_length", "bytes", ui->watch_length, sizeof(ui->watch_length),
+                             ImGuiInputTextFlags_CharsDecimal);
+    ImGui::SameLine();
+    ImGui::Checkbox("Read##watch", &ui->watch_read);
+    ImGui::SameLine();
+    ImGui::Checkbox("Write##watch", &ui->watch_write);
+    ImGui::SameLine();
+    if (ImGui::Button("Add##watch")) {
+        unsigned int start = 0, length = 0;
+        uint8_t access = (ui->watch_read ? CHIP8_WATCH_READ : 0) | (ui->watch_write ? CHIP8_WATCH_WRITE : 0);
+        if (sscanf(ui->watch_start, "%x", &start) != 1 || start >= CHIP8_MEMORY_SIZE) {
+            snprintf(ui->watch_error, sizeof(ui->watch_error), "address must be 0-FFF");
+        } else if (sscanf(ui->watch_length, "%u", &length) != 1 || length == 0 || length > CHIP8_MEMORY_SIZE) {
+            snprintf(ui->watch_error, sizeof(ui->watch_error), "length must be 1-4096");
+        } else if (!access) {
+            snprintf(ui->watch_error, sizeof(ui->watch_error), "watch reads, writes or both");
+        } else if (chip8_watch_memory(borrow_chip(ui), (uint16_t)start, (uint16_t)length, access) < 0) {
+            snprintf(ui->watch_error, sizeof(ui->watch_error), "all %d watchpoints are taken", CHIP8_WATCH_MAX);
+        } else {
+            ui->watch_error[0] = '\0';
+        }
+    }
+    if (ui->watch_error[0]) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", ui->watch_error);
+    }
+    ImGui::Separator();
+}
+
 static void render_memory(Chip8UI* ui) {
     if (!ui || !ui->chip || !ui->show_memory) return;
 
@@ -236,9 +779,17 @@ static void render_memory(Chip8UI* ui) {
 
     ImGui::SetNextItemWidth(200);
     ImGui::SliderInt("Cols##mem", &ui->memory_cols, 1, 16, "%d bytes/row");
-
-    const uint8_t* mem = chip8_get_memory(ui->chip);
-    uint16_t pc = chip8_get_pc(ui->chip);
+    bool profiling = ui->state.profiling;
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!profiling);
+    ImGui::Checkbox("Heat map", &ui->show_heat);
+    ImGui::EndDisabled();
+    bool heat = profiling && ui->show_heat;
+    ImVec2 cell = ImGui::CalcTextSize("00");
+    render_watchpoints(ui);
+
+    const uint8_t* mem = ui->state.memory;
+    uint16_t pc = ui->state.PC;
 
     ImGui::BeginChild("MemScroll");
 
@@ -260,6 +811,12 @@ static void render_memory(Chip8UI* ui) {
         for (int c = 0; c < cols; c++) {
             uint16_t addr = (uint16_t)(base+c);
 
+            if (heat) {
+                ImVec2 at = ImGui::GetCursorScreenPos();
+                if (pc == addr) at.x += ImGui::CalcTextSize(">").x;
+                ImGui::GetWindowDrawList()->AddRectFilled(at, ImVec2(at.x + cell.x, at.y + cell.y), heat_color(ui, addr));
+            }
+
             if (pc == addr) {
                 ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), ">%02X", mem[addr]);
             } else {
@@ -287,15 +844,64 @@ static void render_memory(Chip8UI* ui) {
     ImGui::End();
 }
 
+// Breakpoint list and editor, above the listing
+static void render_breakpoints(Chip8UI* ui) {
+    if (!ImGui::CollapsingHeader("Breakpoints")) return;
+
+    for (int b = 0; b < ui->state.breakpoint_count; b++) {
+        const Chip8RunnerBreakpoint* breakpoint = &ui->state.breakpoint_list[b];
+
+        ImGui::PushID(breakpoint->address);
+        if (ImGui::SmallButton("x")) {
+            chip8_break_clear(borrow_chip(ui), breakpoint->address);
+        }
+        ImGui::SameLine();
+        ImGui::Text("0x%03X  %-24s %llu hits", breakpoint->address,
+                    breakpoint->condition[0] ? breakpoint->condition : "(always)",
+                    (unsigned long long)breakpoint->hits);
+        ImGui::PopID();
+    }
+
+    // conditions: V0-VF I PC SP DT ST [address], e.g. V3 == 0x10 && I > 0x300
+    ImGui::SetNextItemWidth(60);
+    ImGui::InputText("##break_address", ui->break_address, sizeof(ui->break_address),
+                     ImGuiInputTextFlags_CharsHexadecimal);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(220);
+    ImGui::InputTextWithHint("##break_condition", "condition (optional)", ui->break_condition,
+                             sizeof(ui->break_condition));
+    ImGui::SameLine();
+    if (ImGui::Button("Add##break")) {
+        unsigned int address = 0;
+        if (sscanf(ui->break_address, "%x", &address) != 1 || address >= CHIP8_MEMORY_SIZE) {
+            snprintf(ui->break_error, sizeof(ui->break_error), "address must be 0-FFF");
+        } else if (chip8_break_check_condition(ui->break_condition, ui->break_error, sizeof(ui->break_error))) {
+            chip8_break_set(borrow_chip(ui), (uint16_t)address, ui->break_condition);
+            ui->break_error[0] = '\0';
+        }
+    }
+    if (ui->break_error[0]) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", ui->break_error);
+    }
+    ImGui::Separator();
+}
+
 static void render_disassembly(Chip8UI* ui) {
     if (!ui->show_disassembly || !ui->chip) return;
 
     ImGui::Begin("Disassembly", &ui->show_disassembly);
     ImGui::Checkbox("Follow PC", &ui->follow_pc);
+    ImGui::SameLine();
+    ImGui::TextDisabled("(click: breakpoint, right-click: more)");
+
+    render_breakpoints(ui);
 
     ImGui::BeginChild("DisasmScroll");
 
-    uint16_t pc = chip8_get_pc(ui->chip);
+    const uint8_t* mem = ui->state.memory;
+    uint16_t pc = ui->state.PC;
+    // exec count column while profiling
+    const uint64_t* executions = ui->state.profiling ? ui->profile.executions : nullptr;
 
     for (int addr = 0x200; addr < CHIP8_MEMORY_SIZE - 1; addr += 2) {
         bool is_pc = ((uint16_t)addr == pc);
@@ -307,12 +913,43 @@ static void render_disassembly(Chip8UI* ui) {
                 ImGui::SetScrollHereY(0.5f);
         }
 
-        uint16_t opcode = chip8_read_opcode(ui->chip, (uint16_t)addr);
+        uint16_t opcode = (uint16_t)(mem[addr] << 8 | mem[addr + 1]);
         char disasm[64];
-        chip8_disassemble(ui->chip, (uint16_t)addr, disasm, sizeof(disasm));
+        chip8_disassemble_opcode(opcode, disasm, sizeof(disasm));
+
+        bool is_break = (ui->state.breakpoints[addr / 64] >> (addr % 64)) & 1;
+        char row[160];
+        if (executions) {
+            snprintf(row, sizeof(row), "%c%c 0x%03X | %04X | %12llu | %s##%03X", is_break ? '*' : ' ',
+                     is_pc ? '>' : ' ', addr, opcode, (unsigned long long)executions[addr], disasm, addr);
+        } else {
+            snprintf(row, sizeof(row), "%c%c 0x%03X | %04X | %s##%03X", is_break ? '*' : ' ',
+                     is_pc ? '>' : ' ', addr, opcode, disasm, addr);
+        }
 
-        ImGui::Text("%c 0x%03X | %04X | %s",
-                    is_pc ? '>' : ' ', addr, opcode, disasm);
+        if (ImGui::Selectable(row, is_break)) {
+            if (is_break) {
+                chip8_break_clear(borrow_chip(ui), (uint16_t)addr);
+            } else {
+                chip8_break_set(borrow_chip(ui), (uint16_t)addr, NULL);
+            }
+        }
+        if (ImGui::BeginPopupContextItem()) {
+            if (ImGui::MenuItem("Run to here")) {
+                run_to_cursor(ui, (uint16_t)addr);
+            }
+            if (ImGui::MenuItem("Edit condition...")) {
+                // the editor above takes it from here
+                snprintf(ui->break_address, sizeof(ui->break_address), "%03X", addr);
+                ui->break_condition[0] = '\0';
+                for (int b = 0; b < ui->state.breakpoint_count; b++) {
+                    const Chip8RunnerBreakpoint* breakpoint = &ui->state.breakpoint_list[b];
+                    if (breakpoint->address != addr) continue;
+                    snprintf(ui->break_condition, sizeof(ui->break_condition), "%s", breakpoint->condition);
+                }
+            }
+            ImGui::EndPopup();
+        }
 
         if (is_pc)
             ImGui::PopStyleColor();
@@ -322,6 +959,289 @@ static void render_disassembly(Chip8UI* ui) {
     ImGui::End();
 }
 
+// The listing covers a window of records around the selection, which keeps scroll
+// offsets small enough for float precision in traces of any length
+#define TRACE_WINDOW ((int64_t)1 << 20)
+
+static void trace_select(Chip8UI* ui, int64_t record) {
+    if (record < 0) return; // not found, stay put
+
+    const Chip8TraceRecord* selected = &chip8_trace_records(ui->trace)[record];
+    ui->trace_selected = record;
+    ui->trace_cycle = selected->cycle;
+    ui->trace_pc = selected->pc;
+    ui->trace_opcode = selected->opcode;
+    if (chip8_trace_changed_register(selected->opcode) >= 0) {
+        ui->trace_reg = chip8_trace_changed_register(selected->opcode);
+    }
+    if (record < ui->trace_base || record >= ui->trace_base + TRACE_WINDOW) {
+        ui->trace_base = (record > TRACE_WINDOW / 2) ? record - TRACE_WINDOW / 2 : 0;
+    }
+    ui->trace_scroll = true;
+}
+
+// Previous/next buttons for one kind of search, from the selected record
+static void trace_search_buttons(Chip8UI* ui, const char* id, Chip8TraceKey key, uint16_t value) {
+    ImGui::PushID(id);
+    ImGui::SameLine();
+    if (ImGui::ArrowButton("##prev", ImGuiDir_Up)) {
+        int64_t from = (ui->trace_selected >= 0) ? ui->trace_selected : (int64_t)chip8_trace_count(ui->trace);
+        trace_select(ui, chip8_trace_find(ui->trace, key, value, from, true));
+    }
+    ImGui::SameLine();
+    if (ImGui::ArrowButton("##next", ImGuiDir_Down)) {
+        trace_select(ui, chip8_trace_find(ui->trace, key, value, ui->trace_selected, false));
+    }
+    ImGui::PopID();
+}
+
+static void render_trace(Chip8UI* ui) {
+    if (!ui->show_trace) return;
+
+    ImGui::Begin("Trace", &ui->show_trace);
+
+    if (ImGui::Button("Open...")) {
+        open_trace_dialog(ui);
+    }
+    ImGui::SameLine();
+    if (!ui->trace) {
+        ImGui::TextDisabled("(No trace, see File > Start Trace)");
+        ImGui::End();
+        return;
+    }
+    if (ImGui::Button("Close")) {
+        chip8_trace_close(&ui->trace);
+        ImGui::End();
+        return;
+    }
+
+    int64_t count = (int64_t)chip8_trace_count(ui->trace);
+    ImGui::SameLine();
+    ImGui::Text("%lld instructions", (long long)count);
+
+    // every search is answered from the trace's index
+    ImGui::SetNextItemWidth(160);
+    ImGui::InputScalar("##cycle", ImGuiDataType_U64, &ui->trace_cycle);
+    ImGui::SameLine();
+    if (ImGui::Button("Go to cycle")) {
+        trace_select(ui, chip8_trace_find_cycle(ui->trace, ui->trace_cycle));
+    }
+
+    ImGui::SetNextItemWidth(60);
+    ImGui::InputScalar("PC", ImGuiDataType_U16, &ui->trace_pc, nullptr, nullptr, "%03X",
+                       ImGuiInputTextFlags_CharsHexadecimal);
+    trace_search_buttons(ui, "pc", CHIP8_TRACE_BY_PC, ui->trace_pc);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(60);
+    ImGui::InputScalar("Opcode", ImGuiDataType_U16, &ui->trace_opcode, nullptr, nullptr, "%04X",
+                       ImGuiInputTextFlags_CharsHexadecimal);
+    trace_search_buttons(ui, "opcode", CHIP8_TRACE_BY_OPCODE, ui->trace_opcode);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80);
+    ImGui::SliderInt("Write", &ui->trace_reg, 0, CHIP8_NUM_REGISTERS - 1, "V%X");
+    trace_search_buttons(ui, "write", CHIP8_TRACE_BY_WRITE, (uint16_t)ui->trace_reg);
+
+    int64_t shown = (count - ui->trace_base < TRACE_WINDOW) ? count - ui->trace_base : TRACE_WINDOW;
+    if (count > TRACE_WINDOW) {
+        ImGui::BeginDisabled(ui->trace_base == 0);
+        if (ImGui::Button("Earlier")) {
+            ui->trace_base = (ui->trace_base > TRACE_WINDOW / 2) ? ui->trace_base - TRACE_WINDOW / 2 : 0;
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(ui->trace_base + shown == count);
+        if (ImGui::Button("Later")) {
+            int64_t last = count - TRACE_WINDOW;
+            ui->trace_base = (ui->trace_base + TRACE_WINDOW / 2 < last) ? ui->trace_base + TRACE_WINDOW / 2 : last;
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::Text("Listing %lld-%lld", (long long)ui->trace_base, (long long)(ui->trace_base + shown - 1));
+    }
+
+    ImGui::Separator();
+    ImGui::BeginChild("TraceScroll");
+
+    float row_height = ImGui::GetTextLineHeightWithSpacing();
+    if (ui->trace_scroll) {
+        ImGui::SetScrollY((float)(ui->trace_selected - ui->trace_base) * row_height - ImGui::GetWindowHeight() * 0.5f);
+        ui->trace_scroll = false;
+    }
+
+    // only the visible rows are read from the mapping
+    const Chip8TraceRecord* records = chip8_trace_records(ui->trace);
+    ImGuiListClipper clipper;
+    clipper.Begin((int)shown, row_height);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            int64_t r = ui->trace_base + row;
+            const Chip8TraceRecord* record = &records[r];
+
+            char disasm[64];
+            chip8_disassemble_opcode(record->opcode, disasm, sizeof(disasm));
+            char line[160];
+            int written = chip8_trace_changed_register(record->opcode);
+            if (written >= 0) {
+                snprintf(line, sizeof(line), "%12llu  0x%03X | %-28s I=0x%03X  V%X=0x%02X",
+                         (unsigned long long)record->cycle, record->pc, disasm, record->i, written, record->value);
+            } else {
+                snprintf(line, sizeof(line), "%12llu  0x%03X | %-28s I=0x%03X",
+                         (unsigned long long)record->cycle, record->pc, disasm, record->i);
+            }
+
+            ImGui::PushID(row);
+            if (ImGui::Selectable(line, r == ui->trace_selected)) {
+                trace_select(ui, r);
+                ui->trace_scroll = false;
+            }
+            ImGui::PopID();
+        }
+    }
+
+    ImGui::EndChild();
+    ImGui::End();
+}
+
+static void export_folded_dialog(Chip8UI* ui) {
+    char default_path[300];
+    snprintf(default_path, sizeof(default_path), "%s.folded", ui->rom_path);
+    const char* filter_patterns[] = { "*.folded", "*.txt" };
+    return_chip(ui); // the dialog is modal, the ROM goes on meanwhile
+    const char* path = tinyfd_saveFileDialog(
+        "Export Folded Stacks", default_path, 2, filter_patterns, "Folded stacks"
+    );
+    if (path && chip8_profile_export_folded(borrow_chip(ui), path)) {
+        printf("Exported folded stacks: %s\n", path);
+    }
+}
+
+// The sampler samples the thread that starts it, which has to be the runner's, and
+// is stopped there too, so its signal handler is never cut off mid-sample
+static void start_sampler(Chip8* chip, void* arg) {
+    (void)arg;
+    chip8_sampler_start(chip, CHIP8_SAMPLER_DEFAULT_HZ);
+}
+
+static void stop_sampler(Chip8* chip, void* arg) {
+    (void)arg;
+    chip8_sampler_stop(chip);
+}
+
+static void render_samples(Chip8UI* ui) {
+    static const char* const PHASE_LABELS[CHIP8_PHASE_COUNT] = {
+        "Host", "Interpreter", "Translated", "Compiler",
+    };
+
+    bool sampling = ui->state.sampling;
+    if (ImGui::Checkbox("Sample at 1 kHz", &sampling)) {
+        return_chip(ui); // calls are not taken while borrowed
+        chip8_runner_call(ui->runner, sampling ? start_sampler : stop_sampler, nullptr);
+    }
+    if (!ui->state.sampling) return;
+
+    const Chip8SampleReport* report = &ui->profile.samples;
+    ImGui::SameLine();
+    if (ImGui::Button("Reset##samples")) {
+        chip8_sampler_reset(borrow_chip(ui));
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("%llu samples, %llu dropped",
+                        (unsigned long long)report->samples, (unsigned long long)report->dropped);
+    if (report->samples == 0) return;
+
+    // where the emulation thread's time goes, guest or host
+    for (int phase = 0; phase < CHIP8_PHASE_COUNT; phase++) {
+        if (phase > 0) ImGui::SameLine();
+        ImGui::Text("%s %4.1f%%", PHASE_LABELS[phase], 100.0 * report->phases[phase] / report->samples);
+    }
+
+    uint64_t guest = report->samples - report->phases[CHIP8_PHASE_HOST];
+    if (guest == 0) return;
+
+    uint16_t shown[5];
+    int count = 0;
+    for (; count < 5; count++) {
+        int best = -1;
+        for (int a = 0; a < CHIP8_MEMORY_SIZE; a++) {
+            if (!report->pcs[a] || (best >= 0 && report->pcs[a] <= report->pcs[best])) continue;
+            bool seen = false;
+            for (int s = 0; s < count; s++) seen |= (shown[s] == a);
+            if (!seen) best = a;
+        }
+        if (best < 0) break;
+        shown[count] = (uint16_t)best;
+
+        char disasm[64];
+        disassemble_at(ui, (uint16_t)best, disasm, sizeof(disasm));
+        ImGui::Text("0x%03X %5.1f%% %s", best, 100.0 * report->pcs[best] / guest, disasm);
+    }
+}
+
+// Shows the published sampler report and call tree
+static void render_profile(Chip8UI* ui) {
+    if (!ui->show_profile || !ui->chip) return;
+
+    ImGui::Begin("Profile", &ui->show_profile);
+
+    ImGui::SeparatorText("Sampler");
+    render_samples(ui);
+    ImGui::SeparatorText("Routines");
+
+    if (!ui->state.profiling) {
+        ImGui::TextDisabled("(Profiling is off, see Count executions in Controls)");
+        ImGui::End();
+        return;
+    }
+
+    if (ImGui::Button("Export folded stacks...")) {
+        export_folded_dialog(ui);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reset##routines")) {
+        chip8_profile_reset(borrow_chip(ui));
+    }
+
+    // Top routines, by cycles spent in them and their callees
+    const Chip8ProfileRoutine* routines = ui->profile.routines;
+    int count = ui->profile.routine_count;
+    uint64_t total = 0;
+    for (int r = 0; r < count; r++) {
+        if (routines[r].entry == CHIP8_PROFILE_TOP_LEVEL) total = routines[r].inclusive;
+    }
+
+    ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("routines", 4, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Routine");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Inclusive");
+        ImGui::TableSetupColumn("Exclusive");
+        ImGui::TableHeadersRow();
+
+        for (int r = 0; r < count; r++) {
+            const Chip8ProfileRoutine* routine = &routines[r];
+            double share = (total > 0) ? 100.0 / (double)total : 0.0;
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (routine->entry == CHIP8_PROFILE_TOP_LEVEL) {
+                ImGui::Text("(top level)");
+            } else {
+                ImGui::Text("0x%03X", routine->entry);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)routine->calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%5.1f%%", routine->inclusive * share);
+            ImGui::TableNextColumn();
+            ImGui::Text("%5.1f%%", routine->exclusive * share);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
 static void render_keyboard(Chip8UI* ui) {
     if (!ui->show_keyboard) return;
 
@@ -349,7 +1269,7 @@ static void render_keyboard(Chip8UI* ui) {
             uint8_t key = layout[row][col];
             if (col > 0) ImGui::SameLine(0, 4);
 
-            bool pressed = chip8_is_key_pressed(ui->chip, key);
+            bool pressed = ui->state.keys[key];
             if (pressed)
                 ImGui::PushStyleColor(ImGuiCol_Button,
                                       ImVec4(0.2f, 0.7f, 0.2f, 1.0f));
@@ -358,8 +1278,8 @@ static void render_keyboard(Chip8UI* ui) {
             snprintf(label, sizeof(label), "%X##k%X", key, key);
             ImGui::Button(label, btn);
 
-            if (ImGui::IsItemActivated())   chip8_key_press(ui->chip, key);
-            if (ImGui::IsItemDeactivated()) chip8_key_release(ui->chip, key);
+            if (ImGui::IsItemActivated())   send_key(ui, key, true);
+            if (ImGui::IsItemDeactivated()) send_key(ui, key, false);
 
             if (pressed) ImGui::PopStyleColor();
         }
@@ -386,7 +1306,24 @@ Chip8UI* chip8_ui_create() {
     ui->display_scale = 10.0f;
 
     ui->cycles_per_frame = 10;
+    ui->turbo = false;
+    ui->sent_cycles = -1;
+    ui->auto_speed = false;
+    ui->idle_fraction = 0.0f;
     ui->step_count = 10;
+    ui->reversing = false;
+    ui->backend = -1;
+    ui->stop_reason = -1;
+    ui->watch_length[0] = '1';
+    ui->watch_write = true;
+    ui->rewind = nullptr;
+    ui->rewind_frame = -1;
+    ui->movie = nullptr;
+    ui->trace = nullptr;
+    ui->trace_base = 0;
+    ui->trace_selected = -1;
+
+    ui->show_heat = true;
 
     ui->memory_cols = 8;
     ui->follow_pc = true;
@@ -406,6 +1343,7 @@ void chip8_ui_destroy(Chip8UI** ui_ptr) {
 
     Chip8UI* ui = *ui_ptr;
     chip8_ui_close_rom(ui);
+    chip8_trace_close(&ui->trace);
     glDeleteTextures(1, &ui->display_texture);
     free(ui);
     *ui_ptr = nullptr;
@@ -432,9 +1370,34 @@ bool chip8_ui_load_rom(Chip8UI* ui, const char* path) {
         return false;
     }
 
+    if (ui->backend >= 0) {
+        chip8_set_backend(ui->chip, (Chip8Backend)ui->backend);
+    }
+    printf("Loaded ROM: %s (%zu bytes)\n", path_copy, ui->chip->rom_size);
+
     strncpy(ui->rom_path, path_copy, sizeof(ui->rom_path) - 1);
     ui->rom_path[sizeof(ui->rom_path) - 1] = '\0';
     ui->running = false;
+
+    // without history the debugger still works, just without the scrubber
+    ui->rewind = chip8_rewind_create(0, 0);
+    ui->rewind_frame = -1;
+    if (ui->rewind) {
+        chip8_rewind_push(ui->rewind, ui->chip);
+    }
+
+    ui->runner = chip8_runner_create(ui->chip, on_emulation_frame, ui);
+    if (!ui->runner) {
+        chip8_ui_close_rom(ui);
+        return false;
+    }
+    read_published(ui);
+    memset(ui->keys, 0, sizeof(ui->keys));
+    memset(ui->display_rows, 0, sizeof(ui->display_rows));
+    ui->display_dirty = ~0u;
+    ui->seen_cycles = 0;
+    ui->seen_idle = 0;
+    ui->sent_cycles = -1;
     return true;
 }
 
@@ -442,35 +1405,98 @@ void chip8_ui_close_rom(Chip8UI* ui) {
     if (!ui) return;
 
     if (ui->chip) {
+        return_chip(ui);
+        chip8_runner_call(ui->runner, stop_sampler, nullptr); // off the thread it samples, before that goes
+        chip8_runner_destroy(&ui->runner); // the instance is ours for good
+        stop_recording(ui); // a recording is saved rather than lost with the ROM
         chip8_destroy(&ui->chip);
     }
+    chip8_movie_destroy(&ui->movie);
+    chip8_rewind_destroy(&ui->rewind);
+    ui->rewind_frame = -1;
     ui->running = false;
+    ui->reversing = false;
     ui->rom_path[0] = '\0';
 }
 
 void chip8_ui_update(Chip8UI* ui) {
-    if (!ui || !ui->chip || !ui->running) return;
-    if (chip8_is_halted(ui->chip)) {return; }
+    if (!ui || !ui->chip) return;
+
+    read_published(ui);
+
+    // a run the runner ended itself (breakpoint, watchpoint, halt); the state has to
+    // have seen every command first, or it may predate the last Run
+    if (ui->running && !ui->movie && !ui->state.running && ui->state.commands == chip8_runner_sent(ui->runner)) {
+        ui->running = false;
+        if (ui->state.stop_reason >= 0) ui->stop_reason = ui->state.stop_reason;
+    }
+
+    if (ui->reversing) {
+        // runs backwards at the forward speed until the log is used up or a breakpoint comes up
+        Chip8* chip = borrow_chip(ui);
+        for (int i = 0; i < ui->cycles_per_frame; i++) {
+            if (!chip8_step_back(chip)) {
+                ui->reversing = false;
+                break;
+            }
+            if (chip8_break_at_pc(chip)) {
+                ui->reversing = false;
+                ui->stop_reason = CHIP8_STOP_BREAKPOINT;
+                break;
+            }
+        }
+        return_chip(ui);
+        return;
+    }
+
+    if (ui->running && ui->movie) {
+        // the movie brings its own cycle counts, keys and ticks, one frame per UI frame
+        Chip8* chip = borrow_chip(ui);
+        if (chip8_movie_play(ui->movie, chip, 1) == 0) {
+            stop_movie(ui);
+            set_running(ui, false);
+            return;
+        }
+        chip8_rewind_push(ui->rewind, chip);
+        return_chip(ui);
+    }
 
-    for (int i = 0; i < ui->cycles_per_frame; i++) {
-        if (!chip8_step(ui->chip)) break;
+    // counts that went down were loaded from a state
+    if (ui->state.cycle_count > ui->seen_cycles && ui->state.idle_cycles >= ui->seen_idle) {
+        ui->idle_fraction = (float)(ui->state.idle_cycles - ui->seen_idle) /
+                            (float)(ui->state.cycle_count - ui->seen_cycles);
     }
+    ui->seen_cycles = ui->state.cycle_count;
+    ui->seen_idle = ui->state.idle_cycles;
 
-    chip8_update_timers(ui->chip);
+    if (ui->running && ui->auto_speed) {
+        tune_speed(ui);
+    }
+    if (ui->cycles_per_frame != ui->sent_cycles || ui->turbo != ui->sent_turbo) {
+        chip8_runner_set_speed(ui->runner, ui->cycles_per_frame, ui->turbo);
+        ui->sent_cycles = ui->cycles_per_frame;
+        ui->sent_turbo = ui->turbo;
+    }
 }
 
 void chip8_ui_render(Chip8UI* ui) {
     if (!ui) return;
+    if (ui->chip && ui->state.profiling) {
+        update_heat(ui);
+    }
     render_controls(ui);
     render_display(ui);
     render_cpu_state(ui);
     render_memory(ui);
     render_disassembly(ui);
+    render_trace(ui);
+    render_profile(ui);
     render_keyboard(ui);
+    return_chip(ui); // the runner goes on with whatever the windows did
 }
 
 void chip8_ui_process_keyboard(Chip8UI* ui, GLFWwindow* window) {
-    if (!ui || !ui->chip) return;
+    if (!ui || !ui->runner || ui->movie) return;
 
     static const struct { int glfw; uint8_t chip8; } map[] = {
         { GLFW_KEY_1, 0x1 }, { GLFW_KEY_2, 0x2 },
@@ -484,10 +1510,7 @@ void chip8_ui_process_keyboard(Chip8UI* ui, GLFWwindow* window) {
     };
 
     for (int i = 0; i < 16; i++) {
-        if (glfwGetKey(window, map[i].glfw) == GLFW_PRESS)
-            chip8_key_press(ui->chip,   map[i].chip8);
-        else
-            chip8_key_release(ui->chip, map[i].chip8);
+        send_key(ui, map[i].chip8, glfwGetKey(window, map[i].glfw) == GLFW_PRESS);
     }
 }
 
@@ -518,6 +1541,43 @@ void render_dockspace(Chip8UI* ui) {
             if (ImGui::MenuItem("Close ROM", "Ctrl+W", false, ui->chip != nullptr)) {
                 chip8_ui_close_rom(ui);
             }
+            if (ImGui::MenuItem("Quick Save", nullptr, false, ui->chip != nullptr)) {
+                quick_save(ui);
+            }
+            if (ImGui::MenuItem("Quick Load", nullptr, false, ui->chip != nullptr)) {
+                quick_load(ui);
+            }
+            ImGui::Separator();
+            bool recording = ui->chip && ui->state.recording;
+            if (ImGui::MenuItem(recording ? "Stop Recording" : "Start Recording", nullptr, false,
+                                ui->chip != nullptr && !ui->movie)) {
+                if (recording) {
+                    stop_recording(ui);
+                } else {
+                    start_recording(ui);
+                }
+            }
+            if (ImGui::MenuItem(ui->movie ? "Stop Movie" : "Play Movie", nullptr, false,
+                                ui->chip != nullptr && !recording)) {
+                if (ui->movie) {
+                    stop_movie(ui);
+                    set_running(ui, ui->running); // a running ROM goes on from where the movie left it
+                } else {
+                    play_movie(ui);
+                }
+            }
+            bool tracing = ui->chip && ui->state.tracing;
+            if (ImGui::MenuItem(tracing ? "Stop Trace" : "Start Trace", nullptr, false, ui->chip != nullptr)) {
+                toggle_trace(ui);
+            }
+            if (ImGui::MenuItem("Open Trace...")) {
+                open_trace_dialog(ui);
+            }
+            ImGui::Separator();
+            if (ImGui::MenuItem("Load AOT Module...", nullptr, false,
+                                ui->chip != nullptr && chip8_backend_available(CHIP8_BACKEND_AOT))) {
+                open_aot_dialog(ui);
+            }
             ImGui::Separator();
             if (ImGui::MenuItem("Exit", "Ctrl+Q")) {
                 ui->exit_requested = true;
@@ -532,6 +1592,8 @@ void render_dockspace(Chip8UI* ui) {
             ImGui::MenuItem("Memory",      nullptr, &ui->show_memory);
             ImGui::MenuItem("Disassembly", nullptr, &ui->show_disassembly);
             ImGui::MenuItem("Keyboard",    nullptr, &ui->show_keyboard);
+            ImGui::MenuItem("Trace",       nullptr, &ui->show_trace);
+            ImGui::MenuItem("Profile",     nullptr, &ui->show_profile);
             ImGui::EndMenu();
         }
         
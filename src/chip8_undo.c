@@ -0,0 +1,305 @@
+#include "../include/chip8_undo.h"
+#include "chip8_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    The log is one byte buffer of variable-length records, oldest first. A record is
+
+        u16 length  u8 contents  u16 PC  u16 I  u8 SP  u8 delay  u8 sound  u8 flags
+        [u16 register mask, old u16 per register]        contents & UNDO_V
+        [u16 slot mask, old u16 per stack slot]          contents & UNDO_STACK
+        [u32 row mask, old u64 per display row]          contents & UNDO_DISPLAY
+        [u16 address, u8 count, old bytes]               contents & UNDO_MEMORY
+        [old u64 rand_state]                             contents & UNDO_RAND
+        [old u64 idle_cycles]                            contents & UNDO_IDLE
+        u16 length
+
+    so it can be popped from the end and dropped from the front. Most instructions
+    change PC and one or two registers, which makes a typical record about 16 bytes.
+    Values are stored in host byte order; the log never leaves the process.
+*/
+
+#define DEFAULT_MAX_BYTES ((size_t)4 << 20)
+#define HEADER_SIZE       11
+#define RECORD_MAX        (HEADER_SIZE + 2 + CHIP8_NUM_REGISTERS * 2 + 2 + CHIP8_STACK_SIZE * 2 + \
+                           4 + CHIP8_DISPLAY_HEIGHT * 8 + 3 + CHIP8_NUM_REGISTERS + 8 + 8 + 2)
+
+enum {
+    UNDO_V       = 1 << 0,
+    UNDO_STACK   = 1 << 1,
+    UNDO_DISPLAY = 1 << 2,
+    UNDO_MEMORY  = 1 << 3,
+    UNDO_RAND    = 1 << 4,
+    UNDO_IDLE    = 1 << 5,
+};
+
+struct Chip8Undo {
+    uint8_t* buf;
+    size_t capacity;
+    size_t start; // oldest record
+    size_t end;   // one past the newest
+    int count;
+};
+
+// === Byte cursor ===
+
+static inline uint8_t* put16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); return p + 2; }
+static inline uint8_t* put32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); return p + 4; }
+static inline uint8_t* put64(uint8_t* p, uint64_t v) { memcpy(p, &v, 8); return p + 8; }
+
+static inline uint16_t get16(const uint8_t** p) { uint16_t v; memcpy(&v, *p, 2); *p += 2; return v; }
+static inline uint32_t get32(const uint8_t** p) { uint32_t v; memcpy(&v, *p, 4); *p += 4; return v; }
+static inline uint64_t get64(const uint8_t** p) { uint64_t v; memcpy(&v, *p, 8); *p += 8; return v; }
+
+// === Recording (chip8_internal.h) ===
+
+void chip8_undo_begin(Chip8* chip, Chip8UndoMark* mark) {
+    mark->PC = chip->PC;
+    mark->I = chip->I;
+    mark->SP = chip->SP;
+    mark->delay_timer = chip->delay_timer;
+    mark->sound_timer = chip->sound_timer;
+    mark->flags = (uint8_t)((chip->halted ? 1 : 0) | (chip->draw_flag ? 2 : 0));
+    memcpy(mark->V, chip->V, sizeof(mark->V));
+    memcpy(mark->stack, chip->stack, sizeof(mark->stack));
+    mark->rand_state = chip->rand_state;
+    mark->idle_cycles = chip->idle_cycles;
+
+    // only these opcodes write the display or memory
+    uint16_t opcode = (uint16_t)((chip->memory[CHIP8_ADDR(chip->PC)] << 8) | chip->memory[CHIP8_ADDR(chip->PC + 1)]);
+    mark->has_display = opcode == 0x00E0 || (opcode & 0xF000) == 0xD000;
+    if (mark->has_display) {
+        memcpy(mark->display, chip->display, sizeof(mark->display));
+    }
+
+    mark->memory_count = 0;
+    if ((opcode & 0xF0FF) == 0xF033) {
+        mark->memory_count = 3;
+    } else if ((opcode & 0xF0FF) == 0xF055) {
+        mark->memory_count = (uint8_t)(((opcode >> 8) & 0xF) + 1);
+    }
+    mark->memory_address = chip->I;
+    for (uint8_t i = 0; i < mark->memory_count; i++) {
+        mark->memory[i] = chip->memory[CHIP8_ADDR(chip->I + i)];
+    }
+}
+
+static void chip8_undo_push(Chip8Undo* undo, const uint8_t* record, size_t size) {
+    if (undo->end + size > undo->capacity) {
+        // drop the oldest records until a quarter of the buffer is free, then compact
+        size_t wanted = size + undo->capacity / 4;
+        while (undo->count > 0 && undo->capacity - (undo->end - undo->start) < wanted) {
+            const uint8_t* p = undo->buf + undo->start;
+            undo->start += get16(&p);
+            undo->count--;
+        }
+        memmove(undo->buf, undo->buf + undo->start, undo->end - undo->start);
+        undo->end -= undo->start;
+        undo->start = 0;
+    }
+
+    memcpy(undo->buf + undo->end, record, size);
+    undo->end += size;
+    undo->count++;
+}
+
+void chip8_undo_end(Chip8* chip, const Chip8UndoMark* mark) {
+    uint8_t record[RECORD_MAX];
+    uint8_t contents = 0;
+    uint8_t* p = record + 3;
+
+    p = put16(p, mark->PC);
+    p = put16(p, mark->I);
+    *p++ = mark->SP;
+    *p++ = mark->delay_timer;
+    *p++ = mark->sound_timer;
+    *p++ = mark->flags;
+
+    uint16_t v_mask = 0;
+    for (int r = 0; r < CHIP8_NUM_REGISTERS; r++) {
+        if (chip->V[r] != mark->V[r]) v_mask |= (uint16_t)(1u << r);
+    }
+    if (v_mask) {
+        contents |= UNDO_V;
+        p = put16(p, v_mask);
+        for (int r = 0; r < CHIP8_NUM_REGISTERS; r++) {
+            if ((v_mask >> r) & 1) p = put16(p, mark->V[r]);
+        }
+    }
+
+    uint16_t stack_mask = 0;
+    for (int s = 0; s < CHIP8_STACK_SIZE; s++) {
+        if (chip->stack[s] != mark->stack[s]) stack_mask |= (uint16_t)(1u << s);
+    }
+    if (stack_mask) {
+        contents |= UNDO_STACK;
+        p = put16(p, stack_mask);
+        for (int s = 0; s < CHIP8_STACK_SIZE; s++) {
+            if ((stack_mask >> s) & 1) p = put16(p, mark->stack[s]);
+        }
+    }
+
+    if (mark->has_display) {
+        uint32_t row_mask = 0;
+        for (int y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) {
+            if (chip->display[y] != mark->display[y]) row_mask |= 1u << y;
+        }
+        if (row_mask) {
+            contents |= UNDO_DISPLAY;
+            p = put32(p, row_mask);
+            for (int y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) {
+                if ((row_mask >> y) & 1) p = put64(p, mark->display[y]);
+            }
+        }
+    }
+
+    if (mark->memory_count) {
+        contents |= UNDO_MEMORY;
+        p = put16(p, mark->memory_address);
+        *p++ = mark->memory_count;
+        memcpy(p, mark->memory, mark->memory_count);
+        p += mark->memory_count;
+    }
+
+    if (chip->rand_state != mark->rand_state) {
+        contents |= UNDO_RAND;
+        p = put64(p, mark->rand_state);
+    }
+    if (chip->idle_cycles != mark->idle_cycles) {
+        contents |= UNDO_IDLE;
+        p = put64(p, mark->idle_cycles);
+    }
+
+    uint16_t size = (uint16_t)(p - record + 2);
+    put16(record, size);
+    record[2] = contents;
+    put16(p, size);
+    chip8_undo_push(chip->undo, record, size);
+}
+
+void chip8_undo_clear(Chip8* chip) {
+    chip->undo->start = 0;
+    chip->undo->end = 0;
+    chip->undo->count = 0;
+}
+
+// === Interface ===
+
+bool chip8_undo_enable(Chip8* chip, size_t max_bytes) {
+    if (!chip) {
+        fprintf(stderr, "ERROR: Invalid instance of Chip-8 emulator while enabling undo\n");
+        return false;
+    }
+
+    size_t capacity = (max_bytes > 0) ? max_bytes : DEFAULT_MAX_BYTES;
+    if (capacity < 4 * RECORD_MAX) capacity = 4 * RECORD_MAX;
+
+    Chip8Undo* undo = chip->undo ? chip->undo : calloc(1, sizeof(Chip8Undo));
+    uint8_t* buf = undo ? realloc(undo->buf, capacity) : NULL;
+    if (!buf) {
+        fprintf(stderr, "ERROR: Failed to allocate undo log\n");
+        if (undo && !chip->undo) free(undo);
+        return false;
+    }
+
+    undo->buf = buf;
+    undo->capacity = capacity;
+    chip->undo = undo;
+    chip8_undo_clear(chip);
+    return true;
+}
+
+void chip8_undo_disable(Chip8* chip) {
+    if (!chip || !chip->undo) return;
+
+    free(chip->undo->buf);
+    free(chip->undo);
+    chip->undo = NULL;
+}
+
+bool chip8_undo_is_enabled(Chip8* chip) {
+    return chip && chip->undo;
+}
+
+int chip8_undo_available(Chip8* chip) {
+    return (chip && chip->undo) ? chip->undo->count : 0;
+}
+
+static bool chip8_undo_pop(Chip8* chip) {
+    Chip8Undo* undo = chip->undo;
+    if (!undo || undo->count == 0) return false;
+
+    const uint8_t* p = undo->buf + undo->end - 2;
+    uint16_t size = get16(&p);
+    undo->end -= size;
+    undo->count--;
+
+    p = undo->buf + undo->end + 2;
+    uint8_t contents = *p++;
+
+    chip->PC = get16(&p);
+    chip->I = get16(&p);
+    chip->SP = *p++;
+    chip->delay_timer = *p++;
+    chip->sound_timer = *p++;
+    uint8_t flags = *p++;
+    chip->halted = (flags & 1) != 0;
+    chip->draw_flag = (flags & 2) != 0;
+
+    if (contents & UNDO_V) {
+        uint16_t mask = get16(&p);
+        for (int r = 0; r < CHIP8_NUM_REGISTERS; r++) {
+            if ((mask >> r) & 1) chip->V[r] = get16(&p);
+        }
+    }
+    if (contents & UNDO_STACK) {
+        uint16_t mask = get16(&p);
+        for (int s = 0; s < CHIP8_STACK_SIZE; s++) {
+            if ((mask >> s) & 1) chip->stack[s] = get16(&p);
+        }
+    }
+    if (contents & UNDO_DISPLAY) {
+        uint32_t mask = get32(&p);
+        for (int y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) {
+            if ((mask >> y) & 1) chip->display[y] = get64(&p);
+        }
+        chip->dirty_rows |= mask;
+    }
+    if (contents & UNDO_MEMORY) {
+        uint16_t address = get16(&p);
+        uint8_t count = *p++;
+        for (uint8_t i = 0; i < count; i++) {
+            // through the store path, so decoded and translated code is dropped
+            chip8_write_memory(chip, CHIP8_ADDR(address + i), *p++);
+        }
+    }
+    if (contents & UNDO_RAND) {
+        chip->rand_state = get64(&p);
+    }
+    if (contents & UNDO_IDLE) {
+        chip->idle_cycles = get64(&p);
+    }
+
+    chip->cycle_count--;
+    return true;
+}
+
+bool chip8_step_back(Chip8* chip) {
+    return chip8_step_back_n(chip, 1) == 1;
+}
+
+int chip8_step_back_n(Chip8* chip, int n) {
+    if (!chip) return 0;
+
+    int undone = 0;
+    while (undone < n && chip8_undo_pop(chip)) {
+        undone++;
+    }
+
+    // to a recording (and the call tree) this is the host putting a state in place
+    if (undone > 0 && chip->movie) chip8_movie_on_state(chip);
+    if (undone > 0 && chip->profile) chip8_profile_on_state(chip);
+    return undone;
+}
@@ -0,0 +1,226 @@
+#include "../include/chip8_watch.h"
+#include "chip8_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const REGISTER_NAMES[CHIP8_WATCH_REGISTER_COUNT] = {
+    "V0", "V1", "V2", "V3", "V4", "V5", "V6", "V7",
+    "V8", "V9", "VA", "VB", "VC", "VD", "VE", "VF",
+    "I", "DT", "ST", "SP",
+};
+
+static uint16_t chip8_watch_register_value(const Chip8* chip, int reg) {
+    if (reg <= CHIP8_WATCH_VF) return chip->V[reg];
+
+    switch (reg) {
+        case CHIP8_WATCH_I:  return chip->I;
+        case CHIP8_WATCH_DT: return chip->delay_timer;
+        case CHIP8_WATCH_ST: return chip->sound_timer;
+        case CHIP8_WATCH_SP: return chip->SP;
+        default:             return 0;
+    }
+}
+
+static bool chip8_watch_covers(const Chip8MemoryWatch* watch, uint16_t address) {
+    // ranges may wrap past the end of memory
+    return CHIP8_ADDR(address - watch->start) < watch->length;
+}
+
+/*
+    Rebuilds the page bits in chip after a memory watch comes or goes.
+*/
+static void chip8_watch_update_pages(Chip8* chip) {
+    chip->watch_read_pages = 0;
+    chip->watch_write_pages = 0;
+
+    for (int id = 0; id < CHIP8_WATCH_MAX; id++) {
+        const Chip8MemoryWatch* watch = &chip->watches->memory[id];
+        if (watch->length == 0) continue;
+
+        uint16_t pages = 0;
+        for (uint16_t offset = 0; offset < watch->length; offset += CHIP8_PAGE_SIZE) {
+            pages |= (uint16_t)(1u << (CHIP8_ADDR(watch->start + offset) / CHIP8_PAGE_SIZE));
+        }
+        pages |= (uint16_t)(1u << (CHIP8_ADDR(watch->start + watch->length - 1) / CHIP8_PAGE_SIZE));
+
+        if (watch->access & CHIP8_WATCH_READ) chip->watch_read_pages |= pages;
+        if (watch->access & CHIP8_WATCH_WRITE) chip->watch_write_pages |= pages;
+    }
+}
+
+static void chip8_watch_record(Chip8Watches* watches, uint8_t kind, uint16_t target, uint16_t pc,
+                               uint16_t old_value, uint16_t new_value) {
+    if (watches->pending) return; // the first hit is the one a run stops for
+
+    watches->pending = true;
+    watches->hit = (Chip8WatchHit){
+        .kind = kind,
+        .target = target,
+        .pc = pc,
+        .old_value = old_value,
+        .new_value = new_value,
+    };
+}
+
+static void chip8_watch_access(Chip8* chip, uint8_t kind, uint16_t address, uint8_t old, uint8_t byte) {
+    Chip8Watches* watches = chip->watches;
+    if (!watches) return;
+
+    for (int id = 0; id < CHIP8_WATCH_MAX; id++) {
+        Chip8MemoryWatch* watch = &watches->memory[id];
+        if (watch->length == 0 || !(watch->access & kind) || !chip8_watch_covers(watch, address)) continue;
+
+        watch->hits++;
+        chip8_watch_record(watches, kind, address, CHIP8_ADDR(chip->PC), old, byte);
+    }
+}
+
+void chip8_watch_read(Chip8* chip, uint16_t start, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t address = CHIP8_ADDR(start + i);
+        uint8_t byte = chip->memory[address];
+        chip8_watch_access(chip, CHIP8_WATCH_READ, address, byte, byte);
+    }
+}
+
+void chip8_watch_write(Chip8* chip, uint16_t address, uint8_t old, uint8_t byte) {
+    chip8_watch_access(chip, CHIP8_WATCH_WRITE, CHIP8_ADDR(address), old, byte);
+}
+
+void chip8_watch_begin(Chip8* chip) {
+    Chip8Watches* watches = chip->watches;
+    if (!watches) return;
+
+    watches->pending = false;
+    for (int reg = 0; reg < CHIP8_WATCH_REGISTER_COUNT; reg++) {
+        watches->shadow[reg] = chip8_watch_register_value(chip, reg);
+    }
+}
+
+bool chip8_watch_check_registers(Chip8* chip, uint16_t pc) {
+    Chip8Watches* watches = chip->watches;
+    bool changed = false;
+
+    for (uint32_t bits = watches->registers; bits; bits &= bits - 1) {
+        int reg = __builtin_ctz(bits);
+        uint16_t value = chip8_watch_register_value(chip, reg);
+        if (value == watches->shadow[reg]) continue;
+
+        watches->register_hits[reg]++;
+        chip8_watch_record(watches, CHIP8_WATCH_CHANGE, (uint16_t)reg, pc, watches->shadow[reg], value);
+        watches->shadow[reg] = value;
+        changed = true;
+    }
+    return changed;
+}
+
+// HOST INTERFACE
+
+static Chip8Watches* chip8_watch_get_all(Chip8* chip) {
+    if (!chip->watches) {
+        chip->watches = calloc(1, sizeof(Chip8Watches));
+        if (!chip->watches) {
+            fprintf(stderr, "ERROR: Failed to allocate watchpoints\n");
+        }
+    }
+    return chip->watches;
+}
+
+int chip8_watch_memory(Chip8* chip, uint16_t start, uint16_t length, uint8_t access) {
+    if (!chip) {
+        fprintf(stderr, "ERROR: Invalid instance of Chip-8 emulator while setting a watchpoint\n");
+        return -1;
+    }
+    if (length == 0 || length > CHIP8_MEMORY_SIZE || !(access & CHIP8_WATCH_ACCESS)) {
+        fprintf(stderr, "ERROR: Bad watchpoint: %u bytes at 0x%03X\n", length, start);
+        return -1;
+    }
+
+    Chip8Watches* watches = chip8_watch_get_all(chip);
+    if (!watches) return -1;
+
+    for (int id = 0; id < CHIP8_WATCH_MAX; id++) {
+        Chip8MemoryWatch* watch = &watches->memory[id];
+        if (watch->length != 0) continue;
+
+        *watch = (Chip8MemoryWatch){
+            .start = CHIP8_ADDR(start),
+            .length = length,
+            .access = access & CHIP8_WATCH_ACCESS,
+        };
+        watches->memory_count++;
+        chip8_watch_update_pages(chip);
+        return id;
+    }
+
+    fprintf(stderr, "ERROR: All %d watchpoints are taken\n", CHIP8_WATCH_MAX);
+    return -1;
+}
+
+void chip8_watch_remove(Chip8* chip, int id) {
+    if (!chip || !chip->watches || id < 0 || id >= CHIP8_WATCH_MAX) return;
+
+    Chip8MemoryWatch* watch = &chip->watches->memory[id];
+    if (watch->length == 0) return;
+
+    memset(watch, 0, sizeof(*watch));
+    chip->watches->memory_count--;
+    chip8_watch_update_pages(chip);
+}
+
+const Chip8MemoryWatch* chip8_watch_get(Chip8* chip, int id) {
+    if (!chip || !chip->watches || id < 0 || id >= CHIP8_WATCH_MAX) return NULL;
+
+    const Chip8MemoryWatch* watch = &chip->watches->memory[id];
+    return watch->length ? watch : NULL;
+}
+
+bool chip8_watch_register(Chip8* chip, Chip8WatchRegister reg, bool on) {
+    if (!chip || reg < 0 || reg >= CHIP8_WATCH_REGISTER_COUNT) {
+        fprintf(stderr, "ERROR: Invalid instance of Chip-8 emulator or register while setting a watchpoint\n");
+        return false;
+    }
+    if (!on && !chip->watches) return true;
+
+    Chip8Watches* watches = chip8_watch_get_all(chip);
+    if (!watches) return false;
+
+    if (on) {
+        watches->registers |= 1u << reg;
+        watches->shadow[reg] = chip8_watch_register_value(chip, reg);
+    } else {
+        watches->registers &= ~(1u << reg);
+    }
+    watches->register_hits[reg] = 0;
+    return true;
+}
+
+bool chip8_watch_register_is_set(Chip8* chip, Chip8WatchRegister reg) {
+    if (!chip || !chip->watches || reg < 0 || reg >= CHIP8_WATCH_REGISTER_COUNT) return false;
+    return (chip->watches->registers >> reg) & 1;
+}
+
+uint64_t chip8_watch_register_hits(Chip8* chip, Chip8WatchRegister reg) {
+    if (!chip8_watch_register_is_set(chip, reg)) return 0;
+    return chip->watches->register_hits[reg];
+}
+
+const char* chip8_watch_register_name(Chip8WatchRegister reg) {
+    if (reg < 0 || reg >= CHIP8_WATCH_REGISTER_COUNT) return "?";
+    return REGISTER_NAMES[reg];
+}
+
+void chip8_watch_clear_all(Chip8* chip) {
+    if (!chip) return;
+
+    free(chip->watches);
+    chip->watches = NULL;
+    chip->watch_read_pages = 0;
+    chip->watch_write_pages = 0;
+}
+
+const Chip8WatchHit* chip8_watch_last_hit(Chip8* chip) {
+    if (!chip || !chip->watches || !chip->watches->pending) return NULL;
+    return &chip->watches->hit;
+}
@@ -0,0 +1,58 @@
+/*
+    Helpers shared by the behavior tests in this directory.
+
+    Each test is a small program that exits non-zero when a CHECK failed; `make test`
+    and ctest run them all. Guest programs are written as arrays of opcodes and
+    loaded at 0x200, so a test reads like the listing it runs.
+*/
+#ifndef CHIP8_TEST_H
+#define CHIP8_TEST_H
+
+#include "../include/chip8.h"
+
+#include <stdio.h>
+
+static int chip8_test_failures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            chip8_test_failures++;                                          \
+        }                                                                   \
+    } while (0)
+
+#define CHIP8_TEST_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+// Writes opcodes from 0x200 on
+static inline void chip8_test_load(Chip8* chip, const uint16_t* opcodes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        chip8_write_memory(chip, (uint16_t)(0x200 + 2 * i), (uint8_t)(opcodes[i] >> 8));
+        chip8_write_memory(chip, (uint16_t)(0x201 + 2 * i), (uint8_t)opcodes[i]);
+    }
+}
+
+// A fresh instance running opcodes on backend, or NULL if this build lacks the backend
+static inline Chip8* chip8_test_create(const uint16_t* opcodes, size_t count, Chip8Backend backend) {
+    if (!chip8_backend_available(backend)) return NULL;
+
+    Chip8* chip = chip8_create();
+    if (!chip) return NULL;
+    if (!chip8_set_backend(chip, backend)) {
+        chip8_destroy(&chip);
+        return NULL;
+    }
+    chip8_test_load(chip, opcodes, count);
+    return chip;
+}
+
+static inline int chip8_test_finish(const char* name) {
+    if (chip8_test_failures) {
+        fprintf(stderr, "%s: %d checks failed\n", name, chip8_test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif
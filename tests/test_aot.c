@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L // mkstemp under -std=c11
+
+/*
+    AOT modules: a module chip8aotc builds from a ROM runs it like the switch
+    interpreter does, and self-modifying code falls back to the interpreter.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_state.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifndef CHIP8_AOTC
+#error "CHIP8_AOTC must name the chip8aotc binary"
+#endif
+
+static const uint16_t PROGRAM[] = {
+    0x6000, // 200: LD V0, 0
+    0xC5FF, // 202: RND V5, 0xFF
+    0x2216, // 204: CALL 0x216      loop
+    0x7001, // 206: ADD V0, 1
+    0xA211, // 208: LD I, 0x211
+    0xF055, // 20A: LD [I], V0      rewrites the NN of 0x210
+    0x3064, // 20C: SE V0, 100
+    0x1204, // 20E: JP 0x204
+    0x6200, // 210: LD V2, NN
+    0x1212, // 212: JP 0x212
+    0x0000, // 214:
+    0x8354, // 216: ADD V3, V5
+    0x8336, // 218: SHR V3, V3
+    0x00EE, // 21A: RET
+};
+
+static bool write_rom(const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    for (size_t i = 0; i < CHIP8_TEST_LENGTH(PROGRAM); i++) {
+        fputc(PROGRAM[i] >> 8, file);
+        fputc(PROGRAM[i] & 0xFF, file);
+    }
+    return fclose(file) == 0;
+}
+
+static void check_module(const char* rom_path, const char* so_path) {
+    char command[1024];
+    snprintf(command, sizeof(command), "\"%s\" \"%s\" \"%s\" > /dev/null", CHIP8_AOTC, rom_path, so_path);
+    CHECK(system(command) == 0);
+
+    Chip8* chip = chip8_create();
+    Chip8* reference = chip8_create();
+    if (chip && reference && chip8_load_rom(chip, rom_path) && chip8_load_rom(reference, rom_path)) {
+        CHECK(chip8_load_aot(chip, so_path));
+        CHECK(chip8_get_backend(chip) == CHIP8_BACKEND_AOT);
+        chip8_set_seed(chip, 7);
+        chip8_set_seed(reference, 7);
+
+        int mismatches = 0;
+        for (int batch = 0; batch < 100; batch++) {
+            chip8_step_n(chip, 13);
+            for (int i = 0; i < 13; i++) chip8_step(reference);
+
+            uint8_t state[CHIP8_STATE_SIZE];
+            uint8_t expected[CHIP8_STATE_SIZE];
+            chip8_save_state(chip, state, sizeof(state));
+            chip8_save_state(reference, expected, sizeof(expected));
+            mismatches += !chip8_state_equal(state, expected);
+        }
+        CHECK(mismatches == 0);
+        CHECK(chip8_get_pc(chip) == 0x212);
+        CHECK(chip8_get_register(chip, 2) == 100);
+    } else {
+        CHECK(!"instances or ROM");
+    }
+    chip8_destroy(&chip);
+    chip8_destroy(&reference);
+}
+
+int main(void) {
+    if (!chip8_backend_available(CHIP8_BACKEND_AOT)) return chip8_test_finish("aot");
+
+    char rom_path[] = "/tmp/chip8_test_aot_XXXXXX";
+    int fd = mkstemp(rom_path);
+    CHECK(fd >= 0);
+    if (fd < 0) return chip8_test_finish("aot");
+    close(fd);
+
+    char so_path[sizeof(rom_path) + 3];
+    char c_path[sizeof(so_path) + 2];
+    snprintf(so_path, sizeof(so_path), "%s.so", rom_path);
+    snprintf(c_path, sizeof(c_path), "%s.c", so_path);
+
+    CHECK(write_rom(rom_path));
+    check_module(rom_path, so_path);
+
+    unlink(c_path);
+    unlink(so_path);
+    unlink(rom_path);
+    return chip8_test_finish("aot");
+}
@@ -0,0 +1,59 @@
+/*
+    Backends: the decode cache, threaded dispatch and JIT all reach the state single
+    steps of the switch interpreter reach, at every batch boundary, including for code
+    that rewrites itself from inside a hot loop.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_state.h"
+
+static const uint16_t SELF_MODIFYING[] = {
+    0x6000, // 200: LD V0, 0
+    0xC5FF, // 202: RND V5, 0xFF
+    0xA20B, // 204: LD I, 0x20B     loop
+    0x7001, // 206: ADD V0, 1
+    0xF055, // 208: LD [I], V0      rewrites the NN of the next instruction
+    0x6200, // 20A: LD V2, NN
+    0x8324, // 20C: ADD V3, V2
+    0x8354, // 20E: ADD V3, V5
+    0x3064, // 210: SE V0, 100
+    0x1204, // 212: JP 0x204
+    0xF429, // 214: LD F, V4
+    0xD015, // 216: DRW V0, V1, 5
+    0x1218, // 218: JP 0x218
+};
+
+static void check_backend(Chip8Backend backend, int batch) {
+    Chip8* chip = chip8_test_create(SELF_MODIFYING, CHIP8_TEST_LENGTH(SELF_MODIFYING), backend);
+    Chip8* reference = chip8_test_create(SELF_MODIFYING, CHIP8_TEST_LENGTH(SELF_MODIFYING), CHIP8_BACKEND_SWITCH);
+    if (chip && reference) {
+        chip8_set_seed(chip, 42);
+        chip8_set_seed(reference, 42);
+
+        int mismatches = 0;
+        for (int done = 0; done < 2000; done += batch) {
+            CHECK(chip8_step_n(chip, batch) == batch);
+            for (int i = 0; i < batch; i++) chip8_step(reference);
+
+            uint8_t state[CHIP8_STATE_SIZE];
+            uint8_t expected[CHIP8_STATE_SIZE];
+            chip8_save_state(chip, state, sizeof(state));
+            chip8_save_state(reference, expected, sizeof(expected));
+            mismatches += !chip8_state_equal(state, expected);
+        }
+        CHECK(mismatches == 0);
+        CHECK(chip8_get_pc(chip) == 0x218);
+        CHECK(chip8_read_memory(chip, 0x20B) == 100);
+    }
+    chip8_destroy(&chip);
+    chip8_destroy(&reference);
+}
+
+int main(void) {
+    static const int BATCHES[] = { 1, 7, 64, 1000 };
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        for (size_t b = 0; b < CHIP8_TEST_LENGTH(BATCHES); b++) {
+            check_backend((Chip8Backend)backend, BATCHES[b]);
+        }
+    }
+    return chip8_test_finish("backends");
+}
@@ -0,0 +1,146 @@
+/*
+    Breakpoints: chip8_run_until stops before a breakpoint whose condition holds and at
+    the run-to target, resumes past either, and never misses one at a budget boundary.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_break.h"
+
+#include <string.h>
+
+static const uint16_t PROGRAM[] = {
+    0x6000, // 200: LD V0, 0
+    0x2210, // 202: CALL 0x210
+    0x7001, // 204: ADD V0, 1
+    0x1202, // 206: JP 0x202
+    0x0000, 0x0000, 0x0000, 0x0000, // 208-20E
+    0x6105, // 210: LD V1, 5
+    0x00EE, // 212: RET
+};
+
+static const uint16_t BAD_RETURN[] = {
+    0x00EE, // 200: RET with an empty stack
+};
+
+static void check_breakpoints(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    // nothing armed: the budget runs out
+    CHECK(chip8_run_until(chip, 100) == CHIP8_STOP_BUDGET);
+    CHECK(chip8_get_cycle_count(chip) == 100);
+    chip8_reset(chip);
+    chip8_test_load(chip, PROGRAM, CHIP8_TEST_LENGTH(PROGRAM));
+
+    CHECK(chip8_break_set(chip, 0x204, NULL));
+    CHECK(chip8_break_is_set(chip, 0x204) && !chip8_break_is_set(chip, 0x206));
+    CHECK(chip8_break_condition(chip, 0x204) == NULL);
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_BREAKPOINT);
+    CHECK(chip8_get_pc(chip) == 0x204 && chip8_get_cycle_count(chip) == 4);
+    CHECK(chip8_break_at_pc(chip));
+
+    // resuming runs the instruction at the breakpoint first
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_BREAKPOINT);
+    CHECK(chip8_get_pc(chip) == 0x204 && chip8_get_register(chip, 0) == 1);
+    CHECK(chip8_break_hits(chip, 0x204) == 2);
+
+    // budgets of one cycle still stop there, after the five instructions of the loop
+    int runs = 0;
+    while (chip8_run_until(chip, 1) == CHIP8_STOP_BUDGET && runs < 100) runs++;
+    CHECK(runs == 5);
+    CHECK(chip8_get_pc(chip) == 0x204 && chip8_get_register(chip, 0) == 2);
+
+    // a condition replaces the plain breakpoint and is only met once V0 reaches 5
+    CHECK(chip8_break_set(chip, 0x204, "V0 == 5 && [0x200] == 0x60 && SP == 0"));
+    CHECK(strcmp(chip8_break_condition(chip, 0x204), "V0 == 5 && [0x200] == 0x60 && SP == 0") == 0);
+    CHECK(chip8_break_hits(chip, 0x204) == 0);
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_BREAKPOINT);
+    CHECK(chip8_get_pc(chip) == 0x204 && chip8_get_register(chip, 0) == 5);
+
+    // a condition that does not compile leaves the breakpoint as it was
+    CHECK(!chip8_break_set(chip, 0x204, "V0 =="));
+    CHECK(chip8_break_condition(chip, 0x204) != NULL);
+
+    CHECK(chip8_break_set(chip, 0x210, "V1 != 5"));
+    uint16_t addresses[4];
+    CHECK(chip8_break_list(chip, addresses, 4) == 2);
+    CHECK(addresses[0] == 0x204 && addresses[1] == 0x210);
+
+    // breakpoints survive a reset
+    chip8_reset(chip);
+    chip8_test_load(chip, PROGRAM, CHIP8_TEST_LENGTH(PROGRAM));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_BREAKPOINT);
+    CHECK(chip8_get_pc(chip) == 0x210 && chip8_get_register(chip, 1) == 0);
+    chip8_break_clear(chip, 0x210);
+    CHECK(!chip8_break_is_set(chip, 0x210));
+
+    chip8_break_clear_all(chip);
+    CHECK(chip8_break_list(chip, addresses, 4) == 0);
+    CHECK(chip8_run_until(chip, 50) == CHIP8_STOP_BUDGET);
+    chip8_destroy(&chip);
+}
+
+static void check_targets(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    chip8_step_n(chip, 1);
+    CHECK(chip8_get_pc(chip) == 0x202);
+    CHECK(!chip8_break_step_out(chip)); // top level
+
+    // step over the CALL
+    CHECK(chip8_break_step_over(chip));
+    CHECK(chip8_break_has_target(chip));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_TARGET);
+    CHECK(chip8_get_pc(chip) == 0x204 && chip8_get_cycle_count(chip) == 4);
+    CHECK(!chip8_break_has_target(chip));
+    CHECK(!chip8_break_step_over(chip)); // not a CALL
+
+    // step into the subroutine, then out of it
+    chip8_step_n(chip, 3);
+    CHECK(chip8_get_pc(chip) == 0x210);
+    CHECK(chip8_break_step_out(chip));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_TARGET);
+    CHECK(chip8_get_pc(chip) == 0x204);
+
+    // run to cursor on the current PC goes round the loop once
+    uint64_t cycles = chip8_get_cycle_count(chip);
+    CHECK(chip8_break_set_target(chip, 0x204, CHIP8_STACK_SIZE));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_TARGET);
+    CHECK(chip8_get_cycle_count(chip) == cycles + 5);
+
+    // a breakpoint reached first drops the target
+    CHECK(chip8_break_set_target(chip, 0x200, CHIP8_STACK_SIZE));
+    CHECK(chip8_break_set(chip, 0x212, NULL));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_BREAKPOINT);
+    CHECK(!chip8_break_has_target(chip));
+
+    // so does replacing the state
+    CHECK(chip8_break_set_target(chip, CHIP8_BREAK_ANY, 0));
+    chip8_set_seed(chip, 1);
+    CHECK(!chip8_break_has_target(chip));
+    chip8_destroy(&chip);
+
+    chip = chip8_test_create(BAD_RETURN, CHIP8_TEST_LENGTH(BAD_RETURN), backend);
+    CHECK(chip8_break_set(chip, 0x300, NULL));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_HALTED);
+    chip8_destroy(&chip);
+}
+
+static void check_conditions(void) {
+    char error[128] = "";
+    CHECK(chip8_break_check_condition("V3 == 0x10 && I > 0x300", error, sizeof(error)));
+    CHECK(chip8_break_check_condition("!(DT || ST) && (VF + 1) & 2", error, sizeof(error)));
+    CHECK(!chip8_break_check_condition("V3 == ", error, sizeof(error)));
+    CHECK(error[0] != '\0');
+    CHECK(!chip8_break_check_condition("VG == 1", NULL, 0));
+    CHECK(!chip8_break_check_condition("(V0 == 1", NULL, 0));
+}
+
+int main(void) {
+    check_conditions();
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_breakpoints((Chip8Backend)backend);
+        check_targets((Chip8Backend)backend);
+    }
+    return chip8_test_finish("break");
+}
@@ -0,0 +1,89 @@
+/*
+    Diagnostics: 0NNN, unassigned opcodes and stack errors land in the ring in order,
+    a repeating one only queues CHIP8_DIAG_BURST entries but is counted every time,
+    and a reset clears it all.
+*/
+#include "chip8_test.h"
+
+#include <string.h>
+
+#define PASSES 20
+
+static const uint16_t BAD_OPCODES[] = {
+    0x0123, // 200: SYS 0x123
+    0x5011, // 202: unassigned
+    0x7001, // 204: ADD V0, 1
+    0x3014, // 206: SE V0, 20
+    0x1202, // 208: JP 0x202
+    0x00EE, // 20A: RET with an empty stack
+};
+
+static const uint16_t RECURSION[] = {
+    0x2200, // 200: CALL 0x200
+};
+
+static void check_entry(const Chip8Diag* entry, Chip8DiagCode code, uint16_t pc, uint16_t opcode) {
+    CHECK(entry->code == code);
+    CHECK(entry->pc == pc);
+    CHECK(entry->opcode == opcode);
+}
+
+static void check_bad_opcodes(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(BAD_OPCODES, CHIP8_TEST_LENGTH(BAD_OPCODES), backend);
+    if (!chip) return;
+
+    for (int run = 0; run < 2; run++) {
+        chip8_step_n(chip, 1000);
+        CHECK(chip8_is_halted(chip));
+        CHECK(chip8_get_diag_count(chip, CHIP8_DIAG_SYS) == 1);
+        CHECK(chip8_get_diag_count(chip, CHIP8_DIAG_INVALID_OPCODE) == PASSES);
+        CHECK(chip8_get_diag_count(chip, CHIP8_DIAG_STACK_UNDERFLOW) == 1);
+        CHECK(chip8_get_diag_count(chip, CHIP8_DIAG_STACK_OVERFLOW) == 0);
+
+        // oldest first, across several drains
+        Chip8Diag entries[CHIP8_DIAG_RING_SIZE];
+        size_t count = chip8_drain_diagnostics(chip, entries, 4);
+        CHECK(count == 4);
+        count += chip8_drain_diagnostics(chip, entries + count, CHIP8_DIAG_RING_SIZE - count);
+        CHECK(count == 2 + CHIP8_DIAG_BURST);
+        CHECK(chip8_drain_diagnostics(chip, entries, CHIP8_DIAG_RING_SIZE) == 0);
+
+        check_entry(&entries[0], CHIP8_DIAG_SYS, 0x200, 0x0123);
+        for (int i = 1; i <= CHIP8_DIAG_BURST; i++) {
+            check_entry(&entries[i], CHIP8_DIAG_INVALID_OPCODE, 0x202, 0x5011);
+            CHECK(entries[i].cycle >= entries[i - 1].cycle);
+        }
+        check_entry(&entries[count - 1], CHIP8_DIAG_STACK_UNDERFLOW, 0x20A, 0x00EE);
+
+        // a reset starts counting from scratch
+        chip8_reset(chip);
+        chip8_test_load(chip, BAD_OPCODES, CHIP8_TEST_LENGTH(BAD_OPCODES));
+        for (int code = 0; code < CHIP8_DIAG_COUNT; code++)
+            CHECK(chip8_get_diag_count(chip, (Chip8DiagCode)code) == 0);
+        CHECK(chip8_drain_diagnostics(chip, entries, CHIP8_DIAG_RING_SIZE) == 0);
+    }
+    chip8_destroy(&chip);
+}
+
+static void check_recursion(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(RECURSION, CHIP8_TEST_LENGTH(RECURSION), backend);
+    if (!chip) return;
+
+    chip8_step_n(chip, 100);
+    CHECK(chip8_is_halted(chip));
+    CHECK(chip8_get_diag_count(chip, CHIP8_DIAG_STACK_OVERFLOW) == 1);
+
+    Chip8Diag entry;
+    CHECK(chip8_drain_diagnostics(chip, &entry, 1) == 1);
+    check_entry(&entry, CHIP8_DIAG_STACK_OVERFLOW, 0x200, 0x2200);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    CHECK(strcmp(chip8_diag_name(CHIP8_DIAG_STACK_UNDERFLOW), "stack underflow") == 0);
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_bad_opcodes((Chip8Backend)backend);
+        check_recursion((Chip8Backend)backend);
+    }
+    return chip8_test_finish("diag");
+}
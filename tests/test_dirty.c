@@ -0,0 +1,60 @@
+/*
+    Dirty rows: DXYN marks the rows it drew to, 00E0 the rows it blanked, and taking
+    the mask clears it, on every backend.
+*/
+#include "chip8_test.h"
+
+#define ROWS(first, count) ((uint32_t)(((1ull << (count)) - 1) << (first)))
+
+static const uint16_t PROGRAM[] = {
+    0x6000, // 200: LD V0, 0
+    0x611E, // 202: LD V1, 30
+    0xA000, // 204: LD I, 0     the font's 0, five rows
+    0xD015, // 206: DRW V0, V1, 5, wrapping from row 31 to row 0
+    0x00E0, // 208: CLS
+    0x00E0, // 20A: CLS on a blank display
+    0x610A, // 20C: LD V1, 10
+    0xD013, // 20E: DRW V0, V1, 3
+    0x6002, // 210: LD V0, 2
+    0xD013, // 212: DRW V0, V1, 3, erasing part of it
+    0x1214, // 214: JP 0x214
+};
+
+static void check_backend(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    // a new instance has to be drawn as a whole
+    CHECK(chip8_take_dirty_rows(chip) == 0xFFFFFFFFu);
+    CHECK(chip8_take_dirty_rows(chip) == 0);
+
+    chip8_step_n(chip, 3);
+    CHECK(chip8_take_dirty_rows(chip) == 0);
+
+    chip8_step_n(chip, 1);
+    CHECK(chip8_take_dirty_rows(chip) == (ROWS(30, 2) | ROWS(0, 3)));
+
+    chip8_step_n(chip, 1);
+    CHECK(chip8_take_dirty_rows(chip) == (ROWS(30, 2) | ROWS(0, 3)));
+    chip8_step_n(chip, 1);
+    CHECK(chip8_take_dirty_rows(chip) == 0);
+
+    // the mask collects every row until it is taken
+    chip8_step_n(chip, 4);
+    CHECK(chip8_get_register(chip, 0xF) == 1);
+    CHECK(chip8_take_dirty_rows(chip) == ROWS(10, 3));
+
+    // the idle loop at the end draws nothing
+    chip8_step_n(chip, 100);
+    CHECK(chip8_take_dirty_rows(chip) == 0);
+
+    chip8_reset(chip);
+    CHECK(chip8_take_dirty_rows(chip) == 0xFFFFFFFFu);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++)
+        check_backend((Chip8Backend)backend);
+    return chip8_test_finish("dirty");
+}
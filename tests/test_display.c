@@ -0,0 +1,68 @@
+/*
+    Packed display: DXYN wraps sprites around both edges and reports collisions, and
+    chip8_get_display unpacks the rows without touching the instance.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_state.h"
+
+#include <string.h>
+
+static const uint16_t PROGRAM[] = {
+    0x603C, // 200: LD V0, 60
+    0x611E, // 202: LD V1, 30
+    0xA000, // 204: LD I, 0     the font's 0: F0 90 90 90 F0
+    0xD015, // 206: DRW V0, V1, 5
+    0xD015, // 208: DRW V0, V1, 5, erasing it again
+    0x120A, // 20A: JP 0x20A
+};
+
+static const uint8_t ZERO[5] = { 0xF0, 0x90, 0x90, 0x90, 0xF0 };
+
+// Whether the 0 drawn at (60, 30) covers a pixel: rows 30, 31, 0, 1, 2 and columns 60-63, 0-3
+static bool expected_pixel(int x, int y) {
+    int row = (y - 30 + 32) % 32;
+    int column = (x - 60 + 64) % 64;
+    if (row >= 5 || column >= 8) return false;
+    return (ZERO[row] >> (7 - column)) & 1;
+}
+
+static void check_drawn(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    chip8_step_n(chip, 4);
+    CHECK(chip8_get_pc(chip) == 0x208);
+    CHECK(chip8_get_register(chip, 0xF) == 0);
+
+    uint8_t before[CHIP8_STATE_SIZE];
+    uint8_t after[CHIP8_STATE_SIZE];
+    bool pixels[CHIP8_DISPLAY_SIZE];
+    chip8_save_state(chip, before, sizeof(before));
+    chip8_get_display(chip, pixels);
+    chip8_save_state(chip, after, sizeof(after));
+    CHECK(memcmp(before, after, sizeof(before)) == 0);
+
+    const uint64_t* rows = chip8_get_display_rows(chip);
+    int wrong = 0;
+    for (int y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < CHIP8_DISPLAY_WIDTH; x++) {
+            bool expected = expected_pixel(x, y);
+            wrong += (pixels[y * CHIP8_DISPLAY_WIDTH + x] != expected);
+            wrong += (CHIP8_PIXEL(rows, x, y) != expected);
+        }
+    }
+    CHECK(wrong == 0);
+
+    // drawing the same sprite again erases every pixel of it
+    chip8_step_n(chip, 1);
+    CHECK(chip8_get_register(chip, 0xF) == 1);
+    for (int y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) CHECK(rows[y] == 0);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_drawn((Chip8Backend)backend);
+    }
+    return chip8_test_finish("display");
+}
@@ -0,0 +1,79 @@
+/*
+    Superinstructions: a sequence is fused whatever order its slots were first
+    decoded in, and a fused group runs exactly like its instructions one at a time.
+*/
+#include "chip8_test.h"
+#include "../src/chip8_internal.h"
+
+#include <string.h>
+
+static const uint16_t STRAIGHT_LINE[] = {
+    0x00E0, // 200: CLS, whose decode used to cache the next slot unfused
+    0x6001, // 202: LD V0, 1       sprite, reached by falling through
+    0x6102, // 204: LD V1, 2
+    0xD015, // 206: DRW V0, V1, 5
+    0xA300, // 208: LD I, 0x300    index
+    0xF21E, // 20A: ADD I, V2
+    0x7301, // 20C: ADD V3, 1      loop
+    0x3310, // 20E: SE V3, 0x10
+    0x120C, // 210: JP 0x20C
+    0x1212, // 212: JP 0x212
+};
+
+static void check_fused(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(STRAIGHT_LINE, CHIP8_TEST_LENGTH(STRAIGHT_LINE), backend);
+    if (!chip) return;
+
+    chip8_step_n(chip, 10); // decodes 0x200 first, and everything after it by falling through
+    CHECK(chip8_is_fused(chip, 0x202));
+    CHECK(chip8_is_fused(chip, 0x208));
+    CHECK(chip8_is_fused(chip, 0x20C));
+    CHECK(!chip8_is_fused(chip, 0x200));
+    CHECK(!chip8_is_fused(chip, 0x206));
+    chip8_destroy(&chip);
+}
+
+// Fused or not, every budget ends in the state single steps reach
+static void check_same_as_steps(Chip8Backend backend) {
+    for (int budget = 1; budget <= 60; budget++) {
+        Chip8* fused = chip8_test_create(STRAIGHT_LINE, CHIP8_TEST_LENGTH(STRAIGHT_LINE), backend);
+        Chip8* stepped = chip8_test_create(STRAIGHT_LINE, CHIP8_TEST_LENGTH(STRAIGHT_LINE), CHIP8_BACKEND_SWITCH);
+        if (!fused || !stepped) {
+            chip8_destroy(&fused);
+            chip8_destroy(&stepped);
+            return;
+        }
+
+        chip8_step_n(fused, budget);
+        for (int i = 0; i < budget; i++) chip8_step(stepped);
+
+        CHECK(chip8_get_pc(fused) == chip8_get_pc(stepped));
+        CHECK(chip8_get_i(fused) == chip8_get_i(stepped));
+        CHECK(chip8_get_register(fused, 3) == chip8_get_register(stepped, 3));
+        CHECK(chip8_get_cycle_count(fused) == chip8_get_cycle_count(stepped));
+        CHECK(memcmp(chip8_get_display_rows(fused), chip8_get_display_rows(stepped),
+                     CHIP8_DISPLAY_HEIGHT * sizeof(uint64_t)) == 0);
+        chip8_destroy(&fused);
+        chip8_destroy(&stepped);
+    }
+}
+
+// Rewriting a follower breaks up the group it was part of
+static void check_invalidated(void) {
+    Chip8* chip = chip8_test_create(STRAIGHT_LINE, CHIP8_TEST_LENGTH(STRAIGHT_LINE), CHIP8_BACKEND_SWITCH);
+    if (!chip) return;
+
+    CHECK(chip8_is_fused(chip, 0x208));
+    chip8_write_memory(chip, 0x20A, 0x60); // ADD I, V2 -> LD V0, 0x1E
+    CHECK(!chip8_is_fused(chip, 0x208));
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_fused((Chip8Backend)backend);
+        check_same_as_steps((Chip8Backend)backend);
+    }
+    check_invalidated();
+    return chip8_test_finish("fusion");
+}
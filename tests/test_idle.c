@@ -0,0 +1,82 @@
+/*
+    Idle loops: a loop that cannot progress until the next timer tick or key change is
+    fast-forwarded to the end of the budget, however it was reached, and leaves it when
+    the timer or key lets it.
+*/
+#include "chip8_test.h"
+
+static const uint16_t SELF_JUMP[] = {
+    0x6001, // 200: LD V0, 1
+    0x1202, // 202: JP 0x202, reached by falling through
+};
+
+static const uint16_t DELAY_POLL[] = {
+    0x6003, // 200: LD V0, 3
+    0xF015, // 202: LD DT, V0
+    0xF107, // 204: LD V1, DT   poll, reached by falling through
+    0x3100, // 206: SE V1, 0
+    0x1204, // 208: JP 0x204
+    0x120A, // 20A: JP 0x20A
+};
+
+static const uint16_t KEY_WAIT[] = {
+    0x6001, // 200: LD V0, 1
+    0xF20A, // 202: LD V2, K
+    0x1204, // 204: JP 0x204
+};
+
+static void check_self_jump(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(SELF_JUMP, CHIP8_TEST_LENGTH(SELF_JUMP), backend);
+    if (!chip) return;
+
+    for (int frame = 0; frame < 10; frame++) {
+        CHECK(chip8_step_n(chip, 1000) == 1000);
+        chip8_update_timers(chip);
+    }
+    CHECK(chip8_get_pc(chip) == 0x202);
+    CHECK(chip8_get_cycle_count(chip) == 10000);
+    CHECK(chip8_get_idle_cycles(chip) >= 9990);
+    chip8_destroy(&chip);
+}
+
+static void check_delay_poll(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(DELAY_POLL, CHIP8_TEST_LENGTH(DELAY_POLL), backend);
+    if (!chip) return;
+
+    chip8_step_n(chip, 1000);
+    CHECK(chip8_get_idle_cycles(chip) >= 990);
+    CHECK(chip8_get_pc(chip) >= 0x204 && chip8_get_pc(chip) <= 0x208);
+
+    // the poll sees DT reach 0 after three ticks, and leaves for the jump to itself
+    for (int frame = 0; frame < 4; frame++) {
+        chip8_update_timers(chip);
+        chip8_step_n(chip, 1000);
+    }
+    CHECK(chip8_get_pc(chip) == 0x20A);
+    CHECK(chip8_get_register(chip, 1) == 0);
+    chip8_destroy(&chip);
+}
+
+static void check_key_wait(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(KEY_WAIT, CHIP8_TEST_LENGTH(KEY_WAIT), backend);
+    if (!chip) return;
+
+    chip8_step_n(chip, 1000);
+    CHECK(chip8_get_pc(chip) == 0x202);
+    CHECK(chip8_get_idle_cycles(chip) >= 990);
+
+    chip8_key_press(chip, 0x7);
+    chip8_step_n(chip, 1000);
+    CHECK(chip8_get_register(chip, 2) == 0x7);
+    CHECK(chip8_get_pc(chip) == 0x204);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_self_jump((Chip8Backend)backend);
+        check_delay_poll((Chip8Backend)backend);
+        check_key_wait((Chip8Backend)backend);
+    }
+    return chip8_test_finish("idle");
+}
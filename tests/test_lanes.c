@@ -0,0 +1,131 @@
+/*
+    Lanes: every lane runs exactly like its own Chip8 would, whether the lanes stay
+    together or split up through their keys, seeds and memory writes.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_lanes.h"
+#include "../include/chip8_state.h"
+
+#define LANES  8
+#define ROUNDS 40
+#define BUDGET 37
+
+static const uint16_t DIVERGING[] = {
+    0x6105, // 200: LD V1, 5
+    0xC00F, // 202: RND V0, 0x0F
+    0xA300, // 204: LD I, 0x300
+    0xF033, // 206: LD B, V0
+    0xE19E, // 208: SKP V1
+    0x7002, // 20A: ADD V0, 2
+    0xF029, // 20C: LD F, V0
+    0xD015, // 20E: DRW V0, V1, 5
+    0x8104, // 210: ADD V1, V0
+    0xF015, // 212: LD DT, V0
+    0x1202, // 214: JP 0x202
+};
+
+static const uint16_t BAD_RETURN[] = {
+    0x00EE, // 200: RET with an empty stack
+};
+
+static void check_lane(Chip8Lanes* lanes, int lane, Chip8* reference) {
+    Chip8* stored = chip8_create();
+    CHECK(chip8_lanes_store(lanes, lane, stored));
+
+    uint8_t expected[CHIP8_STATE_SIZE], actual[CHIP8_STATE_SIZE];
+    chip8_save_state(reference, expected, sizeof(expected));
+    chip8_save_state(stored, actual, sizeof(actual));
+    CHECK(chip8_state_equal(actual, expected));
+    CHECK(chip8_lanes_get_pc(lanes, lane) == chip8_get_pc(reference));
+    for (int reg = 0; reg < 16; reg++)
+        CHECK(chip8_lanes_get_register(lanes, lane, reg) == chip8_get_register(reference, reg));
+
+    const uint64_t* rows = chip8_lanes_get_display_rows(lanes, lane);
+    const uint64_t* expected_rows = chip8_get_display_rows(reference);
+    for (int y = 0; y < CHIP8_DISPLAY_HEIGHT; y++) CHECK(rows[y] == expected_rows[y]);
+    chip8_destroy(&stored);
+}
+
+// Lanes that never diverge take one dispatch per instruction
+static void check_together(void) {
+    Chip8* chip = chip8_test_create(DIVERGING, CHIP8_TEST_LENGTH(DIVERGING), CHIP8_BACKEND_SWITCH);
+    Chip8Lanes* lanes = chip8_lanes_create(LANES);
+    CHECK(lanes && chip8_lanes_count(lanes) == LANES);
+    CHECK(chip8_lanes_load(lanes, -1, chip));
+
+    for (int round = 0; round < ROUNDS; round++) {
+        CHECK(chip8_lanes_step_n(lanes, BUDGET) == BUDGET);
+        chip8_lanes_update_timers(lanes);
+        chip8_step_n(chip, BUDGET);
+        chip8_update_timers(chip);
+    }
+    for (int lane = 0; lane < LANES; lane++) check_lane(lanes, lane, chip);
+    chip8_lanes_destroy(&lanes);
+    chip8_destroy(&chip);
+}
+
+// Lanes with their own seed and key take separate paths and still match their references
+static void check_diverged(void) {
+    Chip8* references[LANES];
+    Chip8Lanes* lanes = chip8_lanes_create(LANES);
+    for (int lane = 0; lane < LANES; lane++) {
+        references[lane] = chip8_test_create(DIVERGING, CHIP8_TEST_LENGTH(DIVERGING), CHIP8_BACKEND_SWITCH);
+        CHECK(chip8_lanes_load(lanes, lane, references[lane]));
+        chip8_set_seed(references[lane], 1000 + lane);
+        chip8_lanes_seed(lanes, lane, 1000 + lane);
+    }
+
+    bool split = false;
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int lane = 1; lane < LANES; lane += 2) {
+            if (round % 4 == lane % 4) {
+                chip8_key_press(references[lane], 5);
+                chip8_lanes_key_press(lanes, lane, 5);
+            } else {
+                chip8_key_release(references[lane], 5);
+                chip8_lanes_key_release(lanes, lane, 5);
+            }
+        }
+        int dispatches = chip8_lanes_step_n(lanes, BUDGET);
+        CHECK(dispatches >= BUDGET && dispatches <= BUDGET * LANES);
+        if (dispatches > BUDGET) split = true;
+        chip8_lanes_update_timers(lanes);
+        for (int lane = 0; lane < LANES; lane++) {
+            chip8_step_n(references[lane], BUDGET);
+            chip8_update_timers(references[lane]);
+            check_lane(lanes, lane, references[lane]);
+        }
+    }
+    CHECK(split);
+
+    for (int lane = 0; lane < LANES; lane++) chip8_destroy(&references[lane]);
+    chip8_lanes_destroy(&lanes);
+}
+
+// A lane that halts stays put while the others carry on
+static void check_halted(void) {
+    Chip8* good = chip8_test_create(DIVERGING, CHIP8_TEST_LENGTH(DIVERGING), CHIP8_BACKEND_SWITCH);
+    Chip8* bad = chip8_test_create(BAD_RETURN, CHIP8_TEST_LENGTH(BAD_RETURN), CHIP8_BACKEND_SWITCH);
+    Chip8Lanes* lanes = chip8_lanes_create(2);
+    CHECK(chip8_lanes_load(lanes, 0, good));
+    CHECK(chip8_lanes_load(lanes, 1, bad));
+
+    chip8_lanes_step_n(lanes, BUDGET);
+    chip8_step_n(good, BUDGET);
+    chip8_step_n(bad, BUDGET);
+    CHECK(!chip8_lanes_is_halted(lanes, 0));
+    CHECK(chip8_lanes_is_halted(lanes, 1));
+    check_lane(lanes, 0, good);
+    check_lane(lanes, 1, bad);
+
+    chip8_lanes_destroy(&lanes);
+    chip8_destroy(&bad);
+    chip8_destroy(&good);
+}
+
+int main(void) {
+    check_together();
+    check_diverged();
+    check_halted();
+    return chip8_test_finish("lanes");
+}
@@ -0,0 +1,77 @@
+/*
+    Movies: a recording replays without desyncs on every backend, from the start or
+    from a seek into the middle, and ends in the state the recording did.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_movie.h"
+#include "../include/chip8_state.h"
+
+#define FRAMES           120
+#define CYCLES_PER_FRAME 500
+
+static const uint16_t SELF_JUMP[] = {
+    0x6001, // 200: LD V0, 1
+    0x1202, // 202: JP 0x202
+};
+
+static const uint16_t KEY_COUNTER[] = {
+    0x6000, // 200: LD V0, 0
+    0xF10A, // 202: LD V1, K
+    0x7001, // 204: ADD V0, 1
+    0xF129, // 206: LD F, V1
+    0xD005, // 208: DRW V0, V0, 5
+    0x1202, // 20A: JP 0x202
+};
+
+// Key 1 goes down and up again a few times, so FX0A has something to wait for
+static void play_session(Chip8* chip) {
+    for (int frame = 0; frame < FRAMES; frame++) {
+        if (frame % 25 == 5) chip8_key_press(chip, (uint8_t)(frame % 16));
+        if (frame % 25 == 9) chip8_key_release(chip, (uint8_t)((frame - 4) % 16));
+        chip8_step_n(chip, CYCLES_PER_FRAME);
+        chip8_update_timers(chip);
+    }
+}
+
+static void check_replay(Chip8Movie* movie, const uint8_t* end, Chip8Backend backend, int from) {
+    Chip8* chip = chip8_test_create(NULL, 0, backend);
+    if (!chip) return;
+
+    CHECK(chip8_movie_seek(movie, chip, from));
+    CHECK(chip8_movie_play(movie, chip, FRAMES) == FRAMES - from);
+    CHECK(chip8_movie_desyncs(movie) == 0);
+
+    uint8_t state[CHIP8_STATE_SIZE];
+    chip8_save_state(chip, state, sizeof(state));
+    CHECK(chip8_state_equal(state, end));
+    chip8_destroy(&chip);
+}
+
+static void check_program(const uint16_t* opcodes, size_t count, Chip8Backend recorded_on) {
+    Chip8* chip = chip8_test_create(opcodes, count, recorded_on);
+    if (!chip) return;
+
+    CHECK(chip8_movie_record(chip, 10) != NULL);
+    play_session(chip);
+    Chip8Movie* movie = chip8_movie_stop(chip);
+    CHECK(movie && chip8_movie_frames(movie) == FRAMES);
+
+    uint8_t end[CHIP8_STATE_SIZE];
+    chip8_save_state(chip, end, sizeof(end));
+    chip8_destroy(&chip);
+    if (!movie) return;
+
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_replay(movie, end, (Chip8Backend)backend, 0);
+        check_replay(movie, end, (Chip8Backend)backend, 50); // lands after a keyframe, on a cold cache
+    }
+    chip8_movie_destroy(&movie);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_program(SELF_JUMP, CHIP8_TEST_LENGTH(SELF_JUMP), (Chip8Backend)backend);
+        check_program(KEY_COUNTER, CHIP8_TEST_LENGTH(KEY_COUNTER), (Chip8Backend)backend);
+    }
+    return chip8_test_finish("movie");
+}
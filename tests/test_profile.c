@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200809L // mkstemp under -std=c11
+
+/*
+    Profile: every backend counts the instructions run at each address and the bytes
+    they load and store, the same as single steps would, and charges every cycle to
+    the chain of calls that ran it.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_profile.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define STEPS 100
+
+static const uint16_t COUNTED[] = {
+    0x6100, // 200: LD V1, 0
+    0xA300, // 202: LD I, 0x300
+    0xF133, // 204: LD B, V1       writes 0x300-0x302
+    0xF065, // 206: LD V0, [I]     reads 0x300 and moves I on
+    0xA300, // 208: LD I, 0x300
+    0xD013, // 20A: DRW V0, V1, 3  reads 0x300-0x302
+    0x7101, // 20C: ADD V1, 1
+    0x3104, // 20E: SE V1, 4
+    0x1202, // 210: JP 0x202
+    0x1212, // 212: JP 0x212      the other 68 steps
+};
+
+static const uint16_t CALLS[] = {
+    0x2210, // 200: CALL 0x210
+    0x2210, // 202: CALL 0x210
+    0x1204, // 204: JP 0x204      the other 30 steps
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, // 206-20E
+    0x2220, // 210: CALL 0x220
+    0x00EE, // 212: RET
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, // 214-21E
+    0x6001, // 220: LD V0, 1
+    0x00EE, // 222: RET
+};
+
+static void check_counters(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(COUNTED, CHIP8_TEST_LENGTH(COUNTED), backend);
+    if (!chip) return;
+
+    CHECK(chip8_profile_executions(chip) == NULL);
+    CHECK(chip8_profile_enable(chip));
+    CHECK(chip8_profile_is_enabled(chip));
+    chip8_step_n(chip, STEPS);
+
+    const uint64_t* executions = chip8_profile_executions(chip);
+    const uint64_t* reads = chip8_profile_reads(chip);
+    const uint64_t* writes = chip8_profile_writes(chip);
+    CHECK(executions[0x200] == 1);
+    for (uint16_t address = 0x202; address <= 0x20E; address += 2) CHECK(executions[address] == 4);
+    CHECK(executions[0x210] == 3);
+    CHECK(executions[0x212] == STEPS - 32);
+    CHECK(executions[0x201] == 0);
+
+    CHECK(reads[0x300] == 8 && reads[0x301] == 4 && reads[0x302] == 4 && reads[0x303] == 0);
+    CHECK(writes[0x300] == 4 && writes[0x301] == 4 && writes[0x302] == 4 && writes[0x303] == 0);
+    CHECK(reads[0x200] == 0); // fetches are executions
+
+    Chip8ProfileSpot spots[16];
+    CHECK(chip8_profile_hotspots(chip, spots, 16) == 10);
+    CHECK(spots[0].address == 0x212 && spots[0].executions == STEPS - 32);
+    CHECK(spots[1].executions == 4 && spots[9].address == 0x200 && spots[9].executions == 1);
+    CHECK(chip8_profile_hotspots(chip, spots, 2) == 2);
+
+    // the host's writes are not the guest's, and a reset keeps the counters
+    chip8_write_memory(chip, 0x300, 0);
+    CHECK(writes[0x300] == 4);
+    chip8_reset(chip);
+    CHECK(chip8_profile_executions(chip)[0x212] == STEPS - 32);
+
+    chip8_profile_reset(chip);
+    CHECK(chip8_profile_executions(chip)[0x212] == 0);
+    CHECK(chip8_profile_hotspots(chip, spots, 16) == 0);
+
+    chip8_profile_disable(chip);
+    CHECK(!chip8_profile_is_enabled(chip));
+    CHECK(chip8_profile_executions(chip) == NULL);
+    chip8_destroy(&chip);
+}
+
+static void check_folded(Chip8* chip) {
+    char path[] = "/tmp/chip8_test_profile_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    close(fd);
+
+    CHECK(chip8_profile_export_folded(chip, path));
+    char folded[256] = { 0 };
+    FILE* file = fopen(path, "r");
+    CHECK(file != NULL);
+    if (file) {
+        CHECK(fread(folded, 1, sizeof(folded) - 1, file) > 0);
+        fclose(file);
+    }
+    unlink(path);
+
+    CHECK(strstr(folded, "main 32\n") != NULL);
+    CHECK(strstr(folded, "main;sub_210 4\n") != NULL);
+    CHECK(strstr(folded, "main;sub_210;sub_220 4\n") != NULL);
+}
+
+// Each call to 0x210 runs CALL and RET there, and LD and RET in 0x220
+static void check_routines(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(CALLS, CHIP8_TEST_LENGTH(CALLS), backend);
+    if (!chip) return;
+
+    CHECK(chip8_profile_enable(chip));
+    chip8_step_n(chip, 40);
+
+    Chip8ProfileRoutine routines[8];
+    CHECK(chip8_profile_routines(chip, routines, 8) == 3);
+    CHECK(routines[0].entry == CHIP8_PROFILE_TOP_LEVEL);
+    CHECK(routines[0].inclusive == 40 && routines[0].exclusive == 32);
+    CHECK(routines[1].entry == 0x210 && routines[1].calls == 2);
+    CHECK(routines[1].inclusive == 8 && routines[1].exclusive == 4);
+    CHECK(routines[2].entry == 0x220 && routines[2].calls == 2);
+    CHECK(routines[2].inclusive == 4 && routines[2].exclusive == 4);
+    check_folded(chip);
+
+    // a new state no longer matches the calls seen, so attribution starts over
+    chip8_reset(chip);
+    chip8_test_load(chip, CALLS, CHIP8_TEST_LENGTH(CALLS));
+    chip8_step_n(chip, 3);
+    CHECK(chip8_profile_routines(chip, routines, 8) == 3);
+    CHECK(routines[0].entry == CHIP8_PROFILE_TOP_LEVEL && routines[0].inclusive == 43);
+    CHECK(routines[1].entry == 0x210 && routines[1].calls == 3);
+
+    chip8_profile_disable(chip);
+    CHECK(chip8_profile_routines(chip, routines, 8) == 0);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_counters((Chip8Backend)backend);
+        check_routines((Chip8Backend)backend);
+    }
+    return chip8_test_finish("profile");
+}
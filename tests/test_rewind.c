@@ -0,0 +1,113 @@
+/*
+    Rewind: every frame held decodes back to exactly the state that was pushed, across
+    keyframes, after a truncate and after the oldest frames were evicted.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_rewind.h"
+#include "../include/chip8_state.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES            200
+#define KEYFRAME_INTERVAL 16
+
+static const uint16_t PROGRAM[] = {
+    0xC03F, // 200: RND V0, 0x3F
+    0xC11F, // 202: RND V1, 0x1F
+    0xF229, // 204: LD F, V2
+    0xD015, // 206: DRW V0, V1, 5
+    0x7201, // 208: ADD V2, 1
+    0xA400, // 20A: LD I, 0x400
+    0xF233, // 20C: LD B, V2
+    0x1200, // 20E: JP 0x200
+};
+
+// The states behind the frames pushed, oldest first
+typedef struct {
+    uint8_t (*states)[CHIP8_STATE_SIZE];
+    int count;
+} Pushed;
+
+static void push_frames(Chip8Rewind* rewind, Chip8* chip, Pushed* pushed, int frames) {
+    for (int frame = 0; frame < frames; frame++) {
+        chip8_step_n(chip, 13);
+        chip8_update_timers(chip);
+        // a host pushes at 60 Hz; this loop has to let the background thread catch up
+        while (!chip8_rewind_push(rewind, chip)) sched_yield();
+        chip8_save_state(chip, pushed->states[pushed->count++], CHIP8_STATE_SIZE);
+    }
+}
+
+// Frame i of the history is pushed state first + i
+static void check_frames(Chip8Rewind* rewind, const Pushed* pushed, int first) {
+    Chip8* chip = chip8_create();
+    uint8_t state[CHIP8_STATE_SIZE];
+    int wrong = 0;
+
+    // newest first, so every seek goes back across deltas and keyframes
+    for (int frame = pushed->count - first - 1; frame >= 0; frame--) {
+        CHECK(chip8_rewind_seek(rewind, frame, chip));
+        chip8_save_state(chip, state, sizeof(state));
+        wrong += memcmp(state, pushed->states[first + frame], sizeof(state)) != 0;
+    }
+    CHECK(wrong == 0);
+    CHECK(!chip8_rewind_seek(rewind, pushed->count - first, chip));
+    chip8_destroy(&chip);
+}
+
+static void check_history(void) {
+    Pushed pushed = { malloc(2 * FRAMES * CHIP8_STATE_SIZE), 0 };
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    Chip8Rewind* rewind = chip8_rewind_create(0, KEYFRAME_INTERVAL);
+
+    push_frames(rewind, chip, &pushed, FRAMES);
+    CHECK(chip8_rewind_count(rewind) == pushed.count);
+    check_frames(rewind, &pushed, 0);
+
+    // running on from an older frame replaces everything after it
+    int from = pushed.count / 2 + 3;
+    chip8_rewind_truncate(rewind, from);
+    CHECK(chip8_rewind_count(rewind) == from + 1);
+    CHECK(chip8_rewind_seek(rewind, from, chip));
+    pushed.count = from + 1;
+    push_frames(rewind, chip, &pushed, FRAMES);
+    CHECK(chip8_rewind_count(rewind) == pushed.count);
+    check_frames(rewind, &pushed, 0);
+
+    chip8_rewind_clear(rewind);
+    CHECK(chip8_rewind_count(rewind) == 0);
+    CHECK(chip8_rewind_memory_used(rewind) == 0);
+    CHECK(!chip8_rewind_seek(rewind, 0, chip));
+
+    chip8_rewind_destroy(&rewind);
+    CHECK(rewind == NULL);
+    chip8_destroy(&chip);
+    free(pushed.states);
+}
+
+// A budget of a few keyframes drops the oldest intervals and keeps the rest intact
+static void check_budget(void) {
+    size_t budget = 4 * CHIP8_STATE_SIZE;
+    Pushed pushed = { malloc(FRAMES * CHIP8_STATE_SIZE), 0 };
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    Chip8Rewind* rewind = chip8_rewind_create(budget, KEYFRAME_INTERVAL);
+
+    push_frames(rewind, chip, &pushed, FRAMES);
+    CHECK(chip8_rewind_seek(rewind, 0, chip)); // waits for the background thread
+    int held = chip8_rewind_count(rewind);
+    CHECK(held > 0 && held < pushed.count);
+    CHECK(chip8_rewind_memory_used(rewind) <= budget);
+    check_frames(rewind, &pushed, pushed.count - held);
+
+    chip8_rewind_destroy(&rewind);
+    chip8_destroy(&chip);
+    free(pushed.states);
+}
+
+int main(void) {
+    check_history();
+    check_budget();
+    return chip8_test_finish("rewind");
+}
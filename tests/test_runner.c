@@ -0,0 +1,140 @@
+/*
+    Runner: the thread runs frames on its own, takes commands in order, stops at
+    breakpoints, and publishes state, display and profile consistently; acquire and
+    call hand the instance over between frames.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_break.h"
+#include "../include/chip8_runner.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CYCLES_PER_FRAME 100
+
+static const uint16_t PROGRAM[] = {
+    0x7001, // 200: ADD V0, 1
+    0x400F, // 202: SNE V0, 0x0F
+    0x6000, // 204: LD V0, 0
+    0xF029, // 206: LD F, V0
+    0xD115, // 208: DRW V1, V1, 5
+    0x1200, // 20A: JP 0x200
+};
+
+typedef bool (*StateDone)(const Chip8RunnerState* state, uint64_t value);
+
+// Reads the state until done holds, for at most a few seconds
+static bool wait_state(Chip8Runner* runner, Chip8RunnerState* state, StateDone done, uint64_t value) {
+    time_t deadline = time(NULL) + 5;
+    do {
+        chip8_runner_read_state(runner, state);
+        if (done(state, value)) return true;
+        sched_yield();
+    } while (time(NULL) < deadline);
+    return false;
+}
+
+static bool frames_reached(const Chip8RunnerState* state, uint64_t frames) {
+    return state->frames >= frames;
+}
+
+static bool commands_taken(const Chip8RunnerState* state, uint64_t sent) {
+    return state->commands >= sent;
+}
+
+static bool stopped(const Chip8RunnerState* state, uint64_t unused) {
+    (void)unused;
+    return !state->running && state->stop_reason >= 0;
+}
+
+// Frames counted on the runner's thread, read once it was joined
+static void count_frame(Chip8* chip, void* user) {
+    (void)chip;
+    (*(uint64_t*)user)++;
+}
+
+static void enable_profile(Chip8* chip, void* arg) {
+    *(bool*)arg = chip8_profile_enable(chip);
+}
+
+static void check_runner(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    uint64_t frames = 0;
+    Chip8Runner* runner = chip8_runner_create(chip, count_frame, &frames);
+    CHECK(runner != NULL);
+    if (!runner) return;
+
+    Chip8RunnerState* state = malloc(sizeof(Chip8RunnerState));
+    chip8_runner_read_state(runner, state);
+    CHECK(!state->running && state->frames == 0 && state->PC == 0x200);
+
+    // every publication is taken after a whole frame
+    chip8_runner_set_speed(runner, CYCLES_PER_FRAME, true);
+    chip8_runner_run(runner, true);
+    CHECK(wait_state(runner, state, frames_reached, 20));
+    CHECK(state->running);
+    CHECK(state->cycle_count == state->frames * CYCLES_PER_FRAME);
+    CHECK(chip8_runner_take_display(runner) != NULL);
+
+    chip8_runner_set_key(runner, 5, true);
+    CHECK(wait_state(runner, state, commands_taken, chip8_runner_sent(runner)));
+    CHECK(state->keys[5]);
+
+    // a call runs on the thread and is waited for
+    bool profiling = false;
+    chip8_runner_call(runner, enable_profile, &profiling);
+    CHECK(profiling);
+    uint64_t frames_now = state->frames;
+    CHECK(wait_state(runner, state, frames_reached, frames_now + 10));
+    CHECK(state->profiling);
+    Chip8RunnerProfile* profile = malloc(sizeof(Chip8RunnerProfile));
+    chip8_runner_read_profile(runner, profile);
+    CHECK(profile->executions[0x200] > 0 && profile->executions[0x200] >= profile->executions[0x204]);
+    CHECK(profile->hotspot_count > 0);
+    free(profile);
+
+    // the acquired instance is the caller's; what it leaves is published on release
+    Chip8* acquired = chip8_runner_acquire(runner);
+    CHECK(acquired == chip);
+    CHECK(chip8_break_set(acquired, 0x208, "V0 == 3"));
+    uint16_t pc = chip8_get_pc(acquired);
+    chip8_runner_run(runner, false);
+    chip8_runner_release(runner);
+    CHECK(wait_state(runner, state, commands_taken, chip8_runner_sent(runner)));
+    CHECK(!state->running && state->PC == pc);
+    CHECK(state->breakpoint_count == 1 && state->breakpoint_list[0].address == 0x208);
+    CHECK(strcmp(state->breakpoint_list[0].condition, "V0 == 3") == 0);
+    CHECK(state->breakpoints[0x208 / 64] & (1ull << (0x208 % 64)));
+
+    // the breakpoint stops the thread
+    chip8_runner_run(runner, true);
+    CHECK(wait_state(runner, state, stopped, 0));
+    CHECK(state->stop_reason == CHIP8_STOP_BREAKPOINT);
+    CHECK(state->PC == 0x208 && state->V[0] == 3);
+    CHECK(state->breakpoint_list[0].hits == 1);
+
+    // the display taken last is the one the instance shows
+    uint64_t shown[CHIP8_DISPLAY_HEIGHT];
+    const uint64_t* rows = chip8_runner_take_display(runner);
+    CHECK(rows != NULL);
+    if (rows) memcpy(shown, rows, sizeof(shown));
+
+    uint64_t published = state->frames;
+    chip8_runner_destroy(&runner);
+    CHECK(runner == NULL);
+    CHECK(frames == published);
+    CHECK(chip8_get_pc(chip) == 0x208);
+    if (rows) CHECK(memcmp(shown, chip8_get_display_rows(chip), sizeof(shown)) == 0);
+    free(state);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++)
+        check_runner((Chip8Backend)backend);
+    return chip8_test_finish("runner");
+}
@@ -0,0 +1,77 @@
+/*
+    Runtime: every submitted job runs its whole budget exactly once, whichever worker
+    ends up running or stealing it, and lands where a serial run of the same budget does.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_runtime.h"
+#include "../include/chip8_state.h"
+
+#include <stdatomic.h>
+
+#define INSTANCES        64
+#define CYCLES_PER_FRAME 100
+
+static const uint16_t COUNTER[] = {
+    0x6000, // 200: LD V0, 0
+    0x7001, // 202: ADD V0, 1
+    0xC10F, // 204: RND V1, 0x0F
+    0x8014, // 206: ADD V0, V1
+    0x1202, // 208: JP 0x202
+};
+
+static atomic_int completed;
+
+static void on_done(Chip8* chip, void* user) {
+    (void)chip;
+    (void)user;
+    atomic_fetch_add(&completed, 1);
+}
+
+// Jobs of different lengths, so workers run dry at different times and steal
+static uint64_t budget_of(int instance) {
+    return (uint64_t)CYCLES_PER_FRAME * (uint64_t)(20 + 37 * instance % 200);
+}
+
+static Chip8* create(int instance) {
+    Chip8* chip = chip8_test_create(COUNTER, CHIP8_TEST_LENGTH(COUNTER), CHIP8_BACKEND_SWITCH);
+    if (chip) chip8_set_seed(chip, (uint64_t)instance + 1);
+    return chip;
+}
+
+int main(void) {
+    Chip8Runtime* rt = chip8_runtime_create(4, 2);
+    CHECK(rt != NULL);
+    if (!rt) return chip8_test_finish("runtime");
+    CHECK(chip8_runtime_thread_count(rt) == 4);
+
+    Chip8* chips[INSTANCES] = { 0 };
+    for (int i = 0; i < INSTANCES; i++) {
+        chips[i] = create(i);
+        Chip8RuntimeJob job = { budget_of(i), CYCLES_PER_FRAME, on_done, NULL };
+        CHECK(chips[i] && chip8_runtime_submit(rt, chips[i], &job));
+    }
+    chip8_runtime_wait(rt);
+    CHECK(atomic_load(&completed) == INSTANCES);
+
+    for (int i = 0; i < INSTANCES; i++) {
+        Chip8* serial = create(i);
+        if (!serial || !chips[i]) continue;
+        for (uint64_t frame = 0; frame < budget_of(i) / CYCLES_PER_FRAME; frame++) {
+            chip8_step_n(serial, CYCLES_PER_FRAME);
+            chip8_update_timers(serial);
+        }
+
+        uint8_t expected[CHIP8_STATE_SIZE];
+        uint8_t actual[CHIP8_STATE_SIZE];
+        chip8_save_state(serial, expected, sizeof(expected));
+        chip8_save_state(chips[i], actual, sizeof(actual));
+        CHECK(chip8_get_cycle_count(chips[i]) == budget_of(i));
+        CHECK(chip8_state_equal(expected, actual));
+        chip8_destroy(&serial);
+    }
+
+    chip8_runtime_destroy(&rt);
+    CHECK(rt == NULL);
+    for (int i = 0; i < INSTANCES; i++) chip8_destroy(&chips[i]);
+    return chip8_test_finish("runtime");
+}
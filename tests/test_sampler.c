@@ -0,0 +1,76 @@
+/*
+    Sampler: on every backend, samples land on the guest code being run, at the depth
+    it runs at, and the phase, depth and PC counts of a report add up.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_sampler.h"
+
+#include <time.h>
+
+#define WANTED_SAMPLES 50
+
+static const uint16_t PROGRAM[] = {
+    0x2204, // 200: CALL 0x204
+    0x1200, // 202: JP 0x200
+    0x7001, // 204: ADD V0, 1
+    0x8104, // 206: ADD V1, V0
+    0x1204, // 208: JP 0x204      busy forever, one call deep
+};
+
+static void check_report(const Chip8SampleReport* report) {
+    uint64_t phases = 0, depths = 0, pcs = 0, outside = 0;
+    for (int phase = 0; phase < CHIP8_PHASE_COUNT; phase++) phases += report->phases[phase];
+    for (int depth = 0; depth <= CHIP8_STACK_SIZE; depth++) depths += report->depths[depth];
+    for (int pc = 0; pc < CHIP8_MEMORY_SIZE; pc++) {
+        pcs += report->pcs[pc];
+        if (pc < 0x200 || pc > 0x208) outside += report->pcs[pc];
+    }
+    CHECK(phases == report->samples);
+    CHECK(depths == report->samples);
+    CHECK(pcs == report->samples - report->phases[CHIP8_PHASE_HOST]);
+    CHECK(outside == 0);
+    CHECK(pcs > 0 && report->depths[1] > 0);
+}
+
+static void check_backend(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    CHECK(chip8_sampler_report(chip) == NULL);
+    CHECK(chip8_sampler_start(chip, 0));
+    CHECK(chip8_sampler_is_running(chip));
+    CHECK(!chip8_sampler_start(chip, 0));
+
+    // only one instance per process
+    Chip8* other = chip8_create();
+    CHECK(!chip8_sampler_start(other, 0));
+    chip8_destroy(&other);
+
+    // run for at most a few seconds, the timer fires every millisecond
+    const Chip8SampleReport* report = chip8_sampler_report(chip);
+    time_t deadline = time(NULL) + 5;
+    while (report->samples < WANTED_SAMPLES && time(NULL) < deadline) chip8_step_n(chip, 10000);
+    CHECK(report->samples >= WANTED_SAMPLES);
+    check_report(report);
+
+    FILE* out = tmpfile();
+    if (out) {
+        chip8_sampler_print_report(chip, out, 5);
+        CHECK(ftell(out) > 0);
+        fclose(out);
+    }
+
+    chip8_sampler_reset(chip);
+    CHECK(report->samples == 0 && report->pcs[0x204] == 0);
+
+    chip8_sampler_stop(chip);
+    CHECK(!chip8_sampler_is_running(chip));
+    CHECK(chip8_sampler_report(chip) == NULL);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++)
+        check_backend((Chip8Backend)backend);
+    return chip8_test_finish("sampler");
+}
@@ -0,0 +1,70 @@
+/*
+    Seeds: CXNN draws the same numbers for the same seed on every backend, after a
+    reset as well, and different numbers for a different seed.
+*/
+#include "chip8_test.h"
+
+#include <string.h>
+
+#define DRAWS 15
+
+static const uint16_t PROGRAM[] = {
+    0xC0FF, 0xC1FF, 0xC2FF, 0xC3FF, 0xC4FF, // 200: RND V0..V4, 0xFF
+    0xC5FF, 0xC6FF, 0xC7FF, 0xC8FF, 0xC9FF, // 20A: RND V5..V9, 0xFF
+    0xCAFF, 0xCBFF, 0xCCFF, 0xCDFF, 0xCE0F, // 214: RND VA..VE, the last one masked
+    0x121E,                                 // 21E: JP 0x21E
+};
+
+static void draw(Chip8* chip, uint8_t* out) {
+    chip8_step_n(chip, DRAWS);
+    for (int reg = 0; reg < DRAWS; reg++) out[reg] = chip8_get_register(chip, reg);
+}
+
+static void check_backend(Chip8Backend backend, const uint8_t* expected) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    uint8_t values[DRAWS];
+    chip8_set_seed(chip, 42);
+    CHECK(chip8_get_seed(chip) == 42);
+    draw(chip, values);
+    CHECK(memcmp(values, expected, DRAWS) == 0);
+    CHECK(values[0xE] <= 0x0F);
+
+    // the seed survives a reset, which restarts the generator from it
+    chip8_reset(chip);
+    chip8_test_load(chip, PROGRAM, CHIP8_TEST_LENGTH(PROGRAM));
+    CHECK(chip8_get_seed(chip) == 42);
+    draw(chip, values);
+    CHECK(memcmp(values, expected, DRAWS) == 0);
+
+    chip8_set_seed(chip, 43);
+    chip8_reset(chip);
+    chip8_test_load(chip, PROGRAM, CHIP8_TEST_LENGTH(PROGRAM));
+    draw(chip, values);
+    CHECK(memcmp(values, expected, DRAWS) != 0);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    uint8_t expected[DRAWS];
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    chip8_set_seed(chip, 42);
+    draw(chip, expected);
+    chip8_destroy(&chip);
+
+    // new instances start from the same default seed
+    uint8_t first[DRAWS], second[DRAWS];
+    Chip8* a = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    Chip8* b = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    CHECK(chip8_get_seed(a) == chip8_get_seed(b));
+    draw(a, first);
+    draw(b, second);
+    CHECK(memcmp(first, second, DRAWS) == 0);
+    chip8_destroy(&a);
+    chip8_destroy(&b);
+
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++)
+        check_backend((Chip8Backend)backend, expected);
+    return chip8_test_finish("seed");
+}
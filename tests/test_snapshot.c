@@ -0,0 +1,87 @@
+/*
+    Snapshots: a fork restored from a snapshot runs on exactly like the instance it was
+    taken from, on every backend, and a new snapshot only allocates the pages written
+    since the last one.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_snapshot.h"
+#include "../include/chip8_state.h"
+
+#include <string.h>
+
+static const uint16_t PROGRAM[] = {
+    0xA400, // 200: LD I, 0x400
+    0xC0FF, // 202: RND V0, 0xFF
+    0xF033, // 204: LD B, V0     writes page 4 only
+    0xF029, // 206: LD F, V0
+    0xD125, // 208: DRW V1, V2, 5
+    0x7103, // 20A: ADD V1, 3
+    0x1200, // 20C: JP 0x200
+};
+
+static void check_same(Chip8* a, Chip8* b) {
+    uint8_t left[CHIP8_STATE_SIZE], right[CHIP8_STATE_SIZE];
+    chip8_save_state(a, left, sizeof(left));
+    chip8_save_state(b, right, sizeof(right));
+    CHECK(chip8_state_equal(left, right));
+}
+
+static void check_fork(Chip8Snapshot* snapshot, Chip8* original, Chip8Backend backend) {
+    Chip8* fork = chip8_test_create(NULL, 0, backend);
+    if (!fork) return;
+
+    CHECK(chip8_snapshot_restore(fork, snapshot));
+    CHECK(chip8_get_backend(fork) == backend);
+    chip8_step_n(fork, 700);
+    check_same(fork, original);
+
+    // restoring again rewinds a fork that already ran on and wrote memory
+    CHECK(chip8_snapshot_restore(fork, snapshot));
+    chip8_step_n(fork, 700);
+    check_same(fork, original);
+    chip8_destroy(&fork);
+}
+
+int main(void) {
+    size_t live_before = chip8_snapshot_live_pages();
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    chip8_step_n(chip, 300);
+
+    Chip8Snapshot* first = chip8_snapshot_take(chip);
+    CHECK(first != NULL);
+    CHECK(chip8_snapshot_cycle_count(first) == 300);
+    size_t live_first = chip8_snapshot_live_pages();
+    CHECK(live_first - live_before == CHIP8_PAGE_COUNT);
+
+    uint8_t taken[CHIP8_STATE_SIZE], restored[CHIP8_STATE_SIZE];
+    chip8_save_state(chip, taken, sizeof(taken));
+
+    // the loop only stores to page 4, so that is all a second snapshot allocates
+    chip8_step_n(chip, 300);
+    Chip8Snapshot* second = chip8_snapshot_take(chip);
+    CHECK(chip8_snapshot_live_pages() - live_first == 1);
+
+    // nothing written since: everything is shared
+    Chip8Snapshot* third = chip8_snapshot_take(chip);
+    CHECK(chip8_snapshot_live_pages() - live_first == 1);
+    chip8_snapshot_release(&third);
+    CHECK(third == NULL);
+
+    chip8_step_n(chip, 700);
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_fork(second, chip, (Chip8Backend)backend);
+    }
+
+    // a retained snapshot outlives the caller's reference
+    Chip8Snapshot* kept = chip8_snapshot_retain(first);
+    chip8_snapshot_release(&first);
+    CHECK(chip8_snapshot_restore(chip, kept));
+    chip8_save_state(chip, restored, sizeof(restored));
+    CHECK(memcmp(taken, restored, sizeof(taken)) == 0);
+
+    chip8_destroy(&chip);
+    chip8_snapshot_release(&kept);
+    chip8_snapshot_release(&second);
+    CHECK(chip8_snapshot_live_pages() == live_before);
+    return chip8_test_finish("snapshot");
+}
@@ -0,0 +1,136 @@
+#define _POSIX_C_SOURCE 200809L // mkstemp under -std=c11
+
+/*
+    States: a saved state restores into any instance and backend and runs on exactly
+    like the original; truncated, foreign or out-of-range states are refused without
+    touching the instance; state files round trip with their thumbnail.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_state.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Offsets into a state, see the layout in chip8_state.c
+#define STATE_VERSION_OFFSET 4
+#define STATE_SP_OFFSET      (8 + 4096 + 8 * CHIP8_DISPLAY_HEIGHT + 2 * 16 + 2 * 16 + 4)
+#define STATE_FLAGS_OFFSET   (STATE_SP_OFFSET + 3)
+
+static const uint16_t PROGRAM[] = {
+    0x6005, // 200: LD V0, 5
+    0xF015, // 202: LD DT, V0
+    0x2210, // 204: CALL 0x210
+    0xC0FF, // 206: RND V0, 0xFF
+    0x7101, // 208: ADD V1, 1
+    0x1204, // 20A: JP 0x204
+    0x0000, // 20C
+    0x0000, // 20E
+    0xD125, // 210: DRW V1, V2, 5
+    0x00EE, // 212: RET
+};
+
+static void run(Chip8* chip, int frames) {
+    for (int frame = 0; frame < frames; frame++) {
+        chip8_step_n(chip, 37);
+        chip8_update_timers(chip);
+    }
+}
+
+static void check_restore(const uint8_t* saved, Chip8* original, Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(NULL, 0, backend);
+    if (!chip) return;
+
+    CHECK(chip8_load_state(chip, saved, CHIP8_STATE_SIZE));
+    CHECK(chip8_get_backend(chip) == backend);
+    CHECK(chip8_take_dirty_rows(chip) == 0xFFFFFFFFu);
+
+    uint8_t expected[CHIP8_STATE_SIZE], actual[CHIP8_STATE_SIZE];
+    run(chip, 20);
+    chip8_save_state(original, expected, sizeof(expected));
+    chip8_save_state(chip, actual, sizeof(actual));
+    CHECK(chip8_state_equal(actual, expected));
+    chip8_destroy(&chip);
+}
+
+// Every broken state is refused and leaves the instance as it was
+static void check_refused(const uint8_t* saved) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    uint8_t before[CHIP8_STATE_SIZE], after[CHIP8_STATE_SIZE], broken[CHIP8_STATE_SIZE];
+    chip8_save_state(chip, before, sizeof(before));
+
+    CHECK(!chip8_load_state(chip, saved, CHIP8_STATE_SIZE - 1));
+
+    memcpy(broken, saved, sizeof(broken));
+    broken[STATE_VERSION_OFFSET]++;
+    CHECK(!chip8_load_state(chip, broken, sizeof(broken)));
+
+    memcpy(broken, saved, sizeof(broken));
+    broken[0] = 'X';
+    CHECK(!chip8_load_state(chip, broken, sizeof(broken)));
+
+    memcpy(broken, saved, sizeof(broken));
+    broken[STATE_SP_OFFSET] = 17;
+    CHECK(!chip8_load_state(chip, broken, sizeof(broken)));
+
+    memcpy(broken, saved, sizeof(broken));
+    broken[STATE_FLAGS_OFFSET] |= 0x80;
+    CHECK(!chip8_load_state(chip, broken, sizeof(broken)));
+
+    chip8_save_state(chip, after, sizeof(after));
+    CHECK(memcmp(before, after, sizeof(before)) == 0);
+    chip8_destroy(&chip);
+}
+
+static void check_file(Chip8* original) {
+    char path[] = "/tmp/chip8_state_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    close(fd);
+
+    CHECK(chip8_save_state_file(original, path));
+    Chip8* chip = chip8_create();
+    CHECK(chip8_load_state_file(chip, path));
+
+    uint8_t expected[CHIP8_STATE_SIZE], actual[CHIP8_STATE_SIZE];
+    chip8_save_state(original, expected, sizeof(expected));
+    chip8_save_state(chip, actual, sizeof(actual));
+    CHECK(memcmp(actual, expected, sizeof(actual)) == 0);
+
+    // a thumbnail pixel is set when any pixel of its 2x2 block is
+    uint32_t thumb[CHIP8_THUMB_HEIGHT];
+    CHECK(chip8_read_state_thumbnail(path, thumb));
+    const uint64_t* rows = chip8_get_display_rows(original);
+    int wrong = 0;
+    for (int y = 0; y < CHIP8_THUMB_HEIGHT; y++) {
+        for (int x = 0; x < CHIP8_THUMB_WIDTH; x++) {
+            bool any = CHIP8_PIXEL(rows, 2 * x, 2 * y) || CHIP8_PIXEL(rows, 2 * x + 1, 2 * y) ||
+                       CHIP8_PIXEL(rows, 2 * x, 2 * y + 1) || CHIP8_PIXEL(rows, 2 * x + 1, 2 * y + 1);
+            wrong += any != (bool)((thumb[y] >> (31 - x)) & 1);
+        }
+    }
+    CHECK(wrong == 0);
+
+    chip8_destroy(&chip);
+    unlink(path);
+}
+
+int main(void) {
+    Chip8* original = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    chip8_set_seed(original, 7);
+    run(original, 3);
+    chip8_step_n(original, 3); // inside the subroutine, with a return address on the stack
+
+    uint8_t saved[CHIP8_STATE_SIZE];
+    CHECK(chip8_save_state(original, saved, sizeof(saved)) == CHIP8_STATE_SIZE);
+    CHECK(chip8_save_state(original, saved, sizeof(saved) - 1) == 0);
+    check_refused(saved);
+    check_file(original);
+
+    run(original, 20);
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++)
+        check_restore(saved, original, (Chip8Backend)backend);
+    chip8_destroy(&original);
+    return chip8_test_finish("state");
+}
@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200809L // mkstemp under -std=c11
+
+/*
+    Traces: every backend records exactly the instructions a single-stepped instance
+    runs, and searches for the records that wrote a register find every opcode that
+    writes it, through the side index as well as within a bucket.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_trace.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+static const uint16_t PROGRAM[] = {
+    0x6A00, // 200: LD VA, 0      filler: over a bucket of records that write neither V3 nor VF
+    0x6B00, // 202: LD VB, 0
+    0x7A01, // 204: ADD VA, 1
+    0x3AFF, // 206: SE VA, 0xFF
+    0x1204, // 208: JP 0x204
+    0x6A00, // 20A: LD VA, 0
+    0x7B01, // 20C: ADD VB, 1
+    0x3B08, // 20E: SE VB, 8
+    0x1204, // 210: JP 0x204
+    0xA300, // 212: LD I, 0x300
+    0x6507, // 214: LD V5, 7
+    0xF565, // 216: LD V0..V5, [I]
+    0x6101, // 218: LD V1, 1
+    0x6202, // 21A: LD V2, 2
+    0x8124, // 21C: ADD V1, V2
+    0x6003, // 21E: LD V0, 3
+    0x1220, // 220: JP 0x220
+};
+
+static void check_written_registers(void) {
+    CHECK(chip8_trace_written_registers(0xF565) == 0x003F);
+    CHECK(chip8_trace_written_registers(0xF065) == 0x0001);
+    CHECK(chip8_trace_written_registers(0x8124) == 0x8002);
+    CHECK(chip8_trace_written_registers(0x8120) == 0x0002);
+    CHECK(chip8_trace_written_registers(0xD125) == 0x8000);
+    CHECK(chip8_trace_written_registers(0xF533) == 0);
+    CHECK(chip8_trace_changed_register(0x8124) == 1);
+    CHECK(chip8_trace_changed_register(0xD125) == 0xF);
+}
+
+// Each record holds what the instruction at that cycle did on a single-stepped instance
+static void check_recording(const char* path, Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    CHECK(chip8_trace_start(chip, path));
+    CHECK(chip8_trace_is_recording(chip));
+    CHECK(!chip8_trace_start(chip, path));
+    for (int batch = 0; batch < 30; batch++) chip8_step_n(chip, 777);
+    CHECK(chip8_trace_recorded(chip) == 30 * 777);
+    CHECK(chip8_trace_stop(chip));
+    CHECK(!chip8_trace_is_recording(chip));
+    chip8_destroy(&chip);
+
+    // without its index the trace is indexed again on open
+    char index_path[64];
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+    if (backend == CHIP8_BACKEND_THREADED) unlink(index_path);
+
+    Chip8TraceReader* reader = chip8_trace_open(path);
+    CHECK(reader != NULL);
+    if (!reader) return;
+    CHECK(chip8_trace_count(reader) == 30 * 777);
+    CHECK(chip8_trace_find_cycle(reader, 12345) == 12345);
+
+    Chip8* reference = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    const Chip8TraceRecord* records = chip8_trace_records(reader);
+    int wrong = 0;
+    for (uint64_t i = 0; i < chip8_trace_count(reader); i++) {
+        const Chip8TraceRecord* record = &records[i];
+        uint16_t pc = chip8_get_pc(reference);
+        uint16_t opcode = (uint16_t)(chip8_read_memory(reference, pc) << 8 | chip8_read_memory(reference, pc + 1));
+        uint64_t cycle = chip8_get_cycle_count(reference);
+        chip8_step(reference);
+
+        int reg = chip8_trace_changed_register(opcode);
+        uint16_t value = reg >= 0 ? reference->V[reg] : 0;
+        wrong += record->cycle != cycle || record->pc != pc || record->opcode != opcode ||
+                 record->i != reference->I || record->value != value;
+    }
+    CHECK(wrong == 0);
+
+    chip8_destroy(&reference);
+    chip8_trace_close(&reader);
+    CHECK(reader == NULL);
+}
+
+static void check_search(const char* path) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    if (!chip) return;
+
+    CHECK(chip8_trace_start(chip, path));
+    for (int i = 0; i < 20000 && chip8_get_pc(chip) != 0x220; i++) chip8_step(chip);
+    chip8_step(chip);
+    CHECK(chip8_trace_stop(chip));
+    chip8_destroy(&chip);
+
+    Chip8TraceReader* reader = chip8_trace_open(path);
+    CHECK(reader != NULL);
+    if (!reader) return;
+    int64_t count = (int64_t)chip8_trace_count(reader);
+    CHECK(count > 4096);
+
+    int64_t load = chip8_trace_find(reader, CHIP8_TRACE_BY_OPCODE, 0xF565, -1, false);
+    int64_t add = chip8_trace_find(reader, CHIP8_TRACE_BY_OPCODE, 0x8124, -1, false);
+    CHECK(load > 4096 && add == load + 3);
+
+    // FX65 writes V0 through VX, not VX alone
+    CHECK(chip8_trace_find(reader, CHIP8_TRACE_BY_WRITE, 3, -1, false) == load);
+    CHECK(chip8_trace_find(reader, CHIP8_TRACE_BY_WRITE, 0, -1, false) == load);
+    CHECK(chip8_trace_find(reader, CHIP8_TRACE_BY_WRITE, 6, -1, false) == -1);
+    CHECK(chip8_trace_find(reader, CHIP8_TRACE_BY_WRITE, 3, count, true) == load);
+
+    // 8XY4 writes the carry into VF as well as the sum into VX
+    CHECK(chip8_trace_find(reader, CHIP8_TRACE_BY_WRITE, 0xF, -1, false) == add);
+    CHECK(chip8_trace_find(reader, CHIP8_TRACE_BY_WRITE, 0xF, count, true) == add);
+    CHECK(chip8_trace_find(reader, CHIP8_TRACE_BY_WRITE, 0xF, add, false) == -1);
+    CHECK(chip8_trace_find(reader, CHIP8_TRACE_BY_WRITE, 1, load, false) == add - 2);
+
+    chip8_trace_close(&reader);
+}
+
+int main(void) {
+    check_written_registers();
+
+    char path[] = "/tmp/chip8_test_trace_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd >= 0) {
+        close(fd);
+        for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++)
+            check_recording(path, (Chip8Backend)backend);
+        check_search(path);
+
+        char index_path[sizeof(path) + 4];
+        snprintf(index_path, sizeof(index_path), "%s.idx", path);
+        unlink(index_path);
+        unlink(path);
+    }
+    return chip8_test_finish("trace");
+}
@@ -0,0 +1,104 @@
+/*
+    Undo: stepping back through every kind of instruction restores exactly the state
+    before it, on every backend, and running forward again replays the same steps.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_state.h"
+#include "../include/chip8_undo.h"
+
+#include <stdlib.h>
+
+#define STEPS 300
+
+static const uint16_t PROGRAM[] = {
+    0x6A05, // 200: LD VA, 5
+    0xFA15, // 202: LD DT, VA
+    0xFA18, // 204: LD ST, VA
+    0xA400, // 206: LD I, 0x400
+    0x2220, // 208: CALL 0x220
+    0x00E0, // 20A: CLS
+    0x1200, // 20C: JP 0x200
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, // 20E-21E
+    0xC0FF, // 220: RND V0, 0xFF
+    0xC1FF, // 222: RND V1, 0xFF
+    0x8014, // 224: ADD V0, V1, carry in VF
+    0xF033, // 226: LD B, V0
+    0xF355, // 228: LD [I], V3
+    0xF365, // 22A: LD V3, [I]
+    0xF029, // 22C: LD F, V0
+    0xD015, // 22E: DRW V0, V1, 5
+    0xFB07, // 230: LD VB, DT
+    0x00EE, // 232: RET
+};
+
+static void check_backend(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    CHECK(!chip8_undo_is_enabled(chip));
+    CHECK(chip8_undo_enable(chip, 0));
+    CHECK(chip8_undo_is_enabled(chip));
+
+    // the state before every step, with a timer tick now and then
+    uint8_t (*before)[CHIP8_STATE_SIZE] = malloc((STEPS + 1) * CHIP8_STATE_SIZE);
+    for (int step = 0; step < STEPS; step++) {
+        if (step % 7 == 6) chip8_update_timers(chip);
+        chip8_save_state(chip, before[step], CHIP8_STATE_SIZE);
+        chip8_step_n(chip, 1);
+    }
+    chip8_save_state(chip, before[STEPS], CHIP8_STATE_SIZE);
+    CHECK(chip8_undo_available(chip) == STEPS);
+
+    uint8_t state[CHIP8_STATE_SIZE];
+    int wrong = 0;
+    for (int step = STEPS - 1; step >= STEPS / 2; step--) {
+        CHECK(chip8_step_back(chip));
+        chip8_save_state(chip, state, sizeof(state));
+        wrong += !chip8_state_equal(state, before[step]);
+    }
+    CHECK(wrong == 0);
+
+    // forward again in one batch, stopping short of the next tick, which is not replayed
+    chip8_step_n(chip, 2);
+    chip8_save_state(chip, state, sizeof(state));
+    CHECK(chip8_state_equal(state, before[STEPS / 2 + 2]));
+
+    CHECK(chip8_step_back_n(chip, 2 + STEPS / 2) == 2 + STEPS / 2);
+    chip8_save_state(chip, state, sizeof(state));
+    CHECK(chip8_state_equal(state, before[0]));
+    CHECK(chip8_undo_available(chip) == 0);
+    CHECK(!chip8_step_back(chip));
+
+    // replacing the state drops the log
+    chip8_step_n(chip, 10);
+    chip8_set_seed(chip, 5);
+    CHECK(chip8_undo_available(chip) == 0);
+
+    chip8_undo_disable(chip);
+    CHECK(!chip8_undo_is_enabled(chip));
+    chip8_step_n(chip, 10);
+    CHECK(!chip8_step_back(chip));
+
+    free(before);
+    chip8_destroy(&chip);
+}
+
+// A small budget keeps the newest instructions
+static void check_budget(void) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), CHIP8_BACKEND_SWITCH);
+    CHECK(chip8_undo_enable(chip, 1024));
+    chip8_step_n(chip, 10000);
+
+    int available = chip8_undo_available(chip);
+    CHECK(available > 0 && available < 10000);
+    CHECK(chip8_step_back_n(chip, 10000) == available);
+    CHECK(chip8_undo_available(chip) == 0);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++)
+        check_backend((Chip8Backend)backend);
+    check_budget();
+    return chip8_test_finish("undo");
+}
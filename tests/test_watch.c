@@ -0,0 +1,108 @@
+/*
+    Watchpoints: chip8_run_until stops right after the guest instruction that reads or
+    writes a watched range or changes a watched register, and reports what it did.
+*/
+#include "chip8_test.h"
+#include "../include/chip8_watch.h"
+
+#include <string.h>
+
+static const uint16_t PROGRAM[] = {
+    0xA300, // 200: LD I, 0x300
+    0x6007, // 202: LD V0, 7
+    0xF033, // 204: LD B, V0      writes 0, 0, 7 to 0x300-0x302
+    0xA302, // 206: LD I, 0x302
+    0xF065, // 208: LD V0, [I]    reads 0x302
+    0x7301, // 20A: ADD V3, 1
+    0x1200, // 20C: JP 0x200
+};
+
+static void check_memory(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    int write = chip8_watch_memory(chip, 0x302, 1, CHIP8_WATCH_WRITE);
+    CHECK(write >= 0);
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_WATCHPOINT);
+    CHECK(chip8_get_pc(chip) == 0x206);
+    const Chip8WatchHit* hit = chip8_watch_last_hit(chip);
+    CHECK(hit && hit->kind == CHIP8_WATCH_WRITE && hit->target == 0x302 && hit->pc == 0x204);
+    CHECK(hit && hit->cycle == 2 && hit->old_value == 0 && hit->new_value == 7);
+    CHECK(chip8_watch_get(chip, write)->hits == 1);
+
+    // the host's accesses are never caught
+    chip8_read_memory(chip, 0x302);
+    chip8_write_memory(chip, 0x302, 9);
+    CHECK(chip8_watch_get(chip, write)->hits == 1);
+
+    chip8_watch_remove(chip, write);
+    CHECK(chip8_watch_get(chip, write) == NULL);
+    int read = chip8_watch_memory(chip, 0x2FF, 4, CHIP8_WATCH_READ);
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_WATCHPOINT);
+    CHECK(chip8_get_pc(chip) == 0x20A);
+    hit = chip8_watch_last_hit(chip);
+    CHECK(hit && hit->kind == CHIP8_WATCH_READ && hit->target == 0x302 && hit->pc == 0x208);
+    CHECK(hit && hit->new_value == 9);
+
+    // a full loop writes and reads the range again
+    chip8_watch_remove(chip, read);
+    CHECK(chip8_watch_memory(chip, 0x300, 3, CHIP8_WATCH_ACCESS) >= 0);
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_WATCHPOINT);
+    CHECK(chip8_get_pc(chip) == 0x206);
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_WATCHPOINT);
+    CHECK(chip8_get_pc(chip) == 0x20A);
+
+    // ranges wrap at the end of memory, and pages nobody touches never stop a run
+    chip8_watch_clear_all(chip);
+    CHECK(chip8_watch_memory(chip, 0xFFF, 2, CHIP8_WATCH_ACCESS) >= 0);
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_BUDGET);
+    chip8_watch_clear_all(chip);
+
+    for (int id = 0; id < CHIP8_WATCH_MAX; id++) CHECK(chip8_watch_memory(chip, 0x400, 1, CHIP8_WATCH_READ) == id);
+    CHECK(chip8_watch_memory(chip, 0x400, 1, CHIP8_WATCH_READ) == -1);
+    chip8_watch_clear_all(chip);
+    CHECK(chip8_watch_get(chip, 0) == NULL);
+    chip8_destroy(&chip);
+}
+
+static void check_registers(Chip8Backend backend) {
+    Chip8* chip = chip8_test_create(PROGRAM, CHIP8_TEST_LENGTH(PROGRAM), backend);
+    if (!chip) return;
+
+    CHECK(strcmp(chip8_watch_register_name(CHIP8_WATCH_I), "I") == 0);
+    CHECK(chip8_watch_register(chip, (Chip8WatchRegister)3, true));
+    CHECK(chip8_watch_register_is_set(chip, (Chip8WatchRegister)3));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_WATCHPOINT);
+    CHECK(chip8_get_pc(chip) == 0x20C);
+    const Chip8WatchHit* hit = chip8_watch_last_hit(chip);
+    CHECK(hit && hit->kind == CHIP8_WATCH_CHANGE && hit->target == 3 && hit->pc == 0x20A);
+    CHECK(hit && hit->old_value == 0 && hit->new_value == 1);
+
+    // V0 is loaded with the 7 it already holds from the second pass on
+    CHECK(chip8_watch_register(chip, CHIP8_WATCH_V0, true));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_WATCHPOINT);
+    CHECK(chip8_watch_last_hit(chip)->target == 3);
+    CHECK(chip8_watch_register_hits(chip, (Chip8WatchRegister)3) == 2);
+    CHECK(chip8_watch_register_hits(chip, CHIP8_WATCH_V0) == 0);
+
+    // watches survive a reset; hits of a run are cleared when the next one starts
+    chip8_reset(chip);
+    chip8_test_load(chip, PROGRAM, CHIP8_TEST_LENGTH(PROGRAM));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_WATCHPOINT);
+    CHECK(chip8_watch_last_hit(chip)->target == CHIP8_WATCH_V0 && chip8_get_pc(chip) == 0x204);
+
+    chip8_watch_register(chip, CHIP8_WATCH_V0, false);
+    chip8_watch_register(chip, (Chip8WatchRegister)3, false);
+    CHECK(!chip8_watch_register_is_set(chip, CHIP8_WATCH_V0));
+    CHECK(chip8_run_until(chip, 1000) == CHIP8_STOP_BUDGET);
+    CHECK(chip8_watch_last_hit(chip) == NULL);
+    chip8_destroy(&chip);
+}
+
+int main(void) {
+    for (int backend = CHIP8_BACKEND_SWITCH; backend < CHIP8_BACKEND_AOT; backend++) {
+        check_memory((Chip8Backend)backend);
+        check_registers((Chip8Backend)backend);
+    }
+    return chip8_test_finish("watch");
+}
@@ -0,0 +1,396 @@
+/*
+    Ahead-of-time recompiler: ROM -> C -> shared object for chip8_load_aot.
+
+    usage: chip8aotc rom.ch8 out.so [-c out.c] [-I include_dir] [--cc compiler]
+
+    Code reachable from 0x200 is split into basic blocks with the same rules as the JIT
+    (a block ends at 1NNN, 2NNN, 00EE, BNNN, a skip, FX0A, FX33, FX55 or after
+    CHIP8_AOT_MAX_BLOCK instructions). Each block becomes one C function on a Chip8*;
+    register, ALU, I and timer ops are inlined, the rest call back into the interpreter.
+    BNNN targets depend on V0 and are left to the interpreter at runtime.
+*/
+#include "../include/chip8.h"
+#include "../include/chip8_aot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CHIP8_AOT_INCLUDE_DIR
+#define CHIP8_AOT_INCLUDE_DIR "include"
+#endif
+
+#define ROM_START 0x200
+
+typedef struct {
+    uint16_t start;
+    uint8_t length;
+} Block;
+
+typedef struct {
+    Chip8* chip;
+    uint16_t rom_end; // first address past the ROM image
+
+    bool queued[CHIP8_DECODE_SIZE];
+    uint16_t worklist[CHIP8_DECODE_SIZE];
+    int worklist_size;
+
+    Block blocks[CHIP8_DECODE_SIZE];
+    int block_count;
+} Translator;
+
+static void queue_block(Translator* t, uint16_t address) {
+    if ((address & 1) || address < ROM_START || address >= t->rom_end) return;
+    if (t->queued[address >> 1]) return;
+
+    t->queued[address >> 1] = true;
+    t->worklist[t->worklist_size++] = address;
+}
+
+/*
+    Returns true if opcode ends a block, queueing its statically known successors.
+*/
+static bool block_ends(Translator* t, uint16_t pc, uint16_t opcode) {
+    uint8_t nn = opcode & 0x00FF;
+    uint8_t n = opcode & 0x000F;
+    uint16_t nnn = opcode & 0x0FFF;
+
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            return nn == 0xEE;
+
+        case 0x1000:
+            queue_block(t, nnn);
+            return true;
+
+        case 0x2000:
+            queue_block(t, nnn);
+            queue_block(t, pc + 2);
+            return true;
+
+        case 0x3000:
+        case 0x4000:
+            queue_block(t, pc + 2);
+            queue_block(t, pc + 4);
+            return true;
+
+        case 0x5000:
+        case 0x9000:
+            if (n != 0) return false;
+            queue_block(t, pc + 2);
+            queue_block(t, pc + 4);
+            return true;
+
+        case 0xB000:
+            return true;
+
+        case 0xE000:
+            if (nn != 0x9E && nn != 0xA1) return false;
+            queue_block(t, pc + 2);
+            queue_block(t, pc + 4);
+            return true;
+
+        case 0xF000:
+            if (nn == 0x0A || nn == 0x33 || nn == 0x55) {
+                queue_block(t, pc + 2);
+                return true;
+            }
+            return false;
+    }
+
+    return false;
+}
+
+static void discover(Translator* t) {
+    queue_block(t, ROM_START);
+
+    for (int w = 0; w < t->worklist_size; w++) {
+        uint16_t start = t->worklist[w];
+        uint16_t pc = start;
+        uint8_t length = 0;
+        bool ended = false;
+
+        while (!ended && length < CHIP8_AOT_MAX_BLOCK && pc + 1 < t->rom_end) {
+            ended = block_ends(t, pc, chip8_read_opcode(t->chip, pc));
+            pc += 2;
+            length++;
+        }
+
+        if (length == 0) continue;
+        if (!ended) queue_block(t, pc);
+
+        t->blocks[t->block_count].start = start;
+        t->blocks[t->block_count].length = length;
+        t->block_count++;
+    }
+}
+
+// === C emission ===
+
+static void emit_helper(FILE* out, uint16_t pc, uint16_t opcode) {
+    fprintf(out, "    c->PC = 0x%03X; exec_opcode(c, 0x%04X);\n", pc, opcode);
+}
+
+/*
+    Emits one instruction. The statements mirror the interpreter's handlers in chip8.c.
+    Returns true if the block ends here (PC has been set).
+*/
+static bool emit_instruction(FILE* out, uint16_t pc, uint16_t opcode) {
+    uint8_t x = (opcode & 0x0F00) >> 8;
+    uint8_t y = (opcode & 0x00F0) >> 4;
+    uint8_t n = (opcode & 0x000F);
+    uint8_t nn = (opcode & 0x00FF);
+    uint16_t nnn = (opcode & 0x0FFF);
+    unsigned skip = (uint16_t)(pc + 4);
+    unsigned next = (uint16_t)(pc + 2);
+
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            emit_helper(out, pc, opcode);
+            return nn == 0xEE;
+
+        case 0x1000:
+            fprintf(out, "    c->PC = 0x%03X;\n", nnn);
+            return true;
+
+        case 0x2000:
+            emit_helper(out, pc, opcode);
+            return true;
+
+        case 0x3000:
+        case 0x4000:
+            fprintf(out, "    c->PC = (c->V[0x%X] %s 0x%02X) ? 0x%03X : 0x%03X;\n",
+                    x, (opcode & 0xF000) == 0x3000 ? "==" : "!=", nn, skip, next);
+            return true;
+
+        case 0x5000:
+        case 0x9000:
+            if (n != 0) {
+                emit_helper(out, pc, opcode); // unassigned, the interpreter records it
+                return false;
+            }
+            fprintf(out, "    c->PC = (c->V[0x%X] %s c->V[0x%X]) ? 0x%03X : 0x%03X;\n",
+                    x, (opcode & 0xF000) == 0x5000 ? "==" : "!=", y, skip, next);
+            return true;
+
+        case 0x6000:
+            fprintf(out, "    c->V[0x%X] = 0x%02X;\n", x, nn);
+            return false;
+
+        case 0x7000:
+            fprintf(out, "    c->V[0x%X] += 0x%02X;\n", x, nn);
+            return false;
+
+        case 0x8000:
+            switch (n) {
+                case 0x0:
+                    fprintf(out, "    c->V[0x%X] = c->V[0x%X];\n", x, y);
+                    return false;
+                case 0x1:
+                case 0x2:
+                case 0x3:
+                    fprintf(out, "    c->V[0x%X] %s= c->V[0x%X]; c->V[0xF] = 0;\n",
+                            x, n == 0x1 ? "|" : (n == 0x2 ? "&" : "^"), y);
+                    return false;
+                case 0x4:
+                    fprintf(out, "    { uint16_t sum = c->V[0x%X] + c->V[0x%X]; c->V[0xF] = (sum > 0xFF) ? 1 : 0; c->V[0x%X] = sum & 0xFF; }\n",
+                            x, y, x);
+                    return false;
+                case 0x5:
+                    fprintf(out, "    c->V[0xF] = (c->V[0x%X] >= c->V[0x%X]) ? 1 : 0; c->V[0x%X] -= c->V[0x%X];\n", x, y, x, y);
+                    return false;
+                case 0x6:
+                    fprintf(out, "    c->V[0xF] = c->V[0x%X] & 0x01; c->V[0x%X] = c->V[0x%X] >> 1;\n", y, x, y);
+                    return false;
+                case 0x7:
+                    fprintf(out, "    c->V[0xF] = (c->V[0x%X] >= c->V[0x%X]) ? 1 : 0; c->V[0x%X] = c->V[0x%X] - c->V[0x%X];\n",
+                            y, x, x, y, x);
+                    return false;
+                case 0xE:
+                    fprintf(out, "    c->V[0xF] = (c->V[0x%X] & 0x80) >> 7; c->V[0x%X] = c->V[0x%X] << 1;\n", y, x, y);
+                    return false;
+            }
+            emit_helper(out, pc, opcode); // unassigned 8XYn
+            return false;
+
+        case 0xA000:
+            fprintf(out, "    c->I = 0x%03X;\n", nnn);
+            return false;
+
+        case 0xB000:
+            fprintf(out, "    c->PC = 0x%03X + c->V[0x0];\n", nnn);
+            return true;
+
+        case 0xC000:
+        case 0xD000:
+            emit_helper(out, pc, opcode);
+            return false;
+
+        case 0xE000:
+            emit_helper(out, pc, opcode);
+            return nn == 0x9E || nn == 0xA1; // unassigned EXnn only gets recorded
+
+        case 0xF000:
+            switch (nn) {
+                case 0x07:
+                    fprintf(out, "    c->V[0x%X] = c->delay_timer;\n", x);
+                    return false;
+                case 0x15:
+                    fprintf(out, "    c->delay_timer = c->V[0x%X];\n", x);
+                    return false;
+                case 0x18:
+                    fprintf(out, "    c->sound_timer = c->V[0x%X];\n", x);
+                    return false;
+                case 0x1E:
+                    fprintf(out, "    c->I += c->V[0x%X];\n", x);
+                    return false;
+                case 0x29:
+                    fprintf(out, "    c->I = (c->V[0x%X] & 0x0F) * 5;\n", x);
+                    return false;
+                case 0x65:
+                    emit_helper(out, pc, opcode);
+                    return false;
+                case 0x0A:
+                case 0x33:
+                case 0x55:
+                    emit_helper(out, pc, opcode);
+                    return true;
+            }
+            emit_helper(out, pc, opcode); // unassigned FXnn
+            return false;
+    }
+
+    return false;
+}
+
+static bool write_module(Translator* t, const char* rom_path, const char* c_path) {
+    FILE* out = fopen(c_path, "w");
+    if (!out) {
+        fprintf(stderr, "ERROR: Failed to create %s\n", c_path);
+        return false;
+    }
+
+    fprintf(out, "/* Generated by chip8aotc from %s, do not edit. */\n", rom_path);
+    fprintf(out, "#include \"chip8.h\"\n#include \"chip8_aot.h\"\n\n");
+    fprintf(out, "static Chip8AotExecFn exec_opcode;\n\n");
+
+    for (int b = 0; b < t->block_count; b++) {
+        const Block* block = &t->blocks[b];
+        fprintf(out, "static void block_%03X(Chip8* c) {\n", block->start);
+
+        uint16_t pc = block->start;
+        bool ended = false;
+        for (int i = 0; i < block->length; i++, pc += 2) {
+            char disasm[CHIP8_DISASM_BUFSIZE];
+            chip8_disassemble(t->chip, pc, disasm, sizeof(disasm));
+            fprintf(out, "    /* 0x%03X  %s */\n", pc, disasm);
+            ended = emit_instruction(out, pc, chip8_read_opcode(t->chip, pc));
+        }
+        if (!ended) {
+            fprintf(out, "    c->PC = 0x%03X;\n", pc);
+        }
+        fprintf(out, "}\n\n");
+    }
+
+    fprintf(out, "static const Chip8AotBlock blocks[] = {\n");
+    for (int b = 0; b < t->block_count; b++) {
+        fprintf(out, "    { 0x%03X, %u, block_%03X },\n", t->blocks[b].start, t->blocks[b].length, t->blocks[b].start);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const uint8_t image[] = {");
+    const uint8_t* memory = chip8_get_memory(t->chip);
+    for (uint16_t a = ROM_START; a < t->rom_end; a++) {
+        fprintf(out, "%s0x%02X,", ((a - ROM_START) % 16 == 0) ? "\n    " : " ", memory[a]);
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out,
+            "const Chip8AotModule chip8_aot_module = {\n"
+            "    CHIP8_AOT_ABI_VERSION, sizeof(Chip8),\n"
+            "    sizeof(blocks) / sizeof(blocks[0]), blocks,\n"
+            "    image, sizeof(image),\n"
+            "    &exec_opcode,\n"
+            "};\n");
+
+    bool ok = (ferror(out) == 0);
+    if (fclose(out) != 0) ok = false;
+    if (!ok) fprintf(stderr, "ERROR: Failed to write %s\n", c_path);
+    return ok;
+}
+
+static bool compile_module(const char* cc, const char* include_dir, const char* c_path, const char* so_path) {
+    char command[1024];
+    int len = snprintf(command, sizeof(command), "%s -O2 -shared -fPIC -I\"%s\" -o \"%s\" \"%s\"",
+                       cc, include_dir, so_path, c_path);
+    if (len < 0 || (size_t)len >= sizeof(command)) {
+        fprintf(stderr, "ERROR: Compiler command line too long\n");
+        return false;
+    }
+
+    printf("%s\n", command);
+    if (system(command) != 0) {
+        fprintf(stderr, "ERROR: Compiling %s failed\n", c_path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const char* rom_path = NULL;
+    const char* so_path = NULL;
+    const char* c_path = NULL;
+    const char* include_dir = CHIP8_AOT_INCLUDE_DIR;
+    const char* cc = getenv("CC") ? getenv("CC") : "cc";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            c_path = argv[++i];
+        } else if (strcmp(argv[i], "-I") == 0 && i + 1 < argc) {
+            include_dir = argv[++i];
+        } else if (strcmp(argv[i], "--cc") == 0 && i + 1 < argc) {
+            cc = argv[++i];
+        } else if (!rom_path) {
+            rom_path = argv[i];
+        } else if (!so_path) {
+            so_path = argv[i];
+        } else {
+            rom_path = NULL;
+            break;
+        }
+    }
+
+    if (!rom_path || !so_path) {
+        fprintf(stderr, "usage: %s rom.ch8 out.so [-c out.c] [-I include_dir] [--cc compiler]\n", argv[0]);
+        return 1;
+    }
+
+    char c_path_default[512];
+    if (!c_path) {
+        snprintf(c_path_default, sizeof(c_path_default), "%s.c", so_path);
+        c_path = c_path_default;
+    }
+
+    Translator* t = calloc(1, sizeof(Translator));
+    if (!t) {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+
+    t->chip = chip8_create();
+    if (!t->chip || !chip8_load_rom(t->chip, rom_path)) {
+        chip8_destroy(&t->chip);
+        free(t);
+        return 1;
+    }
+    t->rom_end = (uint16_t)(ROM_START + t->chip->rom_size);
+
+    discover(t);
+    printf("Translated %d blocks from %s\n", t->block_count, rom_path);
+
+    bool ok = write_module(t, rom_path, c_path) && compile_module(cc, include_dir, c_path, so_path);
+
+    chip8_destroy(&t->chip);
+    free(t);
+    return ok ? 0 : 1;
+}
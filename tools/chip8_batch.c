@@ -0,0 +1,224 @@
+/*
+    Runs many instances of one ROM on the work-stealing runtime.
+
+    usage: chip8batch [rom.ch8|-] [instances] [frames] [cycles_per_frame] [threads] [lanes]
+
+    Without a ROM the built-in loop of chip8bench is used. Instance i holds key i % 16
+    down for the whole run and seeds CXNN with i, so ROMs that read input or draw random
+    numbers end up in different states. Prints the aggregate throughput and how many
+    distinct final states were reached.
+
+    With lanes (1 to 32) the instances run in groups of that many on the lockstep
+    interpreter of chip8_lanes.h instead, one group after the other on this thread.
+*/
+#define _POSIX_C_SOURCE 200809L // clock_gettime under -std=c11
+
+#include "../include/chip8.h"
+#include "../include/chip8_lanes.h"
+#include "../include/chip8_runtime.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_INSTANCES        1024
+#define DEFAULT_FRAMES           600
+#define DEFAULT_CYCLES_PER_FRAME 1000
+
+// 0x200: LD V0,0 / LD V1,5 / ADD V0,1 / ADD V1,V0 / SUB V2,V1 / LD I,0x300 / ADD I,V0 / SE V0,0xFF / JP 0x204 / JP 0x200
+static const uint8_t BUILTIN_ROM[] = {
+    0x60, 0x00, 0x61, 0x05, 0x70, 0x01, 0x81, 0x04, 0x82, 0x15,
+    0xA3, 0x00, 0xF0, 0x1E, 0x30, 0xFF, 0x12, 0x04, 0x12, 0x00,
+};
+
+typedef struct {
+    atomic_int completed;
+    atomic_int halted;
+} BatchStats;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint8_t* read_rom(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Failed to open the ROM: %s\n", path);
+        return NULL;
+    }
+
+    size_t max_size = CHIP8_MEMORY_SIZE - 0x200;
+    uint8_t* data = malloc(max_size);
+    *size = data ? fread(data, 1, max_size, file) : 0;
+    fclose(file);
+
+    if (!data || *size == 0) {
+        fprintf(stderr, "ERROR: Failed to read ROM!\n");
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+static void on_done(Chip8* chip, void* user) {
+    BatchStats* stats = user;
+    if (chip8_is_halted(chip)) {
+        atomic_fetch_add(&stats->halted, 1);
+    }
+    atomic_fetch_add(&stats->completed, 1);
+}
+
+// FNV-1a over the architectural state, to count distinct outcomes
+static uint64_t state_hash(Chip8* chip) {
+    uint64_t h = 1469598103934665603ULL;
+    const uint8_t* parts[] = { (const uint8_t*)chip->V, (const uint8_t*)&chip->PC, (const uint8_t*)&chip->I,
+                               chip8_get_memory(chip), (const uint8_t*)chip8_get_display_rows(chip) };
+    const size_t sizes[] = { sizeof(chip->V), sizeof(chip->PC), sizeof(chip->I),
+                             CHIP8_MEMORY_SIZE, sizeof(chip->display) };
+
+    for (size_t p = 0; p < sizeof(sizes) / sizeof(sizes[0]); p++) {
+        for (size_t i = 0; i < sizes[p]; i++) {
+            h ^= parts[p][i];
+            h *= 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+    Runs the instances group by group on the lane interpreter and stores the final
+    states back into them. Returns the number of dispatches, or -1 at failure.
+*/
+static long long run_lanes(Chip8** chips, int instances, int lane_count, int frames, int cycles_per_frame) {
+    Chip8Lanes* lanes = chip8_lanes_create(lane_count);
+    if (!lanes) return -1;
+
+    long long dispatches = 0;
+    for (int first = 0; first < instances; first += lane_count) {
+        int group = (instances - first < lane_count) ? instances - first : lane_count;
+        for (int l = 0; l < lane_count; l++) {
+            // a short last group repeats its first instance in the unused lanes
+            chip8_lanes_load(lanes, l, chips[first + (l < group ? l : 0)]);
+        }
+
+        for (int frame = 0; frame < frames; frame++) {
+            dispatches += chip8_lanes_step_n(lanes, cycles_per_frame);
+            chip8_lanes_update_timers(lanes);
+        }
+
+        for (int l = 0; l < group; l++) {
+            chip8_lanes_store(lanes, l, chips[first + l]);
+        }
+    }
+
+    chip8_lanes_destroy(&lanes);
+    return dispatches;
+}
+
+int main(int argc, char* argv[]) {
+    const char* rom_path = (argc > 1 && strcmp(argv[1], "-") != 0) ? argv[1] : NULL;
+    int instances = (argc > 2) ? atoi(argv[2]) : DEFAULT_INSTANCES;
+    int frames = (argc > 3) ? atoi(argv[3]) : DEFAULT_FRAMES;
+    int cycles_per_frame = (argc > 4) ? atoi(argv[4]) : DEFAULT_CYCLES_PER_FRAME;
+    int threads = (argc > 5) ? atoi(argv[5]) : 0;
+    int lane_count = (argc > 6) ? atoi(argv[6]) : 0;
+
+    if (instances <= 0 || frames <= 0 || cycles_per_frame <= 0 || lane_count < 0 || lane_count > CHIP8_LANES_MAX) {
+        fprintf(stderr, "usage: %s [rom.ch8|-] [instances] [frames] [cycles_per_frame] [threads] [lanes]\n", argv[0]);
+        return 1;
+    }
+
+    size_t rom_size = sizeof(BUILTIN_ROM);
+    uint8_t* rom = NULL;
+    if (rom_path) {
+        rom = read_rom(rom_path, &rom_size);
+        if (!rom) return 1;
+    }
+
+    Chip8** chips = calloc((size_t)instances, sizeof(Chip8*));
+    uint64_t* hashes = calloc((size_t)instances, sizeof(uint64_t));
+    Chip8Runtime* rt = chip8_runtime_create(threads, 0);
+    if (!chips || !hashes || !rt) {
+        fprintf(stderr, "ERROR: Failed to set up batch\n");
+        return 1;
+    }
+
+    for (int i = 0; i < instances; i++) {
+        chips[i] = chip8_create();
+        if (!chips[i]) return 1;
+
+        for (size_t b = 0; b < rom_size; b++) {
+            chip8_write_memory(chips[i], (uint16_t)(0x200 + b), rom ? rom[b] : BUILTIN_ROM[b]);
+        }
+        chip8_key_press(chips[i], (uint8_t)(i % CHIP8_NUM_KEYS));
+        chip8_set_seed(chips[i], (uint64_t)i);
+    }
+
+    BatchStats stats;
+    atomic_init(&stats.completed, 0);
+    atomic_init(&stats.halted, 0);
+
+    double start = now_seconds();
+    long long dispatches = 0;
+    if (lane_count > 0) {
+        printf("ROM: %s, %d instances x %d frames x %d cycles in groups of %d lanes\n",
+               rom_path ? rom_path : "(built-in loop)", instances, frames, cycles_per_frame, lane_count);
+
+        dispatches = run_lanes(chips, instances, lane_count, frames, cycles_per_frame);
+        if (dispatches < 0) return 1;
+        for (int i = 0; i < instances; i++) {
+            on_done(chips[i], &stats);
+        }
+    } else {
+        printf("ROM: %s, %d instances x %d frames x %d cycles on %d threads\n",
+               rom_path ? rom_path : "(built-in loop)", instances, frames, cycles_per_frame, chip8_runtime_thread_count(rt));
+
+        Chip8RuntimeJob job = { (uint64_t)frames * (uint64_t)cycles_per_frame, cycles_per_frame, on_done, &stats };
+        for (int i = 0; i < instances; i++) {
+            chip8_runtime_submit(rt, chips[i], &job);
+        }
+        chip8_runtime_wait(rt);
+    }
+    double seconds = now_seconds() - start;
+
+    uint64_t cycles = 0;
+    uint64_t idle = 0;
+    for (int i = 0; i < instances; i++) {
+        cycles += chip8_get_cycle_count(chips[i]);
+        idle += chip8_get_idle_cycles(chips[i]);
+        hashes[i] = state_hash(chips[i]);
+        chip8_destroy(&chips[i]);
+    }
+
+    qsort(hashes, (size_t)instances, sizeof(uint64_t), compare_u64);
+    int distinct = 0;
+    for (int i = 0; i < instances; i++) {
+        if (i == 0 || hashes[i] != hashes[i - 1]) distinct++;
+    }
+
+    printf("  %d completed, %d halted, %d distinct final states\n",
+           atomic_load(&stats.completed), atomic_load(&stats.halted), distinct);
+    printf("  %llu cycles (%.1f%% idle) in %.3f s, %.1f M instr/s\n",
+           (unsigned long long)cycles, cycles ? 100.0 * (double)idle / (double)cycles : 0.0,
+           seconds, (double)cycles / seconds / 1e6);
+    if (dispatches > 0) {
+        printf("  %lld dispatches, %.1f lanes active per dispatch\n",
+               dispatches, (double)cycles / (double)dispatches);
+    }
+
+    chip8_runtime_destroy(&rt);
+    free(hashes);
+    free(chips);
+    free(rom);
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+    Headless throughput benchmark for the interpreter backends.
+
+    usage: chip8bench [rom.ch8|-] [frames] [cycles_per_frame] [module.so]
+
+    Without a ROM a built-in ALU/skip/jump loop is used. Every backend runs the
+    same number of frames (chip8_step_n + chip8_update_timers), the final states
+    are compared, and the speedup over the switch backend is reported. The AOT
+    backend only runs when a chip8aotc module built from the same ROM is given.
+*/
+#define _POSIX_C_SOURCE 200809L // clock_gettime under -std=c11
+
+#include "../include/chip8.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_FRAMES           200000
+#define DEFAULT_CYCLES_PER_FRAME 1000
+
+// 0x200: LD V0,0 / LD V1,5 / ADD V0,1 / ADD V1,V0 / SUB V2,V1 / LD I,0x300 / ADD I,V0 / SE V0,0xFF / JP 0x204 / JP 0x200
+static const uint8_t BUILTIN_ROM[] = {
+    0x60, 0x00, 0x61, 0x05, 0x70, 0x01, 0x81, 0x04, 0x82, 0x15,
+    0xA3, 0x00, 0xF0, 0x1E, 0x30, 0xFF, 0x12, 0x04, 0x12, 0x00,
+};
+
+typedef struct {
+    double seconds;
+    uint64_t cycles;
+    uint16_t pc;
+    uint16_t i;
+    uint8_t v[CHIP8_NUM_REGISTERS];
+} BenchResult;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static Chip8* bench_create(const char* rom_path) {
+    Chip8* chip = chip8_create();
+    if (!chip) return NULL;
+
+    if (rom_path) {
+        if (!chip8_load_rom(chip, rom_path)) {
+            chip8_destroy(&chip);
+            return NULL;
+        }
+    } else {
+        for (size_t i = 0; i < sizeof(BUILTIN_ROM); i++) {
+            chip8_write_memory(chip, (uint16_t)(0x200 + i), BUILTIN_ROM[i]);
+        }
+    }
+    return chip;
+}
+
+static bool bench_run(const char* rom_path, const char* aot_path, Chip8Backend backend,
+                      int frames, int cycles_per_frame, BenchResult* out) {
+    Chip8* chip = bench_create(rom_path);
+    if (!chip) return false;
+
+    if (backend == CHIP8_BACKEND_AOT) {
+        if (!chip8_load_aot(chip, aot_path)) {
+            chip8_destroy(&chip);
+            return false;
+        }
+    } else {
+        chip8_set_backend(chip, backend);
+    }
+
+    double start = now_seconds();
+    for (int f = 0; f < frames && !chip8_is_halted(chip); f++) {
+        chip8_step_n(chip, cycles_per_frame);
+        chip8_update_timers(chip);
+    }
+    out->seconds = now_seconds() - start;
+
+    out->cycles = chip8_get_cycle_count(chip);
+    out->pc = chip8_get_pc(chip);
+    out->i = chip8_get_i(chip);
+    for (int r = 0; r < CHIP8_NUM_REGISTERS; r++) {
+        out->v[r] = chip8_get_register(chip, r);
+    }
+
+    chip8_destroy(&chip);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const char* rom_path = (argc > 1 && strcmp(argv[1], "-") != 0) ? argv[1] : NULL;
+    int frames = (argc > 2) ? atoi(argv[2]) : DEFAULT_FRAMES;
+    int cycles_per_frame = (argc > 3) ? atoi(argv[3]) : DEFAULT_CYCLES_PER_FRAME;
+    const char* aot_path = (argc > 4) ? argv[4] : NULL;
+
+    if (frames <= 0 || cycles_per_frame <= 0) {
+        fprintf(stderr, "usage: %s [rom.ch8|-] [frames] [cycles_per_frame] [module.so]\n", argv[0]);
+        return 1;
+    }
+
+    printf("ROM: %s, %d frames x %d cycles\n", rom_path ? rom_path : "(built-in loop)", frames, cycles_per_frame);
+
+    BenchResult baseline;
+    bool have_baseline = false;
+    int status = 0;
+
+    for (int b = 0; b < CHIP8_BACKEND_COUNT; b++) {
+        Chip8Backend backend = (Chip8Backend)b;
+        if (!chip8_backend_available(backend)) {
+            printf("  %-10s not available in this build\n", chip8_backend_name(backend));
+            continue;
+        }
+        if (backend == CHIP8_BACKEND_AOT && !aot_path) {
+            printf("  %-10s skipped, no module given\n", chip8_backend_name(backend));
+            continue;
+        }
+
+        BenchResult result;
+        if (!bench_run(rom_path, aot_path, backend, frames, cycles_per_frame, &result)) {
+            fprintf(stderr, "ERROR: Failed to set up benchmark\n");
+            return 1;
+        }
+
+        double mips = (double)result.cycles / result.seconds / 1e6;
+        printf("  %-10s %12llu cycles  %8.3f s  %8.1f M instr/s",
+               chip8_backend_name(backend), (unsigned long long)result.cycles, result.seconds, mips);
+
+        if (!have_baseline) {
+            baseline = result;
+            have_baseline = true;
+            printf("\n");
+            continue;
+        }
+
+        bool same = result.cycles == baseline.cycles && result.pc == baseline.pc &&
+                    result.i == baseline.i && memcmp(result.v, baseline.v, sizeof(result.v)) == 0;
+        printf("  x%.2f%s\n", baseline.seconds / result.seconds, same ? "" : "  STATE MISMATCH");
+        if (!same) status = 1;
+    }
+
+    return status;
+}
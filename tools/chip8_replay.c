@@ -0,0 +1,105 @@
+/*
+    Headless movie replay, the determinism check for the backends.
+
+    usage: chip8replay movie.c8m [module.so]
+
+    Plays the whole movie at full speed on every backend, reports the keyframes that did
+    not match the replay and whether every backend ended in the same state. The AOT
+    backend only runs when a chip8aotc module built from the recorded ROM is given.
+*/
+#define _POSIX_C_SOURCE 200809L // clock_gettime under -std=c11
+
+#include "../include/chip8.h"
+#include "../include/chip8_movie.h"
+#include "../include/chip8_state.h"
+
+#include <stdio.h>
+#include <time.h>
+
+typedef struct {
+    double seconds;
+    int frames;
+    int desyncs;
+    uint8_t state[CHIP8_STATE_SIZE];
+} ReplayResult;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool replay_run(Chip8Movie* movie, const char* aot_path, Chip8Backend backend, ReplayResult* out) {
+    Chip8* chip = chip8_create();
+    if (!chip) return false;
+
+    bool ready = (backend == CHIP8_BACKEND_AOT) ? chip8_load_aot(chip, aot_path) : chip8_set_backend(chip, backend);
+    if (!ready || !chip8_movie_seek(movie, chip, 0)) {
+        chip8_destroy(&chip);
+        return false;
+    }
+
+    double start = now_seconds();
+    out->frames = chip8_movie_play(movie, chip, chip8_movie_frames(movie));
+    out->seconds = now_seconds() - start;
+    out->desyncs = chip8_movie_desyncs(movie);
+    chip8_save_state(chip, out->state, sizeof(out->state));
+
+    chip8_destroy(&chip);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s movie.c8m [module.so]\n", argv[0]);
+        return 1;
+    }
+    const char* aot_path = (argc > 2) ? argv[2] : NULL;
+
+    Chip8Movie* movie = chip8_movie_load(argv[1]);
+    if (!movie) return 1;
+
+    printf("Movie: %s, %d frames\n", argv[1], chip8_movie_frames(movie));
+
+    static ReplayResult baseline;
+    bool have_baseline = false;
+    int status = 0;
+
+    for (int b = 0; b < CHIP8_BACKEND_COUNT; b++) {
+        Chip8Backend backend = (Chip8Backend)b;
+        if (!chip8_backend_available(backend)) {
+            printf("  %-10s not available in this build\n", chip8_backend_name(backend));
+            continue;
+        }
+        if (backend == CHIP8_BACKEND_AOT && !aot_path) {
+            printf("  %-10s skipped, no module given\n", chip8_backend_name(backend));
+            continue;
+        }
+
+        static ReplayResult result;
+        if (!replay_run(movie, aot_path, backend, &result)) {
+            fprintf(stderr, "ERROR: Failed to set up replay\n");
+            chip8_movie_destroy(&movie);
+            return 1;
+        }
+
+        printf("  %-10s %8d frames  %8.3f s  %8.0f frames/s  %d desyncs",
+               chip8_backend_name(backend), result.frames, result.seconds,
+               result.frames / result.seconds, result.desyncs);
+        if (result.desyncs > 0 || result.frames != chip8_movie_frames(movie)) status = 1;
+
+        if (!have_baseline) {
+            baseline = result;
+            have_baseline = true;
+            printf("\n");
+            continue;
+        }
+
+        bool same = chip8_state_equal(result.state, baseline.state);
+        printf("%s\n", same ? "" : "  STATE MISMATCH");
+        if (!same) status = 1;
+    }
+
+    chip8_movie_destroy(&movie);
+    return status;
+}